@@ -2,6 +2,7 @@
 #define LAK_ALLOC_HPP
 
 #include "lak/result.hpp"
+#include "lak/source_location.hpp"
 #include "lak/span.hpp"
 
 #include <ostream>
@@ -30,23 +31,50 @@ namespace lak
 		};
 	}
 
-	lak::alloc::result<lak::span<byte_t>> local_alloc(size_t size,
-	                                                  size_t align = 0);
+	// Thread local size class allocator for small short lived allocations,
+	// larger allocations fall back to global_alloc. Memory from local_alloc
+	// may be freed from any thread.
+	lak::alloc::result<lak::span<byte_t>> local_alloc(
+	  size_t size,
+	  size_t align              = 0,
+	  lak::source_location site = lak::source_location::current());
 	void local_free(lak::span<byte_t> data);
 
-	lak::alloc::result<lak::span<byte_t>> global_alloc(size_t size,
-	                                                   size_t align = 0);
+	// site is only used by the allocation statistics, see lak/alloc_stats.hpp
+	lak::alloc::result<lak::span<byte_t>> global_alloc(
+	  size_t size,
+	  size_t align              = 0,
+	  lak::source_location site = lak::source_location::current());
 	void global_free(lak::span<byte_t> data);
 
+	// The default allocator of lak::array. Arrays using it allocate large
+	// buffers directly from page_reserve and only commit as they grow,
+	// smaller buffers come from global_alloc.
+	struct default_allocator
+	{
+		lak::alloc::result<lak::span<byte_t>> allocate(
+		  size_t size,
+		  size_t align              = 0,
+		  lak::source_location site = lak::source_location::current()) const
+		{
+			return lak::global_alloc(size, align, site);
+		}
+
+		void deallocate(lak::span<byte_t> data) const { lak::global_free(data); }
+	};
+
 	template<lak::alloc::locality LOC>
-	lak::alloc::result<lak::span<byte_t>> malloc(size_t size, size_t align = 0)
+	lak::alloc::result<lak::span<byte_t>> malloc(
+	  size_t size,
+	  size_t align              = 0,
+	  lak::source_location site = lak::source_location::current())
 	{
 		static_assert(LOC == lak::alloc::locality::local ||
 		              LOC == lak::alloc::locality::global);
 		if constexpr (LOC == lak::alloc::locality::local)
-			return lak::local_alloc(size, align);
+			return lak::local_alloc(size, align, site);
 		else
-			return lak::global_alloc(size, align);
+			return lak::global_alloc(size, align, site);
 	}
 
 	template<lak::alloc::locality LOC>
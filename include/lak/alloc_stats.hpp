@@ -0,0 +1,93 @@
+#ifndef LAK_ALLOC_STATS_HPP
+#define LAK_ALLOC_STATS_HPP
+
+#include "lak/array.hpp"
+#include "lak/source_location.hpp"
+#include "lak/span.hpp"
+
+#include <atomic>
+#include <ostream>
+
+namespace lak
+{
+	/* --- alloc_stats --- */
+
+	// Opt in allocation statistics. While enabled every global_alloc is
+	// recorded against the call site that made it, and page_reserve'd
+	// regions are tracked to compare committed memory with reserved address
+	// space. While disabled the only cost is an atomic load per call.
+	//
+	// Only memory allocated while enabled is counted, blocks allocated before
+	// that are ignored when they're freed. Disabling stops recording and
+	// leaves the counters as they were.
+
+	// size class i holds the allocations of [2^(i-1), 2^i) bytes, the last
+	// class holds everything larger
+	static constexpr size_t alloc_size_classes = 48U;
+
+	struct alloc_site_stats
+	{
+		lak::source_location site;
+		size_t allocations;
+		size_t frees;
+		size_t live_bytes;
+		size_t total_bytes;
+	};
+
+	struct alloc_size_class_stats
+	{
+		size_t allocations;
+		size_t live_count;
+		size_t live_bytes;
+	};
+
+	struct alloc_stats
+	{
+		size_t allocations;
+		size_t frees;
+		size_t live_bytes;
+		size_t peak_live_bytes;
+		size_t total_bytes;
+		// alignment padding of the live allocations
+		size_t slack_bytes;
+
+		// committed is approximate, committing pages that are already
+		// committed counts them twice (up to the size of their reservation)
+		size_t reserved_bytes;
+		size_t peak_reserved_bytes;
+		size_t committed_bytes;
+		size_t peak_committed_bytes;
+
+		lak::alloc_size_class_stats size_classes[lak::alloc_size_classes];
+
+		// sorted by live_bytes, largest first
+		lak::array<lak::alloc_site_stats> sites;
+
+		void to_json(std::ostream &strm) const;
+	};
+
+	inline std::atomic_bool _alloc_stats_on = false;
+
+	void enable_alloc_stats(bool enabled = true);
+
+	inline bool alloc_stats_enabled()
+	{
+		return lak::_alloc_stats_on.load(std::memory_order_relaxed);
+	}
+
+	lak::alloc_stats get_alloc_stats();
+
+	/* --- allocator hooks --- */
+
+	void _alloc_stats_allocated(lak::span<byte_t> data,
+	                            size_t slack,
+	                            lak::source_location site);
+	void _alloc_stats_freed(lak::span<byte_t> data);
+
+	void _alloc_stats_reserved(lak::span<void> pages);
+	void _alloc_stats_committed(lak::span<void> pages);
+	void _alloc_stats_decommitted(lak::span<void> pages);
+	void _alloc_stats_released(lak::span<void> pages);
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef LAK_ARENA_HPP
+#define LAK_ARENA_HPP
+
+#include "lak/alloc.hpp"
+#include "lak/array.hpp"
+#include "lak/span.hpp"
+#include "lak/stdint.hpp"
+#include "lak/unique_pages.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace lak
+{
+	/* --- arena --- */
+
+	// Monotonic allocator over a chain of lak::unique_pages blocks. Pages are
+	// reserved a block at a time and committed as the arena grows.
+	// Individual allocations are never freed (except the most recent one),
+	// everything is dropped at once with rewind or reset.
+	//
+	// arena_allocators refer to their arena by address, so arenas can't be
+	// moved.
+	struct arena
+	{
+		struct marker
+		{
+			size_t block = 0U;
+			size_t used  = 0U;
+		};
+
+		static constexpr size_t default_block_size = 1024U * 1024U;
+		static constexpr size_t commit_size        = 64U * 1024U;
+
+	private:
+		struct block
+		{
+			lak::unique_pages pages;
+			size_t committed = 0U;
+			size_t used      = 0U;
+
+			byte_t *data() const { return static_cast<byte_t *>(pages.data()); }
+		};
+
+		lak::array<block> _blocks;
+		size_t _current = 0U;
+		size_t _block_size;
+
+		// the offset of an allocation in b, or SIZE_MAX if it doesn't fit
+		static size_t fit(const block &b, size_t size, size_t align);
+
+	public:
+		arena(size_t block_size = default_block_size);
+
+		arena(const arena &)            = delete;
+		arena &operator=(const arena &) = delete;
+
+		lak::alloc::result<lak::span<byte_t>> allocate(
+		  size_t size, size_t align = alignof(std::max_align_t));
+
+		// only gives the memory back if data is the most recent allocation
+		void deallocate(lak::span<byte_t> data);
+
+		marker mark() const;
+
+		// drops everything allocated since m was marked, the pages stay
+		// committed for reuse
+		void rewind(marker m);
+
+		// drops everything, the pages stay committed for reuse
+		void reset() { rewind({}); }
+
+		// drops everything and frees all the pages
+		void release();
+
+		// bytes allocated from the arena, including alignment padding
+		size_t used() const;
+
+		// bytes of address space reserved by the arena
+		size_t reserved() const;
+	};
+
+	/* --- arena_allocator --- */
+
+	// allocator for lak::array
+	struct arena_allocator
+	{
+		lak::arena *_arena = nullptr;
+
+		arena_allocator() = default;
+		arena_allocator(lak::arena &arena) : _arena(&arena) {}
+
+		lak::alloc::result<lak::span<byte_t>> allocate(size_t size,
+		                                               size_t align = 0) const;
+
+		void deallocate(lak::span<byte_t> data) const;
+	};
+
+	template<typename T>
+	using arena_array = lak::array<T, lak::dynamic_extent, lak::arena_allocator>;
+
+	/* --- arena_std_allocator --- */
+
+	// allocator for std containers (and so lak::string)
+	template<typename T>
+	struct arena_std_allocator
+	{
+		using value_type = T;
+
+		lak::arena *_arena;
+
+		arena_std_allocator(lak::arena &arena) : _arena(&arena) {}
+
+		template<typename U>
+		arena_std_allocator(const arena_std_allocator<U> &other)
+		: _arena(other._arena)
+		{
+		}
+
+		T *allocate(size_t n);
+
+		void deallocate(T *ptr, size_t n);
+
+		template<typename U>
+		bool operator==(const arena_std_allocator<U> &other) const
+		{
+			return _arena == other._arena;
+		}
+	};
+
+	template<typename CHAR>
+	using arena_string = std::basic_string<CHAR,
+	                                       std::char_traits<CHAR>,
+	                                       lak::arena_std_allocator<CHAR>>;
+}
+
+#include "lak/arena.inl"
+
+#endif
@@ -0,0 +1,20 @@
+#include "lak/arena.hpp"
+
+#include <new>
+
+/* --- arena_std_allocator --- */
+
+template<typename T>
+T *lak::arena_std_allocator<T>::allocate(size_t n)
+{
+	auto result{_arena->allocate(n * sizeof(T), alignof(T))};
+	if (result.is_err()) throw std::bad_alloc();
+	return reinterpret_cast<T *>(result.unsafe_unwrap().data());
+}
+
+template<typename T>
+void lak::arena_std_allocator<T>::deallocate(T *ptr, size_t n)
+{
+	_arena->deallocate(
+	  lak::span<byte_t>(reinterpret_cast<byte_t *>(ptr), n * sizeof(T)));
+}
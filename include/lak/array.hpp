@@ -9,7 +9,49 @@
 
 namespace lak
 {
-	template<typename T>
+	// How an uninit_array picks its new capacity when it has to reallocate,
+	// and how far ahead paged arrays commit when they grow within their
+	// reservation.
+	struct array_growth
+	{
+		enum struct mode : uint8_t
+		{
+			// multiply by numerator / denominator
+			geometric,
+			// round up to a whole number of pages
+			page,
+			// exactly what was asked for
+			exact,
+		};
+
+		lak::array_growth::mode mode = mode::geometric;
+		uint8_t numerator            = 2U;
+		uint8_t denominator          = 1U;
+
+		static constexpr lak::array_growth geometric(uint8_t numerator   = 2U,
+		                                             uint8_t denominator = 1U)
+		{
+			return {mode::geometric, numerator, denominator};
+		}
+		static constexpr lak::array_growth page() { return {mode::page}; }
+		static constexpr lak::array_growth exact() { return {mode::exact}; }
+
+		// at least required elements of element_size bytes, growing from
+		// capacity
+		size_t next_capacity(size_t capacity,
+		                     size_t required,
+		                     size_t element_size) const;
+	};
+
+	// ALLOC must provide allocate(size, align) -> lak::alloc::result<span> and
+	// deallocate(span), see lak::default_allocator. Only arrays using
+	// lak::default_allocator use paged allocations.
+	//
+	// The functions that may allocate take the caller's source location and
+	// pass it on to allocators that accept one (allocate(size, align, site)),
+	// so the allocation statistics count allocations against the array's user
+	// rather than against this file.
+	template<typename T, typename ALLOC = lak::default_allocator>
 	struct uninit_array
 	{
 	private:
@@ -22,15 +64,44 @@ namespace lak
 		// element count
 		size_t _size = 0U;
 
+		[[no_unique_address]] ALLOC _alloc = {};
+
+		lak::array_growth _growth = {};
+
+		static constexpr bool can_page =
+		  lak::is_same_v<ALLOC, lak::default_allocator>;
+
 		static size_t page_threshold();
 
-		bool is_paged(size_t size) const { return size >= page_threshold(); }
+		bool is_paged(size_t size) const
+		{
+			return can_page && size >= page_threshold();
+		}
 		bool is_paged() const { return is_paged(_data.size()); }
 
+		// paged reservations of at least a huge page are backed by
+		// transparent huge pages (where available) to cut down on TLB misses
+		static bool is_huge_paged(size_t reserved_bytes)
+		{
+			const size_t huge_size{lak::huge_page_size()};
+			return huge_size != 0U && reserved_bytes >= huge_size;
+		}
+
 		// assumes memory has already been reserved, just commits up to the new
 		// capacity
 		void commit_impl(size_t new_capacity);
 
+		lak::alloc::result<lak::span<byte_t>> allocate_impl(
+		  size_t size, size_t align, lak::source_location site);
+
+		// empty array with the same allocator and growth policy
+		uninit_array empty_copy() const
+		{
+			uninit_array result{_alloc};
+			result._growth = _growth;
+			return result;
+		}
+
 	public:
 		using value_type      = T;
 		using size_type       = size_t;
@@ -48,25 +119,47 @@ namespace lak
 		uninit_array &operator=(const uninit_array &) = delete;
 		uninit_array &operator=(uninit_array &&other);
 
-		uninit_array(size_t initial_size) { resize(initial_size); }
+		uninit_array(
+		  size_t initial_size,
+		  lak::source_location site = lak::source_location::current())
+		{
+			resize(initial_size, site);
+		}
+
+		explicit uninit_array(const ALLOC &alloc) : _alloc(alloc) {}
 
 		~uninit_array();
 
+		const ALLOC &get_allocator() const { return _alloc; }
+
 		size_t size() const { return _size; }
 		constexpr size_t max_size() const { return SIZE_MAX; }
 		size_t capacity() const { return _data.size(); }
 		size_t committed() const { return is_paged() ? _committed : _data.size(); }
 
-		// returns the old allocation if reallocation is required
-		lak::optional<uninit_array> reserve(size_t new_capacity);
-		lak::optional<uninit_array> commit(size_t new_capacity);
-		lak::optional<uninit_array> resize(size_t new_size);
-
-		lak::optional<uninit_array> push_back();
+		const lak::array_growth &growth() const { return _growth; }
+		void set_growth(const lak::array_growth &growth) { _growth = growth; }
+
+		// Returns the old allocation if reallocation is required.
+		// Reserving a large capacity up front (enough to be paged) only
+		// reserves address space, pages are committed as the array grows into
+		// it, so appends within the reservation never move the elements.
+		lak::optional<uninit_array> reserve(
+		  size_t new_capacity,
+		  lak::source_location site = lak::source_location::current());
+		lak::optional<uninit_array> commit(
+		  size_t new_capacity,
+		  lak::source_location site = lak::source_location::current());
+		lak::optional<uninit_array> resize(
+		  size_t new_size,
+		  lak::source_location site = lak::source_location::current());
+
+		lak::optional<uninit_array> push_back(
+		  lak::source_location site = lak::source_location::current());
 		void pop_back() { --_size; }
 
 		void clear() { _size = 0U; }
-		uninit_array force_clear() { return lak::exchange(*this, uninit_array{}); }
+		uninit_array force_clear() { return lak::exchange(*this, empty_copy()); }
 
 		[[nodiscard]] bool empty() const { return size() == 0U; }
 
@@ -103,7 +196,9 @@ namespace lak
 	template<typename T>
 	concept array_type_is_copyable = lak::_array_type_is_copyable<T>::value;
 
-	template<typename T, size_t SIZE = lak::dynamic_extent>
+	// ALLOC defaults to lak::default_allocator, only used by the dynamic size
+	// array
+	template<typename T, size_t SIZE = lak::dynamic_extent, typename ALLOC>
 	struct array
 	{
 	private:
@@ -164,8 +259,8 @@ namespace lak
 		constexpr const T &back() const;
 	};
 
-	template<typename T>
-	struct array<T, 0U>
+	template<typename T, typename ALLOC>
+	struct array<T, 0U, ALLOC>
 	{
 		using value_type      = T;
 		using size_type       = size_t;
@@ -220,18 +315,20 @@ namespace lak
 		return {lak::move(t), lak::move(u)...};
 	}
 
-	template<typename T>
-	struct array<T, lak::dynamic_extent>
+	template<typename T, typename ALLOC>
+	struct array<T, lak::dynamic_extent, ALLOC>
 	{
 	private:
-		using data_type = lak::uninit_array<T>;
+		using data_type = lak::uninit_array<T, ALLOC>;
 		data_type _data;
 
 		// resizes to `size()+count` and leaves a `count` sized gap of
 		// uninitialised elements before `before`
 		void right_shift(size_t count, size_t before = 0U);
 
-		void resize_impl(size_t new_size);
+		void resize_impl(
+		  size_t new_size,
+		  lak::source_location site = lak::source_location::current());
 
 	public:
 		using value_type      = typename data_type::value_type;
@@ -243,8 +340,10 @@ namespace lak
 		using const_pointer   = typename data_type::const_pointer;
 		using iterator        = typename data_type::iterator;
 		using const_iterator  = typename data_type::const_iterator;
+		using allocator_type  = ALLOC;
 
 		array() = default;
+		explicit array(const ALLOC &alloc) : _data(alloc) {}
 		array(const array &)
 		requires lak::array_type_is_copyable<T>;
 
@@ -254,26 +353,46 @@ namespace lak
 		array(array &&other);
 		array &operator=(array &&other);
 
-		array(size_t initial_size);
+		array(size_t initial_size,
+		      lak::source_location site = lak::source_location::current());
 
-		array(std::initializer_list<T> list)
+		array(std::initializer_list<T> list,
+		      lak::source_location site = lak::source_location::current())
 		requires lak::array_type_is_copyable<T>;
 
 		template<typename ITER>
 		requires lak::array_type_is_copyable<T>
-		array(ITER &&begin, ITER &&end);
+		array(ITER &&begin,
+		      ITER &&end,
+		      lak::source_location site = lak::source_location::current());
 
 		~array();
 
+		const ALLOC &get_allocator() const { return _data.get_allocator(); }
+
 		size_t size() const { return _data.size(); }
 		constexpr size_t max_size() const { return _data.max_size(); }
 		size_t capacity() const { return _data.capacity(); }
 		size_t committed() const { return _data.committed(); }
 
-		void resize(size_t new_size);
-		void resize(size_t new_size, const T &default_value)
+		const lak::array_growth &growth() const { return _data.growth(); }
+		void set_growth(const lak::array_growth &growth)
+		{
+			_data.set_growth(growth);
+		}
+
+		void resize(
+		  size_t new_size,
+		  lak::source_location site = lak::source_location::current());
+		void resize(
+		  size_t new_size,
+		  const T &default_value,
+		  lak::source_location site = lak::source_location::current())
 		requires lak::array_type_is_copyable<T>;
-		void reserve(size_t new_capacity);
+		// see uninit_array::reserve
+		void reserve(
+		  size_t new_capacity,
+		  lak::source_location site = lak::source_location::current());
 
 		void clear();
 		void force_clear();
@@ -304,6 +423,8 @@ namespace lak
 		reference back() { return _data.back(); }
 		const_reference back() const { return _data.back(); }
 
+		// allocations made by emplace_*, push_front and insert are counted
+		// against this file, reserve first to count them against the caller
 		template<typename... ARGS>
 		reference emplace_front(ARGS &&...args);
 
@@ -317,9 +438,13 @@ namespace lak
 		template<typename... ARGS>
 		reference emplace_back(ARGS &&...args);
 
-		reference push_back(const T &t)
+		reference push_back(
+		  const T &t,
+		  lak::source_location site = lak::source_location::current())
 		requires lak::array_type_is_copyable<T>;
-		reference push_back(T &&t);
+		reference push_back(
+		  T &&t,
+		  lak::source_location site = lak::source_location::current());
 
 		void pop_back();
 		T popped_back();
@@ -414,13 +539,233 @@ namespace lak
 		void pop_back();
 		T popped_back();
 	};
+
+	// Dynamic array that keeps up to INLINE_SIZE elements inside itself and
+	// only spills to ALLOC (or to pages, see uninit_array) once it outgrows
+	// them. Shrinking doesn't move spilled elements back inline, force_clear
+	// does. Moving an inline small_array moves each element.
+	template<typename T,
+	         size_t INLINE_SIZE,
+	         typename ALLOC = lak::default_allocator>
+	struct small_array
+	{
+		static_assert(INLINE_SIZE > 0U);
+
+	private:
+		using heap_type = lak::uninit_array<T, ALLOC>;
+
+		// spilled storage, has no capacity while the elements are inline
+		heap_type _heap;
+
+		// element count while inline
+		size_t _size = 0U;
+
+		alignas(T) byte_t _inline[INLINE_SIZE * sizeof(T)];
+
+		bool is_inline() const { return _heap.capacity() == 0U; }
+
+		// new_size must fit in the current storage
+		void set_size(size_t new_size);
+
+		// resizes to `size()+count` and leaves a `count` sized gap of
+		// uninitialised elements before `before`
+		void right_shift(size_t count, size_t before = 0U);
+
+		void resize_impl(size_t new_size);
+
+		// move the elements to new spilled storage with at least new_capacity
+		// elements, leaving a `count` sized gap before `before`
+		void relocate(size_t new_capacity, size_t count, size_t before);
+
+		// destructively move other's elements into this empty array
+		void steal(small_array &other);
+
+	public:
+		using value_type      = T;
+		using size_type       = size_t;
+		using difference_type = ptrdiff_t;
+		using reference       = T &;
+		using const_reference = const T &;
+		using pointer         = T *;
+		using const_pointer   = const T *;
+		using iterator        = T *;
+		using const_iterator  = const T *;
+		using allocator_type  = ALLOC;
+
+		static constexpr size_t inline_size = INLINE_SIZE;
+
+		small_array() {}
+		explicit small_array(const ALLOC &alloc) : _heap(alloc) {}
+		small_array(const small_array &other)
+		requires lak::array_type_is_copyable<T>;
+
+		small_array &operator=(const small_array &other)
+		requires lak::array_type_is_copyable<T>;
+
+		small_array(small_array &&other);
+		small_array &operator=(small_array &&other);
+
+		small_array(size_t initial_size);
+
+		small_array(std::initializer_list<T> list)
+		requires lak::array_type_is_copyable<T>;
+
+		template<typename ITER>
+		requires lak::array_type_is_copyable<T>
+		small_array(ITER &&begin, ITER &&end);
+
+		~small_array();
+
+		const ALLOC &get_allocator() const { return _heap.get_allocator(); }
+
+		size_t size() const { return is_inline() ? _size : _heap.size(); }
+		constexpr size_t max_size() const { return _heap.max_size(); }
+		size_t capacity() const
+		{
+			return is_inline() ? INLINE_SIZE : _heap.capacity();
+		}
+		size_t committed() const
+		{
+			return is_inline() ? INLINE_SIZE : _heap.committed();
+		}
+
+		// true if the elements are stored inline
+		bool is_small() const { return is_inline(); }
+
+		// used once the elements have spilled
+		const lak::array_growth &growth() const { return _heap.growth(); }
+		void set_growth(const lak::array_growth &growth)
+		{
+			_heap.set_growth(growth);
+		}
+
+		void resize(size_t new_size);
+		void resize(size_t new_size, const T &default_value)
+		requires lak::array_type_is_copyable<T>;
+		void reserve(size_t new_capacity);
+
+		void clear();
+		// also releases the spilled storage
+		void force_clear();
+
+		[[nodiscard]] bool empty() const { return size() == 0U; }
+
+		pointer data()
+		{
+			return is_inline() ? reinterpret_cast<T *>(_inline) : _heap.data();
+		}
+		const_pointer data() const
+		{
+			return is_inline() ? reinterpret_cast<const T *>(_inline)
+			                   : _heap.data();
+		}
+
+		iterator begin() { return data(); }
+		iterator end() { return data() + size(); }
+
+		const_iterator begin() const { return data(); }
+		const_iterator end() const { return data() + size(); }
+
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend() const { return end(); }
+
+		reference at(size_t index);
+		const_reference at(size_t index) const;
+
+		reference operator[](size_t index) { return data()[index]; }
+		const_reference operator[](size_t index) const { return data()[index]; }
+
+		reference front() { return data()[0]; }
+		const_reference front() const { return data()[0]; }
+
+		reference back() { return data()[size() - 1U]; }
+		const_reference back() const { return data()[size() - 1U]; }
+
+		template<typename... ARGS>
+		reference emplace_front(ARGS &&...args);
+
+		reference push_front(const T &t)
+		requires lak::array_type_is_copyable<T>;
+		reference push_front(T &&t);
+
+		void pop_front();
+		T popped_front();
+
+		template<typename... ARGS>
+		reference emplace_back(ARGS &&...args);
+
+		reference push_back(const T &t)
+		requires lak::array_type_is_copyable<T>;
+		reference push_back(T &&t);
+
+		void pop_back();
+		T popped_back();
+
+		iterator insert(const_iterator before, const T &value)
+		requires lak::array_type_is_copyable<T>;
+		iterator insert(const_iterator before, T &&value);
+		iterator insert(const_iterator before, std::initializer_list<T> list)
+		requires lak::array_type_is_copyable<T>;
+
+		iterator erase(const_iterator first, const_iterator last);
+
+		iterator erase(const_iterator element)
+		{
+			return erase(element, element + 1);
+		}
+	};
+
+	/* --- is_trivially_relocatable --- */
+
+	template<typename T, typename ALLOC>
+	struct is_trivially_relocatable<lak::uninit_array<T, ALLOC>>
+	: lak::is_trivially_relocatable<ALLOC>
+	{
+	};
+
+	template<typename T, size_t SIZE, typename ALLOC>
+	struct is_trivially_relocatable<lak::array<T, SIZE, ALLOC>>
+	: lak::is_trivially_relocatable<T>
+	{
+	};
+
+	template<typename T, typename ALLOC>
+	struct is_trivially_relocatable<lak::array<T, lak::dynamic_extent, ALLOC>>
+	: lak::is_trivially_relocatable<ALLOC>
+	{
+	};
+
+	template<typename T, size_t MAX_SIZE>
+	struct is_trivially_relocatable<lak::stack_array<T, MAX_SIZE>>
+	: lak::is_trivially_relocatable<T>
+	{
+	};
+
+	// the inline elements are addressed relative to the small_array, never
+	// through a stored pointer
+	template<typename T, size_t N, typename ALLOC>
+	struct is_trivially_relocatable<lak::small_array<T, N, ALLOC>>
+	: lak::conjunction<lak::is_trivially_relocatable<T>,
+	                   lak::is_trivially_relocatable<ALLOC>>
+	{
+	};
 }
 
-template<typename T, size_t S>
-bool operator==(const lak::array<T, S> &a, const lak::array<T, S> &b);
+template<typename T, size_t S, typename ALLOC>
+bool operator==(const lak::array<T, S, ALLOC> &a,
+                const lak::array<T, S, ALLOC> &b);
+
+template<typename T, size_t S, typename ALLOC>
+bool operator!=(const lak::array<T, S, ALLOC> &a,
+                const lak::array<T, S, ALLOC> &b);
+
+template<typename T, size_t N, typename ALLOC>
+bool operator==(const lak::small_array<T, N, ALLOC> &a,
+                const lak::small_array<T, N, ALLOC> &b);
 
-template<typename T, size_t S>
-bool operator!=(const lak::array<T, S> &a, const lak::array<T, S> &b);
+template<typename T, size_t N, typename ALLOC>
+bool operator!=(const lak::small_array<T, N, ALLOC> &a,
+                const lak::small_array<T, N, ALLOC> &b);
 
 #endif
 
@@ -2,38 +2,76 @@
 #include "lak/alloc.hpp"
 #include "lak/compiler.hpp"
 #include "lak/integer_range.hpp"
+#include "lak/math.hpp"
 #include "lak/memmanip.hpp"
 #include "lak/result.hpp"
 #include "lak/span.hpp"
+#include "lak/span_manip.hpp"
+
+/* --- array_growth --- */
+
+inline size_t lak::array_growth::next_capacity(size_t capacity,
+                                               size_t required,
+                                               size_t element_size) const
+{
+	switch (mode)
+	{
+		case mode::geometric:
+		{
+			ASSERT_GREATER(denominator, 0U);
+			return std::max(required, capacity / denominator * numerator +
+			                            capacity % denominator * numerator /
+			                              denominator);
+		}
+
+		case mode::page:
+		{
+			if (element_size == 0U) return required;
+			return lak::round_to_page_multiple(required * element_size) /
+			       element_size;
+		}
+
+		case mode::exact:
+			return required;
+
+		default:
+			ASSERT_UNREACHABLE();
+	}
+}
 
 /* --- uninit_array --- */
 
-template<typename T>
-size_t lak::uninit_array<T>::page_threshold()
+template<typename T, typename ALLOC>
+size_t lak::uninit_array<T, ALLOC>::page_threshold()
 {
 	const static size_t _page_threshold = (lak::page_size() / 4U) / sizeof(T);
 	return _page_threshold;
 }
 
-template<typename T>
-lak::uninit_array<T>::uninit_array(uninit_array &&other)
+template<typename T, typename ALLOC>
+lak::uninit_array<T, ALLOC>::uninit_array(uninit_array &&other)
 : _data(lak::exchange(other._data, lak::span<T>{})),
   _committed(lak::exchange(other._committed, 0U)),
-  _size(lak::exchange(other._size, 0U))
+  _size(lak::exchange(other._size, 0U)),
+  _alloc(other._alloc),
+  _growth(other._growth)
 {
 }
 
-template<typename T>
-lak::uninit_array<T> &lak::uninit_array<T>::operator=(uninit_array &&other)
+template<typename T, typename ALLOC>
+lak::uninit_array<T, ALLOC> &lak::uninit_array<T, ALLOC>::operator=(
+  uninit_array &&other)
 {
 	lak::swap(_data, other._data);
 	lak::swap(_committed, other._committed);
 	lak::swap(_size, other._size);
+	lak::swap(_alloc, other._alloc);
+	lak::swap(_growth, other._growth);
 	return *this;
 }
 
-template<typename T>
-lak::uninit_array<T>::uninit_array::~uninit_array()
+template<typename T, typename ALLOC>
+lak::uninit_array<T, ALLOC>::uninit_array::~uninit_array()
 {
 	if (committed() != 0)
 	{
@@ -46,7 +84,7 @@ lak::uninit_array<T>::uninit_array::~uninit_array()
 		}
 		else
 		{
-			lak::global_free(lak::span<byte_t>(_data));
+			_alloc.deallocate(lak::span<byte_t>(_data));
 		}
 	}
 	_data      = {};
@@ -54,16 +92,28 @@ lak::uninit_array<T>::uninit_array::~uninit_array()
 	_size      = 0U;
 }
 
-template<typename T>
-void lak::uninit_array<T>::commit_impl(size_t new_capacity)
+template<typename T, typename ALLOC>
+void lak::uninit_array<T, ALLOC>::commit_impl(size_t new_capacity)
 {
 	if (!is_paged() || new_capacity <= _committed) return;
 
+	// commit ahead of what's needed so growing element by element doesn't
+	// commit a page at a time
+	new_capacity = std::min(
+	  _growth.next_capacity(_committed, new_capacity, sizeof(T)), _data.size());
+
 	const size_t committed_bytes{
 	  lak::round_to_page_multiple(_committed * sizeof(T))};
 
-	const size_t new_bytes =
-	  lak::round_to_page_multiple(new_capacity * sizeof(T));
+	size_t new_bytes = lak::round_to_page_multiple(new_capacity * sizeof(T));
+
+	// commit whole huge pages, partially committed ones are backed by base
+	// size pages
+	if (const size_t reserved_bytes{
+	      lak::round_to_page_multiple(_data.size() * sizeof(T))};
+	    is_huge_paged(reserved_bytes))
+		new_bytes = std::min(lak::to_multiple(new_bytes, lak::huge_page_size()),
+		                     reserved_bytes);
 
 	lak::page_commit(
 	  lak::span<void>(
@@ -75,18 +125,31 @@ void lak::uninit_array<T>::commit_impl(size_t new_capacity)
 	_committed = new_bytes / sizeof(T);
 }
 
-template<typename T>
-lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::reserve(
-  size_t new_capacity)
+template<typename T, typename ALLOC>
+lak::alloc::result<lak::span<byte_t>>
+lak::uninit_array<T, ALLOC>::allocate_impl(size_t size,
+                                           size_t align,
+                                           lak::source_location site)
+{
+	if constexpr (requires { _alloc.allocate(size, align, site); })
+		return _alloc.allocate(size, align, site);
+	else
+		return _alloc.allocate(size, align);
+}
+
+template<typename T, typename ALLOC>
+lak::optional<lak::uninit_array<T, ALLOC>>
+lak::uninit_array<T, ALLOC>::reserve(size_t new_capacity,
+                                     lak::source_location site)
 {
 	if (new_capacity <= capacity()) return lak::nullopt;
 
-	new_capacity = std::max(new_capacity, capacity() * 2U);
+	new_capacity = _growth.next_capacity(capacity(), new_capacity, sizeof(T));
 
 	const auto old_committed{committed()};
 	const auto old_size{_size};
 
-	lak::optional<uninit_array> result{lak::exchange(*this, uninit_array{})};
+	lak::optional<uninit_array> result{lak::exchange(*this, empty_copy())};
 
 	if (is_paged(new_capacity))
 	{
@@ -95,8 +158,11 @@ lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::reserve(
 		const size_t reserve_bytes{
 		  lak::round_to_page_multiple(new_capacity * sizeof(T))};
 
-		_data =
-		  lak::span<T>(lak::page_reserve(reserve_bytes).expect("reserve failed"));
+		_data = lak::span<T>(
+		  lak::page_reserve(reserve_bytes,
+		                    lak::page_options{.transparent_huge_pages =
+		                                        is_huge_paged(reserve_bytes)})
+		    .expect("reserve failed"));
 
 		commit_impl(old_committed);
 	}
@@ -105,7 +171,8 @@ lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::reserve(
 		// use non-paged allocations
 
 		_data = lak::span<T>(
-		  lak::global_alloc(new_capacity * sizeof(T)).expect("alloc failed"));
+		  allocate_impl(new_capacity * sizeof(T), alignof(T), site)
+		    .expect("alloc failed"));
 	}
 
 	_size = old_size;
@@ -113,37 +180,38 @@ lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::reserve(
 	return result;
 }
 
-template<typename T>
-lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::commit(
-  size_t new_capacity)
+template<typename T, typename ALLOC>
+lak::optional<lak::uninit_array<T, ALLOC>> lak::uninit_array<T, ALLOC>::commit(
+  size_t new_capacity, lak::source_location site)
 {
-	auto result{reserve(new_capacity)};
+	auto result{reserve(new_capacity, site)};
 
 	commit_impl(new_capacity);
 
 	return result;
 }
 
-template<typename T>
-lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::resize(
-  size_t new_size)
+template<typename T, typename ALLOC>
+lak::optional<lak::uninit_array<T, ALLOC>> lak::uninit_array<T, ALLOC>::resize(
+  size_t new_size, lak::source_location site)
 {
-	auto result{commit(new_size)};
+	auto result{commit(new_size, site)};
 	_size = new_size;
 
 	return result;
 }
 
-template<typename T>
-lak::optional<lak::uninit_array<T>> lak::uninit_array<T>::push_back()
+template<typename T, typename ALLOC>
+lak::optional<lak::uninit_array<T, ALLOC>>
+lak::uninit_array<T, ALLOC>::push_back(lak::source_location site)
 {
-	return resize(size() + 1U);
+	return resize(size() + 1U, site);
 }
 
 /* --- fixed size --- */
 
-template<typename T, size_t SIZE>
-lak::array<T, SIZE>::array(std::initializer_list<T> list)
+template<typename T, size_t SIZE, typename ALLOC>
+lak::array<T, SIZE, ALLOC>::array(std::initializer_list<T> list)
 requires lak::array_type_is_copyable<T>
 {
 	ASSERT_EQUAL(list.size(), SIZE);
@@ -155,61 +223,61 @@ requires lak::array_type_is_copyable<T>
 		lak::copy(list.begin(), list.end(), data(), data() + SIZE);
 }
 
-template<typename T, size_t SIZE>
-T &lak::array<T, SIZE>::at(size_t index)
+template<typename T, size_t SIZE, typename ALLOC>
+T &lak::array<T, SIZE, ALLOC>::at(size_t index)
 {
 	ASSERT_GREATER(SIZE, index);
 	return _data[index];
 }
 
-template<typename T, size_t SIZE>
-const T &lak::array<T, SIZE>::at(size_t index) const
+template<typename T, size_t SIZE, typename ALLOC>
+const T &lak::array<T, SIZE, ALLOC>::at(size_t index) const
 {
 	ASSERT_GREATER(SIZE, index);
 	return _data[index];
 }
 
-template<typename T, size_t SIZE>
-constexpr T &lak::array<T, SIZE>::operator[](size_t index)
+template<typename T, size_t SIZE, typename ALLOC>
+constexpr T &lak::array<T, SIZE, ALLOC>::operator[](size_t index)
 {
 	return _data[index];
 }
 
-template<typename T, size_t SIZE>
-constexpr const T &lak::array<T, SIZE>::operator[](size_t index) const
+template<typename T, size_t SIZE, typename ALLOC>
+constexpr const T &lak::array<T, SIZE, ALLOC>::operator[](size_t index) const
 {
 	return _data[index];
 }
 
-template<typename T, size_t SIZE>
-constexpr T &lak::array<T, SIZE>::front()
+template<typename T, size_t SIZE, typename ALLOC>
+constexpr T &lak::array<T, SIZE, ALLOC>::front()
 {
 	return _data[0];
 }
 
-template<typename T, size_t SIZE>
-constexpr const T &lak::array<T, SIZE>::front() const
+template<typename T, size_t SIZE, typename ALLOC>
+constexpr const T &lak::array<T, SIZE, ALLOC>::front() const
 {
 	return _data[0];
 }
 
-template<typename T, size_t SIZE>
-constexpr T &lak::array<T, SIZE>::back()
+template<typename T, size_t SIZE, typename ALLOC>
+constexpr T &lak::array<T, SIZE, ALLOC>::back()
 {
 	return _data[SIZE - 1];
 }
 
-template<typename T, size_t SIZE>
-constexpr const T &lak::array<T, SIZE>::back() const
+template<typename T, size_t SIZE, typename ALLOC>
+constexpr const T &lak::array<T, SIZE, ALLOC>::back() const
 {
 	return _data[SIZE - 1];
 }
 
 /* --- dynamic size --- */
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::right_shift(size_t count,
-                                                     size_t before)
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::right_shift(size_t count,
+                                                            size_t before)
 {
 	if (count == 0) return;
 
@@ -217,39 +285,40 @@ void lak::array<T, lak::dynamic_extent>::right_shift(size_t count,
 
 	if (auto old{_data.resize(old_size + count)}; old)
 	{
-		for (size_t i : lak::size_range_count(before))
-			lak::destructive_move_construct(old->data() + i, _data.data() + i);
-		for (size_t i : lak::size_range::from_to(before, old_size))
-			lak::destructive_move_construct(old->data() + i,
-			                                _data.data() + i + count);
+		lak::relocate(old->data(), _data.data(), before);
+		lak::relocate(
+		  old->data() + before, _data.data() + before + count, old_size - before);
 	}
 	else
 	{
-		for (size_t i = old_size; i-- > before;)
-			lak::destructive_move_construct(_data.data() + i,
-			                                _data.data() + i + count);
+		lak::relocate(
+		  _data.data() + before, _data.data() + before + count, old_size - before);
 	}
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::resize_impl(size_t new_size)
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::resize_impl(
+  size_t new_size, lak::source_location site)
 {
-	if (auto old{_data.resize(new_size)}; old)
-		for (size_t i : lak::size_range_count(old->size()))
-			lak::destructive_move_construct(old->data() + i, _data.data() + i);
+	if (auto old{_data.resize(new_size, site)}; old)
+		lak::relocate(old->data(), _data.data(), old->size());
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent>::array(size_t initial_size) : array()
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC>::array(size_t initial_size,
+                                                 lak::source_location site)
+: array()
 {
-	resize(initial_size);
+	resize(initial_size, site);
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent>::array(
-  const array<T, lak::dynamic_extent> &other)
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC>::array(
+  const array<T, lak::dynamic_extent, ALLOC> &other)
 requires lak::array_type_is_copyable<T>
+: _data(other.get_allocator())
 {
+	_data.set_growth(other.growth());
 	_data.resize(other.size());
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 	if constexpr (!lak::concepts::copy_constructible<T>)
@@ -260,9 +329,10 @@ requires lak::array_type_is_copyable<T>
 			new (data() + i) T(other[i]);
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent> &lak::array<T, lak::dynamic_extent>::
-operator=(const array<T, lak::dynamic_extent> &other)
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC> &
+lak::array<T, lak::dynamic_extent, ALLOC>::operator=(
+  const array<T, lak::dynamic_extent, ALLOC> &other)
 requires lak::array_type_is_copyable<T>
 {
 	clear();
@@ -277,26 +347,28 @@ requires lak::array_type_is_copyable<T>
 	return *this;
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent>::array(
-  array<T, lak::dynamic_extent> &&other)
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC>::array(
+  array<T, lak::dynamic_extent, ALLOC> &&other)
 : _data(lak::move(other._data))
 {
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent> &lak::array<T, lak::dynamic_extent>::
-operator=(array<T, lak::dynamic_extent> &&other)
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC> &
+lak::array<T, lak::dynamic_extent, ALLOC>::operator=(
+  array<T, lak::dynamic_extent, ALLOC> &&other)
 {
 	lak::swap(_data, other._data);
 	return *this;
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent>::array(std::initializer_list<T> list)
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC>::array(std::initializer_list<T> list,
+                                                 lak::source_location site)
 requires lak::array_type_is_copyable<T>
 {
-	_data.resize(list.size());
+	_data.resize(list.size(), site);
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 	if constexpr (!lak::concepts::copy_constructible<T>)
 		ASSERT_UNREACHABLE();
@@ -306,12 +378,14 @@ requires lak::array_type_is_copyable<T>
 			new (data() + i) T(list.begin()[i]);
 }
 
-template<typename T>
+template<typename T, typename ALLOC>
 template<typename ITER>
 requires lak::array_type_is_copyable<T>
-lak::array<T, lak::dynamic_extent>::array(ITER &&begin, ITER &&end)
+lak::array<T, lak::dynamic_extent, ALLOC>::array(ITER &&begin,
+                                                 ITER &&end,
+                                                 lak::source_location site)
 {
-	_data.resize(end - begin);
+	_data.resize(end - begin, site);
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 	if constexpr (!lak::concepts::copy_constructible<T>)
 		ASSERT_UNREACHABLE();
@@ -320,18 +394,19 @@ lak::array<T, lak::dynamic_extent>::array(ITER &&begin, ITER &&end)
 		for (size_t i = 0; begin != end; ++begin, ++i) new (data() + i) T(*begin);
 }
 
-template<typename T>
-lak::array<T, lak::dynamic_extent>::array::~array()
+template<typename T, typename ALLOC>
+lak::array<T, lak::dynamic_extent, ALLOC>::array::~array()
 {
 	force_clear();
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::resize(size_t new_size)
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::resize(
+  size_t new_size, lak::source_location site)
 {
 	if (const size_t old_size{size()}; new_size > old_size)
 	{
-		resize_impl(new_size);
+		resize_impl(new_size, site);
 		if constexpr (!std::is_trivially_default_constructible_v<T>)
 			for (T *it : lak::pointer_range(begin() + old_size, end())) new (it) T();
 	}
@@ -344,14 +419,14 @@ void lak::array<T, lak::dynamic_extent>::resize(size_t new_size)
 	}
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::resize(size_t new_size,
-                                                const T &default_value)
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::resize(
+  size_t new_size, const T &default_value, lak::source_location site)
 requires lak::array_type_is_copyable<T>
 {
 	if (const size_t old_size{size()}; new_size > old_size)
 	{
-		resize_impl(new_size);
+		resize_impl(new_size, site);
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 		if constexpr (!lak::concepts::copy_constructible<T>)
 			ASSERT_UNREACHABLE();
@@ -369,43 +444,43 @@ requires lak::array_type_is_copyable<T>
 	}
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::reserve(size_t new_capacity)
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::reserve(
+  size_t new_capacity, lak::source_location site)
 {
-	if (auto old{_data.reserve(new_capacity)}; old)
-		for (size_t i : lak::size_range_count(old->size()))
-			lak::destructive_move_construct(old->data() + i, _data.data() + i);
+	if (auto old{_data.reserve(new_capacity, site)}; old)
+		lak::relocate(old->data(), _data.data(), old->size());
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::clear()
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::clear()
 {
 	if constexpr (!std::is_trivially_destructible_v<T>)
 		for (auto &e : *this) e.~T();
 	_data.clear();
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::force_clear()
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::force_clear()
 {
 	if constexpr (!std::is_trivially_destructible_v<T>)
 		for (auto &e : *this) e.~T();
 	[[maybe_unused]] auto old{_data.force_clear()};
 }
 
-template<typename T>
+template<typename T, typename ALLOC>
 template<typename... ARGS>
-typename lak::array<T, lak::dynamic_extent>::reference
-lak::array<T, lak::dynamic_extent>::emplace_front(ARGS &&...args)
+typename lak::array<T, lak::dynamic_extent, ALLOC>::reference
+lak::array<T, lak::dynamic_extent, ALLOC>::emplace_front(ARGS &&...args)
 {
 	right_shift(1U);
 	new (data()) T(lak::forward<ARGS>(args)...);
 	return front();
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::reference
-lak::array<T, lak::dynamic_extent>::push_front(const T &t)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::reference
+lak::array<T, lak::dynamic_extent, ALLOC>::push_front(const T &t)
 requires lak::array_type_is_copyable<T>
 {
 	right_shift(1U);
@@ -418,51 +493,48 @@ requires lak::array_type_is_copyable<T>
 	return front();
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::reference
-lak::array<T, lak::dynamic_extent>::push_front(T &&t)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::reference
+lak::array<T, lak::dynamic_extent, ALLOC>::push_front(T &&t)
 {
 	right_shift(1U);
 	new (data()) T(lak::move(t));
 	return front();
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::pop_front()
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::pop_front()
 {
 	ASSERT_GREATER(size(), 0U);
-	lak::shift_left(lak::span(_data), 1U);
-	if constexpr (!std::is_trivially_destructible_v<T>) back().~T();
-	if (_data.resize(size() - 1U)) ASSERT_UNREACHABLE();
+	erase(cbegin());
 }
 
-template<typename T>
-T lak::array<T, lak::dynamic_extent>::popped_front()
+template<typename T, typename ALLOC>
+T lak::array<T, lak::dynamic_extent, ALLOC>::popped_front()
 {
 	ASSERT_GREATER(size(), 0U);
 	T result = lak::move(front());
-	lak::shift_left(lak::span(_data), 1U);
-	if constexpr (!std::is_trivially_destructible_v<T>) back().~T();
-	if (_data.resize(size() - 1U)) ASSERT_UNREACHABLE();
+	erase(cbegin());
 	return result;
 }
 
-template<typename T>
+template<typename T, typename ALLOC>
 template<typename... ARGS>
-typename lak::array<T, lak::dynamic_extent>::reference
-lak::array<T, lak::dynamic_extent>::emplace_back(ARGS &&...args)
+typename lak::array<T, lak::dynamic_extent, ALLOC>::reference
+lak::array<T, lak::dynamic_extent, ALLOC>::emplace_back(ARGS &&...args)
 {
 	resize_impl(size() + 1U);
 	new (data() + size() - 1U) T(lak::forward<ARGS>(args)...);
 	return back();
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::reference
-lak::array<T, lak::dynamic_extent>::push_back(const T &t)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::reference
+lak::array<T, lak::dynamic_extent, ALLOC>::push_back(const T &t,
+                                                     lak::source_location site)
 requires lak::array_type_is_copyable<T>
 {
-	resize_impl(size() + 1U);
+	resize_impl(size() + 1U, site);
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 	if constexpr (!lak::concepts::copy_constructible<T>)
 		ASSERT_UNREACHABLE();
@@ -472,25 +544,26 @@ requires lak::array_type_is_copyable<T>
 	return back();
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::reference
-lak::array<T, lak::dynamic_extent>::push_back(T &&t)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::reference
+lak::array<T, lak::dynamic_extent, ALLOC>::push_back(T &&t,
+                                                     lak::source_location site)
 {
-	resize_impl(size() + 1U);
+	resize_impl(size() + 1U, site);
 	new (data() + size() - 1U) T(lak::move(t));
 	return back();
 }
 
-template<typename T>
-void lak::array<T, lak::dynamic_extent>::pop_back()
+template<typename T, typename ALLOC>
+void lak::array<T, lak::dynamic_extent, ALLOC>::pop_back()
 {
 	ASSERT_GREATER(size(), 0U);
 	if constexpr (!std::is_trivially_destructible_v<T>) back().~T();
 	if (_data.resize(size() - 1U)) ASSERT_UNREACHABLE();
 }
 
-template<typename T>
-T lak::array<T, lak::dynamic_extent>::popped_back()
+template<typename T, typename ALLOC>
+T lak::array<T, lak::dynamic_extent, ALLOC>::popped_back()
 {
 	ASSERT_GREATER(size(), 0U);
 	T result = lak::move(back());
@@ -499,10 +572,10 @@ T lak::array<T, lak::dynamic_extent>::popped_back()
 	return result;
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::iterator
-lak::array<T, lak::dynamic_extent>::insert(const_iterator before,
-                                           const T &value)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::iterator
+lak::array<T, lak::dynamic_extent, ALLOC>::insert(const_iterator before,
+                                                  const T &value)
 requires lak::array_type_is_copyable<T>
 {
 	ASSERT_GREATER_OR_EQUAL(before, cbegin());
@@ -522,9 +595,10 @@ requires lak::array_type_is_copyable<T>
 	return data() + index;
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::iterator
-lak::array<T, lak::dynamic_extent>::insert(const_iterator before, T &&value)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::iterator
+lak::array<T, lak::dynamic_extent, ALLOC>::insert(const_iterator before,
+                                                  T &&value)
 {
 	ASSERT_GREATER_OR_EQUAL(before, cbegin());
 	ASSERT_LESS_OR_EQUAL(before, cend());
@@ -538,10 +612,10 @@ lak::array<T, lak::dynamic_extent>::insert(const_iterator before, T &&value)
 	return data() + index;
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::iterator
-lak::array<T, lak::dynamic_extent>::insert(const_iterator before,
-                                           std::initializer_list<T> values)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::iterator
+lak::array<T, lak::dynamic_extent, ALLOC>::insert(
+  const_iterator before, std::initializer_list<T> values)
 requires lak::array_type_is_copyable<T>
 {
 	ASSERT_GREATER_OR_EQUAL(before, cbegin());
@@ -562,10 +636,10 @@ requires lak::array_type_is_copyable<T>
 	return data() + index;
 }
 
-template<typename T>
-typename lak::array<T, lak::dynamic_extent>::iterator
-lak::array<T, lak::dynamic_extent>::erase(const_iterator first,
-                                          const_iterator last)
+template<typename T, typename ALLOC>
+typename lak::array<T, lak::dynamic_extent, ALLOC>::iterator
+lak::array<T, lak::dynamic_extent, ALLOC>::erase(const_iterator first,
+                                                 const_iterator last)
 {
 	ASSERT_GREATER_OR_EQUAL(first, cbegin());
 	ASSERT_LESS_OR_EQUAL(first, cend());
@@ -579,15 +653,26 @@ lak::array<T, lak::dynamic_extent>::erase(const_iterator first,
 
 	if (length == 0) return begin() + index;
 
-	lak::shift_left(lak::split(lak::span(_data), first).second, length);
-
-	resize(size() - length);
+	if constexpr (lak::is_trivially_relocatable_v<T>)
+	{
+		T *erased{begin() + index};
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for (T *it : lak::pointer_range(erased, erased + length)) it->~T();
+		lak::relocate(erased + length, erased, size() - index - length);
+		if (_data.resize(size() - length)) ASSERT_UNREACHABLE();
+	}
+	else
+	{
+		lak::shift_left(lak::split(lak::span(_data), first).second, length);
+		resize(size() - length);
+	}
 
 	return begin() + index;
 }
 
-template<typename T, size_t S>
-bool operator==(const lak::array<T, S> &a, const lak::array<T, S> &b)
+template<typename T, size_t S, typename ALLOC>
+bool operator==(const lak::array<T, S, ALLOC> &a,
+                const lak::array<T, S, ALLOC> &b)
 {
 	if (a.size() != b.size()) return false;
 	for (size_t i = 0; i < a.size(); ++i)
@@ -595,8 +680,9 @@ bool operator==(const lak::array<T, S> &a, const lak::array<T, S> &b)
 	return true;
 }
 
-template<typename T, size_t S>
-bool operator!=(const lak::array<T, S> &a, const lak::array<T, S> &b)
+template<typename T, size_t S, typename ALLOC>
+bool operator!=(const lak::array<T, S, ALLOC> &a,
+                const lak::array<T, S, ALLOC> &b)
 {
 	return !(a == b);
 }
@@ -721,3 +807,475 @@ T lak::stack_array<T, MAX_SIZE>::popped_back()
 	--_size;
 	return result;
 }
+
+/* --- small_array --- */
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::set_size(size_t new_size)
+{
+	ASSERT_LESS_OR_EQUAL(new_size, capacity());
+	if (is_inline())
+		_size = new_size;
+	else if (_heap.resize(new_size))
+		ASSERT_UNREACHABLE();
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::relocate(size_t new_capacity,
+                                             size_t count,
+                                             size_t before)
+{
+	const size_t old_size{size()};
+	ASSERT_GREATER_OR_EQUAL(new_capacity, old_size + count);
+
+	heap_type heap{_heap.get_allocator()};
+	heap.set_growth(lak::array_growth::exact());
+	[[maybe_unused]] auto old{heap.reserve(new_capacity)};
+	heap.set_growth(_heap.growth());
+	if (heap.resize(old_size + count)) ASSERT_UNREACHABLE();
+
+	lak::relocate(data(), heap.data(), before);
+	lak::relocate(
+	  data() + before, heap.data() + before + count, old_size - before);
+
+	// the old spilled storage (if any) is released with heap
+	lak::swap(_heap, heap);
+	_size = 0U;
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::right_shift(size_t count, size_t before)
+{
+	if (count == 0) return;
+
+	const size_t old_size{size()};
+
+	if (old_size + count > capacity())
+	{
+		relocate(_heap.growth().next_capacity(
+		           capacity(), old_size + count, sizeof(T)),
+		         count,
+		         before);
+	}
+	else
+	{
+		set_size(old_size + count);
+		lak::relocate(data() + before, data() + before + count, old_size - before);
+	}
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::resize_impl(size_t new_size)
+{
+	if (const size_t old_size{size()}; new_size > old_size)
+		right_shift(new_size - old_size, old_size);
+	else
+		set_size(new_size);
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::steal(small_array &other)
+{
+	ASSERT(is_inline());
+	ASSERT_EQUAL(_size, 0U);
+
+	if (other.is_inline())
+	{
+		_heap.set_growth(other.growth());
+		lak::relocate(other.data(), data(), other._size);
+		_size = lak::exchange(other._size, 0U);
+	}
+	else
+	{
+		lak::swap(_heap, other._heap);
+	}
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC>::small_array(const small_array &other)
+requires lak::array_type_is_copyable<T>
+: _heap(other.get_allocator())
+{
+	_heap.set_growth(other.growth());
+	resize_impl(other.size());
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		for (size_t i : lak::size_range_count(other.size()))
+			new (data() + i) T(other[i]);
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC> &lak::small_array<T, N, ALLOC>::operator=(
+  const small_array &other)
+requires lak::array_type_is_copyable<T>
+{
+	if (this == &other) return *this;
+	clear();
+	resize_impl(other.size());
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		for (size_t i : lak::size_range_count(other.size()))
+			new (data() + i) T(other[i]);
+	return *this;
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC>::small_array(small_array &&other)
+: _heap(other.get_allocator())
+{
+	steal(other);
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC> &lak::small_array<T, N, ALLOC>::operator=(
+  small_array &&other)
+{
+	if (this == &other) return *this;
+	force_clear();
+	steal(other);
+	return *this;
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC>::small_array(size_t initial_size)
+: small_array()
+{
+	resize(initial_size);
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC>::small_array(std::initializer_list<T> list)
+requires lak::array_type_is_copyable<T>
+{
+	resize_impl(list.size());
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		for (size_t i : lak::size_range_count(list.size()))
+			new (data() + i) T(list.begin()[i]);
+}
+
+template<typename T, size_t N, typename ALLOC>
+template<typename ITER>
+requires lak::array_type_is_copyable<T>
+lak::small_array<T, N, ALLOC>::small_array(ITER &&begin, ITER &&end)
+{
+	resize_impl(end - begin);
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		for (size_t i = 0; begin != end; ++begin, ++i) new (data() + i) T(*begin);
+}
+
+template<typename T, size_t N, typename ALLOC>
+lak::small_array<T, N, ALLOC>::~small_array()
+{
+	force_clear();
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::resize(size_t new_size)
+{
+	if (const size_t old_size{size()}; new_size > old_size)
+	{
+		resize_impl(new_size);
+		if constexpr (!std::is_trivially_default_constructible_v<T>)
+			for (T *it : lak::pointer_range(begin() + old_size, end())) new (it) T();
+	}
+	else if (new_size < old_size)
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for (T *it : lak::pointer_range(begin() + new_size, end())) it->~T();
+
+		set_size(new_size);
+	}
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::resize(size_t new_size,
+                                           const T &default_value)
+requires lak::array_type_is_copyable<T>
+{
+	if (const size_t old_size{size()}; new_size > old_size)
+	{
+		resize_impl(new_size);
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+		if constexpr (!lak::concepts::copy_constructible<T>)
+			ASSERT_UNREACHABLE();
+		else
+#endif
+			for (T *it : lak::pointer_range(begin() + old_size, end()))
+				new (it) T(default_value);
+	}
+	else if (new_size < old_size)
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for (T *it : lak::pointer_range(begin() + new_size, end())) it->~T();
+
+		set_size(new_size);
+	}
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::reserve(size_t new_capacity)
+{
+	if (new_capacity > capacity()) relocate(new_capacity, 0U, size());
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::clear()
+{
+	if constexpr (!std::is_trivially_destructible_v<T>)
+		for (auto &e : *this) e.~T();
+	set_size(0U);
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::force_clear()
+{
+	if constexpr (!std::is_trivially_destructible_v<T>)
+		for (auto &e : *this) e.~T();
+	[[maybe_unused]] auto old{_heap.force_clear()};
+	_size = 0U;
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::at(size_t index)
+{
+	ASSERT_LESS(index, size());
+	return data()[index];
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::const_reference
+lak::small_array<T, N, ALLOC>::at(size_t index) const
+{
+	ASSERT_LESS(index, size());
+	return data()[index];
+}
+
+template<typename T, size_t N, typename ALLOC>
+template<typename... ARGS>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::emplace_front(ARGS &&...args)
+{
+	right_shift(1U);
+	new (data()) T(lak::forward<ARGS>(args)...);
+	return front();
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::push_front(const T &t)
+requires lak::array_type_is_copyable<T>
+{
+	right_shift(1U);
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		new (data()) T(t);
+	return front();
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::push_front(T &&t)
+{
+	right_shift(1U);
+	new (data()) T(lak::move(t));
+	return front();
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::pop_front()
+{
+	ASSERT_GREATER(size(), 0U);
+	erase(cbegin());
+}
+
+template<typename T, size_t N, typename ALLOC>
+T lak::small_array<T, N, ALLOC>::popped_front()
+{
+	ASSERT_GREATER(size(), 0U);
+	T result = lak::move(front());
+	erase(cbegin());
+	return result;
+}
+
+template<typename T, size_t N, typename ALLOC>
+template<typename... ARGS>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::emplace_back(ARGS &&...args)
+{
+	resize_impl(size() + 1U);
+	new (data() + size() - 1U) T(lak::forward<ARGS>(args)...);
+	return back();
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::push_back(const T &t)
+requires lak::array_type_is_copyable<T>
+{
+	resize_impl(size() + 1U);
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		new (data() + size() - 1U) T(t);
+	return back();
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::reference
+lak::small_array<T, N, ALLOC>::push_back(T &&t)
+{
+	resize_impl(size() + 1U);
+	new (data() + size() - 1U) T(lak::move(t));
+	return back();
+}
+
+template<typename T, size_t N, typename ALLOC>
+void lak::small_array<T, N, ALLOC>::pop_back()
+{
+	ASSERT_GREATER(size(), 0U);
+	if constexpr (!std::is_trivially_destructible_v<T>) back().~T();
+	set_size(size() - 1U);
+}
+
+template<typename T, size_t N, typename ALLOC>
+T lak::small_array<T, N, ALLOC>::popped_back()
+{
+	ASSERT_GREATER(size(), 0U);
+	T result = lak::move(back());
+	if constexpr (!std::is_trivially_destructible_v<T>) back().~T();
+	set_size(size() - 1U);
+	return result;
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::iterator
+lak::small_array<T, N, ALLOC>::insert(const_iterator before, const T &value)
+requires lak::array_type_is_copyable<T>
+{
+	ASSERT_GREATER_OR_EQUAL(before, cbegin());
+	ASSERT_LESS_OR_EQUAL(before, cend());
+
+	const size_t index = before - data();
+
+	right_shift(1U, index);
+
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		new (data() + index) T(value);
+
+	return data() + index;
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::iterator
+lak::small_array<T, N, ALLOC>::insert(const_iterator before, T &&value)
+{
+	ASSERT_GREATER_OR_EQUAL(before, cbegin());
+	ASSERT_LESS_OR_EQUAL(before, cend());
+
+	const size_t index = before - data();
+
+	right_shift(1U, index);
+
+	new (data() + index) T(lak::move(value));
+
+	return data() + index;
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::iterator
+lak::small_array<T, N, ALLOC>::insert(const_iterator before,
+                                      std::initializer_list<T> values)
+requires lak::array_type_is_copyable<T>
+{
+	ASSERT_GREATER_OR_EQUAL(before, cbegin());
+	ASSERT_LESS_OR_EQUAL(before, cend());
+
+	const size_t index = before - data();
+
+	right_shift(values.size(), index);
+
+#if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
+	if constexpr (!lak::concepts::copy_constructible<T>)
+		ASSERT_UNREACHABLE();
+	else
+#endif
+		for (T *it = data() + index; const auto &value : values)
+			new (it++) T(value);
+
+	return data() + index;
+}
+
+template<typename T, size_t N, typename ALLOC>
+typename lak::small_array<T, N, ALLOC>::iterator
+lak::small_array<T, N, ALLOC>::erase(const_iterator first,
+                                     const_iterator last)
+{
+	ASSERT_GREATER_OR_EQUAL(first, cbegin());
+	ASSERT_LESS_OR_EQUAL(first, cend());
+	ASSERT_GREATER_OR_EQUAL(last, cbegin());
+	ASSERT_LESS_OR_EQUAL(last, cend());
+
+	const size_t index  = first - cbegin();
+	const size_t length = last - first;
+
+	ASSERT_LESS_OR_EQUAL(index + length, size());
+
+	if (length == 0) return begin() + index;
+
+	if constexpr (lak::is_trivially_relocatable_v<T>)
+	{
+		T *erased{begin() + index};
+		if constexpr (!std::is_trivially_destructible_v<T>)
+			for (T *it : lak::pointer_range(erased, erased + length)) it->~T();
+		lak::relocate(erased + length, erased, size() - index - length);
+		set_size(size() - length);
+	}
+	else
+	{
+		lak::shift_left(lak::span<T>(data(), size()).subspan(index), length);
+		resize(size() - length);
+	}
+
+	return begin() + index;
+}
+
+template<typename T, size_t N, typename ALLOC>
+bool operator==(const lak::small_array<T, N, ALLOC> &a,
+                const lak::small_array<T, N, ALLOC> &b)
+{
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); ++i)
+		if (lak::not_equal_to<T>{}(a[i], b[i])) return false;
+	return true;
+}
+
+template<typename T, size_t N, typename ALLOC>
+bool operator!=(const lak::small_array<T, N, ALLOC> &a,
+                const lak::small_array<T, N, ALLOC> &b)
+{
+	return !(a == b);
+}
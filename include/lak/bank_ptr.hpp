@@ -2,15 +2,33 @@
 #define LAK_BANK_PTR_HPP
 
 #include "lak/array.hpp"
-#include "lak/railcar.hpp"
+#include "lak/object_pool.hpp"
+#include "lak/slot_map.hpp"
 
 #ifdef LAK_NO_STD
 #	error STL required
 #endif
 #include <mutex>
+#include <new>
 
 namespace lak
 {
+	// kept outside of bank so bank<T> can be instantiated with an incomplete T
+	template<typename T>
+	struct _bank_node
+	{
+		// first so a T * is also a pointer to its node
+		alignas(T) byte_t value[sizeof(T)];
+		lak::slot_handle handle;
+		// only used by shared_bank_ptr
+		size_t reference_count;
+
+		T *get() { return std::launder(reinterpret_cast<T *>(value)); }
+	};
+
+	// Objects are allocated from an lak::object_pool, the bank maps
+	// generational handles to them so handles to destroyed objects can be
+	// detected. Creating, destroying and looking up objects is O(1).
 	template<typename T>
 	struct bank
 	{
@@ -20,24 +38,30 @@ namespace lak
 		template<typename U>
 		friend struct unique_bank_ptr;
 
+		using node = lak::_bank_node<T>;
+
 		static std::mutex _mutex;
-		static lak::railcar<T> _container;
-		static lak::array<size_t> _deleted;
+		static lak::slot_map<node *> _container;
 
-		static void internal_flush();
+		[[nodiscard]] static node *internal_node(T *ptr);
 
-		[[nodiscard]] static size_t internal_find_index(T *ptr);
+		[[nodiscard]] static lak::slot_handle internal_find_handle(T *ptr);
+
+		[[nodiscard]] static node *internal_get(lak::slot_handle handle);
 
 		template<typename... ARGS>
-		[[nodiscard]] static size_t internal_create(ARGS &&...args);
+		[[nodiscard]] static lak::slot_handle internal_create(ARGS &&...args);
 
-		static void internal_destroy(size_t index);
+		static void internal_destroy(lak::slot_handle handle);
 
 		template<typename FUNCTOR>
-		[[nodiscard]] static size_t internal_find_if(FUNCTOR &&func);
+		[[nodiscard]] static lak::slot_handle internal_find_if(FUNCTOR &&func);
 
 	public:
-		static void flush();
+		// destroyed handles are released immediately, this does nothing
+		static void flush() {}
+
+		[[nodiscard]] static size_t size();
 
 		[[nodiscard]] static T *create(const T &t);
 
@@ -48,6 +72,11 @@ namespace lak
 
 		static void destroy(T *t);
 
+		// nullptr if the object has been destroyed
+		[[nodiscard]] static T *get(lak::slot_handle handle);
+
+		[[nodiscard]] static lak::slot_handle handle_of(T *t);
+
 		template<typename FUNCTOR>
 		static void for_each(FUNCTOR &&func);
 
@@ -62,19 +91,18 @@ namespace lak
 		template<typename U>
 		friend struct shared_bank_ptr;
 
-		size_t _index; // not thread safe!
+		lak::slot_handle _handle; // not thread safe!
 		T *_value;
 
-		unique_bank_ptr(size_t index) : _index(index)
+		unique_bank_ptr(lak::slot_handle handle) : _handle(handle)
 		{
-			_value = _index == std::numeric_limits<size_t>::max()
-			           ? nullptr
-			           : &bank<T>::_container[index];
+			_value = _handle ? bank<T>::internal_get(_handle)->get() : nullptr;
 		}
 
 	public:
 		using bank<T>::flush;
 		using bank<T>::for_each;
+		using bank<T>::size;
 
 		[[nodiscard]] static unique_bank_ptr create(const T &t);
 
@@ -102,6 +130,8 @@ namespace lak
 
 		T *release();
 
+		lak::slot_handle handle() const { return _handle; }
+
 		T *get();
 		const T *get() const;
 
@@ -131,19 +161,18 @@ namespace lak
 		template<typename U>
 		friend struct unique_bank_ptr;
 
-		static lak::railcar<size_t> _reference_count;
-
-		shared_bank_ptr(size_t index) : unique_bank_ptr<T>(index) {}
+		shared_bank_ptr(lak::slot_handle handle) : unique_bank_ptr<T>(handle) {}
 
 	public:
+		using bank<T>::flush;
 		using bank<T>::for_each;
+		using bank<T>::size;
 		using unique_bank_ptr<T>::get;
+		using unique_bank_ptr<T>::handle;
 		using unique_bank_ptr<T>::operator->;
 		using unique_bank_ptr<T>::operator*;
 		using unique_bank_ptr<T>::operator bool;
 
-		static void flush();
-
 		[[nodiscard]] static shared_bank_ptr create(const T &t);
 
 		[[nodiscard]] static shared_bank_ptr create(T &&t);
@@ -183,11 +212,7 @@ namespace lak
 	template<typename T>
 	std::mutex lak::bank<T>::_mutex;
 	template<typename T>
-	lak::railcar<T> lak::bank<T>::_container;
-	template<typename T>
-	lak::array<size_t> lak::bank<T>::_deleted;
-	template<typename T>
-	lak::railcar<size_t> lak::shared_bank_ptr<T>::_reference_count;
+	lak::slot_map<lak::_bank_node<T> *> lak::bank<T>::_container;
 }
 
 #include "bank_ptr.inl"
@@ -1,113 +1,88 @@
 #include "lak/utility.hpp"
 
-#ifdef LAK_NO_STD
-#	error Requires std::sort
-#endif
-
-#include <algorithm>
-
 /* --- lak::bank<T> --- */
 
 template<typename T>
-void lak::bank<T>::internal_flush()
+typename lak::bank<T>::node *lak::bank<T>::internal_node(T *ptr)
 {
-	if (_deleted.empty()) return;
-	std::sort(_deleted.begin(), _deleted.end(), std::greater<size_t>{});
-	size_t destroyed = 0;
-	while (destroyed < _deleted.size() &&
-	       _deleted[destroyed] == _container.size() - 1)
-	{
-		_container.pop_back();
-		++destroyed;
-	}
-	_deleted.erase(_deleted.begin(), _deleted.begin() + destroyed);
+	return reinterpret_cast<node *>(ptr);
 }
 
 template<typename T>
-size_t lak::bank<T>::internal_find_index(T *ptr)
+lak::slot_handle lak::bank<T>::internal_find_handle(T *ptr)
 {
-	if (!ptr) return std::numeric_limits<size_t>::max();
+	if (!ptr) return {};
+	const lak::slot_handle handle{internal_node(ptr)->handle};
+	ASSERT(_container.contains(handle));
+	return handle;
+}
 
-	auto it = std::lower_bound(_container.begin(),
-	                           _container.end(),
-	                           ptr,
-	                           [](const T &a, const T *b) { return &a < b; });
-	ASSERT(it != _container.end());
-	return std::distance(_container.begin(), it);
+template<typename T>
+typename lak::bank<T>::node *lak::bank<T>::internal_get(
+  lak::slot_handle handle)
+{
+	node **result{_container.get(handle)};
+	return result ? *result : nullptr;
 }
 
 template<typename T>
 template<typename... ARGS>
-size_t lak::bank<T>::internal_create(ARGS &&...args)
+lak::slot_handle lak::bank<T>::internal_create(ARGS &&...args)
 {
-	if (_deleted.size() > 0)
+	node *n{new (lak::object_pool<node>::allocate()) node};
+	try
 	{
-		auto index = _deleted.back();
-		_deleted.pop_back();
-		_container[index].~T();
-		new (&_container[index]) T(lak::forward<ARGS>(args)...);
-		return index;
+		new (n->value) T(lak::forward<ARGS>(args)...);
 	}
-	else
+	catch (...)
 	{
-		_container.emplace_back(lak::forward<ARGS>(args)...);
-		return _container.size() - 1;
+		lak::object_pool<node>::free(n);
+		throw;
 	}
+	n->handle          = _container.insert(n);
+	n->reference_count = 0U;
+	return n->handle;
 }
 
 template<typename T>
-void lak::bank<T>::internal_destroy(size_t index)
+void lak::bank<T>::internal_destroy(lak::slot_handle handle)
 {
-	ASSERT_GREATER(_container.size(), index);
-	_deleted.push_back(index);
-	internal_flush();
+	node *n{internal_get(handle)};
+	ASSERT(n);
+	_container.erase(handle);
+	n->get()->~T();
+	lak::object_pool<node>::free(n);
 }
 
 template<typename T>
 template<typename FUNCTOR>
-size_t lak::bank<T>::internal_find_if(FUNCTOR &&func)
+lak::slot_handle lak::bank<T>::internal_find_if(FUNCTOR &&func)
 {
-	for (size_t del_index = 0, i = 0; i < _container.size(); ++i)
-	{
-		if (del_index < _deleted.size())
-		{
-			ASSERT_GREATER_OR_EQUAL(_deleted[del_index], i);
-			if (i == _deleted[del_index])
-			{
-				++del_index;
-				continue;
-			}
-		}
-
-		if (func(_container[i])) return i;
-	}
+	for (node *n : _container)
+		if (func(*n->get())) return n->handle;
 
-	return std::numeric_limits<size_t>::max();
+	return {};
 }
 
 template<typename T>
-void lak::bank<T>::flush()
+size_t lak::bank<T>::size()
 {
 	std::lock_guard lock(_mutex);
-	internal_flush();
+	return _container.size();
 }
 
 template<typename T>
 T *lak::bank<T>::create(const T &t)
 {
 	std::lock_guard lock(_mutex);
-	auto result = internal_create(t);
-	return result != std::numeric_limits<size_t>::max() ? &_container[result]
-	                                                    : nullptr;
+	return internal_get(internal_create(t))->get();
 }
 
 template<typename T>
 T *lak::bank<T>::create(T &&t)
 {
 	std::lock_guard lock(_mutex);
-	auto result = internal_create(lak::move(t));
-	return result != std::numeric_limits<size_t>::max() ? &_container[result]
-	                                                    : nullptr;
+	return internal_get(internal_create(lak::move(t)))->get();
 }
 
 template<typename T>
@@ -115,21 +90,30 @@ template<typename... ARGS>
 T *lak::bank<T>::create(ARGS &&...args)
 {
 	std::lock_guard lock(_mutex);
-	auto result = internal_create(lak::forward<ARGS>(args)...);
-	return result != std::numeric_limits<size_t>::max() ? &_container[result]
-	                                                    : nullptr;
+	return internal_get(internal_create(lak::forward<ARGS>(args)...))->get();
 }
 
 template<typename T>
 void lak::bank<T>::destroy(T *t)
 {
+	if (!t) return;
 	std::lock_guard lock(_mutex);
-	auto it = std::lower_bound(_container.begin(),
-	                           _container.end(),
-	                           t,
-	                           [](const T &a, const T *b) { return &a < b; });
-	ASSERT(it != _container.end());
-	internal_destroy(std::distance(_container.begin(), it));
+	internal_destroy(internal_find_handle(t));
+}
+
+template<typename T>
+T *lak::bank<T>::get(lak::slot_handle handle)
+{
+	std::lock_guard lock(_mutex);
+	node *n{internal_get(handle)};
+	return n ? n->get() : nullptr;
+}
+
+template<typename T>
+lak::slot_handle lak::bank<T>::handle_of(T *t)
+{
+	std::lock_guard lock(_mutex);
+	return internal_find_handle(t);
 }
 
 template<typename T>
@@ -137,18 +121,7 @@ template<typename FUNCTOR>
 void lak::bank<T>::for_each(FUNCTOR &&func)
 {
 	std::lock_guard lock(_mutex);
-	for (size_t del_index = 0, i = 0; i < _container.size(); ++i)
-	{
-		ASSERT_GREATER_OR_EQUAL(_deleted[del_index], i);
-		if (i < _deleted[del_index])
-		{
-			func(_container[i]);
-		}
-		else
-		{
-			++del_index;
-		}
-	}
+	for (node *n : _container) func(*n->get());
 }
 
 template<typename T>
@@ -156,9 +129,8 @@ template<typename FUNCTOR>
 T *lak::bank<T>::find_if(FUNCTOR &&func)
 {
 	std::lock_guard lock(_mutex);
-	auto result = internal_find_if(lak::forward<FUNCTOR>(func));
-	return result != std::numeric_limits<size_t>::max() ? &_container[result]
-	                                                    : nullptr;
+	node *n{internal_get(internal_find_if(lak::forward<FUNCTOR>(func)))};
+	return n ? n->get() : nullptr;
 }
 
 /* --- lak::unique_bank_ptr<T> --- */
@@ -190,14 +162,12 @@ lak::unique_bank_ptr<T> lak::unique_bank_ptr<T>::from_raw_bank_ptr(T *ptr)
 {
 	if (!ptr) return {};
 	std::lock_guard lock(bank<T>::_mutex);
-	ASSERT_GREATER_OR_EQUAL(ptr, &bank<T>::_container.front());
-	ASSERT_GREATER_OR_EQUAL(&bank<T>::_container.back(), ptr);
-	return {bank<T>::internal_find_index(ptr)};
+	return {bank<T>::internal_find_handle(ptr)};
 }
 
 template<typename T>
 lak::unique_bank_ptr<T>::unique_bank_ptr()
-: unique_bank_ptr(std::numeric_limits<size_t>::max())
+: unique_bank_ptr(lak::slot_handle{})
 {
 }
 
@@ -212,7 +182,7 @@ template<typename T>
 lak::unique_bank_ptr<T>::unique_bank_ptr(unique_bank_ptr &&other)
 : unique_bank_ptr()
 {
-	std::swap(_index, other._index);
+	std::swap(_handle, other._handle);
 	std::swap(_value, other._value);
 };
 
@@ -220,7 +190,7 @@ template<typename T>
 lak::unique_bank_ptr<T> &lak::unique_bank_ptr<T>::operator=(
   unique_bank_ptr &&other)
 {
-	std::swap(_index, other._index);
+	std::swap(_handle, other._handle);
 	std::swap(_value, other._value);
 	return *this;
 };
@@ -236,23 +206,16 @@ void lak::unique_bank_ptr<T>::reset()
 {
 	if (!*this) return;
 	std::lock_guard lock(bank<T>::_mutex);
-	if (_index == bank<T>::_container.size() - 1)
-	{
-		bank<T>::_container.pop_back();
-	}
-	else
-	{
-		bank<T>::internal_destroy(_index);
-	}
-	_index = std::numeric_limits<size_t>::max();
-	_value = nullptr;
+	bank<T>::internal_destroy(_handle);
+	_handle = {};
+	_value  = nullptr;
 }
 
 template<typename T>
 T *lak::unique_bank_ptr<T>::release()
 {
 	auto result = _value;
-	_index      = std::numeric_limits<size_t>::max();
+	_handle     = {};
 	_value      = nullptr;
 	return result;
 }
@@ -297,48 +260,48 @@ template<typename T>
 bool lak::unique_bank_ptr<T>::operator<(
   const lak::unique_bank_ptr<T> &rhs) const
 {
-	ASSERT((_index == rhs._index) == (_value == rhs._value));
-	return _index < rhs._index;
+	ASSERT((_handle == rhs._handle) == (_value == rhs._value));
+	return _handle < rhs._handle;
 }
 
 template<typename T>
 bool lak::unique_bank_ptr<T>::operator<=(
   const lak::unique_bank_ptr<T> &rhs) const
 {
-	ASSERT((_index == rhs._index) == (_value == rhs._value));
-	return _index <= rhs._index;
+	ASSERT((_handle == rhs._handle) == (_value == rhs._value));
+	return _handle <= rhs._handle;
 }
 
 template<typename T>
 bool lak::unique_bank_ptr<T>::operator>(
   const lak::unique_bank_ptr<T> &rhs) const
 {
-	ASSERT((_index == rhs._index) == (_value == rhs._value));
-	return _index > rhs._index;
+	ASSERT((_handle == rhs._handle) == (_value == rhs._value));
+	return _handle > rhs._handle;
 }
 
 template<typename T>
 bool lak::unique_bank_ptr<T>::operator>=(
   const lak::unique_bank_ptr<T> &rhs) const
 {
-	ASSERT((_index == rhs._index) == (_value == rhs._value));
-	return _index >= rhs._index;
+	ASSERT((_handle == rhs._handle) == (_value == rhs._value));
+	return _handle >= rhs._handle;
 }
 
 template<typename T>
 bool lak::unique_bank_ptr<T>::operator==(
   const lak::unique_bank_ptr<T> &rhs) const
 {
-	ASSERT((_index == rhs._index) == (_value == rhs._value));
-	return _index == rhs._index;
+	ASSERT((_handle == rhs._handle) == (_value == rhs._value));
+	return _handle == rhs._handle;
 }
 
 template<typename T>
 bool lak::unique_bank_ptr<T>::operator!=(
   const lak::unique_bank_ptr<T> &rhs) const
 {
-	ASSERT((_index == rhs._index) == (_value == rhs._value));
-	return _index != rhs._index;
+	ASSERT((_handle == rhs._handle) == (_value == rhs._value));
+	return _handle != rhs._handle;
 }
 
 template<typename T>
@@ -356,39 +319,28 @@ bool lak::unique_bank_ptr<T>::operator!=(lak::nullptr_t) const
 template<typename T>
 lak::unique_bank_ptr<T>::operator bool() const
 {
-	ASSERT((_index == std::numeric_limits<size_t>::max()) ==
-	       (_value == nullptr));
-	return _index != std::numeric_limits<size_t>::max();
+	ASSERT(!_handle == (_value == nullptr));
+	return bool(_handle);
 }
 
 /* --- lak::shared_bank_ptr<T> --- */
 
-template<typename T>
-void lak::shared_bank_ptr<T>::flush()
-{
-	std::lock_guard lock(bank<T>::_mutex);
-	bank<T>::internal_flush();
-	_reference_count.resize(bank<T>::_container.size());
-}
-
 template<typename T>
 lak::shared_bank_ptr<T> lak::shared_bank_ptr<T>::create(const T &t)
 {
 	std::lock_guard lock(bank<T>::_mutex);
-	auto index = bank<T>::internal_create(t);
-	_reference_count.resize(bank<T>::_container.size());
-	++_reference_count[index];
-	return {index};
+	auto handle = bank<T>::internal_create(t);
+	++bank<T>::internal_get(handle)->reference_count;
+	return {handle};
 }
 
 template<typename T>
 lak::shared_bank_ptr<T> lak::shared_bank_ptr<T>::create(T &&t)
 {
 	std::lock_guard lock(bank<T>::_mutex);
-	auto index = bank<T>::internal_create(lak::move(t));
-	_reference_count.resize(bank<T>::_container.size());
-	++_reference_count[index];
-	return {index};
+	auto handle = bank<T>::internal_create(lak::move(t));
+	++bank<T>::internal_get(handle)->reference_count;
+	return {handle};
 }
 
 template<typename T>
@@ -396,10 +348,9 @@ template<typename... ARGS>
 lak::shared_bank_ptr<T> lak::shared_bank_ptr<T>::create(ARGS &&...args)
 {
 	std::lock_guard lock(bank<T>::_mutex);
-	auto index = bank<T>::internal_create(lak::forward<ARGS>(args)...);
-	_reference_count.resize(bank<T>::_container.size());
-	++_reference_count[index];
-	return {index};
+	auto handle = bank<T>::internal_create(lak::forward<ARGS>(args)...);
+	++bank<T>::internal_get(handle)->reference_count;
+	return {handle};
 }
 
 template<typename T>
@@ -407,10 +358,9 @@ template<typename FUNCTOR>
 lak::shared_bank_ptr<T> lak::shared_bank_ptr<T>::find_if(FUNCTOR &&func)
 {
 	std::lock_guard lock(bank<T>::_mutex);
-	auto result = internal_find_if(lak::forward<FUNCTOR>(func));
-	_reference_count.resize(bank<T>::_container.size());
-	if (result != std::numeric_limits<size_t>::max()) ++_reference_count[result];
-	return {result};
+	auto handle = bank<T>::internal_find_if(lak::forward<FUNCTOR>(func));
+	if (handle) ++bank<T>::internal_get(handle)->reference_count;
+	return {handle};
 }
 
 template<typename T>
@@ -426,27 +376,25 @@ lak::shared_bank_ptr<T>::shared_bank_ptr(const shared_bank_ptr &other)
 	if (other)
 	{
 		std::lock_guard lock(bank<T>::_mutex);
-		unique_bank_ptr<T>::_index = other._index;
-		unique_bank_ptr<T>::_value = other._value;
-		++_reference_count[unique_bank_ptr<T>::_index];
+		unique_bank_ptr<T>::_handle = other._handle;
+		unique_bank_ptr<T>::_value  = other._value;
+		++bank<T>::internal_get(other._handle)->reference_count;
 	}
-	else
-		reset();
 };
 
 template<typename T>
 lak::shared_bank_ptr<T> &lak::shared_bank_ptr<T>::operator=(
   const shared_bank_ptr &other)
 {
+	if (this == &other) return *this;
+	reset();
 	if (other)
 	{
 		std::lock_guard lock(bank<T>::_mutex);
-		unique_bank_ptr<T>::_index = other._index;
-		unique_bank_ptr<T>::_value = other._value;
-		++_reference_count[unique_bank_ptr<T>::_index];
+		unique_bank_ptr<T>::_handle = other._handle;
+		unique_bank_ptr<T>::_value  = other._value;
+		++bank<T>::internal_get(other._handle)->reference_count;
 	}
-	else
-		reset();
 	return *this;
 };
 
@@ -457,27 +405,26 @@ lak::shared_bank_ptr<T>::shared_bank_ptr(unique_bank_ptr<T> &&other)
 	if (other)
 	{
 		std::lock_guard lock(bank<T>::_mutex);
-		std::swap(unique_bank_ptr<T>::_index, other._index);
+		std::swap(unique_bank_ptr<T>::_handle, other._handle);
 		std::swap(unique_bank_ptr<T>::_value, other._value);
-		++_reference_count[unique_bank_ptr<T>::_index];
+		// unique_bank_ptrs don't count references
+		++bank<T>::internal_get(unique_bank_ptr<T>::_handle)->reference_count;
 	}
-	else
-		reset();
 };
 
 template<typename T>
 lak::shared_bank_ptr<T> &lak::shared_bank_ptr<T>::operator=(
   unique_bank_ptr<T> &&other)
 {
+	reset();
 	if (other)
 	{
 		std::lock_guard lock(bank<T>::_mutex);
-		std::swap(unique_bank_ptr<T>::_index, other._index);
+		std::swap(unique_bank_ptr<T>::_handle, other._handle);
 		std::swap(unique_bank_ptr<T>::_value, other._value);
-		++_reference_count[unique_bank_ptr<T>::_index];
+		// unique_bank_ptrs don't count references
+		++bank<T>::internal_get(unique_bank_ptr<T>::_handle)->reference_count;
 	}
-	else
-		reset();
 	return *this;
 };
 
@@ -492,75 +439,65 @@ void lak::shared_bank_ptr<T>::reset()
 {
 	if (!*this) return;
 	std::lock_guard lock(bank<T>::_mutex);
-	if (--_reference_count[unique_bank_ptr<T>::_index] == 0)
-	{
-		if (unique_bank_ptr<T>::_index == bank<T>::_container.size() - 1)
-		{
-			bank<T>::_container.pop_back();
-			_reference_count.pop_back();
-		}
-		else
-		{
-			bank<T>::internal_destroy(unique_bank_ptr<T>::_index);
-			_reference_count.resize(bank<T>::_container.size());
-		}
-	}
-	unique_bank_ptr<T>::_index = std::numeric_limits<size_t>::max();
-	unique_bank_ptr<T>::_value = nullptr;
+	if (--bank<T>::internal_get(unique_bank_ptr<T>::_handle)->reference_count ==
+	    0U)
+		bank<T>::internal_destroy(unique_bank_ptr<T>::_handle);
+	unique_bank_ptr<T>::_handle = {};
+	unique_bank_ptr<T>::_value  = nullptr;
 }
 
 template<typename T>
 bool lak::shared_bank_ptr<T>::operator<(
   const lak::shared_bank_ptr<T> &rhs) const
 {
-	ASSERT((unique_bank_ptr<T>::_index == rhs._index) ==
+	ASSERT((unique_bank_ptr<T>::_handle == rhs._handle) ==
 	       (unique_bank_ptr<T>::_value == rhs._value));
-	return unique_bank_ptr<T>::_index < rhs._index;
+	return unique_bank_ptr<T>::_handle < rhs._handle;
 }
 
 template<typename T>
 bool lak::shared_bank_ptr<T>::operator<=(
   const lak::shared_bank_ptr<T> &rhs) const
 {
-	ASSERT((unique_bank_ptr<T>::_index == rhs._index) ==
+	ASSERT((unique_bank_ptr<T>::_handle == rhs._handle) ==
 	       (unique_bank_ptr<T>::_value == rhs._value));
-	return unique_bank_ptr<T>::_index <= rhs._index;
+	return unique_bank_ptr<T>::_handle <= rhs._handle;
 }
 
 template<typename T>
 bool lak::shared_bank_ptr<T>::operator>(
   const lak::shared_bank_ptr<T> &rhs) const
 {
-	ASSERT((unique_bank_ptr<T>::_index == rhs._index) ==
+	ASSERT((unique_bank_ptr<T>::_handle == rhs._handle) ==
 	       (unique_bank_ptr<T>::_value == rhs._value));
-	return unique_bank_ptr<T>::_index > rhs._index;
+	return unique_bank_ptr<T>::_handle > rhs._handle;
 }
 
 template<typename T>
 bool lak::shared_bank_ptr<T>::operator>=(
   const lak::shared_bank_ptr<T> &rhs) const
 {
-	ASSERT((unique_bank_ptr<T>::_index == rhs._index) ==
+	ASSERT((unique_bank_ptr<T>::_handle == rhs._handle) ==
 	       (unique_bank_ptr<T>::_value == rhs._value));
-	return unique_bank_ptr<T>::_index >= rhs._index;
+	return unique_bank_ptr<T>::_handle >= rhs._handle;
 }
 
 template<typename T>
 bool lak::shared_bank_ptr<T>::operator==(
   const lak::shared_bank_ptr<T> &rhs) const
 {
-	ASSERT((unique_bank_ptr<T>::_index == rhs._index) ==
+	ASSERT((unique_bank_ptr<T>::_handle == rhs._handle) ==
 	       (unique_bank_ptr<T>::_value == rhs._value));
-	return unique_bank_ptr<T>::_index == rhs._index;
+	return unique_bank_ptr<T>::_handle == rhs._handle;
 }
 
 template<typename T>
 bool lak::shared_bank_ptr<T>::operator!=(
   const lak::shared_bank_ptr<T> &rhs) const
 {
-	ASSERT((unique_bank_ptr<T>::_index == rhs._index) ==
+	ASSERT((unique_bank_ptr<T>::_handle == rhs._handle) ==
 	       (unique_bank_ptr<T>::_value == rhs._value));
-	return unique_bank_ptr<T>::_index != rhs._index;
+	return unique_bank_ptr<T>::_handle != rhs._handle;
 }
 
 template<typename T>
@@ -15,8 +15,9 @@ namespace lak
 	struct bigint
 	{
 #ifndef LAK_BIGINT_STANDALONE_HPP
+		// most values fit in a few limbs, those don't allocate
 		template<typename T>
-		using _array = lak::array<T>;
+		using _array = lak::small_array<T, 4U>;
 		template<typename T, typename U>
 		using _pair = lak::pair<T, U>;
 #else
@@ -363,6 +364,12 @@ namespace lak
 			return strm;
 		}
 	};
+
+	template<>
+	struct is_trivially_relocatable<lak::bigint>
+	: lak::is_trivially_relocatable<lak::bigint::_array<lak::bigint::value_type>>
+	{
+	};
 }
 
 #endif
@@ -12,6 +12,8 @@
 #ifdef LAK_BIGINT_STANDALONE_IMPL
 #undef LAK_BIGINT_STANDALONE_IMPL
 
+#include "../../src/alloc.cpp"
+#include "../../src/alloc_stats.cpp"
 #include "../../src/bigint.cpp"
 #include "../../src/debug.cpp"
 #include "../../src/memmanip.cpp"
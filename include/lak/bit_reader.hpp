@@ -40,11 +40,12 @@ namespace lak
 
 		bit_reader &operator=(const bit_reader &) = default;
 
-		// (bytes, bits)
+		// (bytes, bits), bits that have been peeked but not read aren't counted
 		inline lak::pair<uintmax_t, uint8_t> bytes_read() const
 		{
-			return lak::pair<uintmax_t, uint8_t>(_bytes_read,
-			                                     uint8_t(8 - _unused_bits));
+			const uintmax_t bits = (_bytes_read * 8U) + (8U - _unused_bits) -
+			                       _num_bits;
+			return lak::pair<uintmax_t, uint8_t>(bits / 8U, uint8_t(bits % 8U));
 		}
 
 		inline bit_reader(lak::span<const byte_t> data) : _data(data) {}
@@ -73,12 +73,17 @@ lak::bit_reader<ENDIAN>::peek_bits(const uint8_t bits)
 	if (bits > std::numeric_limits<uintmax_t>::digits)
 		return lak::err_t{lak::bit_reader_error_t::too_many_bits};
 
-	if (bits > _num_bits)
-		if (const uint8_t bytes = (bits - _num_bits) / 8U,
-		    frac_bits           = (bits - _num_bits) % 8U;
-		    !((_data.size() > bytes) ||
-		      ((_data.size() == bytes) && (frac_bits == 0U))))
-			return lak::err_t{lak::bit_reader_error_t::out_of_data};
+	// _data[0] may already be partially accumulated
+	if (bits > _num_bits &&
+	    (_data.empty() ||
+	     size_t(bits - _num_bits) > ((_data.size() - 1U) * 8U) + _unused_bits))
+	{
+		// accumulate what's left so reset_data doesn't drop any bits
+		if (!_data.empty())
+			accumulate_to(
+			  uint8_t(_num_bits + ((_data.size() - 1U) * 8U) + _unused_bits));
+		return lak::err_t{lak::bit_reader_error_t::out_of_data};
+	}
 
 	accumulate_to(bits);
 
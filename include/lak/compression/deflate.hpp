@@ -6,6 +6,7 @@
 #include "lak/array.hpp"
 #include "lak/bit_reader.hpp"
 #include "lak/buffer_span.hpp"
+#include "lak/compression/huffman.hpp"
 #include "lak/result.hpp"
 #include "lak/span.hpp"
 
@@ -95,20 +96,27 @@ namespace lak
 		uint32_t _ilen  = 0;
 		uint32_t _nread = 0;
 
-		lak::array<int16_t, 0x23E> _literal_table = {};
-		lak::array<uint8_t, 0x120> _literal_len   = {};
-		uint32_t _literal_count                   = 0;
+		// the current block uses the fixed Huffman tables
+		bool _fixed_tables = false;
 
-		lak::array<int16_t, 0x3E> _distance_table = {};
-		lak::array<uint8_t, 0x20> _distance_len   = {};
-		uint32_t _distance_count                  = 0;
+		lak::huffman_table _literal_table       = {};
+		lak::array<uint8_t, 0x120> _literal_len = {};
+		uint32_t _literal_count                 = 0;
 
-		lak::array<int16_t, 0x24> _codelen_table = {};
-		lak::array<uint8_t, 0x13> _codelen_len   = {};
-		uint32_t _codelen_count                  = 0;
+		lak::huffman_table _distance_table      = {};
+		lak::array<uint8_t, 0x20> _distance_len = {};
+		uint32_t _distance_count                = 0;
 
-		template<typename T>
-		bool get_huff(lak::span<int16_t> table, T *out);
+		lak::huffman_table _codelen_table       = {};
+		lak::array<uint8_t, 0x13> _codelen_len  = {};
+		uint32_t _codelen_count                 = 0;
+
+		const lak::huffman_table &literal_table() const;
+		const lak::huffman_table &distance_table() const;
+
+		// returns true if there wasn't enough data
+		force_inline bool get_huff(const lak::huffman_table &table,
+		                           lak::huffman_entry *out);
 
 		force_inline deflate_iterator &fail(error_t reason);
 
@@ -121,7 +129,9 @@ namespace lak
 
 		error_t gen_huffman_table(lak::span<const uint8_t> lengths,
 		                          bool allow_no_symbols,
-		                          lak::span<int16_t> table);
+		                          lak::huffman_kind kind,
+		                          uint8_t root_bits,
+		                          lak::huffman_table &table);
 
 	public:
 		deflate_iterator(lak::span<const byte_t> compressed,
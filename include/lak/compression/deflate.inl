@@ -36,6 +36,49 @@ inline lak::deflate_iterator &lak::deflate_iterator::finished()
 	return *this;
 }
 
+inline const lak::huffman_table &lak::deflate_iterator::literal_table() const
+{
+	return _fixed_tables ? lak::huffman_table::fixed_literal_length()
+	                     : _literal_table;
+}
+
+inline const lak::huffman_table &lak::deflate_iterator::distance_table()
+  const
+{
+	return _fixed_tables ? lak::huffman_table::fixed_distance()
+	                     : _distance_table;
+}
+
+force_inline bool lak::deflate_iterator::get_huff(
+  const lak::huffman_table &table, lak::huffman_entry *out)
+{
+	if_let_ok (uintmax_t bits,
+	           _compressed.peek_bits(lak::huffman_table::max_bits))
+	{
+		*out = table.lookup(uint32_t(bits));
+		_compressed.read_bits(out->length).UNWRAP();
+		return false;
+	}
+
+	// near the end of the data, peek only as many bits as the code needs
+	for (uint8_t available = 1U;;)
+	{
+		if_let_ok (uintmax_t bits, _compressed.peek_bits(available))
+		{
+			const lak::huffman_entry entry{table.lookup(uint32_t(bits))};
+			if (entry.length > available)
+			{
+				available = entry.length;
+				continue;
+			}
+			*out = entry;
+			_compressed.read_bits(entry.length).UNWRAP();
+			return false;
+		}
+		return true;
+	}
+}
+
 inline lak::deflate_iterator &lak::deflate_iterator::step()
 {
 	_icrc = ~_crc;
@@ -45,6 +88,8 @@ inline lak::deflate_iterator &lak::deflate_iterator::step()
 	static constexpr uint8_t codelen_order_anaconda[19] = {
 	  18, 17, 16, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
 
+	lak::huffman_entry entry;
+
 #define SET_STATE(STATE)                                                      \
 	_state = state_t::STATE;                                                    \
 	[[fallthrough]];                                                            \
@@ -201,8 +246,11 @@ inline lak::deflate_iterator &lak::deflate_iterator::step()
 								_codelen_len[codelen_order[_counter]] = 0;
 						}
 
-						if (gen_huffman_table(_codelen_len, false, _codelen_table) !=
-						    error_t::ok)
+						if (gen_huffman_table(_codelen_len,
+						                      false,
+						                      lak::huffman_kind::symbols,
+						                      7U,
+						                      _codelen_table) != error_t::ok)
 							return fail(error_t::huffman_table_gen_failed);
 
 						_repeat_count = 0;
@@ -215,8 +263,9 @@ inline lak::deflate_iterator &lak::deflate_iterator::step()
 						{
 							if (_repeat_count == 0)
 							{
-								if (get_huff(_codelen_table, &_symbol))
+								if (get_huff(_codelen_table, &entry))
 									return fail(error_t::out_of_data);
+								_symbol = entry.value;
 
 								if (_symbol < 16)
 								{
@@ -273,54 +322,23 @@ inline lak::deflate_iterator &lak::deflate_iterator::step()
 						if (gen_huffman_table(
 						      lak::span(_literal_len).first(_literal_count),
 						      false,
+						      lak::huffman_kind::literal_length,
+						      10U,
 						      _literal_table) != error_t::ok ||
 						    gen_huffman_table(
 						      lak::span(_distance_len).first(_distance_count),
 						      true,
+						      lak::huffman_kind::distance,
+						      8U,
 						      _distance_table) != error_t::ok)
 							return fail(error_t::huffman_table_gen_failed);
+
+						_fixed_tables = false;
 					}
 					else if (_block_type == 1)
 					{
 						// Static tables
-
-						int32_t next_free = 2;
-						int32_t i         = 0;
-
-						for (; i < 0x7E; ++i)
-						{
-							_literal_table[i] = uint16_t(~next_free);
-							next_free += 2;
-						}
-
-						for (; i < 0x96; ++i)
-							_literal_table[i] = uint16_t(i + (0x100 - 0x7E));
-
-						for (; i < 0xFE; ++i)
-						{
-							_literal_table[i] = uint16_t(~next_free);
-							next_free += 2;
-						}
-
-						for (; i < 0x18E; ++i) _literal_table[i] = uint16_t(i - 0xFE);
-
-						for (; i < 0x196; ++i)
-							_literal_table[i] = uint16_t(i + (0x118 - 0x18E));
-
-						for (; i < 0x1CE; ++i)
-						{
-							_literal_table[i] = uint16_t(~next_free);
-							next_free += 2;
-						}
-
-						for (; i < 0x23E; ++i)
-							_literal_table[i] = uint16_t(i + (0x90 - 0x1CE));
-
-						for (i = 0; i < 0x1E; ++i)
-							_distance_table[i] = uint16_t(~(i * 2 + 2));
-
-						for (i = 0x1E; i < 0x3E; ++i)
-							_distance_table[i] = uint16_t(i - 0x1E);
+						_fixed_tables = true;
 					}
 					else
 						return fail(error_t::invalid_block_code);
@@ -329,67 +347,57 @@ inline lak::deflate_iterator &lak::deflate_iterator::step()
 					{
 						SET_STATE(read_symbol)
 
-						if (get_huff(_literal_table, &_symbol))
+						if (get_huff(literal_table(), &entry))
 							return fail(error_t::out_of_data);
 
-						if (_symbol < 256)
+						if (entry.op == lak::huffman_table::op_literal)
 						{
-							if (push_value(byte_t(_symbol)))
+							if (push_value(byte_t(entry.value)))
 								return success();
 							else
 								continue;
 						}
 
-						if (_symbol == 256) break;
+						if (entry.op == lak::huffman_table::op_end) break;
 
-						if (_symbol <= 264)
-						{
-							_repeat_length = (_symbol - 257) + 3;
-						}
-						else if (_symbol <= 284)
-						{
-							SET_STATE(read_length)
+						if (entry.op > lak::huffman_table::max_bits)
+							return fail(error_t::invalid_symbol);
 
-							const uint8_t length_bits = uint8_t((_symbol - 261) / 4);
-							if (_compressed.read_bits(length_bits)
-							      .if_ok_copy_to<uint32_t>(_repeat_length)
-							      .is_err())
-								return fail(error_t::out_of_data);
-							_repeat_length +=
-							  3 + ((4 + ((_symbol - 265) & 3)) << length_bits);
-						}
-						else if (_symbol == 285)
-						{
-							_repeat_length = 258;
-						}
-						else
+						// the table has the base length and the number of extra bits
+						_repeat_length = entry.value;
+						_symbol        = entry.op;
+
+						SET_STATE(read_length)
+
+						if (_symbol > 0)
 						{
-							return fail(error_t::invalid_symbol);
+							if_let_ok (uintmax_t extra,
+							           _compressed.read_bits(uint8_t(_symbol)))
+								_repeat_length += uint32_t(extra);
+							else
+								return fail(error_t::out_of_data);
 						}
 
 						SET_STATE(read_distance)
 
-						if (get_huff(_distance_table, &_symbol))
+						if (get_huff(distance_table(), &entry))
 							return fail(error_t::out_of_data);
 
-						if (_symbol <= 3)
-						{
-							_distance = _symbol + 1;
-						}
-						else if (_symbol <= 29)
-						{
-							SET_STATE(read_distance_extra)
+						if (entry.op > lak::huffman_table::max_bits)
+							return fail(error_t::invalid_symbol);
 
-							const uint8_t distance_bits = uint8_t((_symbol - 2) / 2);
-							if (_compressed.read_bits(distance_bits)
-							      .if_ok_copy_to<uint32_t>(_distance)
-							      .is_err())
-								return fail(error_t::out_of_data);
-							_distance += 1 + ((2 + (_symbol & 1)) << distance_bits);
-						}
-						else
+						_distance = entry.value;
+						_symbol   = entry.op;
+
+						SET_STATE(read_distance_extra)
+
+						if (_symbol > 0)
 						{
-							return fail(error_t::invalid_symbol);
+							if_let_ok (uintmax_t extra,
+							           _compressed.read_bits(uint8_t(_symbol)))
+								_distance += uint32_t(extra);
+							else
+								return fail(error_t::out_of_data);
 						}
 
 						if (_distance > _output_buffer.size())
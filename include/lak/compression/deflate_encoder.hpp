@@ -0,0 +1,127 @@
+#ifndef LAK_COMPRESSION_DEFLATE_ENCODER_HPP
+#define LAK_COMPRESSION_DEFLATE_ENCODER_HPP
+
+#include "lak/array.hpp"
+#include "lak/compression/deflate.hpp"
+#include "lak/span.hpp"
+
+namespace lak
+{
+	/* --- deflate_encoder --- */
+
+	// Streaming DEFLATE compressor, the output can be decompressed with
+	// lak::deflate_iterator using the same header.
+	//
+	// Input is buffered and compressed a block at a time, finish() compresses
+	// whatever is left and writes the trailer. Compressed output accumulates
+	// until it's taken with take_compressed().
+	struct deflate_encoder
+	{
+		using header_t = lak::deflate_iterator::header_t;
+
+		enum class level_t : uint8_t
+		{
+			// no compression, only stored blocks
+			stored,
+			// greedy matching with short hash chains
+			fast,
+			// lazy matching with longer hash chains
+			lazy,
+		};
+
+		static constexpr size_t window_size = 0x8000U;
+		static constexpr size_t min_match   = 3U;
+		static constexpr size_t max_match   = 258U;
+
+	private:
+		struct token
+		{
+			// 0 for literals
+			uint16_t length;
+			// the literal byte or the match distance
+			uint16_t value;
+		};
+
+		static constexpr size_t _block_size = 0x10000U;
+		static constexpr size_t _hash_bits  = 15U;
+		// _window never grows past this, slide_window leaves _pos below
+		// window_size + _block_size so there is always room for another block
+		// and its lookahead
+		static constexpr size_t _window_limit =
+		  window_size + (2U * _block_size) + (2U * max_match);
+
+		header_t _header;
+		level_t _level;
+		bool _finished = false;
+
+		// the last window_size bytes that have been compressed followed by the
+		// input that hasn't, input is copied in as it's consumed
+		lak::array<byte_t> _window;
+		size_t _pos = 0U;
+
+		// hash chains of the positions in _window, -1 terminated
+		lak::array<int32_t> _head;
+		lak::array<int32_t> _prev;
+		size_t _hashed = 0U;
+
+		lak::array<token> _tokens;
+
+		lak::array<byte_t> _compressed;
+		uint64_t _bit_accum = 0U;
+		uint8_t _num_bits   = 0U;
+
+		uint32_t _checksum   = 0U;
+		uint32_t _input_size = 0U;
+
+		void put_bits(uint32_t bits, uint8_t count);
+		void align_bits();
+
+		void write_header();
+		void write_trailer();
+
+		// adds every position before pos to the hash chains
+		void insert_hash(size_t pos);
+		size_t longest_match(size_t pos,
+		                     size_t prev_length,
+		                     size_t *distance) const;
+		void slide_window();
+
+		// tokenises the input from _pos until at least block_end
+		void match_greedy(size_t block_end);
+		void match_lazy(size_t block_end);
+
+		void write_stored(lak::span<const byte_t> data, bool final);
+		void write_block(size_t block_end, bool final);
+
+	public:
+		deflate_encoder(header_t header = header_t::zlib,
+		                level_t level   = level_t::lazy);
+
+		deflate_encoder(const deflate_encoder &)            = delete;
+		deflate_encoder &operator=(const deflate_encoder &) = delete;
+
+		deflate_encoder(deflate_encoder &&)            = default;
+		deflate_encoder &operator=(deflate_encoder &&) = default;
+
+		void write(lak::span<const byte_t> data);
+
+		// compresses the remaining input and writes the trailer, nothing can be
+		// written after this
+		void finish();
+
+		bool is_finished() const { return _finished; }
+
+		// the output that hasn't been taken yet
+		lak::span<const byte_t> compressed() const { return _compressed; }
+		lak::array<byte_t> take_compressed();
+	};
+
+	// compresses all of data in one go
+	lak::array<byte_t> encode_deflate(
+	  lak::span<const byte_t> data,
+	  lak::deflate_iterator::header_t header =
+	    lak::deflate_iterator::header_t::zlib,
+	  lak::deflate_encoder::level_t level = lak::deflate_encoder::level_t::lazy);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef LAK_COMPRESSION_HUFFMAN_HPP
+#define LAK_COMPRESSION_HUFFMAN_HPP
+
+#include "lak/array.hpp"
+#include "lak/span.hpp"
+#include "lak/stdint.hpp"
+
+namespace lak
+{
+	/* --- deflate alphabets --- */
+
+	// base and extra bit count of length symbols 257 to 285
+	inline constexpr uint16_t deflate_length_base[29] = {
+	  3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+	  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+	inline constexpr uint8_t deflate_length_extra[29] = {
+	  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+	  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+	// base and extra bit count of distance symbols 0 to 29
+	inline constexpr uint16_t deflate_distance_base[30] = {
+	  1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+	  33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+	  1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+	inline constexpr uint8_t deflate_distance_extra[30] = {
+	  0, 0, 0, 0, 1, 1, 2,  2,  3,  3,  4,  4,  5,  5,  6,
+	  6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+	/* --- huffman_table --- */
+
+	struct huffman_entry
+	{
+		// literal byte, symbol, or the base of a length or distance
+		uint16_t value;
+		// number of bits of the code
+		uint8_t length;
+		// one of huffman_table::op_*, or the number of extra bits to read and
+		// add to value
+		uint8_t op;
+	};
+
+	enum struct huffman_kind : uint8_t
+	{
+		// value is the symbol
+		symbols,
+		// deflate literal/length alphabet
+		literal_length,
+		// deflate distance alphabet
+		distance,
+	};
+
+	enum struct huffman_error : uint8_t
+	{
+		ok,
+		no_symbols,
+		too_many_symbols,
+		incomplete_tree,
+	};
+
+	// Lookup table decoder for the LSB first canonical Huffman codes used by
+	// deflate. The first root_bits bits of the stream index the root table,
+	// longer codes continue into a second level table. Each entry has the
+	// code length and the decoded value, including the base and extra bit
+	// count of lengths and distances, so decoding a symbol is one or two
+	// lookups rather than a walk of the tree one bit at a time.
+	struct huffman_table
+	{
+		static constexpr uint8_t max_bits = 15U;
+
+		static constexpr uint8_t op_literal = 0x10U;
+		static constexpr uint8_t op_end     = 0x20U;
+		// the low bits are the number of index bits of the second level table
+		static constexpr uint8_t op_link    = 0x40U;
+		static constexpr uint8_t op_invalid = 0x80U;
+
+		lak::array<lak::huffman_entry> entries;
+		uint8_t root_bits = 0U;
+
+		lak::huffman_error build(lak::span<const uint8_t> lengths,
+		                         bool allow_no_symbols,
+		                         lak::huffman_kind kind,
+		                         uint8_t root_bits);
+
+		// bits are the next bits of the stream, LSB first. If fewer than
+		// max_bits are available the rest must be zero, the entry is only
+		// valid if its length is no more than the number available.
+		inline lak::huffman_entry lookup(uint32_t bits) const
+		{
+			lak::huffman_entry entry{entries[bits & ((1U << root_bits) - 1U)]};
+			if (entry.op & op_link)
+				entry = entries[entry.value + ((bits >> root_bits) &
+				                               ((1U << (entry.op & 0xFU)) - 1U))];
+			return entry;
+		}
+
+		// the tables of deflate's fixed Huffman code blocks
+		static const lak::huffman_table &fixed_literal_length();
+		static const lak::huffman_table &fixed_distance();
+	};
+
+	/* --- huffman_lengths --- */
+
+	// Code lengths of an optimal prefix code for frequencies, limited to
+	// max_bits. At least two symbols are always given codes so the code is
+	// complete, unused symbols get a length of 0.
+	void huffman_lengths(lak::span<const uint32_t> frequencies,
+	                     uint8_t max_bits,
+	                     lak::span<uint8_t> lengths);
+
+	/* --- huffman_codes --- */
+
+	// The canonical codes for lengths, bit reversed so they can be written
+	// LSB first.
+	void huffman_codes(lak::span<const uint8_t> lengths,
+	                   lak::span<uint16_t> codes);
+}
+
+#endif
@@ -20,10 +20,51 @@ namespace lak
 		offset_too_large,
 
 		match_too_long,
+
+		// the frame doesn't start with the LZ4 magic number
+		invalid_magic,
+		// unknown version, reserved bits set or a dictionary ID
+		unsupported_frame,
+		header_checksum_mismatch,
+		block_too_large,
+		block_checksum_mismatch,
+		content_size_mismatch,
+		content_checksum_mismatch,
 	};
 
 	const char *lz4_error_name(lak::lz4_decode_error err);
 
+	/* --- lz4 blocks --- */
+
+	enum class lz4_mode : uint8_t
+	{
+		// one hash table probe per position, a higher acceleration skips
+		// through incompressible data faster at the cost of compression
+		fast,
+		// searches hash chains for the longest match
+		high_compression,
+	};
+
+	// the largest a block compressed from size bytes can be
+	constexpr size_t lz4_compress_bound(size_t size)
+	{
+		return size + (size / 255U) + 16U;
+	}
+
+	// Appends the compressed block to output. Matches may refer back into
+	// the last 64KiB of dictionary, which must be the data that immediately
+	// precedes data when it's decoded.
+	void encode_lz4_block(lak::span<const byte_t> data,
+	                      lak::array<byte_t> *output,
+	                      lak::lz4_mode mode = lak::lz4_mode::fast,
+	                      uint32_t acceleration = 1U,
+	                      lak::span<const byte_t> dictionary = {});
+
+	lak::array<byte_t> encode_lz4_block(
+	  lak::span<const byte_t> data,
+	  lak::lz4_mode mode = lak::lz4_mode::fast,
+	  uint32_t acceleration = 1U);
+
 	// allow_partial_reads disables the output_full error, but in the event of a
 	// partial read, it means the input stream is left in a potentially bad state
 	// for further block decoding.
@@ -40,6 +81,83 @@ namespace lak
 	{
 		return decode_lz4_block(strm, output_size, allow_partial_read);
 	}
+
+	// Decodes into output without allocating and returns the number of bytes
+	// decoded. Matches may refer back into the last 64KiB of dictionary,
+	// which must be the data that was decoded immediately before this block,
+	// such as the previous blocks of a linked block stream. Bytes of output
+	// past the decoded data may be overwritten.
+	lak::result<size_t, lak::lz4_decode_error> decode_lz4_block(
+	  lak::binary_reader &strm,
+	  lak::span<byte_t> output,
+	  lak::span<const byte_t> dictionary = {},
+	  bool allow_partial_read            = false);
+
+	inline lak::result<size_t, lak::lz4_decode_error> decode_lz4_block(
+	  lak::binary_reader &&strm,
+	  lak::span<byte_t> output,
+	  lak::span<const byte_t> dictionary = {},
+	  bool allow_partial_read            = false)
+	{
+		return decode_lz4_block(strm, output, dictionary, allow_partial_read);
+	}
+
+	// Appends at most max_output_size bytes to output and returns the number
+	// of bytes appended. The new elements aren't initialised before decoding
+	// into them. If linked is true, matches may refer back into the last
+	// 64KiB already in output.
+	lak::result<size_t, lak::lz4_decode_error> decode_lz4_block(
+	  lak::binary_reader &strm,
+	  lak::array<byte_t> *output,
+	  size_t max_output_size,
+	  bool linked             = false,
+	  bool allow_partial_read = false);
+
+	inline lak::result<size_t, lak::lz4_decode_error> decode_lz4_block(
+	  lak::binary_reader &&strm,
+	  lak::array<byte_t> *output,
+	  size_t max_output_size,
+	  bool linked             = false,
+	  bool allow_partial_read = false)
+	{
+		return decode_lz4_block(
+		  strm, output, max_output_size, linked, allow_partial_read);
+	}
+
+	/* --- lz4 frames --- */
+
+	enum class lz4_block_size : uint8_t
+	{
+		max_64KiB  = 4,
+		max_256KiB = 5,
+		max_1MiB   = 6,
+		max_4MiB   = 7,
+	};
+
+	struct lz4_frame_options
+	{
+		lak::lz4_mode mode             = lak::lz4_mode::fast;
+		uint32_t acceleration          = 1U;
+		lak::lz4_block_size block_size = lak::lz4_block_size::max_64KiB;
+		// blocks may refer back into the blocks before them
+		bool linked_blocks    = false;
+		bool block_checksums  = false;
+		bool content_size     = false;
+		bool content_checksum = true;
+	};
+
+	lak::array<byte_t> encode_lz4_frame(
+	  lak::span<const byte_t> data, const lak::lz4_frame_options &options = {});
+
+	// decodes one frame, skipping any skippable frames before it
+	lak::result<lak::array<byte_t>, lak::lz4_decode_error> decode_lz4_frame(
+	  lak::binary_reader &strm);
+
+	inline lak::result<lak::array<byte_t>, lak::lz4_decode_error>
+	decode_lz4_frame(lak::binary_reader &&strm)
+	{
+		return decode_lz4_frame(strm);
+	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,182 @@
+#ifndef LAK_CONCURRENT_RAILCAR_HPP
+#define LAK_CONCURRENT_RAILCAR_HPP
+
+#include "lak/stdint.hpp"
+#include "lak/tuple.hpp"
+#include "lak/utility.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <new>
+
+namespace lak
+{
+	template<typename T>
+	struct concurrent_railcar;
+
+	/* --- concurrent_railcar_snapshot --- */
+
+	// the elements that were published when the snapshot was taken, elements
+	// pushed afterwards aren't visited
+	template<typename T>
+	struct concurrent_railcar_snapshot
+	{
+	private:
+		const lak::concurrent_railcar<T> *_container = nullptr;
+		size_t _size                                 = 0U;
+
+		template<typename U>
+		friend struct concurrent_railcar;
+
+		concurrent_railcar_snapshot(const lak::concurrent_railcar<T> *container,
+		                            size_t size)
+		: _container(container), _size(size)
+		{
+		}
+
+	public:
+		struct iterator
+		{
+			const lak::concurrent_railcar<T> *_container;
+			size_t _index;
+
+			using value_type        = T;
+			using difference_type   = ptrdiff_t;
+			using reference         = const T &;
+			using pointer           = const T *;
+			using iterator_category = std::forward_iterator_tag;
+
+			reference operator*() const { return (*_container)[_index]; }
+			pointer operator->() const { return &(*_container)[_index]; }
+
+			iterator &operator++()
+			{
+				++_index;
+				return *this;
+			}
+			iterator operator++(int) { return {_container, _index++}; }
+
+			bool operator==(const iterator &other) const
+			{
+				return _index == other._index;
+			}
+			bool operator!=(const iterator &other) const
+			{
+				return _index != other._index;
+			}
+		};
+
+		concurrent_railcar_snapshot() = default;
+
+		size_t size() const { return _size; }
+		[[nodiscard]] bool empty() const { return _size == 0U; }
+
+		const T &operator[](size_t index) const;
+
+		iterator begin() const { return {_container, 0U}; }
+		iterator end() const { return {_container, _size}; }
+	};
+
+	/* --- concurrent_railcar --- */
+
+	// Append only railcar that any number of threads may push_back to and
+	// read from at the same time.
+	//
+	// push_back is wait-free: the index is claimed with a single fetch-add and
+	// the element is constructed in place. Bins double in size and are never
+	// relocated, so published elements never move. The bin after the one
+	// being filled is allocated ahead of time by whichever thread claims the
+	// middle index of a bin, so pushes rarely have to allocate.
+	//
+	// Elements may finish construction out of order, an element can be read
+	// once it has been published. snapshot() returns the longest run of
+	// published elements from the front. If a constructor throws its index is
+	// never published.
+	//
+	// clear and destruction must not race with any other member.
+	template<typename T>
+	struct concurrent_railcar
+	{
+	private:
+		struct slot
+		{
+			alignas(T) byte_t value[sizeof(T)];
+			std::atomic_bool published;
+
+			T *get() { return std::launder(reinterpret_cast<T *>(value)); }
+			const T *get() const
+			{
+				return std::launder(reinterpret_cast<const T *>(value));
+			}
+		};
+
+		// bin i holds first_bin_size << i slots
+		static constexpr size_t first_bin_size = std::bit_ceil(
+		  std::max<size_t>(4096U / sizeof(slot), size_t(4U)));
+		static constexpr size_t first_bin_shift =
+		  std::countr_zero(first_bin_size);
+		static constexpr size_t max_bins =
+		  std::numeric_limits<size_t>::digits - first_bin_shift;
+
+		std::atomic<slot *> _bins[max_bins] = {};
+		// indices that have been claimed by push_back
+		std::atomic_size_t _size = 0U;
+		// every element before this has been published
+		mutable std::atomic_size_t _published = 0U;
+
+		static constexpr size_t bin_size(size_t bin)
+		{
+			return first_bin_size << bin;
+		}
+
+		// the bin and the offset within it of index
+		static constexpr lak::pair<size_t, size_t> locate(size_t index);
+
+		slot *internal_get_bin(size_t bin);
+		slot &internal_slot(size_t index);
+		const slot &internal_slot(size_t index) const;
+
+	public:
+		using value_type      = T;
+		using size_type       = size_t;
+		using reference       = T &;
+		using const_reference = const T &;
+
+		concurrent_railcar() = default;
+
+		concurrent_railcar(const concurrent_railcar &)            = delete;
+		concurrent_railcar &operator=(const concurrent_railcar &) = delete;
+
+		~concurrent_railcar();
+
+		// the number of indices claimed, the newest may not be published yet
+		size_t size() const { return _size.load(std::memory_order_acquire); }
+		[[nodiscard]] bool empty() const { return size() == 0U; }
+
+		// returns the index of the new element, which is published on return
+		template<typename... ARGS>
+		size_t emplace_back(ARGS &&...args);
+		size_t push_back(const T &t);
+		size_t push_back(T &&t);
+
+		[[nodiscard]] bool is_published(size_t index) const;
+
+		// nullptr if index hasn't been published
+		const T *try_get(size_t index) const;
+
+		// index must have been published
+		T &operator[](size_t index);
+		const T &operator[](size_t index) const;
+
+		lak::concurrent_railcar_snapshot<T> snapshot() const;
+
+		void clear();
+	};
+}
+
+#include "lak/concurrent_railcar.inl"
+
+#endif
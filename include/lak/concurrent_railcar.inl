@@ -0,0 +1,172 @@
+#include "lak/concurrent_railcar.hpp"
+
+#include "lak/alloc.hpp"
+#include "lak/debug.hpp"
+
+/* --- concurrent_railcar_snapshot --- */
+
+template<typename T>
+const T &lak::concurrent_railcar_snapshot<T>::operator[](size_t index) const
+{
+	ASSERT_LESS(index, _size);
+	return (*_container)[index];
+}
+
+/* --- concurrent_railcar --- */
+
+template<typename T>
+constexpr lak::pair<size_t, size_t> lak::concurrent_railcar<T>::locate(
+  size_t index)
+{
+	// bin i starts at index (first_bin_size << i) - first_bin_size
+	const size_t biased{index + first_bin_size};
+	const size_t bin{size_t(std::bit_width(biased)) - 1U - first_bin_shift};
+	return {bin, biased - bin_size(bin)};
+}
+
+template<typename T>
+typename lak::concurrent_railcar<T>::slot *
+lak::concurrent_railcar<T>::internal_get_bin(size_t bin)
+{
+	ASSERT_LESS(bin, max_bins);
+	slot *result{_bins[bin].load(std::memory_order_acquire)};
+	if (result) return result;
+
+	slot *new_bin{reinterpret_cast<slot *>(
+	  lak::global_alloc(sizeof(slot) * bin_size(bin), alignof(slot))
+	    .expect("bin alloc failed")
+	    .data())};
+	for (size_t i = 0U; i < bin_size(bin); ++i)
+		new (&new_bin[i].published) std::atomic_bool(false);
+
+	// if another thread beat us to it use their bin instead
+	if (_bins[bin].compare_exchange_strong(
+	      result, new_bin, std::memory_order_acq_rel, std::memory_order_acquire))
+		return new_bin;
+
+	lak::global_free(lak::span<byte_t>(reinterpret_cast<byte_t *>(new_bin),
+	                                   sizeof(slot) * bin_size(bin)));
+	return result;
+}
+
+template<typename T>
+typename lak::concurrent_railcar<T>::slot &
+lak::concurrent_railcar<T>::internal_slot(size_t index)
+{
+	auto [bin, offset] = locate(index);
+	return _bins[bin].load(std::memory_order_acquire)[offset];
+}
+
+template<typename T>
+const typename lak::concurrent_railcar<T>::slot &
+lak::concurrent_railcar<T>::internal_slot(size_t index) const
+{
+	auto [bin, offset] = locate(index);
+	return _bins[bin].load(std::memory_order_acquire)[offset];
+}
+
+template<typename T>
+lak::concurrent_railcar<T>::~concurrent_railcar()
+{
+	clear();
+	for (size_t bin = 0U; bin < max_bins; ++bin)
+	{
+		if (slot *b{_bins[bin].load(std::memory_order_acquire)}; b)
+			lak::global_free(lak::span<byte_t>(reinterpret_cast<byte_t *>(b),
+			                                   sizeof(slot) * bin_size(bin)));
+	}
+}
+
+template<typename T>
+template<typename... ARGS>
+size_t lak::concurrent_railcar<T>::emplace_back(ARGS &&...args)
+{
+	const size_t index{_size.fetch_add(1U, std::memory_order_acq_rel)};
+	auto [bin, offset] = locate(index);
+	slot &s{internal_get_bin(bin)[offset]};
+
+	if (offset == bin_size(bin) / 2U && bin + 1U < max_bins)
+		internal_get_bin(bin + 1U);
+
+	new (s.value) T(lak::forward<ARGS>(args)...);
+	s.published.store(true, std::memory_order_release);
+	return index;
+}
+
+template<typename T>
+size_t lak::concurrent_railcar<T>::push_back(const T &t)
+{
+	return emplace_back(t);
+}
+
+template<typename T>
+size_t lak::concurrent_railcar<T>::push_back(T &&t)
+{
+	return emplace_back(lak::move(t));
+}
+
+template<typename T>
+bool lak::concurrent_railcar<T>::is_published(size_t index) const
+{
+	return try_get(index) != nullptr;
+}
+
+template<typename T>
+const T *lak::concurrent_railcar<T>::try_get(size_t index) const
+{
+	if (index >= size()) return nullptr;
+	auto [bin, offset] = locate(index);
+	const slot *b{_bins[bin].load(std::memory_order_acquire)};
+	if (!b || !b[offset].published.load(std::memory_order_acquire))
+		return nullptr;
+	return b[offset].get();
+}
+
+template<typename T>
+T &lak::concurrent_railcar<T>::operator[](size_t index)
+{
+	slot &s{internal_slot(index)};
+	ASSERT(s.published.load(std::memory_order_acquire));
+	return *s.get();
+}
+
+template<typename T>
+const T &lak::concurrent_railcar<T>::operator[](size_t index) const
+{
+	const slot &s{internal_slot(index)};
+	ASSERT(s.published.load(std::memory_order_acquire));
+	return *s.get();
+}
+
+template<typename T>
+lak::concurrent_railcar_snapshot<T> lak::concurrent_railcar<T>::snapshot()
+  const
+{
+	size_t published{_published.load(std::memory_order_acquire)};
+	size_t end{published};
+	while (is_published(end)) ++end;
+
+	// share the scan with the next snapshot
+	while (published < end &&
+	       !_published.compare_exchange_weak(published,
+	                                         end,
+	                                         std::memory_order_acq_rel,
+	                                         std::memory_order_acquire))
+		;
+
+	return {this, end};
+}
+
+template<typename T>
+void lak::concurrent_railcar<T>::clear()
+{
+	const size_t old_size{_size.load(std::memory_order_acquire)};
+	for (size_t i = 0U; i < old_size; ++i)
+	{
+		slot &s{internal_slot(i)};
+		if (s.published.exchange(false, std::memory_order_relaxed))
+			s.get()->~T();
+	}
+	_size.store(0U, std::memory_order_release);
+	_published.store(0U, std::memory_order_release);
+}
@@ -0,0 +1,219 @@
+#ifndef LAK_COROUTINE_HPP
+#define LAK_COROUTINE_HPP
+
+#include "lak/await.hpp"
+#include "lak/optional.hpp"
+#include "lak/result.hpp"
+#include "lak/tasks.hpp"
+#include "lak/type_traits.hpp"
+
+#include <atomic>
+#include <coroutine>
+
+namespace lak
+{
+	template<typename T>
+	struct task;
+
+	/* --- schedule_on --- */
+
+	// co_await lak::schedule_on(pool) resumes the coroutine on one of pool's
+	// workers.
+	struct schedule_on
+	{
+		lak::tasks &_pool;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		void await_resume() const noexcept {}
+	};
+
+	/* --- _task_promise --- */
+
+	struct _task_promise_tags
+	{
+		static inline char done;
+		static inline char detached;
+	};
+
+	template<typename T>
+	struct _result_awaiter;
+
+	template<typename T>
+	struct _task_promise_base
+	{
+		using value_type =
+		  lak::conditional_t<lak::is_void_v<T>, lak::monostate, T>;
+
+		// nullptr: running and nobody is waiting
+		// &_task_promise_tags::done: finished
+		// &_task_promise_tags::detached: the owning task was destroyed, the
+		// frame destroys itself when it finishes
+		// otherwise: address of the coroutine waiting on this one
+		std::atomic<void *> _continuation = nullptr;
+		bool _started                     = false;
+		lak::optional<lak::await_result<value_type>> _result;
+
+		struct final_awaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			template<typename PROMISE>
+			std::coroutine_handle<> await_suspend(
+			  std::coroutine_handle<PROMISE> handle) noexcept
+			{
+				return handle.promise().complete(handle);
+			}
+			void await_resume() const noexcept {}
+		};
+
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		final_awaiter final_suspend() const noexcept { return {}; }
+
+		void unhandled_exception();
+
+		bool done() const
+		{
+			return _continuation.load(std::memory_order_acquire) ==
+			       &lak::_task_promise_tags::done;
+		}
+
+		// publishes the result, returns the coroutine to resume next
+		template<typename PROMISE>
+		std::coroutine_handle<> complete(std::coroutine_handle<PROMISE> handle);
+
+		template<typename U>
+		U &&await_transform(U &&awaitable)
+		{
+			return lak::forward<U>(awaitable);
+		}
+
+		// co_await on a lak::result inside a task that returns a lak::result
+		// yields the ok value, or finishes the task with the error.
+		template<typename OK, typename ERR>
+		requires lak::is_result_v<T> &&
+		         requires(ERR &&err) { T(lak::err_t{lak::forward<ERR>(err)}); }
+		lak::_result_awaiter<lak::result<OK, ERR>> await_transform(
+		  lak::result<OK, ERR> result)
+		{
+			return {lak::move(result)};
+		}
+	};
+
+	template<typename T>
+	struct _task_promise : public lak::_task_promise_base<T>
+	{
+		lak::task<T> get_return_object();
+
+		template<typename U>
+		void return_value(U &&value)
+		{
+			this->_result.emplace(
+			  lak::await_result<T>(lak::ok_t<T>{T(lak::forward<U>(value))}));
+		}
+	};
+
+	template<>
+	struct _task_promise<void> : public lak::_task_promise_base<void>
+	{
+		lak::task<void> get_return_object();
+
+		void return_void()
+		{
+			_result.emplace(
+			  lak::await_result<lak::monostate>(lak::ok_t{lak::monostate{}}));
+		}
+	};
+
+	template<typename RESULT>
+	struct _result_awaiter
+	{
+		RESULT _result;
+
+		bool await_ready() const noexcept { return _result.is_ok(); }
+
+		template<typename PROMISE>
+		std::coroutine_handle<> await_suspend(
+		  std::coroutine_handle<PROMISE> handle);
+
+		lak::result_ok_type_t<RESULT> await_resume()
+		{
+			return lak::forward<lak::result_ok_type_t<RESULT>>(*_result.ok());
+		}
+	};
+
+	/* --- task --- */
+
+	// Lazily started coroutine. co_await on a task starts it (if it hasn't
+	// been started already) and yields a lak::await_result, err(failed) if the
+	// coroutine threw.
+	template<typename T = void>
+	struct [[nodiscard]] task
+	{
+		using promise_type = lak::_task_promise<T>;
+		using handle_type  = std::coroutine_handle<promise_type>;
+		using value_type   = typename promise_type::value_type;
+
+	private:
+		handle_type _handle;
+
+		friend promise_type;
+
+		task(handle_type handle) : _handle(handle) {}
+
+	public:
+		task() = default;
+		task(task &&other) : _handle(lak::exchange(other._handle, nullptr)) {}
+		task &operator=(task &&other)
+		{
+			lak::swap(_handle, other._handle);
+			return *this;
+		}
+		~task() { reset(); }
+
+		// if the coroutine is still running it is detached and cleans itself up
+		// when it finishes
+		void reset();
+
+		bool valid() const { return !!_handle; }
+		bool ready() const { return _handle && _handle.promise().done(); }
+
+		// run the coroutine on this thread until its first suspension
+		task &start();
+
+		// run the coroutine on one of pool's workers
+		task &start_on(lak::tasks &pool);
+
+		struct awaiter
+		{
+			handle_type _handle;
+
+			bool await_ready() const { return _handle.promise().done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiter);
+			lak::await_result<value_type> await_resume();
+		};
+
+		awaiter operator co_await() const &
+		{
+			ASSERT(_handle);
+			return {_handle};
+		}
+	};
+
+	/* --- spawn --- */
+
+	// starts task on pool, the task can be co_awaited or sync_waited later
+	template<typename T>
+	lak::task<T> spawn(lak::tasks &pool, lak::task<T> task);
+
+	/* --- sync_wait --- */
+
+	// blocks this thread until task has finished, starts task on this thread
+	// if it hasn't been started
+	template<typename T>
+	lak::await_result<typename lak::task<T>::value_type> sync_wait(
+	  const lak::task<T> &task);
+}
+
+#include "lak/coroutine.inl"
+
+#endif
@@ -0,0 +1,210 @@
+#include "lak/coroutine.hpp"
+
+#include "lak/debug.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+/* --- schedule_on --- */
+
+inline void lak::schedule_on::await_suspend(std::coroutine_handle<> handle)
+{
+	(void)_pool.push([handle] { handle.resume(); });
+}
+
+/* --- _task_promise --- */
+
+template<typename T>
+void lak::_task_promise_base<T>::unhandled_exception()
+{
+	try
+	{
+		throw;
+	}
+	catch (const std::exception &e)
+	{
+		ERROR("Uncaught Exception: ", e.what());
+	}
+	catch (...)
+	{
+		ERROR("Uncaught Exception");
+	}
+	_result.emplace(
+	  lak::await_result<value_type>(lak::err_t{lak::await_error::failed}));
+}
+
+template<typename T>
+template<typename PROMISE>
+std::coroutine_handle<> lak::_task_promise_base<T>::complete(
+  std::coroutine_handle<PROMISE> handle)
+{
+	void *waiter{_continuation.exchange(&lak::_task_promise_tags::done,
+	                                    std::memory_order_acq_rel)};
+	if (waiter == &lak::_task_promise_tags::detached)
+	{
+		handle.destroy();
+		return std::noop_coroutine();
+	}
+	else if (waiter)
+		return std::coroutine_handle<>::from_address(waiter);
+	else
+		return std::noop_coroutine();
+}
+
+template<typename T>
+lak::task<T> lak::_task_promise<T>::get_return_object()
+{
+	return lak::task<T>(
+	  std::coroutine_handle<lak::_task_promise<T>>::from_promise(*this));
+}
+
+inline lak::task<void> lak::_task_promise<void>::get_return_object()
+{
+	return lak::task<void>(
+	  std::coroutine_handle<lak::_task_promise<void>>::from_promise(*this));
+}
+
+/* --- _result_awaiter --- */
+
+template<typename RESULT>
+template<typename PROMISE>
+std::coroutine_handle<> lak::_result_awaiter<RESULT>::await_suspend(
+  std::coroutine_handle<PROMISE> handle)
+{
+	// finish the task with the error, the frame is left suspended here and is
+	// destroyed by its owner like it would be at the final suspend point
+	using value_type = typename PROMISE::value_type;
+	handle.promise()._result.emplace(lak::await_result<value_type>(
+	  lak::ok_t<value_type>{value_type(lak::err_t{*_result.err()})}));
+	return handle.promise().complete(handle);
+}
+
+/* --- task --- */
+
+template<typename T>
+void lak::task<T>::reset()
+{
+	if (!_handle) return;
+	handle_type handle{lak::exchange(_handle, nullptr)};
+
+	if (handle.promise()._started)
+	{
+		void *expected{nullptr};
+		if (handle.promise()._continuation.compare_exchange_strong(
+		      expected, &lak::_task_promise_tags::detached))
+			return;
+		ASSERT_EQUAL(expected, (void *)&lak::_task_promise_tags::done);
+	}
+
+	handle.destroy();
+}
+
+template<typename T>
+lak::task<T> &lak::task<T>::start()
+{
+	ASSERT(_handle);
+	ASSERT(!_handle.promise()._started);
+	_handle.promise()._started = true;
+	_handle.resume();
+	return *this;
+}
+
+template<typename T>
+lak::task<T> &lak::task<T>::start_on(lak::tasks &pool)
+{
+	ASSERT(_handle);
+	ASSERT(!_handle.promise()._started);
+	_handle.promise()._started = true;
+	(void)pool.push([handle{_handle}] { handle.resume(); });
+	return *this;
+}
+
+template<typename T>
+std::coroutine_handle<> lak::task<T>::awaiter::await_suspend(
+  std::coroutine_handle<> waiter)
+{
+	promise_type &promise{_handle.promise()};
+
+	if (!promise._started)
+	{
+		// lazily start the task on this thread, it will resume us when it's done
+		promise._started = true;
+		promise._continuation.store(waiter.address(), std::memory_order_release);
+		return _handle;
+	}
+
+	void *expected{nullptr};
+	if (promise._continuation.compare_exchange_strong(
+	      expected, waiter.address(), std::memory_order_acq_rel))
+		return std::noop_coroutine();
+
+	// finished between await_ready and now
+	return waiter;
+}
+
+template<typename T>
+lak::await_result<typename lak::task<T>::value_type>
+lak::task<T>::awaiter::await_resume()
+{
+	ASSERT(_handle.promise()._result.has_value());
+	return *_handle.promise()._result;
+}
+
+/* --- spawn --- */
+
+template<typename T>
+lak::task<T> lak::spawn(lak::tasks &pool, lak::task<T> task)
+{
+	task.start_on(pool);
+	return task;
+}
+
+/* --- sync_wait --- */
+
+namespace lak
+{
+	struct _sync_wait_task
+	{
+		struct promise_type
+		{
+			_sync_wait_task get_return_object() { return {}; }
+			std::suspend_never initial_suspend() const noexcept { return {}; }
+			std::suspend_never final_suspend() const noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+
+	template<typename T>
+	struct _sync_wait_state
+	{
+		lak::optional<lak::await_result<T>> result;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	template<typename T>
+	lak::_sync_wait_task _sync_wait(const lak::task<T> &task,
+	                                lak::_sync_wait_state<
+	                                  typename lak::task<T>::value_type> &state)
+	{
+		auto result{co_await task};
+		// notify while holding the lock so that sync_wait can't return and
+		// destroy state before we're done with it
+		std::lock_guard lock{state.mutex};
+		state.result.emplace(lak::move(result));
+		state.finished.notify_all();
+	}
+}
+
+template<typename T>
+lak::await_result<typename lak::task<T>::value_type> lak::sync_wait(
+  const lak::task<T> &task)
+{
+	lak::_sync_wait_state<typename lak::task<T>::value_type> state;
+	lak::_sync_wait(task, state);
+	std::unique_lock lock{state.mutex};
+	state.finished.wait(lock, [&] { return state.result.has_value(); });
+	return lak::move(*state.result);
+}
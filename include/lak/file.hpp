@@ -54,6 +54,71 @@ namespace lak
 
 	lak::errno_result<lak::array<byte_t>> read_file(const fs::path &path);
 
+	/* --- mapped_file --- */
+
+	enum struct mapped_file_access
+	{
+		read_only,
+		// writes go to the file
+		read_write,
+		// writes are private to the mapping
+		copy_on_write,
+	};
+
+	enum struct mapped_file_advice
+	{
+		normal,
+		sequential,
+		random,
+	};
+
+	struct mapped_file_options
+	{
+		lak::mapped_file_access access = lak::mapped_file_access::read_only;
+		lak::mapped_file_advice advice = lak::mapped_file_advice::normal;
+		// read the whole file in when it's mapped rather than on first touch
+		bool prefault = false;
+	};
+
+	// A whole file mapped into memory, pages are read from the page cache on
+	// demand so mapping large files doesn't copy them or allocate for them.
+	struct mapped_file
+	{
+	private:
+		lak::span<byte_t> _data         = {};
+		lak::mapped_file_access _access = lak::mapped_file_access::read_only;
+
+		void clear();
+
+	public:
+		static lak::error_code_result<mapped_file> open(
+		  const fs::path &path, const lak::mapped_file_options &options = {});
+
+		mapped_file() = default;
+		mapped_file(mapped_file &&other);
+		mapped_file &operator=(mapped_file &&other);
+		~mapped_file() { clear(); }
+
+		lak::span<const byte_t> data() const { return _data; }
+
+		// not available for read_only mappings
+		lak::span<byte_t> mutable_data();
+
+		size_t size() const { return _data.size(); }
+		bool empty() const { return _data.empty(); }
+
+		// change the expected access pattern of [offset, offset + count)
+		void advise(lak::mapped_file_advice advice,
+		            size_t offset = 0U,
+		            size_t count  = lak::dynamic_extent);
+
+		// write changes to [offset, offset + count) back to the file and wait
+		// for them to finish (windows only starts the write), does nothing for
+		// mappings that aren't read_write
+		lak::error_code_result<> flush(size_t offset = 0U,
+		                               size_t count  = lak::dynamic_extent);
+	};
+
 	bool save_file(const fs::path &path, lak::span<const byte_t> data);
 
 	bool save_file(const fs::path &path, const lak::astring &string);
@@ -0,0 +1,260 @@
+#ifndef LAK_IO_QUEUE_HPP
+#define LAK_IO_QUEUE_HPP
+
+#ifndef LAK_NO_FILESYSTEM
+
+#	include "lak/array.hpp"
+#	include "lak/error_code_result.hpp"
+#	include "lak/file.hpp"
+#	include "lak/memory.hpp"
+#	include "lak/optional.hpp"
+#	include "lak/span.hpp"
+#	include "lak/tasks.hpp"
+
+#	include <coroutine>
+
+namespace lak
+{
+	struct io_queue;
+	struct io_queue_impl;
+
+	/* --- io_file --- */
+
+	// file opened for use with an io_queue
+	struct io_file
+	{
+		enum struct mode
+		{
+			read,
+			// creates or truncates the file
+			write,
+			// creates the file if it doesn't exist
+			read_write,
+		};
+
+	private:
+		// file descriptor or HANDLE
+		intptr_t _handle = -1;
+
+		explicit io_file(intptr_t handle) : _handle(handle) {}
+
+		void close();
+
+	public:
+		static lak::error_code_result<io_file> open(
+		  const fs::path &path, lak::io_file::mode mode = mode::read);
+
+		// takes ownership of handle
+		static io_file adopt(intptr_t handle) { return io_file(handle); }
+
+		io_file() = default;
+		io_file(io_file &&other) : _handle(lak::exchange(other._handle, -1)) {}
+		io_file &operator=(io_file &&other)
+		{
+			lak::swap(_handle, other._handle);
+			return *this;
+		}
+		~io_file() { close(); }
+
+		bool is_open() const { return _handle != -1; }
+		intptr_t native_handle() const { return _handle; }
+		intptr_t release() { return lak::exchange(_handle, -1); }
+
+		lak::error_code_result<uint64_t> size() const;
+	};
+
+	/* --- io_operation --- */
+
+	enum struct io_kind : uint8_t
+	{
+		read,
+		write,
+		// hint that [offset, offset + buffer.size()) will be read soon, buffer
+		// isn't accessed
+		readahead,
+		// open path for reading, file is set to the new handle (owned by the
+		// caller) and the result is the size of the file
+		open,
+	};
+
+	// number of bytes transferred, reads of regular files only come up short
+	// at the end of the file
+	using io_result = lak::error_code_result<size_t>;
+
+	// A single request, the memory for it is owned by the caller and must
+	// stay alive until _complete has been called. _complete is called once,
+	// from the queue's completion thread or one of its workers.
+	struct io_operation
+	{
+		lak::io_kind kind        = lak::io_kind::read;
+		intptr_t file            = -1;
+		uint64_t offset          = 0U;
+		lak::span<byte_t> buffer = {};
+		// index of the registered buffer that buffer lies within, -1 if it
+		// isn't in a registered buffer
+		int buffer_index         = -1;
+		// the file to open for io_kind::open
+		const fs::path *path     = nullptr;
+
+		// bytes moved by earlier partial transfers of this operation
+		size_t _transferred = 0U;
+		void (*_complete)(lak::io_operation *, lak::io_result) = nullptr;
+	};
+
+	// calls func(io_result) then destroys itself
+	template<typename F>
+	struct io_callback : public lak::io_operation
+	{
+		F _func;
+
+		template<typename FUNC>
+		io_callback(FUNC &&func);
+
+		static lak::io_callback<F> *make(F func);
+		static void complete(lak::io_operation *op, lak::io_result result);
+	};
+
+	// co_await resumes the coroutine on the completion thread with the
+	// io_result
+	struct [[nodiscard]] io_awaitable : public lak::io_operation
+	{
+		lak::io_queue *_queue = nullptr;
+		std::coroutine_handle<> _handle;
+		lak::optional<lak::io_result> _result;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		lak::io_result await_resume() { return lak::move(*_result); }
+
+		static void complete(lak::io_operation *op, lak::io_result result);
+	};
+
+	/* --- io_queue --- */
+
+	enum struct io_backend
+	{
+		// io_uring if the kernel supports it, otherwise thread_pool
+		automatic,
+		io_uring,
+		// blocking reads and writes on a lak::tasks pool
+		thread_pool,
+	};
+
+	struct io_queue_options
+	{
+		lak::io_backend backend = lak::io_backend::automatic;
+		// maximum number of operations in flight, submit blocks beyond this
+		size_t queue_depth = 256U;
+		// workers of the thread_pool backend
+		size_t threads = 4U;
+	};
+
+	extern template struct lak::unique_ptr<lak::io_queue_impl>;
+
+	// Asynchronous file reads and writes. Batches of operations are handed to
+	// the kernel in a single system call with the io_uring backend, so the
+	// cost of loading many small files is bound by the queue depth rather
+	// than the latency of each read.
+	//
+	// Operations submitted from completion callbacks are always accepted,
+	// even if the queue is full, so callbacks can chain more work.
+	struct io_queue
+	{
+	private:
+		lak::unique_ptr<lak::io_queue_impl> _impl;
+
+	public:
+		io_queue() : io_queue(lak::io_queue_options{}) {}
+		io_queue(const lak::io_queue_options &options);
+		io_queue(io_queue &&other);
+		io_queue &operator=(io_queue &&other);
+		// waits for every operation to complete
+		~io_queue();
+
+		lak::io_backend backend() const;
+		size_t queue_depth() const;
+
+		// operations are submitted in order, but may complete in any order
+		void submit(lak::span<lak::io_operation *const> operations);
+		void submit(lak::io_operation &operation);
+
+		// on_complete(io_result) is called once the operation has completed
+		template<typename F>
+		void read(const lak::io_file &file,
+		          uint64_t offset,
+		          lak::span<byte_t> buffer,
+		          F &&on_complete);
+
+		template<typename F>
+		void write(const lak::io_file &file,
+		           uint64_t offset,
+		           lak::span<const byte_t> buffer,
+		           F &&on_complete);
+
+		lak::io_awaitable async_read(const lak::io_file &file,
+		                             uint64_t offset,
+		                             lak::span<byte_t> buffer);
+
+		lak::io_awaitable async_write(const lak::io_file &file,
+		                              uint64_t offset,
+		                              lak::span<const byte_t> buffer);
+
+		void readahead(const lak::io_file &file, uint64_t offset, size_t size);
+
+		// Pins buffers so reads and writes into them skip mapping the pages on
+		// every operation. Operations select a buffer with buffer_index. Does
+		// nothing with the thread_pool backend. There must be no operations
+		// in flight that use the previous buffers. If the kernel refuses to
+		// pin them the buffers can still be used with a buffer_index of -1.
+		lak::error_code_result<> register_buffers(
+		  lak::span<const lak::span<byte_t>> buffers);
+		void unregister_buffers();
+
+		// blocks until every submitted operation has completed
+		void wait_idle();
+	};
+
+	/* --- load_files --- */
+
+	// Reads each file in whole through queue, on_loaded(index,
+	// error_code_result<array<byte_t>>) is called once per file in any order
+	// and from any thread. Files are opened through the queue as well, so
+	// opening many files is bound by the queue depth too. Returns once every
+	// file has been loaded.
+	template<typename F>
+	void load_files(lak::io_queue &queue,
+	                lak::span<const fs::path> paths,
+	                F &&on_loaded);
+
+	// load_files for every regular file in directory (not recursive),
+	// on_loaded(const fs::path &, error_code_result<array<byte_t>>). Files
+	// are queued as the directory is scanned rather than after, and each
+	// file's read is preceded by a readahead hint for the whole file so the
+	// thread_pool backend doesn't wait on one file per worker. Returns the
+	// error that stopped the scan, files found before it are still loaded.
+	template<typename F>
+	lak::error_code_result<> load_directory(lak::io_queue &queue,
+	                                        const fs::path &directory,
+	                                        F &&on_loaded);
+
+	// sets path to the next file to load, false once there are none left
+	using _load_files_next = bool (*)(void *context, fs::path &path);
+
+	using _load_files_callback = void (*)(
+	  void *context,
+	  size_t index,
+	  const fs::path &path,
+	  lak::error_code_result<lak::array<byte_t>> result);
+
+	void _load_files(lak::io_queue &queue,
+	                 lak::_load_files_next next,
+	                 lak::_load_files_callback callback,
+	                 void *context,
+	                 bool readahead);
+}
+
+#	include "lak/io_queue.inl"
+
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+#include "lak/io_queue.hpp"
+
+#include "lak/debug.hpp"
+#include "lak/utility.hpp"
+
+#include <new>
+
+/* --- io_callback --- */
+
+template<typename F>
+template<typename FUNC>
+lak::io_callback<F>::io_callback(FUNC &&func) : _func(lak::forward<FUNC>(func))
+{
+	this->_complete = &complete;
+}
+
+template<typename F>
+lak::io_callback<F> *lak::io_callback<F>::make(F func)
+{
+	return new (lak::task_slab<lak::io_callback<F>>::allocate())
+	  lak::io_callback<F>(lak::move(func));
+}
+
+template<typename F>
+void lak::io_callback<F>::complete(lak::io_operation *op,
+                                   lak::io_result result)
+{
+	lak::io_callback<F> *callback{static_cast<lak::io_callback<F> *>(op)};
+	callback->_func(lak::move(result));
+	callback->~io_callback();
+	lak::task_slab<lak::io_callback<F>>::free(callback);
+}
+
+/* --- io_queue --- */
+
+template<typename F>
+void lak::io_queue::read(const lak::io_file &file,
+                         uint64_t offset,
+                         lak::span<byte_t> buffer,
+                         F &&on_complete)
+{
+	auto *op{lak::io_callback<lak::remove_cvref_t<F>>::make(
+	  lak::forward<F>(on_complete))};
+	op->kind   = lak::io_kind::read;
+	op->file   = file.native_handle();
+	op->offset = offset;
+	op->buffer = buffer;
+	submit(*op);
+}
+
+template<typename F>
+void lak::io_queue::write(const lak::io_file &file,
+                          uint64_t offset,
+                          lak::span<const byte_t> buffer,
+                          F &&on_complete)
+{
+	auto *op{lak::io_callback<lak::remove_cvref_t<F>>::make(
+	  lak::forward<F>(on_complete))};
+	op->kind   = lak::io_kind::write;
+	op->file   = file.native_handle();
+	op->offset = offset;
+	// writes only read from the buffer
+	op->buffer =
+	  lak::span<byte_t>(const_cast<byte_t *>(buffer.data()), buffer.size());
+	submit(*op);
+}
+
+/* --- load_files --- */
+
+template<typename F>
+void lak::load_files(lak::io_queue &queue,
+                     lak::span<const fs::path> paths,
+                     F &&on_loaded)
+{
+	struct context
+	{
+		lak::span<const fs::path> paths;
+		size_t next;
+		lak::remove_reference_t<F> &on_loaded;
+	} ctx{paths, 0U, on_loaded};
+
+	lak::_load_files(
+	  queue,
+	  [](void *c, fs::path &path) -> bool
+	  {
+		  context &ctx{*static_cast<context *>(c)};
+		  if (ctx.next == ctx.paths.size()) return false;
+		  path = ctx.paths[ctx.next++];
+		  return true;
+	  },
+	  [](void *c,
+	     size_t index,
+	     const fs::path &,
+	     lak::error_code_result<lak::array<byte_t>> result)
+	  { static_cast<context *>(c)->on_loaded(index, lak::move(result)); },
+	  &ctx,
+	  false);
+}
+
+template<typename F>
+lak::error_code_result<> lak::load_directory(lak::io_queue &queue,
+                                             const fs::path &directory,
+                                             F &&on_loaded)
+{
+	struct context
+	{
+		fs::directory_iterator it;
+		std::error_code error;
+		lak::remove_reference_t<F> &on_loaded;
+	};
+
+	RES_TRY_ASSIGN(fs::directory_iterator it =,
+	               lak::directory_iterator(directory));
+
+	context ctx{lak::move(it), {}, on_loaded};
+
+	lak::_load_files(
+	  queue,
+	  [](void *c, fs::path &path) -> bool
+	  {
+		  context &ctx{*static_cast<context *>(c)};
+		  for (; !ctx.error && ctx.it != fs::directory_iterator();
+		       ctx.it.increment(ctx.error))
+		  {
+			  std::error_code error;
+			  if (!ctx.it->is_regular_file(error)) continue;
+			  path = ctx.it->path();
+			  ctx.it.increment(ctx.error);
+			  return true;
+		  }
+		  return false;
+	  },
+	  [](void *c,
+	     size_t,
+	     const fs::path &path,
+	     lak::error_code_result<lak::array<byte_t>> result)
+	  { static_cast<context *>(c)->on_loaded(path, lak::move(result)); },
+	  &ctx,
+	  true);
+
+	if (ctx.error) return lak::err_t{ctx.error};
+	return lak::ok_t{};
+}
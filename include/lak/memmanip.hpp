@@ -80,6 +80,10 @@ namespace lak
 		return result;
 	}
 
+	// assumed size of a cache line, data written by different threads is
+	// padded to this to avoid false sharing
+	static constexpr size_t cache_line_size = 64U;
+
 	void *aligned_alloc(size_t alignment, size_t size);
 
 	void aligned_free(void *p);
@@ -94,15 +98,66 @@ namespace lak
 	template<typename OK = lak::monostate>
 	using page_result_t = lak::result<OK, page_error>;
 
+	// size of the pages transparent_huge_pages asks for, 0 if the platform
+	// doesn't have transparent huge pages
+	size_t huge_page_size();
+
+	struct page_options
+	{
+		// hint that the pages should be backed by huge pages when they're
+		// committed, the reservation is aligned to huge_page_size()
+		bool transparent_huge_pages = false;
+		// reserve from the explicit huge page pool (eg 2MiB or 1GiB pages),
+		// 0 for base size pages. fails if the pool can't back the whole
+		// reservation, commits must be multiples of this size
+		size_t explicit_page_size = 0U;
+		// bind the pages to this NUMA node, -1 for the default policy
+		int numa_node = -1;
+	};
+
 	lak::page_result_t<lak::span<void>> page_reserve(
 	  size_t size, size_t *page_size_out = nullptr);
 
+	// options that the platform doesn't support are ignored, except for
+	// explicit_page_size
+	lak::page_result_t<lak::span<void>> page_reserve(
+	  size_t size,
+	  const lak::page_options &options,
+	  size_t *page_size_out = nullptr);
+
 	lak::page_result_t<> page_commit(lak::span<void> pages);
 
 	lak::page_result_t<> page_decommit(lak::span<void> pages);
 
 	lak::page_result_t<> page_free(lak::span<void> pages);
 
+	/* --- shared memory --- */
+
+	// Anonymous shared memory object (memfd on linux, a pagefile backed
+	// section on windows) that can be mapped any number of times, either
+	// shared or copy on write.
+
+	// file descriptor or HANDLE
+	using shared_memory_handle = intptr_t;
+
+	// offsets into shared memory must be multiples of this
+	size_t shared_memory_granularity();
+
+	lak::page_result_t<lak::shared_memory_handle> shared_memory_create(
+	  size_t size);
+
+	void shared_memory_close(lak::shared_memory_handle handle);
+
+	// copy_on_write mappings see writes made through shared mappings to the
+	// pages they haven't written to themselves
+	lak::page_result_t<lak::span<void>> shared_memory_map(
+	  lak::shared_memory_handle handle,
+	  size_t offset,
+	  size_t size,
+	  bool copy_on_write);
+
+	lak::page_result_t<> shared_memory_unmap(lak::span<void> pages);
+
 #if 0
   lak::page_result_t<bool> pages_are_committed(lak::span<void> pages);
 
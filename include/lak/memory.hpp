@@ -488,6 +488,28 @@ namespace lak
 
 		inline T *get() const { return _value.get(); }
 	};
+
+	/* --- is_trivially_relocatable --- */
+
+	template<typename T>
+	struct is_trivially_relocatable<lak::unique_ptr<T>> : lak::true_type
+	{
+	};
+
+	template<typename T>
+	struct is_trivially_relocatable<lak::unique_ref<T>> : lak::true_type
+	{
+	};
+
+	template<typename T>
+	struct is_trivially_relocatable<lak::shared_ptr<T>> : lak::true_type
+	{
+	};
+
+	template<typename T>
+	struct is_trivially_relocatable<lak::shared_ref<T>> : lak::true_type
+	{
+	};
 }
 
 #include "lak/memory.inl"
@@ -0,0 +1,84 @@
+#ifndef LAK_MPMC_BUFFER_HPP
+#define LAK_MPMC_BUFFER_HPP
+
+#include "lak/memmanip.hpp"
+#include "lak/optional.hpp"
+#include "lak/span.hpp"
+#include "lak/stdint.hpp"
+#include "lak/uninitialised.hpp"
+
+#include <atomic>
+
+namespace lak
+{
+	/* --- mpmc_buffer --- */
+
+	// Lock-free bounded queue for any number of producer and consumer threads
+	// (Dmitry Vyukov's bounded MPMC queue). S must be a power of two.
+	//
+	// Each cell carries a sequence number that says whether it is ready to be
+	// written (sequence == position) or read (sequence == position + 1) for
+	// the lap of the ring that position is on, so producers and consumers
+	// only contend on the position they claim with a CAS.
+	template<typename T, size_t S>
+	struct mpmc_buffer
+	{
+		static_assert(S > 0U && (S & (S - 1U)) == 0U,
+		              "mpmc_buffer size must be a power of two");
+
+		static constexpr size_t _mask = S - 1U;
+
+		struct cell
+		{
+			std::atomic_size_t sequence;
+			lak::uninitialised<T> value;
+		};
+
+		alignas(lak::cache_line_size) cell _cells[S];
+
+		alignas(lak::cache_line_size) std::atomic_size_t _enqueue_pos = 0U;
+
+		alignas(lak::cache_line_size) std::atomic_size_t _dequeue_pos = 0U;
+
+		mpmc_buffer();
+		mpmc_buffer(const mpmc_buffer &) = delete;
+		mpmc_buffer &operator=(const mpmc_buffer &) = delete;
+		~mpmc_buffer();
+
+		static constexpr size_t capacity() { return S; }
+
+		// approximate while other threads are pushing or popping
+		size_t size() const;
+		bool empty() const { return size() == 0U; }
+
+		// returns false if the buffer is full
+		template<typename... ARGS>
+		bool try_emplace(ARGS &&...args);
+		bool try_push(const T &value) { return try_emplace(value); }
+		bool try_push(T &&value) { return try_emplace(lak::move(value)); }
+
+		// claims a run of free cells with a single CAS and moves as many of
+		// values into them as will fit, returns the number of values moved
+		size_t try_push_batch(lak::span<T> values);
+
+		// returns nullopt if the buffer is empty
+		lak::optional<T> try_pop();
+
+		// claims a run of full cells with a single CAS and moves up to
+		// out.size() values out of them, returns the number of values moved
+		size_t try_pop_batch(lak::span<T> out);
+
+	private:
+		// claim up to max consecutive cells from pos whose sequence is their
+		// position + offset, returns the number claimed and sets first to the
+		// first claimed position
+		size_t _claim(std::atomic_size_t &pos,
+		              size_t offset,
+		              size_t max,
+		              size_t &first);
+	};
+}
+
+#include "lak/mpmc_buffer.inl"
+
+#endif
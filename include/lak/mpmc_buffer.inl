@@ -0,0 +1,134 @@
+#include "lak/mpmc_buffer.hpp"
+
+#include <algorithm>
+
+/* --- mpmc_buffer --- */
+
+template<typename T, size_t S>
+lak::mpmc_buffer<T, S>::mpmc_buffer()
+{
+	for (size_t i = 0U; i < S; ++i)
+		_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template<typename T, size_t S>
+lak::mpmc_buffer<T, S>::~mpmc_buffer()
+{
+	const size_t end{_enqueue_pos.load(std::memory_order_acquire)};
+	for (size_t pos{_dequeue_pos.load(std::memory_order_relaxed)}; pos != end;
+	     ++pos)
+		_cells[pos & _mask].value.destroy();
+}
+
+template<typename T, size_t S>
+size_t lak::mpmc_buffer<T, S>::size() const
+{
+	const size_t dequeue{_dequeue_pos.load(std::memory_order_acquire)};
+	const size_t enqueue{_enqueue_pos.load(std::memory_order_acquire)};
+	// the positions are read separately so dequeue may have overtaken enqueue
+	return ptrdiff_t(enqueue - dequeue) <= 0 ? 0U
+	                                         : std::min(enqueue - dequeue, S);
+}
+
+template<typename T, size_t S>
+size_t lak::mpmc_buffer<T, S>::_claim(std::atomic_size_t &pos,
+                                      size_t offset,
+                                      size_t max,
+                                      size_t &first)
+{
+	first = pos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		// count the ready cells from first. nobody else can claim these cells
+		// without moving pos, so they stay ready if the CAS succeeds.
+		size_t count{0U};
+		for (; count < max; ++count)
+		{
+			const size_t p{first + count};
+			const size_t seq{
+			  _cells[p & _mask].sequence.load(std::memory_order_acquire)};
+			if (seq != p + offset) break;
+		}
+
+		if (count == 0U)
+		{
+			const size_t p{first};
+			const size_t seq{
+			  _cells[p & _mask].sequence.load(std::memory_order_acquire)};
+			// behind: the cell hasn't been released by the previous lap (full
+			// for a producer, empty for a consumer)
+			if (ptrdiff_t(seq - (p + offset)) < 0) return 0U;
+			// ahead: another thread claimed first, reload and try again
+			first = pos.load(std::memory_order_relaxed);
+			continue;
+		}
+
+		if (pos.compare_exchange_weak(
+		      first, first + count, std::memory_order_relaxed))
+			return count;
+	}
+}
+
+template<typename T, size_t S>
+template<typename... ARGS>
+bool lak::mpmc_buffer<T, S>::try_emplace(ARGS &&...args)
+{
+	size_t pos;
+	if (_claim(_enqueue_pos, 0U, 1U, pos) == 0U) return false;
+
+	cell &c{_cells[pos & _mask]};
+	c.value.create(lak::forward<ARGS>(args)...);
+	c.sequence.store(pos + 1U, std::memory_order_release);
+	return true;
+}
+
+template<typename T, size_t S>
+size_t lak::mpmc_buffer<T, S>::try_push_batch(lak::span<T> values)
+{
+	if (values.empty()) return 0U;
+
+	size_t pos;
+	const size_t count{_claim(_enqueue_pos, 0U, values.size(), pos)};
+
+	for (size_t i = 0U; i < count; ++i)
+	{
+		cell &c{_cells[(pos + i) & _mask]};
+		c.value.create(lak::move(values[i]));
+		c.sequence.store(pos + i + 1U, std::memory_order_release);
+	}
+
+	return count;
+}
+
+template<typename T, size_t S>
+lak::optional<T> lak::mpmc_buffer<T, S>::try_pop()
+{
+	size_t pos;
+	if (_claim(_dequeue_pos, 1U, 1U, pos) == 0U) return lak::nullopt;
+
+	cell &c{_cells[pos & _mask]};
+	lak::optional<T> result{lak::move(c.value.value())};
+	c.value.destroy();
+	// ready to be written on the next lap
+	c.sequence.store(pos + S, std::memory_order_release);
+	return result;
+}
+
+template<typename T, size_t S>
+size_t lak::mpmc_buffer<T, S>::try_pop_batch(lak::span<T> out)
+{
+	if (out.empty()) return 0U;
+
+	size_t pos;
+	const size_t count{_claim(_dequeue_pos, 1U, out.size(), pos)};
+
+	for (size_t i = 0U; i < count; ++i)
+	{
+		cell &c{_cells[(pos + i) & _mask]};
+		out[i] = lak::move(c.value.value());
+		c.value.destroy();
+		c.sequence.store(pos + i + S, std::memory_order_release);
+	}
+
+	return count;
+}
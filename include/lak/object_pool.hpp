@@ -0,0 +1,76 @@
+#ifndef LAK_OBJECT_POOL_HPP
+#define LAK_OBJECT_POOL_HPP
+
+#include "lak/array.hpp"
+#include "lak/stdint.hpp"
+#include "lak/utility.hpp"
+
+#include <mutex>
+
+namespace lak
+{
+	/* --- object_pool --- */
+
+	// Global pool of fixed size slots for objects of type T.
+	//
+	// Slots are carved out of slabs and kept on intrusive free lists. Each
+	// thread caches up to two magazines (lists of magazine_size free slots),
+	// allocate and free only touch the shared depot (under its mutex) to swap
+	// a whole magazine, so the common case takes no lock.
+	//
+	// Slots may be freed from any thread. Slabs are never returned to the
+	// system, the pool only grows to the peak number of live objects.
+	template<typename T>
+	struct object_pool
+	{
+		union node
+		{
+			node *next;
+			alignas(T) byte_t data[sizeof(T)];
+		};
+
+		static constexpr size_t magazine_size = 32U;
+		static constexpr size_t slab_size =
+		  std::max<size_t>(64U * 1024U / sizeof(node), magazine_size);
+
+		struct magazine
+		{
+			node *head   = nullptr;
+			size_t count = 0U;
+
+			node *pop();
+			void push(node *n);
+		};
+
+		struct cache
+		{
+			magazine loaded;
+			magazine previous;
+			~cache();
+		};
+
+		static inline thread_local cache _cache;
+
+		static inline std::mutex _depot_mutex;
+		// magazines holding exactly magazine_size slots
+		static inline lak::array<node *> _full;
+		// slots from partially filled magazines of exited threads
+		static inline magazine _loose;
+
+		// a full magazine from the depot, allocating a slab if it's empty
+		static magazine take_full();
+		static void give_full(magazine m);
+
+		// storage for a T
+		[[nodiscard]] static void *allocate();
+		static void free(void *ptr);
+
+		template<typename... ARGS>
+		[[nodiscard]] static T *create(ARGS &&...args);
+		static void destroy(T *ptr);
+	};
+}
+
+#include "lak/object_pool.inl"
+
+#endif
@@ -0,0 +1,140 @@
+#include "lak/object_pool.hpp"
+
+#include "lak/alloc.hpp"
+#include "lak/debug.hpp"
+
+/* --- object_pool --- */
+
+template<typename T>
+typename lak::object_pool<T>::node *lak::object_pool<T>::magazine::pop()
+{
+	node *n{head};
+	head = n->next;
+	--count;
+	return n;
+}
+
+template<typename T>
+void lak::object_pool<T>::magazine::push(node *n)
+{
+	n->next = head;
+	head    = n;
+	++count;
+}
+
+template<typename T>
+lak::object_pool<T>::cache::~cache()
+{
+	std::lock_guard lock{_depot_mutex};
+	for (magazine *m : {&loaded, &previous})
+	{
+		while (m->count > 0U) _loose.push(m->pop());
+	}
+}
+
+template<typename T>
+typename lak::object_pool<T>::magazine lak::object_pool<T>::take_full()
+{
+	std::lock_guard lock{_depot_mutex};
+
+	magazine result;
+
+	if (!_full.empty())
+	{
+		result.head  = _full.popped_back();
+		result.count = magazine_size;
+		return result;
+	}
+
+	if (_loose.count > 0U)
+	{
+		while (_loose.count > 0U && result.count < magazine_size)
+			result.push(_loose.pop());
+		return result;
+	}
+
+	node *slab{reinterpret_cast<node *>(
+	  lak::global_alloc(sizeof(node) * slab_size, alignof(node))
+	    .expect("slab alloc failed")
+	    .data())};
+
+	for (size_t i = 0U; i < slab_size; i += magazine_size)
+	{
+		const size_t end{std::min(i + magazine_size, slab_size)};
+		for (size_t j = i; j < end; ++j)
+			slab[j].next = j + 1U < end ? &slab[j + 1U] : nullptr;
+		if (end - i == magazine_size)
+			_full.push_back(&slab[i]);
+		else
+			for (size_t j = i; j < end; ++j) _loose.push(&slab[j]);
+	}
+
+	result.head  = _full.popped_back();
+	result.count = magazine_size;
+	return result;
+}
+
+template<typename T>
+void lak::object_pool<T>::give_full(magazine m)
+{
+	ASSERT_EQUAL(m.count, magazine_size);
+	std::lock_guard lock{_depot_mutex};
+	_full.push_back(m.head);
+}
+
+template<typename T>
+void *lak::object_pool<T>::allocate()
+{
+	cache &c{_cache};
+
+	if (c.loaded.count == 0U)
+	{
+		if (c.previous.count > 0U)
+			lak::swap(c.loaded, c.previous);
+		else
+			c.loaded = take_full();
+	}
+
+	return c.loaded.pop()->data;
+}
+
+template<typename T>
+void lak::object_pool<T>::free(void *ptr)
+{
+	if (!ptr) return;
+
+	cache &c{_cache};
+
+	if (c.loaded.count == magazine_size)
+	{
+		if (c.previous.count == magazine_size)
+			give_full(lak::exchange(c.previous, magazine{}));
+		lak::swap(c.loaded, c.previous);
+	}
+
+	c.loaded.push(static_cast<node *>(ptr));
+}
+
+template<typename T>
+template<typename... ARGS>
+T *lak::object_pool<T>::create(ARGS &&...args)
+{
+	void *ptr{allocate()};
+	try
+	{
+		return new (ptr) T(lak::forward<ARGS>(args)...);
+	}
+	catch (...)
+	{
+		free(ptr);
+		throw;
+	}
+}
+
+template<typename T>
+void lak::object_pool<T>::destroy(T *ptr)
+{
+	if (!ptr) return;
+	ptr->~T();
+	free(ptr);
+}
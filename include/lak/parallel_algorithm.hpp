@@ -0,0 +1,108 @@
+#ifndef LAK_PARALLEL_ALGORITHM_HPP
+#define LAK_PARALLEL_ALGORITHM_HPP
+
+#include "lak/algorithm.hpp"
+#include "lak/tasks.hpp"
+
+#include <functional>
+#include <iterator>
+
+namespace lak
+{
+	/* --- parallel_chunk_size --- */
+
+	// chunks are kept to a whole number of cache lines so that neighbouring
+	// chunks never write to the same line, and large enough that the cost of
+	// pushing the job is noise next to the work in it.
+
+	static constexpr size_t parallel_cache_line      = 64U;
+	static constexpr size_t parallel_min_chunk_bytes = 16U * 1024U;
+	static constexpr size_t parallel_max_chunk_bytes = 1024U * 1024U;
+	// chunks per worker, gives the work stealing something to balance
+	static constexpr size_t parallel_chunks_per_worker = 4U;
+
+	template<typename T>
+	size_t parallel_chunk_size(size_t count, size_t workers);
+
+	/* --- parallel_for_chunks --- */
+
+	// Calls func(chunk_begin, chunk_end) for each chunk of [begin, end) on
+	// pool. The calling thread runs the first chunk itself.
+
+	template<typename ITER, typename F>
+	void parallel_for_chunks(lak::tasks &pool, ITER begin, ITER end, F &&func);
+
+	/* --- parallel_for --- */
+
+	template<typename ITER, typename F>
+	void parallel_for(lak::tasks &pool, ITER begin, ITER end, F &&func);
+
+	/* --- parallel_transform --- */
+
+	template<typename IN_ITER, typename OUT_ITER, typename F>
+	OUT_ITER parallel_transform(
+	  lak::tasks &pool, IN_ITER begin, IN_ITER end, OUT_ITER output, F &&func);
+
+	/* --- parallel_reduce --- */
+
+	// op must be associative, chunks are combined in order with init on the
+	// left. Each chunk is seeded with its first element, so op is called with
+	// (T, value_type) and (T, T).
+
+	template<typename ITER, typename T, typename OP>
+	T parallel_reduce(lak::tasks &pool, ITER begin, ITER end, T init, OP op);
+
+	/* --- parallel_accumulate --- */
+
+	// Folds each chunk with op(T, value_type) like std::accumulate, the first
+	// chunk from init and the rest from T{}, then folds the chunk results in
+	// order with combine(T, T). T{} must be an identity of combine, which
+	// must be associative.
+
+	template<typename ITER, typename T, typename OP = std::plus<>>
+	T parallel_accumulate(
+	  lak::tasks &pool, ITER begin, ITER end, T init, OP op = {});
+
+	template<typename ITER, typename T, typename OP, typename COMBINE>
+	T parallel_accumulate(lak::tasks &pool,
+	                      ITER begin,
+	                      ITER end,
+	                      T init,
+	                      OP op,
+	                      COMBINE combine);
+
+	/* --- parallel_count --- */
+
+	template<typename ITER, typename T>
+	size_t parallel_count(lak::tasks &pool,
+	                      ITER begin,
+	                      ITER end,
+	                      const T &value);
+
+	/* --- parallel_merge --- */
+
+	// Stable merge of the sorted ranges [begin_a, end_a) and [begin_b, end_b)
+	// into output, the output is split into independent pieces by binary
+	// searching the merge path.
+
+	template<typename IN_ITER, typename OUT_ITER, typename CMP = lak::less<>>
+	OUT_ITER parallel_merge(lak::tasks &pool,
+	                        IN_ITER begin_a,
+	                        IN_ITER end_a,
+	                        IN_ITER begin_b,
+	                        IN_ITER end_b,
+	                        OUT_ITER output,
+	                        CMP compare = {});
+
+	/* --- parallel_sort --- */
+
+	// Sorts chunks in parallel then merges them pairwise with parallel_merge.
+	// Uses a temporary buffer the size of the range. Not stable.
+
+	template<typename ITER, typename CMP = lak::less<>>
+	void parallel_sort(lak::tasks &pool, ITER begin, ITER end, CMP compare = {});
+}
+
+#include "lak/parallel_algorithm.inl"
+
+#endif
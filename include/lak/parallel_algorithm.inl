@@ -0,0 +1,346 @@
+#include "lak/parallel_algorithm.hpp"
+
+#include "lak/array.hpp"
+#include "lak/defer.hpp"
+#include "lak/math.hpp"
+
+#include <algorithm>
+
+/* --- parallel_chunk_size --- */
+
+template<typename T>
+size_t lak::parallel_chunk_size(size_t count, size_t workers)
+{
+	constexpr size_t line_elements{
+	  sizeof(T) >= lak::parallel_cache_line
+	    ? 1U
+	    : lak::parallel_cache_line / sizeof(T)};
+	constexpr size_t min_elements{
+	  std::max<size_t>(lak::parallel_min_chunk_bytes / sizeof(T), 1U)};
+	constexpr size_t max_elements{
+	  std::max<size_t>(lak::parallel_max_chunk_bytes / sizeof(T), 1U)};
+
+	if (workers == 0U || count == 0U) return count;
+
+	const size_t target_chunks{workers * lak::parallel_chunks_per_worker};
+	size_t chunk{(count + target_chunks - 1U) / target_chunks};
+	chunk = std::min(std::max(chunk, min_elements), max_elements);
+	chunk = (chunk + line_elements - 1U) / line_elements * line_elements;
+	return std::min(chunk, count);
+}
+
+/* --- parallel_for_chunks --- */
+
+template<typename ITER, typename F>
+void lak::parallel_for_chunks(lak::tasks &pool, ITER begin, ITER end, F &&func)
+{
+	static_assert(std::random_access_iterator<ITER>);
+	using value_type = std::iter_value_t<ITER>;
+
+	const size_t count{size_t(end - begin)};
+	if (count == 0U) return;
+
+	const size_t chunk{lak::parallel_chunk_size<value_type>(count, pool.size())};
+	if (chunk >= count)
+	{
+		func(begin, end);
+		return;
+	}
+
+	lak::array<lak::task_handle<lak::monostate>> handles;
+	handles.reserve(count / chunk);
+	// the jobs reference func, they must all finish before we return even if
+	// the chunk run on this thread throws
+	DEFER(for (auto &handle : handles) handle.wait().UNWRAP(););
+
+	for (size_t i = chunk; i < count; i += chunk)
+		handles.push_back(pool.push(
+		  [&func, b{begin + i}, e{begin + std::min(i + chunk, count)}]
+		  { func(b, e); }));
+
+	func(begin, begin + chunk);
+}
+
+/* --- parallel_for --- */
+
+template<typename ITER, typename F>
+void lak::parallel_for(lak::tasks &pool, ITER begin, ITER end, F &&func)
+{
+	lak::parallel_for_chunks(pool,
+	                         begin,
+	                         end,
+	                         [&func](ITER b, ITER e)
+	                         {
+		                         for (; b != e; ++b) func(*b);
+	                         });
+}
+
+/* --- parallel_transform --- */
+
+template<typename IN_ITER, typename OUT_ITER, typename F>
+OUT_ITER lak::parallel_transform(
+  lak::tasks &pool, IN_ITER begin, IN_ITER end, OUT_ITER output, F &&func)
+{
+	static_assert(std::random_access_iterator<OUT_ITER>);
+
+	lak::parallel_for_chunks(pool,
+	                         begin,
+	                         end,
+	                         [&](IN_ITER b, IN_ITER e)
+	                         {
+		                         OUT_ITER out{output + (b - begin)};
+		                         for (; b != e; ++b, ++out) *out = func(*b);
+	                         });
+
+	return output + (end - begin);
+}
+
+/* --- parallel_reduce --- */
+
+template<typename ITER, typename T, typename OP>
+T lak::parallel_reduce(lak::tasks &pool, ITER begin, ITER end, T init, OP op)
+{
+	static_assert(std::random_access_iterator<ITER>);
+	using value_type = std::iter_value_t<ITER>;
+
+	const size_t count{size_t(end - begin)};
+	if (count == 0U) return init;
+
+	auto reduce_chunk{[&op](ITER b, ITER e) -> T
+	                  {
+		                  T result(*b);
+		                  for (++b; b != e; ++b) result = op(lak::move(result), *b);
+		                  return result;
+	                  }};
+
+	const size_t chunk{lak::parallel_chunk_size<value_type>(count, pool.size())};
+	if (chunk >= count) return op(lak::move(init), reduce_chunk(begin, end));
+
+	lak::array<lak::task_handle<T>> handles;
+	handles.reserve(count / chunk);
+	DEFER(for (auto &handle : handles) (void)handle.wait(););
+
+	for (size_t i = chunk; i < count; i += chunk)
+		handles.push_back(pool.push(
+		  [&reduce_chunk, b{begin + i}, e{begin + std::min(i + chunk, count)}]
+		  { return reduce_chunk(b, e); }));
+
+	T result(op(lak::move(init), reduce_chunk(begin, begin + chunk)));
+	for (auto &handle : handles)
+		result = op(lak::move(result), lak::move(handle.wait().UNWRAP()));
+	return result;
+}
+
+/* --- parallel_accumulate --- */
+
+template<typename ITER, typename T, typename OP>
+T lak::parallel_accumulate(
+  lak::tasks &pool, ITER begin, ITER end, T init, OP op)
+{
+	return lak::parallel_accumulate(pool, begin, end, lak::move(init), op, op);
+}
+
+template<typename ITER, typename T, typename OP, typename COMBINE>
+T lak::parallel_accumulate(lak::tasks &pool,
+                           ITER begin,
+                           ITER end,
+                           T init,
+                           OP op,
+                           COMBINE combine)
+{
+	static_assert(std::random_access_iterator<ITER>);
+	using value_type = std::iter_value_t<ITER>;
+
+	auto accumulate_chunk{[&op](T result, ITER b, ITER e) -> T
+	                      {
+		                      for (; b != e; ++b)
+			                      result = op(lak::move(result), *b);
+		                      return result;
+	                      }};
+
+	const size_t count{size_t(end - begin)};
+	const size_t chunk{lak::parallel_chunk_size<value_type>(count, pool.size())};
+	if (chunk >= count) return accumulate_chunk(lak::move(init), begin, end);
+
+	lak::array<lak::task_handle<T>> handles;
+	handles.reserve(count / chunk);
+	DEFER(for (auto &handle : handles) (void)handle.wait(););
+
+	for (size_t i = chunk; i < count; i += chunk)
+		handles.push_back(pool.push(
+		  [&accumulate_chunk,
+		   b{begin + i},
+		   e{begin + std::min(i + chunk, count)}]
+		  { return accumulate_chunk(T{}, b, e); }));
+
+	T result(accumulate_chunk(lak::move(init), begin, begin + chunk));
+	for (auto &handle : handles)
+		result = combine(lak::move(result), lak::move(handle.wait().UNWRAP()));
+	return result;
+}
+
+/* --- parallel_count --- */
+
+template<typename ITER, typename T>
+size_t lak::parallel_count(lak::tasks &pool,
+                           ITER begin,
+                           ITER end,
+                           const T &value)
+{
+	static_assert(std::random_access_iterator<ITER>);
+	using value_type = std::iter_value_t<ITER>;
+
+	const size_t count{size_t(end - begin)};
+	const size_t chunk{lak::parallel_chunk_size<value_type>(count, pool.size())};
+	if (chunk >= count) return lak::count(begin, end, value);
+
+	lak::array<lak::task_handle<size_t>> handles;
+	handles.reserve(count / chunk);
+	DEFER(for (auto &handle : handles) (void)handle.wait(););
+
+	for (size_t i = chunk; i < count; i += chunk)
+		handles.push_back(pool.push(
+		  [&value, b{begin + i}, e{begin + std::min(i + chunk, count)}]
+		  { return lak::count(b, e, value); }));
+
+	size_t result{lak::count(begin, begin + chunk, value)};
+	for (auto &handle : handles) result += handle.wait().UNWRAP();
+	return result;
+}
+
+/* --- parallel_merge --- */
+
+template<typename IN_ITER, typename OUT_ITER, typename CMP>
+OUT_ITER lak::parallel_merge(lak::tasks &pool,
+                             IN_ITER begin_a,
+                             IN_ITER end_a,
+                             IN_ITER begin_b,
+                             IN_ITER end_b,
+                             OUT_ITER output,
+                             CMP compare)
+{
+	static_assert(std::random_access_iterator<IN_ITER>);
+	static_assert(std::random_access_iterator<OUT_ITER>);
+
+	const size_t count_a{size_t(end_a - begin_a)};
+	const size_t count_b{size_t(end_b - begin_b)};
+
+	// number of elements from a in the first diagonal elements of the output
+	auto co_rank{[&](size_t diagonal) -> size_t
+	             {
+		             size_t low{diagonal > count_b ? diagonal - count_b : 0U};
+		             size_t high{std::min(diagonal, count_a)};
+		             for (;;)
+		             {
+			             const size_t i{low + (high - low) / 2U};
+			             const size_t j{diagonal - i};
+			             if (i > 0U && j < count_b &&
+			                 compare(begin_b[j], begin_a[i - 1U]))
+				             high = i - 1U;
+			             else if (j > 0U && i < count_a &&
+			                      !compare(begin_b[j - 1U], begin_a[i]))
+				             low = i + 1U;
+			             else
+				             return i;
+		             }
+	             }};
+
+	// split the output, each chunk of output is an independent merge
+	lak::parallel_for_chunks(
+	  pool,
+	  output,
+	  output + (count_a + count_b),
+	  [&](OUT_ITER b, OUT_ITER e)
+	  {
+		  const size_t d0{size_t(b - output)};
+		  const size_t d1{size_t(e - output)};
+		  const size_t i0{co_rank(d0)};
+		  const size_t i1{co_rank(d1)};
+		  std::merge(std::make_move_iterator(begin_a + i0),
+		             std::make_move_iterator(begin_a + i1),
+		             std::make_move_iterator(begin_b + (d0 - i0)),
+		             std::make_move_iterator(begin_b + (d1 - i1)),
+		             b,
+		             compare);
+	  });
+
+	return output + (count_a + count_b);
+}
+
+/* --- parallel_sort --- */
+
+template<typename ITER, typename CMP>
+void lak::parallel_sort(lak::tasks &pool, ITER begin, ITER end, CMP compare)
+{
+	static_assert(std::random_access_iterator<ITER>);
+	using value_type = std::iter_value_t<ITER>;
+
+	const size_t count{size_t(end - begin)};
+	const size_t chunk{lak::parallel_chunk_size<value_type>(count, pool.size())};
+	if (chunk >= count)
+	{
+		std::sort(begin, end, compare);
+		return;
+	}
+
+	// sort runs of a power of two chunk count so that the merge tree is
+	// balanced
+	size_t runs{1U};
+	while (runs * 2U <= (count + chunk - 1U) / chunk &&
+	       runs < pool.size() * lak::parallel_chunks_per_worker)
+		runs *= 2U;
+	const size_t run_size{(count + runs - 1U) / runs};
+
+	auto run_begin{[&](auto base, size_t run)
+	               { return base + std::min(run * run_size, count); }};
+
+	{
+		lak::array<lak::task_handle<lak::monostate>> handles;
+		handles.reserve(runs);
+		DEFER(for (auto &handle : handles) handle.wait().UNWRAP(););
+		for (size_t run = 1U; run < runs; ++run)
+			handles.push_back(pool.push(
+			  [&, run]
+			  {
+				  std::sort(run_begin(begin, run), run_begin(begin, run + 1U), compare);
+			  }));
+		std::sort(begin, run_begin(begin, 1U), compare);
+	}
+
+	lak::array<value_type> buffer;
+	buffer.resize(count);
+
+	bool in_buffer{false};
+	for (size_t width = 1U; width < runs; width *= 2U)
+	{
+		for (size_t run = 0U; run < runs; run += width * 2U)
+		{
+			const size_t mid{std::min(run + width, runs)};
+			const size_t last{std::min(run + width * 2U, runs)};
+			if (in_buffer)
+				lak::parallel_merge(pool,
+				                    run_begin(buffer.begin(), run),
+				                    run_begin(buffer.begin(), mid),
+				                    run_begin(buffer.begin(), mid),
+				                    run_begin(buffer.begin(), last),
+				                    run_begin(begin, run),
+				                    compare);
+			else
+				lak::parallel_merge(pool,
+				                    run_begin(begin, run),
+				                    run_begin(begin, mid),
+				                    run_begin(begin, mid),
+				                    run_begin(begin, last),
+				                    run_begin(buffer.begin(), run),
+				                    compare);
+		}
+		in_buffer = !in_buffer;
+	}
+
+	if (in_buffer)
+		lak::parallel_transform(pool,
+		                        buffer.begin(),
+		                        buffer.end(),
+		                        begin,
+		                        [](value_type &v) { return lak::move(v); });
+}
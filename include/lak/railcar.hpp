@@ -66,15 +66,23 @@ namespace lak
 
 	/* --- railcar --- */
 
+	// Array of fixed size bins, elements never move when the railcar grows.
+	// Bin sizes are rounded up to a power of two so indexing is a shift and
+	// a mask. Bins emptied by pop_back, erase, resize and clear are kept for
+	// reuse until shrink_to_fit or force_clear.
 	template<typename T>
 	struct railcar
 	{
 	private:
 		lak::array<lak::array<T>> _data = {};
-		size_t _bin_size                = 0;
+		// emptied bins with a capacity of _bin_size
+		lak::array<lak::array<T>> _spare = {};
+		size_t _bin_size                 = 0;
+		size_t _bin_shift                = 0;
 
-		void internal_init_bin_size();
+		void internal_init_bin_size(size_t bin_size = 0);
 		void internal_alloc_end();
+		void internal_free_end();
 
 	public:
 		using value_type      = T;
@@ -89,6 +97,10 @@ namespace lak
 
 		railcar() = default;
 
+		// elements per bin, rounded up to a power of two. Note that braced
+		// initialisation picks the initializer_list constructor instead.
+		explicit railcar(size_t bin_size);
+
 		railcar(const railcar &)
 		requires lak::concepts::copy_constructible<T>;
 		railcar &operator=(const railcar &)
@@ -108,8 +120,12 @@ namespace lak
 		void resize(size_t new_size);
 		void clear();
 		void reserve(size_t new_capacity);
+		// frees the spare bins
+		void shrink_to_fit();
 		void force_clear();
 
+		size_t bin_size() const { return _bin_size; }
+
 		[[nodiscard]] bool empty() const { return _data.size() == 0; }
 
 		iterator begin();
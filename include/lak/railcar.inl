@@ -2,6 +2,8 @@
 
 #include "lak/debug.hpp"
 
+#include <bit>
+
 /* --- railcar_iterator --- */
 
 template<typename T>
@@ -160,11 +162,15 @@ bool lak::railcar_iterator<T>::operator<=(const railcar_iterator &other) const
 /* --- railcar --- */
 
 template<typename T>
-void lak::railcar<T>::internal_init_bin_size()
+void lak::railcar<T>::internal_init_bin_size(size_t bin_size)
 {
-	if (_bin_size == 0)
-		_bin_size = std::max<size_t>(lak::page_size() / sizeof(T), size_t(1));
-	ASSERT_GREATER(_bin_size, 1U);
+	if (_bin_size != 0) return;
+	if (bin_size == 0)
+		// as many elements as fit in a page, but no fewer than 8
+		bin_size = std::bit_floor(
+		  std::max<size_t>(lak::page_size() / sizeof(T), size_t(8)));
+	_bin_size  = std::bit_ceil(std::max<size_t>(bin_size, size_t(2)));
+	_bin_shift = size_t(std::countr_zero(_bin_size));
 }
 
 template<typename T>
@@ -173,45 +179,70 @@ void lak::railcar<T>::internal_alloc_end()
 	if (_data.empty() || _data.back().size() == _bin_size)
 	{
 		internal_init_bin_size();
-		lak::array<T> new_bin;
-		new_bin.reserve(_bin_size);
-		_data.emplace_back(lak::move(new_bin));
+		if (_spare.empty())
+			_data.emplace_back().reserve(_bin_size);
+		else
+			_data.push_back(_spare.popped_back());
 	}
 	ASSERT_NOT_EQUAL(_data.back().size(), _bin_size);
 }
 
+template<typename T>
+void lak::railcar<T>::internal_free_end()
+{
+	ASSERT(_data.back().empty());
+	_spare.push_back(_data.popped_back());
+}
+
+template<typename T>
+lak::railcar<T>::railcar(size_t bin_size)
+{
+	internal_init_bin_size(bin_size);
+}
+
 template<typename T>
 lak::railcar<T>::railcar(const railcar &other)
 requires lak::concepts::copy_constructible<T>
-#if !(defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE))
-: _data(other._data)
-#endif
 {
+	// copy element by element so every bin gets its full capacity up front
+	internal_init_bin_size(other._bin_size);
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 	if constexpr (!lak::concepts::copy_constructible<T>)
 		ASSERT_UNREACHABLE();
 	else
-		_data = other._data;
 #endif
+		for (const auto &bin : other._data)
+			for (const T &value : bin) push_back(value);
 }
 
 template<typename T>
 lak::railcar<T> &lak::railcar<T>::operator=(const railcar &other)
 requires lak::concepts::copy_constructible<T>
 {
+	if (this == &other) return *this;
+	clear();
+	if (_bin_size != other._bin_size)
+	{
+		force_clear();
+		_bin_size = 0;
+		internal_init_bin_size(other._bin_size);
+	}
 #if defined(LAK_COMPILER_CLANG) && defined(LAK_OS_APPLE)
 	if constexpr (!lak::concepts::copy_constructible<T>)
 		ASSERT_UNREACHABLE();
 	else
 #endif
-		_data = other._data;
+		for (const auto &bin : other._data)
+			for (const T &value : bin) push_back(value);
 	return *this;
 }
 
 template<typename T>
 lak::railcar<T>::railcar(railcar &&other)
 : _data(lak::exchange(other._data, lak::array<lak::array<T>>{})),
-  _bin_size(other._bin_size)
+  _spare(lak::exchange(other._spare, lak::array<lak::array<T>>{})),
+  _bin_size(other._bin_size),
+  _bin_shift(other._bin_shift)
 {
 }
 
@@ -219,7 +250,9 @@ template<typename T>
 lak::railcar<T> &lak::railcar<T>::operator=(railcar &&other)
 {
 	lak::swap(_data, other._data);
+	lak::swap(_spare, other._spare);
 	lak::swap(_bin_size, other._bin_size);
+	lak::swap(_bin_shift, other._bin_shift);
 	return *this;
 }
 
@@ -254,7 +287,7 @@ lak::railcar<T>::railcar(ITER &&begin, ITER &&end)
 template<typename T>
 size_t lak::railcar<T>::size() const
 {
-	size_t result = _data.size() * _bin_size;
+	size_t result = _data.size() << _bin_shift;
 	if (!_data.empty()) result -= (_bin_size - _data.back().size());
 	return result;
 }
@@ -276,21 +309,34 @@ void lak::railcar<T>::resize(size_t new_size)
 template<typename T>
 void lak::railcar<T>::clear()
 {
-	resize(0);
+	while (!_data.empty())
+	{
+		_data.back().clear();
+		internal_free_end();
+	}
 }
 
 template<typename T>
 void lak::railcar<T>::reserve(size_t new_capacity)
 {
 	internal_init_bin_size();
-	_data.reserve(new_capacity / _bin_size);
+	const size_t bins{(new_capacity + _bin_size - 1U) >> _bin_shift};
+	_data.reserve(bins);
+	while (_data.size() + _spare.size() < bins)
+		_spare.emplace_back().reserve(_bin_size);
+}
+
+template<typename T>
+void lak::railcar<T>::shrink_to_fit()
+{
+	_spare.force_clear();
 }
 
 template<typename T>
 void lak::railcar<T>::force_clear()
 {
 	_data.force_clear();
-	_bin_size = 0;
+	_spare.force_clear();
 }
 
 template<typename T>
@@ -320,25 +366,25 @@ typename lak::railcar<T>::const_iterator lak::railcar<T>::cend() const
 template<typename T>
 T &lak::railcar<T>::at(size_t index)
 {
-	return _data[index / _bin_size][index % _bin_size];
+	return _data[index >> _bin_shift][index & (_bin_size - 1U)];
 }
 
 template<typename T>
 const T &lak::railcar<T>::at(size_t index) const
 {
-	return _data[index / _bin_size][index % _bin_size];
+	return _data[index >> _bin_shift][index & (_bin_size - 1U)];
 }
 
 template<typename T>
 T &lak::railcar<T>::operator[](size_t index)
 {
-	return _data[index / _bin_size][index % _bin_size];
+	return _data[index >> _bin_shift][index & (_bin_size - 1U)];
 }
 
 template<typename T>
 const T &lak::railcar<T>::operator[](size_t index) const
 {
-	return _data[index / _bin_size][index % _bin_size];
+	return _data[index >> _bin_shift][index & (_bin_size - 1U)];
 }
 
 template<typename T>
@@ -400,7 +446,7 @@ template<typename T>
 void lak::railcar<T>::pop_back()
 {
 	_data.back().pop_back();
-	if (_data.back().empty()) _data.pop_back();
+	if (_data.back().empty()) internal_free_end();
 }
 
 template<typename T>
@@ -427,9 +473,9 @@ T *lak::railcar<T>::erase(const T *element)
 		next_page.erase(next_page.begin());
 	}
 
-	// If the last page only had 1 element in it it will now be empty, remove the
-	// page.
-	if (_data.back().empty()) _data.pop_back();
+	// If the last page only had 1 element in it it will now be empty, recycle
+	// the page.
+	if (_data.back().empty()) internal_free_end();
 
 	return result;
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef LAK_SLOT_MAP_HPP
+#define LAK_SLOT_MAP_HPP
+
+#include "lak/array.hpp"
+#include "lak/span.hpp"
+#include "lak/stdint.hpp"
+
+namespace lak
+{
+	/* --- slot_handle --- */
+
+	// 24 bit slot index and 8 bit generation. A slot's generation changes
+	// every time its value is erased, so handles to erased values stop
+	// resolving instead of aliasing whatever reuses the slot (until the
+	// generation wraps around).
+	struct slot_handle
+	{
+		static constexpr uint32_t index_bits     = 24U;
+		static constexpr uint32_t index_mask     = (1U << index_bits) - 1U;
+		static constexpr uint32_t max_generation = 0xFFU;
+
+		// the null handle, its index is never allocated
+		uint32_t value = UINT32_MAX;
+
+		static constexpr lak::slot_handle make(uint32_t index,
+		                                       uint32_t generation)
+		{
+			return {(generation << index_bits) | index};
+		}
+
+		constexpr uint32_t index() const { return value & index_mask; }
+		constexpr uint32_t generation() const { return value >> index_bits; }
+
+		constexpr bool is_null() const { return value == UINT32_MAX; }
+		constexpr explicit operator bool() const { return !is_null(); }
+
+		constexpr bool operator==(const slot_handle &rhs) const = default;
+		constexpr auto operator<=>(const slot_handle &rhs) const = default;
+	};
+
+	/* --- slot_map --- */
+
+	// Unordered container addressed by slot_handles. Insert, erase and lookup
+	// are O(1), the values are kept contiguous so iterating only touches live
+	// values. Erasing moves the last value into the hole, pointers to values
+	// are invalidated by insert and erase but handles are not.
+	//
+	// A slot's generation wraps back to 0 after max_generation, so slots are
+	// reused forever and only the number of live values is limited. A stale
+	// handle can only resolve to a newer value once its slot has been erased
+	// another max_generation + 1 times.
+	template<typename T>
+	struct slot_map
+	{
+	private:
+		static constexpr uint32_t _no_slot = UINT32_MAX;
+
+		struct slot
+		{
+			// index into _values while live, the next free slot otherwise
+			uint32_t index;
+			uint32_t generation;
+		};
+
+		lak::array<T> _values;
+		// the slot of each value in _values
+		lak::array<uint32_t> _owners;
+		lak::array<slot> _slots;
+		uint32_t _free = _no_slot;
+
+		uint32_t internal_alloc_slot();
+		void internal_free_slot(uint32_t slot_index);
+
+	public:
+		using value_type     = T;
+		using size_type      = size_t;
+		using iterator       = T *;
+		using const_iterator = const T *;
+
+		slot_map()                            = default;
+		slot_map(const slot_map &)            = default;
+		slot_map &operator=(const slot_map &) = default;
+		slot_map(slot_map &&other);
+		slot_map &operator=(slot_map &&other);
+
+		size_t size() const { return _values.size(); }
+		[[nodiscard]] bool empty() const { return _values.empty(); }
+
+		void reserve(size_t new_capacity);
+		// invalidates every handle
+		void clear();
+
+		template<typename... ARGS>
+		lak::slot_handle emplace(ARGS &&...args);
+		lak::slot_handle insert(const T &value);
+		lak::slot_handle insert(T &&value);
+
+		// false if handle was already erased
+		bool erase(lak::slot_handle handle);
+
+		[[nodiscard]] bool contains(lak::slot_handle handle) const;
+
+		// nullptr if handle has been erased
+		T *get(lak::slot_handle handle);
+		const T *get(lak::slot_handle handle) const;
+
+		// the handle of data()[index]
+		lak::slot_handle handle_at(size_t index) const;
+
+		T *data() { return _values.data(); }
+		const T *data() const { return _values.data(); }
+
+		iterator begin() { return _values.begin(); }
+		iterator end() { return _values.end(); }
+		const_iterator begin() const { return _values.begin(); }
+		const_iterator end() const { return _values.end(); }
+		const_iterator cbegin() const { return _values.cbegin(); }
+		const_iterator cend() const { return _values.cend(); }
+
+		operator lak::span<T>() { return lak::span<T>(_values); }
+		operator lak::span<const T>() const
+		{
+			return lak::span<const T>(_values);
+		}
+	};
+}
+
+#include "lak/slot_map.inl"
+
+#endif
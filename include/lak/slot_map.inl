@@ -0,0 +1,137 @@
+#include "lak/slot_map.hpp"
+
+#include "lak/debug.hpp"
+#include "lak/utility.hpp"
+
+/* --- slot_map --- */
+
+template<typename T>
+uint32_t lak::slot_map<T>::internal_alloc_slot()
+{
+	if (_free != _no_slot) return lak::exchange(_free, _slots[_free].index);
+
+	// index_mask itself is never allocated, so no generation of any slot can
+	// make the null handle
+	ASSERTF(_slots.size() < lak::slot_handle::index_mask,
+	        "slot_map ran out of slots, every slot is live");
+	_slots.push_back(slot{.index = _no_slot, .generation = 0U});
+	return uint32_t(_slots.size() - 1U);
+}
+
+template<typename T>
+void lak::slot_map<T>::internal_free_slot(uint32_t slot_index)
+{
+	slot &s{_slots[slot_index]};
+	s.generation = (s.generation + 1U) & lak::slot_handle::max_generation;
+	s.index      = _free;
+	_free   = slot_index;
+}
+
+template<typename T>
+lak::slot_map<T>::slot_map(slot_map &&other)
+: _values(lak::move(other._values)),
+  _owners(lak::move(other._owners)),
+  _slots(lak::move(other._slots)),
+  _free(lak::exchange(other._free, _no_slot))
+{
+}
+
+template<typename T>
+lak::slot_map<T> &lak::slot_map<T>::operator=(slot_map &&other)
+{
+	lak::swap(_values, other._values);
+	lak::swap(_owners, other._owners);
+	lak::swap(_slots, other._slots);
+	lak::swap(_free, other._free);
+	return *this;
+}
+
+template<typename T>
+void lak::slot_map<T>::reserve(size_t new_capacity)
+{
+	_values.reserve(new_capacity);
+	_owners.reserve(new_capacity);
+	_slots.reserve(new_capacity);
+}
+
+template<typename T>
+void lak::slot_map<T>::clear()
+{
+	for (uint32_t owner : _owners) internal_free_slot(owner);
+	_values.clear();
+	_owners.clear();
+}
+
+template<typename T>
+template<typename... ARGS>
+lak::slot_handle lak::slot_map<T>::emplace(ARGS &&...args)
+{
+	_values.emplace_back(lak::forward<ARGS>(args)...);
+	const uint32_t slot_index{internal_alloc_slot()};
+	_owners.push_back(slot_index);
+	slot &s{_slots[slot_index]};
+	s.index = uint32_t(_values.size() - 1U);
+	return lak::slot_handle::make(slot_index, s.generation);
+}
+
+template<typename T>
+lak::slot_handle lak::slot_map<T>::insert(const T &value)
+{
+	return emplace(value);
+}
+
+template<typename T>
+lak::slot_handle lak::slot_map<T>::insert(T &&value)
+{
+	return emplace(lak::move(value));
+}
+
+template<typename T>
+bool lak::slot_map<T>::erase(lak::slot_handle handle)
+{
+	if (!contains(handle)) return false;
+
+	const uint32_t index{_slots[handle.index()].index};
+	if (const size_t last{_values.size() - 1U}; index != last)
+	{
+		_values[index]               = lak::move(_values[last]);
+		_owners[index]               = _owners[last];
+		_slots[_owners[index]].index = index;
+	}
+	_values.pop_back();
+	_owners.pop_back();
+
+	internal_free_slot(handle.index());
+	return true;
+}
+
+template<typename T>
+bool lak::slot_map<T>::contains(lak::slot_handle handle) const
+{
+	// the null handle's index is never allocated, and erasing a value always
+	// changes its slot's generation
+	return handle.index() < _slots.size() &&
+	       _slots[handle.index()].generation == handle.generation();
+}
+
+template<typename T>
+T *lak::slot_map<T>::get(lak::slot_handle handle)
+{
+	return contains(handle) ? &_values[_slots[handle.index()].index]
+	                        : nullptr;
+}
+
+template<typename T>
+const T *lak::slot_map<T>::get(lak::slot_handle handle) const
+{
+	return contains(handle) ? &_values[_slots[handle.index()].index]
+	                        : nullptr;
+}
+
+template<typename T>
+lak::slot_handle lak::slot_map<T>::handle_at(size_t index) const
+{
+	ASSERT_LESS(index, _values.size());
+	const uint32_t slot_index{_owners[index]};
+	return lak::slot_handle::make(slot_index, _slots[slot_index].generation);
+}
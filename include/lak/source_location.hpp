@@ -0,0 +1,27 @@
+#ifndef LAK_SOURCE_LOCATION_HPP
+#define LAK_SOURCE_LOCATION_HPP
+
+#include "lak/stdint.hpp"
+
+#include <version>
+#ifdef __cpp_lib_source_location
+#	include <source_location>
+#endif
+
+namespace lak
+{
+#ifdef __cpp_lib_source_location
+	using source_location = std::source_location;
+#else
+	struct source_location
+	{
+		static source_location current() { return {}; }
+		constexpr const char *file_name() const { return {}; }
+		constexpr const char *function_name() const { return {}; }
+		constexpr uint_least32_t line() const { return 0U; }
+		constexpr uint_least32_t column() const { return 0U; }
+	};
+#endif
+}
+
+#endif
@@ -11,7 +11,9 @@
 
 namespace lak
 {
-	template<typename T, size_t SIZE>
+	struct default_allocator;
+
+	template<typename T, size_t SIZE, typename ALLOC = lak::default_allocator>
 	struct array;
 
 	template<typename T>
@@ -381,11 +383,11 @@ namespace lak
 	template<typename T>
 	span(std::initializer_list<T> &) -> span<const T>;
 
-	template<typename T, size_t N>
-	span(const lak::array<T, N> &) -> span<const T, N>;
+	template<typename T, size_t N, typename ALLOC>
+	span(const lak::array<T, N, ALLOC> &) -> span<const T, N>;
 
-	template<typename T, size_t N>
-	span(lak::array<T, N> &) -> span<T, N>;
+	template<typename T, size_t N, typename ALLOC>
+	span(lak::array<T, N, ALLOC> &) -> span<T, N>;
 
 	template<typename T, size_t N>
 	span(T (&)[N]) -> span<T, N>;
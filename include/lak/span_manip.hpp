@@ -72,6 +72,10 @@ namespace lak
 	template<typename T>
 	lak::span<T> common_initial_sequence(lak::span<T> a, lak::span<T> b);
 
+	// trivially relocatable elements are rotated by copying the shorter side
+	// through a stack buffer when it fits in _rotate_buffer_size bytes
+	static constexpr size_t _rotate_buffer_size = 512U;
+
 	template<typename T>
 	lak::span<T> rotate_left(lak::span<T> data, size_t distance = 1);
 
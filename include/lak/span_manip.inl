@@ -5,6 +5,9 @@
 #include "lak/result.hpp"
 #include "lak/span.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 template<size_t S, typename T>
 lak::result<lak::span<T, S>> lak::as_const_sized(lak::span<T> s)
 {
@@ -105,6 +108,32 @@ lak::span<T> lak::common_initial_sequence(lak::span<T> a, lak::span<T> b)
 template<typename T>
 lak::span<T> lak::rotate_left(lak::span<T> data, size_t distance)
 {
+	if constexpr (lak::is_trivially_relocatable_v<T>)
+	{
+		const size_t size = data.size();
+		if (size == 0 || (distance %= size) == 0) return data;
+
+		const size_t right = size - distance;
+		if (std::min(distance, right) * sizeof(T) <= lak::_rotate_buffer_size)
+		{
+			alignas(T) byte_t buffer[lak::_rotate_buffer_size];
+			T *begin = data.data();
+			if (distance <= right)
+			{
+				std::memcpy(buffer, begin, distance * sizeof(T));
+				std::memmove(begin, begin + distance, right * sizeof(T));
+				std::memcpy(begin + right, buffer, distance * sizeof(T));
+			}
+			else
+			{
+				std::memcpy(buffer, begin + distance, right * sizeof(T));
+				std::memmove(begin + right, begin, distance * sizeof(T));
+				std::memcpy(begin, buffer, right * sizeof(T));
+			}
+			return data;
+		}
+	}
+
 	lak::rotate_left(data.begin(), data.end(), distance);
 
 	return data;
@@ -113,6 +142,12 @@ lak::span<T> lak::rotate_left(lak::span<T> data, size_t distance)
 template<typename T>
 lak::span<T> lak::rotate_right(lak::span<T> data, size_t distance)
 {
+	if constexpr (lak::is_trivially_relocatable_v<T>)
+	{
+		if (data.empty()) return data;
+		return lak::rotate_left(data, data.size() - distance % data.size());
+	}
+
 	lak::rotate_right(data.begin(), data.end(), distance);
 
 	return data;
@@ -0,0 +1,83 @@
+#ifndef LAK_SPSC_BUFFER_HPP
+#define LAK_SPSC_BUFFER_HPP
+
+#include "lak/memmanip.hpp"
+#include "lak/optional.hpp"
+#include "lak/span.hpp"
+#include "lak/stdint.hpp"
+#include "lak/uninitialised.hpp"
+
+#include <atomic>
+
+namespace lak
+{
+	/* --- spsc_buffer --- */
+
+	// Lock-free bounded ring buffer for exactly one producer thread and one
+	// consumer thread. S must be a power of two.
+	//
+	// _head and _tail count forever and are masked on access. Each side keeps
+	// a cached copy of the other side's index so that it only touches the
+	// other side's cache line when the ring looks full (or empty).
+	template<typename T, size_t S>
+	struct spsc_buffer
+	{
+		static_assert(S > 0U && (S & (S - 1U)) == 0U,
+		              "spsc_buffer size must be a power of two");
+
+		static constexpr size_t _mask = S - 1U;
+
+		// written by the producer
+		alignas(lak::cache_line_size) std::atomic_size_t _tail = 0U;
+		size_t _cached_head                                    = 0U;
+
+		// written by the consumer
+		alignas(lak::cache_line_size) std::atomic_size_t _head = 0U;
+		size_t _cached_tail                                    = 0U;
+
+		alignas(lak::cache_line_size) lak::uninitialised<T> _buffer[S];
+
+		spsc_buffer() = default;
+		spsc_buffer(const spsc_buffer &) = delete;
+		spsc_buffer &operator=(const spsc_buffer &) = delete;
+		~spsc_buffer();
+
+		static constexpr size_t capacity() { return S; }
+
+		// only exact when called from the producer or consumer while the other
+		// side is idle
+		size_t size() const;
+		bool empty() const { return size() == 0U; }
+
+		/* --- producer --- */
+
+		// returns false if the buffer is full
+		template<typename... ARGS>
+		bool try_emplace(ARGS &&...args);
+		bool try_push(const T &value) { return try_emplace(value); }
+		bool try_push(T &&value) { return try_emplace(lak::move(value)); }
+
+		// moves as many of values as will fit into the buffer, returns the
+		// number of values moved
+		size_t try_push_batch(lak::span<T> values);
+
+		/* --- consumer --- */
+
+		// returns nullopt if the buffer is empty
+		lak::optional<T> try_pop();
+
+		// moves up to out.size() values out of the buffer into out, returns the
+		// number of values moved
+		size_t try_pop_batch(lak::span<T> out);
+
+	private:
+		// number of free slots, refreshing _cached_head if fewer than wanted
+		size_t _free_slots(size_t tail, size_t wanted);
+		// number of used slots, refreshing _cached_tail if fewer than wanted
+		size_t _used_slots(size_t head, size_t wanted);
+	};
+}
+
+#include "lak/spsc_buffer.inl"
+
+#endif
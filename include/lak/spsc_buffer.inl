@@ -0,0 +1,102 @@
+#include "lak/spsc_buffer.hpp"
+
+#include <algorithm>
+
+/* --- spsc_buffer --- */
+
+template<typename T, size_t S>
+lak::spsc_buffer<T, S>::~spsc_buffer()
+{
+	const size_t tail{_tail.load(std::memory_order_acquire)};
+	for (size_t head{_head.load(std::memory_order_relaxed)}; head != tail;
+	     ++head)
+		_buffer[head & _mask].destroy();
+}
+
+template<typename T, size_t S>
+size_t lak::spsc_buffer<T, S>::size() const
+{
+	const size_t head{_head.load(std::memory_order_acquire)};
+	const size_t tail{_tail.load(std::memory_order_acquire)};
+	return std::min(tail - head, S);
+}
+
+template<typename T, size_t S>
+size_t lak::spsc_buffer<T, S>::_free_slots(size_t tail, size_t wanted)
+{
+	size_t free{S - (tail - _cached_head)};
+	if (free < wanted)
+	{
+		_cached_head = _head.load(std::memory_order_acquire);
+		free         = S - (tail - _cached_head);
+	}
+	return free;
+}
+
+template<typename T, size_t S>
+size_t lak::spsc_buffer<T, S>::_used_slots(size_t head, size_t wanted)
+{
+	size_t used{_cached_tail - head};
+	if (used < wanted)
+	{
+		_cached_tail = _tail.load(std::memory_order_acquire);
+		used         = _cached_tail - head;
+	}
+	return used;
+}
+
+template<typename T, size_t S>
+template<typename... ARGS>
+bool lak::spsc_buffer<T, S>::try_emplace(ARGS &&...args)
+{
+	const size_t tail{_tail.load(std::memory_order_relaxed)};
+	if (_free_slots(tail, 1U) == 0U) return false;
+
+	_buffer[tail & _mask].create(lak::forward<ARGS>(args)...);
+	_tail.store(tail + 1U, std::memory_order_release);
+	return true;
+}
+
+template<typename T, size_t S>
+size_t lak::spsc_buffer<T, S>::try_push_batch(lak::span<T> values)
+{
+	const size_t tail{_tail.load(std::memory_order_relaxed)};
+	const size_t count{std::min(_free_slots(tail, values.size()), values.size())};
+
+	for (size_t i = 0U; i < count; ++i)
+		_buffer[(tail + i) & _mask].create(lak::move(values[i]));
+
+	// publish the whole batch with one store
+	if (count > 0U) _tail.store(tail + count, std::memory_order_release);
+	return count;
+}
+
+template<typename T, size_t S>
+lak::optional<T> lak::spsc_buffer<T, S>::try_pop()
+{
+	const size_t head{_head.load(std::memory_order_relaxed)};
+	if (_used_slots(head, 1U) == 0U) return lak::nullopt;
+
+	lak::uninitialised<T> &slot{_buffer[head & _mask]};
+	lak::optional<T> result{lak::move(slot.value())};
+	slot.destroy();
+	_head.store(head + 1U, std::memory_order_release);
+	return result;
+}
+
+template<typename T, size_t S>
+size_t lak::spsc_buffer<T, S>::try_pop_batch(lak::span<T> out)
+{
+	const size_t head{_head.load(std::memory_order_relaxed)};
+	const size_t count{std::min(_used_slots(head, out.size()), out.size())};
+
+	for (size_t i = 0U; i < count; ++i)
+	{
+		lak::uninitialised<T> &slot{_buffer[(head + i) & _mask]};
+		out[i] = lak::move(slot.value());
+		slot.destroy();
+	}
+
+	if (count > 0U) _head.store(head + count, std::memory_order_release);
+	return count;
+}
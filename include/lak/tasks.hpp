@@ -1,30 +1,203 @@
 #ifndef LAK_TASKS_HPP
 #define LAK_TASKS_HPP
 
-#include "lak/array.hpp"
+#include "lak/memory.hpp"
+#include "lak/object_pool.hpp"
+#include "lak/optional.hpp"
+#include "lak/result.hpp"
+#include "lak/stdint.hpp"
+#include "lak/type_traits.hpp"
+#include "lak/uninitialised.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
+#include <ostream>
 #include <thread>
 
 namespace lak
 {
+	struct tasks;
+	struct tasks_impl;
+
+	enum struct task_error
+	{
+		running = 0,
+		failed  = 1
+	};
+
+	template<typename T>
+	using task_result = lak::result<T, lak::task_error>;
+
+	// the value type of a task_handle for a job of type FUNC
+	template<typename FUNC, typename... ARGS>
+	using task_value_t = lak::conditional_t<
+	  lak::is_void_v<lak::invoke_result_t<lak::remove_cvref_t<FUNC> &, ARGS...>>,
+	  lak::monostate,
+	  lak::invoke_result_t<lak::remove_cvref_t<FUNC> &, ARGS...>>;
+
+	/* --- task_job --- */
+
+	// type erased job, _invoke runs and then releases the job
+	struct task_job
+	{
+		void (*_invoke)(lak::task_job *) = nullptr;
+	};
+
+	/* --- task_slab --- */
+
+	// storage shared by every job type of the same size class
+	template<size_t SIZE, size_t ALIGN>
+	struct _task_storage
+	{
+		alignas(ALIGN) byte_t data[SIZE];
+	};
+
+	// jobs are usually allocated on the producer and freed on a worker, the
+	// pool's depot hands the worker's full magazines back to the producer.
+	template<typename T>
+	using task_slab = lak::object_pool<lak::_task_storage<
+	  (sizeof(T) + alignof(T) - 1U) / alignof(T) * alignof(T),
+	  alignof(T)>>;
+
+	/* --- task_state --- */
+
+	struct task_state_base : public lak::task_job
+	{
+		// one reference for the queued job and one for the handle
+		std::atomic_uint32_t _ref_count = 2U;
+		std::atomic_bool _ready         = false;
+		// set to this once the task has completed
+		std::atomic<lak::task_job *> _continuation = nullptr;
+		lak::tasks_impl *_pool                     = nullptr;
+		void (*_destroy)(lak::task_state_base *)   = nullptr;
+
+		bool ready() const { return _ready.load(std::memory_order_acquire); }
+
+		void retain() { _ref_count.fetch_add(1U, std::memory_order_relaxed); }
+
+		void release();
+
+		// mark the task as ready, wake any waiters and schedule the continuation
+		void complete();
+
+		// blocks until ready, runs other jobs from the pool if this is called
+		// from one of its workers
+		void wait();
+
+		// runs job once this task has completed
+		void set_continuation(lak::task_job *job);
+	};
+
+	template<typename T>
+	struct task_state : public lak::task_state_base
+	{
+		lak::uninitialised<lak::task_result<T>> _result;
+
+		lak::result<T &, lak::task_error> get();
+	};
+
+	// FUNC must return a lak::task_result<T>
+	template<typename FUNC, typename T>
+	struct task_job_impl : public lak::task_state<T>
+	{
+		lak::uninitialised<FUNC> _func;
+
+		template<typename F>
+		task_job_impl(lak::tasks_impl *pool, F &&func);
+
+		static void invoke(lak::task_job *job);
+		static void destroy(lak::task_state_base *state);
+	};
+
+	/* --- task_handle --- */
+
+	template<typename T>
+	struct task_handle
+	{
+	private:
+		lak::task_state<T> *_state = nullptr;
+
+		template<typename U>
+		friend struct task_handle;
+		friend struct lak::tasks;
+
+		task_handle(lak::task_state<T> *state) : _state(state) {}
+
+	public:
+		using value_type = T;
+
+		task_handle() = default;
+		task_handle(task_handle &&other);
+		task_handle &operator=(task_handle &&other);
+		~task_handle() { reset(); }
+
+		void reset();
+
+		bool valid() const { return _state != nullptr; }
+		bool ready() const { return _state && _state->ready(); }
+
+		// err(task_error::running) if the task has not finished yet
+		lak::result<T &, lak::task_error> try_get();
+
+		// blocks until the task has finished
+		lak::result<T &, lak::task_error> wait();
+
+		// schedules func(T &) to run on the same pool once this task has
+		// finished, if this task fails func is not run and the returned task
+		// fails too
+		template<typename FUNC>
+		lak::task_handle<lak::task_value_t<FUNC, T &>> then(FUNC &&func) &&;
+	};
+
+	/* --- tasks --- */
+
+	extern template struct lak::unique_ptr<lak::tasks_impl>;
+
+	// pool of long lived worker threads, each with their own job deque.
+	// idle workers steal from the other workers' deques.
 	struct tasks
 	{
 	private:
-		lak::array<std::thread> _threads;
-		std::atomic_size_t _active = 0;
-		std::mutex _mutex;
+		lak::unique_ptr<lak::tasks_impl> _impl;
+
+		template<typename T>
+		friend struct lak::task_handle;
+		friend struct lak::task_state_base;
+
+		// reserve a slot for a job, blocks while the pool is full
+		void admit();
+		// reserve a slot for a job if one is immediately available
+		bool try_admit();
+		// reserve a slot for a job, blocks until the deadline
+		bool admit_until(std::chrono::steady_clock::time_point deadline);
+
+		// hand an admitted job to a worker
+		void submit(lak::task_job *job);
 
-		// leaves _mutex locked
-		std::mutex &await_not_full();
+		// reserve a slot and hand the job to a worker, ignoring the pool limit
+		static void submit_continuation(lak::tasks_impl *impl,
+		                                lak::task_job *job);
 
-		void deactivate(size_t index);
+		// func must return a lak::task_result<T>
+		template<typename T, typename FUNC>
+		static lak::task_job_impl<lak::remove_cvref_t<FUNC>, T> *make_job(
+		  lak::tasks_impl *impl, FUNC &&func);
 
-		void deactivate(std::thread::id id);
+		// wraps func so that it returns a lak::task_result
+		template<typename FUNC>
+		static auto wrap_job(FUNC &&func);
 
 	public:
-		inline tasks() = default;
-		inline tasks(size_t threads) { _threads.resize(threads); }
+		// number of jobs that may be waiting per worker before push blocks
+		static constexpr size_t default_queue_depth = 256U;
+
+		// number of times admission polls before going to sleep
+		static constexpr size_t admit_spin_count = 64U;
+
+		tasks() = default;
+		tasks(size_t threads);
+		tasks(size_t threads, size_t max_pending);
 
 		inline static tasks hardware_max()
 		{
@@ -37,11 +210,45 @@ namespace lak
 
 		~tasks();
 
+		size_t size() const;
+
+		// jobs pushed from one of this pool's workers are always accepted to
+		// avoid the pool deadlocking on itself.
+
+		// sleeps while the pool is full
+		template<typename FUNC>
+		lak::task_handle<lak::task_value_t<FUNC>> push(FUNC &&func);
+
+		// returns nullopt (without consuming func) if the pool is full
 		template<typename FUNC>
-		void push(FUNC &&func);
+		lak::optional<lak::task_handle<lak::task_value_t<FUNC>>> try_push(
+		  FUNC &&func);
+
+		// returns nullopt (without consuming func) if the pool is still full
+		// after timeout
+		template<typename FUNC, typename REP, typename PERIOD>
+		lak::optional<lak::task_handle<lak::task_value_t<FUNC>>> push_for(
+		  FUNC &&func, const std::chrono::duration<REP, PERIOD> &timeout);
 	};
 }
 
+inline std::ostream &operator<<(std::ostream &strm, const lak::task_error &err)
+{
+	switch (err)
+	{
+		case lak::task_error::running:
+			strm << "task running";
+			break;
+		case lak::task_error::failed:
+			strm << "task failed";
+			break;
+		default:
+			ASSERT_NYI();
+			break;
+	}
+	return strm;
+}
+
 #include "lak/tasks.inl"
 
 #endif
@@ -1,16 +1,195 @@
+#include "lak/debug.hpp"
+#include "lak/utility.hpp"
+
+#include <new>
+
+/* --- task_state --- */
+
+template<typename T>
+lak::result<T &, lak::task_error> lak::task_state<T>::get()
+{
+	if (!ready()) return lak::err_t{lak::task_error::running};
+	lak::task_result<T> &result{_result.value()};
+	if (result.is_ok())
+		return lak::ok_t<T &>{*result.ok()};
+	else
+		return lak::err_t{*result.err()};
+}
+
+/* --- task_job_impl --- */
+
+template<typename FUNC, typename T>
+template<typename F>
+lak::task_job_impl<FUNC, T>::task_job_impl(lak::tasks_impl *pool, F &&func)
+: _func(lak::forward<F>(func))
+{
+	this->_invoke  = &invoke;
+	this->_destroy = &destroy;
+	this->_pool    = pool;
+}
+
+template<typename FUNC, typename T>
+void lak::task_job_impl<FUNC, T>::invoke(lak::task_job *job)
+{
+	auto *self{static_cast<task_job_impl *>(job)};
+	try
+	{
+		self->_result.create(self->_func.value()());
+	}
+	catch (const std::exception &e)
+	{
+		ERROR("Uncaught Exception: ", e.what());
+		self->_result.create(lak::err_t{lak::task_error::failed});
+	}
+	catch (...)
+	{
+		ERROR("Uncaught Exception");
+		self->_result.create(lak::err_t{lak::task_error::failed});
+	}
+	self->_func.destroy();
+	self->complete();
+	self->release();
+}
+
+template<typename FUNC, typename T>
+void lak::task_job_impl<FUNC, T>::destroy(lak::task_state_base *state)
+{
+	auto *self{static_cast<task_job_impl *>(state)};
+	// a task is always completed before its last reference is released
+	self->_result.destroy();
+	self->~task_job_impl();
+	lak::task_slab<task_job_impl>::free(self);
+}
+
+/* --- task_handle --- */
+
+template<typename T>
+lak::task_handle<T>::task_handle(task_handle &&other)
+: _state(lak::exchange(other._state, nullptr))
+{
+}
+
+template<typename T>
+lak::task_handle<T> &lak::task_handle<T>::operator=(task_handle &&other)
+{
+	lak::swap(_state, other._state);
+	return *this;
+}
+
+template<typename T>
+void lak::task_handle<T>::reset()
+{
+	if (_state) lak::exchange(_state, nullptr)->release();
+}
+
+template<typename T>
+lak::result<T &, lak::task_error> lak::task_handle<T>::try_get()
+{
+	ASSERT(_state);
+	return _state->get();
+}
+
+template<typename T>
+lak::result<T &, lak::task_error> lak::task_handle<T>::wait()
+{
+	ASSERT(_state);
+	_state->wait();
+	return _state->get();
+}
+
+template<typename T>
 template<typename FUNC>
-void lak::tasks::push(FUNC &&func)
-{
-	ASSERT_GREATER(_threads.size(), 0U);
-	std::lock_guard lock{await_not_full(), std::adopt_lock};
-	const size_t index{_active};
-	if (_threads[index].joinable()) _threads[index].join();
-	_threads[index] = std::thread(
-	  [func, this]
+lak::task_handle<lak::task_value_t<FUNC, T &>> lak::task_handle<T>::then(
+  FUNC &&func) &&
+{
+	ASSERT(_state);
+	using value_type = lak::task_value_t<FUNC, T &>;
+
+	lak::task_state_base *state{_state};
+	auto *job{lak::tasks::make_job<value_type>(
+	  state->_pool,
+	  [antecedent{lak::move(*this)},
+	   func{lak::forward<FUNC>(func)}]() mutable -> lak::task_result<value_type>
 	  {
-		  func();
-		  std::lock_guard lock{this->_mutex};
-		  this->deactivate(std::this_thread::get_id());
-	  });
-	++_active;
+		  lak::result<T &, lak::task_error> value{antecedent.try_get()};
+		  if (value.is_err()) return lak::err_t{lak::task_error::failed};
+		  if constexpr (lak::is_void_v<lak::invoke_result_t<
+		                  lak::remove_cvref_t<FUNC> &,
+		                  T &>>)
+		  {
+			  func(*value.ok());
+			  return lak::ok_t{lak::monostate{}};
+		  }
+		  else
+			  return lak::ok_t{func(*value.ok())};
+	  })};
+
+	state->set_continuation(job);
+
+	return lak::task_handle<value_type>(job);
+}
+
+/* --- tasks --- */
+
+template<typename T, typename FUNC>
+lak::task_job_impl<lak::remove_cvref_t<FUNC>, T> *lak::tasks::make_job(
+  lak::tasks_impl *impl, FUNC &&func)
+{
+	using job_type = lak::task_job_impl<lak::remove_cvref_t<FUNC>, T>;
+	return new (lak::task_slab<job_type>::allocate())
+	  job_type(impl, lak::forward<FUNC>(func));
+}
+
+template<typename FUNC>
+auto lak::tasks::wrap_job(FUNC &&func)
+{
+	using func_type  = lak::remove_cvref_t<FUNC>;
+	using value_type = lak::task_value_t<func_type>;
+
+	return [func{lak::forward<FUNC>(func)}]() mutable
+	       -> lak::task_result<value_type>
+	{
+		if constexpr (lak::is_void_v<lak::invoke_result_t<func_type &>>)
+		{
+			func();
+			return lak::ok_t{lak::monostate{}};
+		}
+		else
+			return lak::ok_t{func()};
+	};
+}
+
+template<typename FUNC>
+lak::task_handle<lak::task_value_t<FUNC>> lak::tasks::push(FUNC &&func)
+{
+	admit();
+	auto *job{make_job<lak::task_value_t<FUNC>>(
+	  _impl.get(), wrap_job(lak::forward<FUNC>(func)))};
+	submit(job);
+	return lak::task_handle<lak::task_value_t<FUNC>>(job);
+}
+
+template<typename FUNC>
+lak::optional<lak::task_handle<lak::task_value_t<FUNC>>> lak::tasks::try_push(
+  FUNC &&func)
+{
+	if (!try_admit()) return lak::nullopt;
+	auto *job{make_job<lak::task_value_t<FUNC>>(
+	  _impl.get(), wrap_job(lak::forward<FUNC>(func)))};
+	submit(job);
+	return lak::task_handle<lak::task_value_t<FUNC>>(job);
+}
+
+template<typename FUNC, typename REP, typename PERIOD>
+lak::optional<lak::task_handle<lak::task_value_t<FUNC>>> lak::tasks::push_for(
+  FUNC &&func, const std::chrono::duration<REP, PERIOD> &timeout)
+{
+	if (!admit_until(std::chrono::steady_clock::now() +
+	                 std::chrono::ceil<std::chrono::steady_clock::duration>(
+	                   timeout)))
+		return lak::nullopt;
+	auto *job{make_job<lak::task_value_t<FUNC>>(
+	  _impl.get(), wrap_job(lak::forward<FUNC>(func)))};
+	submit(job);
+	return lak::task_handle<lak::task_value_t<FUNC>>(job);
 }
@@ -12,6 +12,7 @@
 #define LAK_TINFLATE_HPP
 
 #include "lak/array.hpp"
+#include "lak/compression/huffman.hpp"
 #include "lak/span.hpp"
 #include "lak/stdint.hpp"
 
@@ -92,13 +93,15 @@ namespace tinf
 		uint32_t ilen  = 0;
 		uint32_t nread = 0;
 
-		int16_t literal_table[0x23E]; // (288 * 2) - 2
-		int16_t distance_table[0x3E]; // (32 * 2) - 2
+		// the current block uses the fixed Huffman tables
+		bool fixed_tables = false;
+		lak::huffman_table literal_table;
+		lak::huffman_table distance_table;
 		uint32_t literal_count  = 0;
 		uint32_t distance_count = 0;
 		uint32_t codelen_count  = 0;
-		int16_t codelen_table[0x24]; // (19 * 2) - 2
-		uint8_t literal_len[0x120];  // 288
+		lak::huffman_table codelen_table;
+		uint8_t literal_len[0x120]; // 288
 		uint8_t distance_len[0x20];  // 32
 		uint8_t codelen_len[0x13];   // 19
 
@@ -145,26 +148,20 @@ namespace tinf
 			return false;
 		}
 
-		template<typename T>
-		bool get_huff(int16_t *table, T *out)
+		// returns true if there wasn't enough data
+		force_inline bool get_huff(const lak::huffman_table &table,
+		                           lak::huffman_entry *out)
 		{
-			uint32_t bitsUsed = 0;
-			uint32_t index    = 0;
-
-			for (;;)
-			{
-				if (num_bits <= bitsUsed)
-					if (get_byte()) return true;
+			// bits past num_bits are always zero
+			while (num_bits < lak::huffman_table::max_bits && !data.empty())
+				get_byte();
 
-				index += (bit_accum >> bitsUsed) & 1;
-				++bitsUsed;
-				if (table[index] >= 0) break;
-				index = ~(table[index]);
-			}
+			const lak::huffman_entry entry{table.lookup(bit_accum)};
+			if (entry.length > num_bits) return true;
 
-			*out = table[index];
+			*out = entry;
 
-			flush_bits(bitsUsed);
+			flush_bits(entry.length);
 
 			return false;
 		}
@@ -205,7 +202,9 @@ namespace tinf
 	error_t gen_huffman_table(uint32_t symbols,
 	                          const uint8_t *lengths,
 	                          bool allow_no_symbols,
-	                          int16_t *table);
+	                          lak::huffman_kind kind,
+	                          uint8_t root_bits,
+	                          lak::huffman_table *table);
 }
 
 #endif // LAK_TINFLATE_HPP
@@ -3,30 +3,14 @@
 
 #include "lak/debug.hpp"
 #include "lak/result.hpp"
+#include "lak/source_location.hpp"
 #include "lak/string_literals.hpp"
 #include "lak/unicode.hpp"
 
 #include <ostream>
-#include <version>
-#ifdef __cpp_lib_source_location
-#	include <source_location>
-#endif
 
 namespace lak
 {
-#ifdef __cpp_lib_source_location
-	using source_location = std::source_location;
-#else
-	struct source_location
-	{
-		static source_location current() { return {}; }
-		constexpr const char *file_name() const { return {}; }
-		constexpr const char *function_name() const { return {}; }
-		constexpr uint_least32_t line() const { return 0U; }
-		constexpr uint_least32_t column() const { return 0U; }
-	};
-#endif
-
 	struct trace
 	{
 		lak::source_location location;
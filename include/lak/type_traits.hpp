@@ -131,6 +131,22 @@ namespace lak
 	inline constexpr bool is_standard_layout_v =
 	  lak::is_standard_layout<T>::value;
 
+	/* --- is_trivially_relocatable --- */
+
+	// Moving a T to a new address and destroying the original is the same as
+	// copying its bytes. Types that don't point into themselves can opt in by
+	// specialising this.
+	template<typename T>
+	struct is_trivially_relocatable
+	: public lak::bool_type<std::is_trivially_copyable_v<T> &&
+	                        std::is_trivially_destructible_v<T>>
+	{
+	};
+
+	template<typename T>
+	inline constexpr bool is_trivially_relocatable_v =
+	  lak::is_trivially_relocatable<T>::value;
+
 	/* --- type_identity --- */
 
 	template<typename T>
@@ -1,6 +1,7 @@
 #ifndef LAK_UNIQUE_PAGES_HPP
 #define LAK_UNIQUE_PAGES_HPP
 
+#include "lak/memmanip.hpp"
 #include "lak/span.hpp"
 
 namespace lak
@@ -15,6 +16,10 @@ namespace lak
 	public:
 		static unique_pages make(size_t min_size, size_t *actual_size = nullptr);
 
+		// make but failing to reserve the pages is an error rather than fatal
+		static lak::page_result_t<unique_pages> try_make(
+		  size_t min_size, size_t *actual_size = nullptr);
+
 		inline ~unique_pages() { clear(); }
 
 		unique_pages() = default;
@@ -41,100 +46,97 @@ namespace lak
 		using lak::span<void>::size_bytes;
 	};
 
-#if 0
-  struct shared_pages : private lak::span<void>
-  {
-  private:
-    lak::reference_count *_count = nullptr;
-
-    shared_pages(lak::span<void> pages)
-    {
-      ASSERT_GREATER(pages.size(), sizeof(lak::reference_count));
-      auto &span = static_cast<lak::span<void> &>(*this);
-
-      span =
-        lak::span<void>(static_cast<lak::reference_count *>(pages.data()) + 1,
-                        pages.size_bytes() - sizeof(lak::reference_count));
-
-      _count = static_cast<lak::reference_count *>(pages.data());
-      new (_count) lak::reference_count();
-
-      ++*_count;
-    }
-
-    void clear()
-    {
-      if (!_count) return;
-
-      static_cast<lak::span<void> &>(*this) = {};
-
-      if (auto &count = *lak::exchange(_count, nullptr); --count)
-        ASSERT(lak::page_free(*this));
-    }
-
-  public:
-    static shared_pages make(size_t min_size)
-    {
-      ASSERT_GREATER(min_size, 0);
-      min_size += sizeof(lak::reference_count);
-      auto pages = lak::page_reserve(min_size);
-      if (!pages.empty() && pages.size() < min_size)
-      {
-        ASSERT(lak::page_free(pages));
-        pages = {};
-      }
-      if (pages.empty() || !lak::page_commit(pages)) throw std::bad_alloc();
-      return shared_pages(pages);
-    }
-
-    ~shared_pages() { clear(); }
-
-    shared_pages() = default;
-
-    shared_pages(const shared_pages &other)
-    : lak::span<void>(static_cast<lak::span<void>>(other))
-    {
-      _count = other._count;
-      if (_count) ++*_count;
-    }
-
-    shared_pages(shared_pages &&other)
-    : lak::span<void>(static_cast<lak::span<void>>(other))
-    {
-      _count = lak::exchange(other._count, nullptr);
-      other.clear();
-    }
-
-    shared_pages &operator=(const shared_pages &other)
-    {
-      static_cast<lak::span<void> &>(*this) = other;
-
-      _count = other._count;
-      if (_count) ++*_count;
-
-      return *this;
-    }
-
-    shared_pages &operator=(shared_pages &&other)
-    {
-      lak::swap<lak::span<void>>(*this, other);
-      lak::swap(_count, other._count);
-
-      return *this;
-    }
-
-    // -Werror=class-conversion bug
-    // operator lak::span<void>()
-    // {
-    //   return static_cast<lak::span<void> &>(*this);
-    // }
-
-    using lak::span<void>::data;
-    using lak::span<void>::empty;
-    using lak::span<void>::size;
-    using lak::span<void>::size_bytes;
-  };
-#endif
+	/* --- shared_pages --- */
+
+	struct _shared_pages_block;
+
+	// Reference counted pages of anonymous shared memory. Copies and slices
+	// share the same pages, fork makes a copy on write mapping so that a
+	// writer only pays for the pages it changes. The pages are committed
+	// when they're made.
+	struct shared_pages : private lak::span<void>
+	{
+	private:
+		lak::_shared_pages_block *_block = nullptr;
+
+		inline shared_pages(lak::_shared_pages_block *block,
+		                    lak::span<void> pages)
+		: lak::span<void>(pages), _block(block)
+		{
+		}
+
+		void retain() const;
+
+		void clear();
+
+	public:
+		static shared_pages make(size_t min_size, size_t *actual_size = nullptr);
+
+		inline ~shared_pages() { clear(); }
+
+		shared_pages() = default;
+
+		inline shared_pages(const shared_pages &other)
+		: lak::span<void>(other.span()), _block(other._block)
+		{
+			retain();
+		}
+
+		inline shared_pages(shared_pages &&other)
+		: lak::span<void>(other.span()),
+		  _block(lak::exchange(other._block, nullptr))
+		{
+			static_cast<lak::span<void> &>(other) = {};
+		}
+
+		inline shared_pages &operator=(const shared_pages &other)
+		{
+			if (this != &other)
+			{
+				other.retain();
+				clear();
+				static_cast<lak::span<void> &>(*this) = other.span();
+				_block                                 = other._block;
+			}
+			return *this;
+		}
+
+		inline shared_pages &operator=(shared_pages &&other)
+		{
+			lak::swap<lak::span<void>>(*this, other);
+			lak::swap(_block, other._block);
+			return *this;
+		}
+
+		inline lak::span<void> span() const
+		{
+			return static_cast<lak::span<void>>(*this);
+		}
+
+		// number of shared_pages sharing these pages (including slices)
+		size_t use_count() const;
+
+		// true if the pages are a fork, writes to them aren't seen by anyone
+		// else
+		bool is_fork() const;
+
+		// share a sub range of the pages, keeps all of the pages alive
+		shared_pages subspan(size_t offset,
+		                     size_t count = lak::dynamic_extent) const;
+		shared_pages first(size_t count) const;
+		shared_pages last(size_t count) const;
+
+		// copy on write copy of these pages. forks of shared pages see writes
+		// made to the shared pages in the pages they haven't written to, so
+		// shared pages shouldn't be written to while they have forks. forks
+		// of forks are copied eagerly.
+		shared_pages fork() const;
+
+		using lak::span<void>::data;
+		using lak::span<void>::empty;
+		using lak::span<void>::size;
+		using lak::span<void>::size_bytes;
+	};
 }
 
 #endif
@@ -9,6 +9,7 @@
 #	include <utility>
 #endif
 
+#include <cstring>
 #include <functional>
 
 namespace lak
@@ -81,6 +82,20 @@ namespace lak
 	template<typename T>
 	force_inline constexpr void swap(T &a, T &b)
 	{
+		if constexpr (lak::is_trivially_relocatable_v<T> &&
+		              !std::is_trivially_copyable_v<T>)
+		{
+			if (!std::is_constant_evaluated())
+			{
+				alignas(T) unsigned char temp[sizeof(T)];
+				std::memcpy(temp, static_cast<const void *>(&a), sizeof(T));
+				std::memcpy(
+				  static_cast<void *>(&a), static_cast<const void *>(&b), sizeof(T));
+				std::memcpy(static_cast<void *>(&b), temp, sizeof(T));
+				return;
+			}
+		}
+
 		T temp{lak::move(a)};
 		a = lak::move(b);
 		b = lak::move(temp);
@@ -155,6 +170,33 @@ namespace lak
 		if constexpr (!std::is_trivially_destructible_v<T>) src->~T();
 	}
 
+	/* --- relocate --- */
+
+	// destructive_move_construct count Ts from src to dst, the ranges may
+	// overlap. trivially relocatable Ts are moved with a single memmove.
+	template<typename T>
+	void relocate(T *src, T *dst, size_t count)
+	{
+		if (src == dst || count == 0U) return;
+
+		if constexpr (lak::is_trivially_relocatable_v<T>)
+		{
+			std::memmove(static_cast<void *>(dst),
+			             static_cast<const void *>(src),
+			             count * sizeof(T));
+		}
+		else if (dst < src || dst >= src + count)
+		{
+			for (size_t i = 0U; i < count; ++i)
+				lak::destructive_move_construct(src + i, dst + i);
+		}
+		else
+		{
+			for (size_t i = count; i-- > 0U;)
+				lak::destructive_move_construct(src + i, dst + i);
+		}
+	}
+
 	/* --- as_ptr --- */
 
 	// Converts pointers and pointer-like types to pointers.
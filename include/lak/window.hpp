@@ -43,6 +43,7 @@ int main()
 #include "lak/bank_ptr.hpp"
 #include "lak/image.hpp"
 #include "lak/memmanip.hpp"
+#include "lak/railcar.hpp"
 #include "lak/result.hpp"
 #include "lak/streamify.hpp"
 #include "lak/string.hpp"
@@ -124,10 +125,12 @@ namespace lak
 	extern template struct lak::array<lak::window_handle, lak::dynamic_extent>;
 	extern template struct lak::railcar<lak::window_handle>;
 	extern template struct lak::bank<lak::window_handle>;
-	extern template size_t lak::bank<lak::window_handle>::internal_create<
+	extern template lak::slot_handle
+	lak::bank<lak::window_handle>::internal_create<
 	  lak::window_handle>(lak::window_handle &&);
 	using const_window_handle_ref = const lak::window_handle &;
-	extern template size_t lak::bank<lak::window_handle>::internal_create<
+	extern template lak::slot_handle
+	lak::bank<lak::window_handle>::internal_create<
 	  lak::const_window_handle_ref>(lak::const_window_handle_ref &&);
 	extern template struct lak::unique_bank_ptr<lak::window_handle>;
 	extern template struct lak::shared_bank_ptr<lak::window_handle>;
@@ -0,0 +1,15 @@
+#ifndef LAK_XXHASH_HPP
+#define LAK_XXHASH_HPP
+
+#include "lak/span.hpp"
+#include "lak/stdint.hpp"
+
+namespace lak
+{
+	/* --- xxhash32 --- */
+
+	// 32 bit xxHash, as used for LZ4 frame checksums
+	uint32_t xxhash32(lak::span<const byte_t> data, uint32_t seed = 0U);
+}
+
+#endif
@@ -1,40 +1,414 @@
 #include "lak/alloc.hpp"
+#include "lak/alloc_stats.hpp"
 
 #include "lak/compiler.hpp"
+#include "lak/debug.hpp"
 #include "lak/math.hpp"
 #include "lak/memmanip.hpp"
 #include "lak/utility.hpp"
 
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdlib>
+#include <mutex>
+#include <new>
 
 /* --- local alloc --- */
 
-lak::alloc::result<lak::span<byte_t>> lak::local_alloc(size_t, size_t)
+// Small allocations are carved out of 64KiB segments, each segment holding
+// blocks of a single size class. Segments are owned by the thread that
+// created them: the owner allocates and frees without any synchronisation,
+// other threads push the blocks they free onto the segment's remote list
+// which the owner collects when it runs out of free blocks.
+//
+// Segments are cut from large reserved regions so that local_free can tell
+// local allocations apart from the global fallback with a range check, and
+// are aligned to their size so that a block's segment is found by masking
+// its address. Segments of exited threads are abandoned and adopted by the
+// next thread that needs a segment of that size class.
+
+namespace lak
+{
+	struct _local_heap;
+
+	struct _local_block
+	{
+		lak::_local_block *next;
+	};
+
+	struct _local_segment
+	{
+		// nullptr while abandoned
+		std::atomic<lak::_local_heap *> owner;
+		// blocks freed by threads other than the owner
+		std::atomic<lak::_local_block *> remote;
+		// blocks freed by the owner
+		lak::_local_block *free;
+		lak::_local_segment *prev;
+		lak::_local_segment *next;
+		// never used blocks
+		byte_t *bump;
+		byte_t *end;
+		// blocks allocated and not yet collected from the free lists
+		uint32_t used;
+		uint32_t size_class;
+	};
+
+	static constexpr size_t _local_segment_size = 64U * 1024U;
+	static constexpr size_t _local_region_size  = 1024U * 1024U * 1024U;
+	static constexpr size_t _local_max_regions  = 64U;
+	static constexpr size_t _local_max_size     = 8U * 1024U;
+	// 8 classes of 16 bytes up to 128, then 4 classes per power of two
+	static constexpr size_t _local_class_count = 32U;
+
+	static constexpr size_t _local_class_size(size_t size_class)
+	{
+		if (size_class < 8U) return (size_class + 1U) * 16U;
+		const size_t k{size_class - 8U};
+		return (5U + (k % 4U)) << (5U + (k / 4U));
+	}
+
+	static constexpr size_t _local_size_class(size_t size)
+	{
+		if (size <= 128U) return size == 0U ? 0U : (size - 1U) / 16U;
+		const size_t e{size_t(std::bit_width(size - 1U)) - 1U};
+		return 8U + ((e - 7U) * 4U) + ((size - 1U) >> (e - 2U)) - 4U;
+	}
+
+	static_assert(_local_size_class(1U) == 0U);
+	static_assert(_local_size_class(128U) == 7U);
+	static_assert(_local_size_class(129U) == 8U);
+	static_assert(_local_class_size(8U) == 160U);
+	static_assert(_local_size_class(257U) == 12U);
+	static_assert(_local_class_size(12U) == 320U);
+	static_assert(_local_size_class(_local_max_size) == _local_class_count - 1U);
+	static_assert(_local_class_size(_local_class_count - 1U) == _local_max_size);
+
+	struct _local_arena
+	{
+		std::mutex mutex;
+		byte_t *regions[_local_max_regions] = {};
+		std::atomic_size_t region_count     = 0U;
+		// the next unused segment of the last region
+		byte_t *region_bump = nullptr;
+		byte_t *region_end  = nullptr;
+		// segments that were emptied, still committed
+		lak::_local_segment *empty = nullptr;
+		lak::_local_segment *abandoned[_local_class_count] = {};
+
+		bool contains(const void *ptr) const;
+		lak::_local_segment *acquire(size_t size_class);
+		void release(lak::_local_segment *segment);
+		void abandon(lak::_local_segment *segment);
+	};
+
+	struct _local_heap
+	{
+		// the segment blocks are being allocated from, the head of the list
+		lak::_local_segment *segments[_local_class_count];
+
+		void *allocate(size_t size_class);
+		void *allocate_slow(size_t size_class);
+		void free(lak::_local_segment *segment, void *ptr);
+		void collect(lak::_local_segment *segment);
+		void link(lak::_local_segment *segment);
+		void unlink(lak::_local_segment *segment);
+		void abandon_all();
+	};
+
+	// abandons the heap's segments when the thread exits
+	struct _local_heap_reaper
+	{
+		bool armed = false;
+		~_local_heap_reaper();
+	};
+}
+
+static lak::_local_arena local_arena;
+// constinit and trivially destructible so that frees from other thread_local
+// destructors still work after the reaper has run
+static constinit thread_local lak::_local_heap local_heap = {};
+static thread_local lak::_local_heap_reaper local_heap_reaper;
+
+static lak::_local_segment *local_segment_of(const void *ptr)
+{
+	return reinterpret_cast<lak::_local_segment *>(
+	  uintptr_t(ptr) & ~uintptr_t(lak::_local_segment_size - 1U));
+}
+
+bool lak::_local_arena::contains(const void *ptr) const
+{
+	const size_t count{region_count.load(std::memory_order_acquire)};
+	for (size_t i = 0U; i < count; ++i)
+		if (ptr >= regions[i] && ptr < regions[i] + lak::_local_region_size)
+			return true;
+	return false;
+}
+
+lak::_local_segment *lak::_local_arena::acquire(size_t size_class)
+{
+	std::lock_guard lock{mutex};
+
+	if (lak::_local_segment *segment{abandoned[size_class]}; segment)
+	{
+		abandoned[size_class] = segment->next;
+		return segment;
+	}
+
+	lak::_local_segment *segment{empty};
+	if (segment)
+	{
+		empty = segment->next;
+	}
+	else
+	{
+		if (region_bump == region_end)
+		{
+			const size_t count{region_count.load(std::memory_order_relaxed)};
+			if (count == lak::_local_max_regions) return nullptr;
+			// over reserve so that the segments can be aligned to their size
+			auto region{lak::page_reserve(lak::_local_region_size +
+			                              lak::_local_segment_size)};
+			if (region.is_err()) return nullptr;
+			byte_t *base{
+			  lak::align_ptr(static_cast<byte_t *>(region.unsafe_unwrap().data()),
+			                 lak::_local_segment_size)};
+			regions[count] = base;
+			region_count.store(count + 1U, std::memory_order_release);
+			region_bump = base;
+			region_end  = base + lak::_local_region_size;
+		}
+
+		if (lak::page_commit(lak::span<void>(region_bump,
+		                                     lak::_local_segment_size))
+		      .is_err())
+			return nullptr;
+		segment = reinterpret_cast<lak::_local_segment *>(region_bump);
+		region_bump += lak::_local_segment_size;
+	}
+
+	const size_t block_size{lak::_local_class_size(size_class)};
+	// blocks are aligned to the largest power of two that divides their size
+	const size_t block_align{block_size & (~block_size + 1U)};
+	byte_t *base{reinterpret_cast<byte_t *>(segment)};
+	new (segment) lak::_local_segment{};
+	segment->bump =
+	  base + lak::to_multiple(sizeof(lak::_local_segment), block_align);
+	segment->end = segment->bump +
+	               (base + lak::_local_segment_size - segment->bump) /
+	                 block_size * block_size;
+	segment->size_class = uint32_t(size_class);
+	return segment;
+}
+
+void lak::_local_arena::release(lak::_local_segment *segment)
+{
+	std::lock_guard lock{mutex};
+	segment->next = empty;
+	empty         = segment;
+}
+
+void lak::_local_arena::abandon(lak::_local_segment *segment)
+{
+	std::lock_guard lock{mutex};
+	segment->owner.store(nullptr, std::memory_order_release);
+	segment->next                     = abandoned[segment->size_class];
+	abandoned[segment->size_class] = segment;
+}
+
+void lak::_local_heap::link(lak::_local_segment *segment)
 {
-	ASSERT_UNREACHABLE();
+	lak::_local_segment *&head{segments[segment->size_class]};
+	segment->prev = nullptr;
+	segment->next = head;
+	if (head) head->prev = segment;
+	head = segment;
 }
 
-void lak::local_free(lak::span<byte_t>) { ASSERT_UNREACHABLE(); }
+void lak::_local_heap::unlink(lak::_local_segment *segment)
+{
+	if (segment->prev)
+		segment->prev->next = segment->next;
+	else
+		segments[segment->size_class] = segment->next;
+	if (segment->next) segment->next->prev = segment->prev;
+	segment->prev = segment->next = nullptr;
+}
+
+void lak::_local_heap::collect(lak::_local_segment *segment)
+{
+	lak::_local_block *block{
+	  segment->remote.exchange(nullptr, std::memory_order_acquire)};
+	while (block)
+	{
+		lak::_local_block *next{block->next};
+		block->next   = segment->free;
+		segment->free = block;
+		--segment->used;
+		block = next;
+	}
+}
+
+void *lak::_local_heap::allocate(size_t size_class)
+{
+	if (lak::_local_segment *segment{segments[size_class]}; segment)
+	{
+		if (lak::_local_block *block{segment->free}; block)
+		{
+			segment->free = block->next;
+			++segment->used;
+			return block;
+		}
+		if (segment->bump != segment->end)
+		{
+			void *result{segment->bump};
+			segment->bump += lak::_local_class_size(size_class);
+			++segment->used;
+			return result;
+		}
+	}
+	return allocate_slow(size_class);
+}
+
+void *lak::_local_heap::allocate_slow(size_t size_class)
+{
+	local_heap_reaper.armed = true;
+
+	// look for a segment with blocks freed since we last checked, moving it
+	// to the front of the list
+	for (lak::_local_segment *segment{segments[size_class]}; segment;
+	     segment = segment->next)
+	{
+		collect(segment);
+		if (segment->free || segment->bump != segment->end)
+		{
+			unlink(segment);
+			link(segment);
+			return allocate(size_class);
+		}
+	}
+
+	for (;;)
+	{
+		lak::_local_segment *segment{local_arena.acquire(size_class)};
+		if (!segment) return nullptr;
+		segment->owner.store(this, std::memory_order_release);
+		collect(segment);
+		link(segment);
+		if (segment->free || segment->bump != segment->end)
+			return allocate(size_class);
+		// adopted a segment that's still full, it stays in our list and gets
+		// picked up once its blocks are freed
+	}
+}
+
+void lak::_local_heap::free(lak::_local_segment *segment, void *ptr)
+{
+	lak::_local_block *block{static_cast<lak::_local_block *>(ptr)};
+	block->next   = segment->free;
+	segment->free = block;
+	--segment->used;
+
+	// keep the head segment around so that alloc/free in a loop doesn't
+	// bounce segments in and out of the arena
+	if (segment->used == 0U && segment != segments[segment->size_class])
+	{
+		unlink(segment);
+		local_arena.release(segment);
+	}
+}
+
+void lak::_local_heap::abandon_all()
+{
+	for (lak::_local_segment *&head : segments)
+	{
+		while (head)
+		{
+			lak::_local_segment *segment{head};
+			unlink(segment);
+			collect(segment);
+			if (segment->used == 0U)
+				local_arena.release(segment);
+			else
+				local_arena.abandon(segment);
+		}
+	}
+}
+
+lak::_local_heap_reaper::~_local_heap_reaper()
+{
+	if (armed) local_heap.abandon_all();
+}
+
+lak::alloc::result<lak::span<byte_t>> lak::local_alloc(
+  size_t size, size_t align, lak::source_location site)
+{
+	if (align <= alignof(std::max_align_t))
+		align = 0U;
+	else
+		ASSERT(std::has_single_bit(align));
+
+	// over aligned allocations use the next power of two size class, blocks
+	// of those classes are aligned to their size
+	const size_t block_size{align ? std::bit_ceil(std::max(size, align)) : size};
+	if (block_size > lak::_local_max_size)
+		return lak::global_alloc(size, align, site);
+
+	void *ptr{local_heap.allocate(lak::_local_size_class(block_size))};
+	if (!ptr) return lak::global_alloc(size, align, site);
+	return lak::ok_t{lak::span<byte_t>(static_cast<byte_t *>(ptr), size)};
+}
+
+void lak::local_free(lak::span<byte_t> data)
+{
+	if (!data.data()) return;
+
+	if (!local_arena.contains(data.data()))
+	{
+		lak::global_free(data);
+		return;
+	}
+
+	lak::_local_segment *segment{local_segment_of(data.data())};
+	if (segment->owner.load(std::memory_order_relaxed) == &local_heap)
+	{
+		local_heap.free(segment, data.data());
+	}
+	else
+	{
+		lak::_local_block *block{
+		  static_cast<lak::_local_block *>(static_cast<void *>(data.data()))};
+		block->next = segment->remote.load(std::memory_order_relaxed);
+		while (!segment->remote.compare_exchange_weak(
+		  block->next, block, std::memory_order_release))
+			;
+	}
+}
 
 /* --- global alloc --- */
 
-lak::alloc::result<lak::span<byte_t>> lak::global_alloc(size_t size,
-                                                        size_t align)
+lak::alloc::result<lak::span<byte_t>> lak::global_alloc(
+  size_t size, size_t align, lak::source_location site)
 {
 	if (align < alignof(std::max_align_t)) align = alignof(std::max_align_t);
+	const size_t slack{lak::slack<size_t>(size, align)};
 	void *ptr =
 #ifdef LAK_COMPILER_MSVC
 	  _aligned_malloc(size, align);
 #else
-	  std::aligned_alloc(align, size + lak::slack<size_t>(size, align));
+	  std::aligned_alloc(align, size + slack);
 #endif
 	if (!ptr) return lak::err_t<lak::bad_alloc>{};
-	return lak::ok_t{lak::span<byte_t>(static_cast<byte_t *>(ptr), size)};
+	lak::span<byte_t> result(static_cast<byte_t *>(ptr), size);
+	if (lak::alloc_stats_enabled())
+		lak::_alloc_stats_allocated(result, slack, site);
+	return lak::ok_t{result};
 }
 
 void lak::global_free(lak::span<byte_t> data)
 {
+	if (lak::alloc_stats_enabled()) lak::_alloc_stats_freed(data);
 #ifdef LAK_COMPILER_MSVC
 	_aligned_free(data.data());
 #else
@@ -0,0 +1,423 @@
+#include "lak/alloc_stats.hpp"
+
+#include "lak/algorithm.hpp"
+#include "lak/debug.hpp"
+#include "lak/memmanip.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+/* --- alloc stats --- */
+
+// Call sites live in a fixed size open addressed table so that recording an
+// allocation against its site doesn't take a lock, sites that don't fit are
+// all counted against the last slot. Live blocks are remembered in sharded
+// maps so that frees can be attributed to the site that allocated them.
+// The maps use the std allocator so recording never recurses into
+// global_alloc.
+
+namespace lak
+{
+	struct _alloc_site_slot
+	{
+		// 0 while empty
+		std::atomic_uint64_t key;
+		// set once site has been written
+		std::atomic_bool ready;
+		lak::source_location site;
+		std::atomic_size_t allocations;
+		std::atomic_size_t frees;
+		std::atomic_size_t live_bytes;
+		std::atomic_size_t total_bytes;
+	};
+
+	struct _alloc_size_class_slot
+	{
+		std::atomic_size_t allocations;
+		std::atomic_size_t live_count;
+		std::atomic_size_t live_bytes;
+	};
+
+	struct _alloc_block
+	{
+		size_t size;
+		size_t slack;
+		uint32_t site;
+	};
+
+	struct _alloc_block_shard
+	{
+		alignas(lak::cache_line_size) std::mutex mutex;
+		std::unordered_map<const void *, lak::_alloc_block> blocks;
+	};
+
+	struct _alloc_reservation
+	{
+		size_t size;
+		size_t committed;
+	};
+
+	static constexpr size_t _alloc_site_count        = 4096U;
+	static constexpr size_t _alloc_block_shard_count = 64U;
+
+	struct _alloc_stats_state
+	{
+		std::atomic_size_t allocations;
+		std::atomic_size_t frees;
+		std::atomic_size_t live_bytes;
+		std::atomic_size_t peak_live_bytes;
+		std::atomic_size_t total_bytes;
+		std::atomic_size_t slack_bytes;
+
+		lak::_alloc_size_class_slot size_classes[lak::alloc_size_classes];
+
+		// the last slot is the overflow site
+		lak::_alloc_site_slot sites[lak::_alloc_site_count + 1U];
+
+		lak::_alloc_block_shard blocks[lak::_alloc_block_shard_count];
+
+		std::mutex page_mutex;
+		std::map<uintptr_t, lak::_alloc_reservation> reservations;
+		size_t reserved_bytes;
+		size_t peak_reserved_bytes;
+		size_t committed_bytes;
+		size_t peak_committed_bytes;
+
+		uint32_t find_site(lak::source_location site);
+		lak::_alloc_block_shard &shard_of(const void *ptr);
+		// returns the reservation containing ptr or reservations.end()
+		std::map<uintptr_t, lak::_alloc_reservation>::iterator
+		find_reservation(const void *ptr);
+	};
+}
+
+static lak::_alloc_stats_state &alloc_stats_state()
+{
+	// leaked so that allocations made during static destruction can still be
+	// recorded
+	static lak::_alloc_stats_state *state{new lak::_alloc_stats_state{}};
+	return *state;
+}
+
+static void update_peak(std::atomic_size_t &peak, size_t value)
+{
+	size_t current{peak.load(std::memory_order_relaxed)};
+	while (current < value &&
+	       !peak.compare_exchange_weak(
+	         current, value, std::memory_order_relaxed))
+		;
+}
+
+static size_t size_class_of(size_t size)
+{
+	return std::min<size_t>(std::bit_width(size), lak::alloc_size_classes - 1U);
+}
+
+uint32_t lak::_alloc_stats_state::find_site(lak::source_location site)
+{
+	uint64_t key{uintptr_t(site.file_name())};
+	key = (key ^ (key >> 29U)) * 0xBF58476D1CE4E5B9U;
+	key ^= uintptr_t(site.function_name());
+	key = (key ^ (key >> 32U)) * 0x94D049BB133111EBU;
+	key ^= (uint64_t(site.line()) << 32U) | site.column();
+	key = (key ^ (key >> 31U)) * 0xBF58476D1CE4E5B9U;
+	if (key == 0U) key = 1U;
+
+	for (size_t i = 0; i < lak::_alloc_site_count; ++i)
+	{
+		const uint32_t index{
+		  uint32_t((key + i) & (lak::_alloc_site_count - 1U))};
+		lak::_alloc_site_slot &slot{sites[index]};
+		uint64_t expected{slot.key.load(std::memory_order_acquire)};
+		if (expected == key) return index;
+		if (expected == 0U &&
+		    slot.key.compare_exchange_strong(
+		      expected, key, std::memory_order_acq_rel))
+		{
+			slot.site = site;
+			slot.ready.store(true, std::memory_order_release);
+			return index;
+		}
+		if (expected == key) return index;
+	}
+
+	sites[lak::_alloc_site_count].ready.store(true, std::memory_order_release);
+	return uint32_t(lak::_alloc_site_count);
+}
+
+lak::_alloc_block_shard &lak::_alloc_stats_state::shard_of(const void *ptr)
+{
+	const uintptr_t bits{uintptr_t(ptr) >> 4U};
+	return blocks[(bits ^ (bits >> 7U) ^ (bits >> 13U)) &
+	              (lak::_alloc_block_shard_count - 1U)];
+}
+
+std::map<uintptr_t, lak::_alloc_reservation>::iterator
+lak::_alloc_stats_state::find_reservation(const void *ptr)
+{
+	auto it{reservations.upper_bound(uintptr_t(ptr))};
+	if (it == reservations.begin()) return reservations.end();
+	--it;
+	if (uintptr_t(ptr) >= it->first + it->second.size)
+		return reservations.end();
+	return it;
+}
+
+static void forget_block(lak::_alloc_stats_state &state,
+                         const lak::_alloc_block &block)
+{
+	lak::_alloc_site_slot &site{state.sites[block.site]};
+	site.frees.fetch_add(1U, std::memory_order_relaxed);
+	site.live_bytes.fetch_sub(block.size, std::memory_order_relaxed);
+
+	lak::_alloc_size_class_slot &size_class{
+	  state.size_classes[size_class_of(block.size)]};
+	size_class.live_count.fetch_sub(1U, std::memory_order_relaxed);
+	size_class.live_bytes.fetch_sub(block.size, std::memory_order_relaxed);
+
+	state.frees.fetch_add(1U, std::memory_order_relaxed);
+	state.live_bytes.fetch_sub(block.size, std::memory_order_relaxed);
+	state.slack_bytes.fetch_sub(block.slack, std::memory_order_relaxed);
+}
+
+void lak::_alloc_stats_allocated(lak::span<byte_t> data,
+                                 size_t slack,
+                                 lak::source_location site)
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+
+	const lak::_alloc_block block{
+	  .size = data.size(), .slack = slack, .site = state.find_site(site)};
+
+	{
+		lak::_alloc_block_shard &shard{state.shard_of(data.data())};
+		std::lock_guard lock{shard.mutex};
+		auto [it, inserted]{shard.blocks.try_emplace(data.data(), block)};
+		if (!inserted)
+		{
+			// the block was freed while stats were disabled and the address has
+			// been reused
+			forget_block(state, it->second);
+			it->second = block;
+		}
+	}
+
+	lak::_alloc_site_slot &site_slot{state.sites[block.site]};
+	site_slot.allocations.fetch_add(1U, std::memory_order_relaxed);
+	site_slot.live_bytes.fetch_add(block.size, std::memory_order_relaxed);
+	site_slot.total_bytes.fetch_add(block.size, std::memory_order_relaxed);
+
+	lak::_alloc_size_class_slot &size_class{
+	  state.size_classes[size_class_of(block.size)]};
+	size_class.allocations.fetch_add(1U, std::memory_order_relaxed);
+	size_class.live_count.fetch_add(1U, std::memory_order_relaxed);
+	size_class.live_bytes.fetch_add(block.size, std::memory_order_relaxed);
+
+	state.allocations.fetch_add(1U, std::memory_order_relaxed);
+	state.total_bytes.fetch_add(block.size, std::memory_order_relaxed);
+	state.slack_bytes.fetch_add(block.slack, std::memory_order_relaxed);
+	update_peak(
+	  state.peak_live_bytes,
+	  state.live_bytes.fetch_add(block.size, std::memory_order_relaxed) +
+	    block.size);
+}
+
+void lak::_alloc_stats_freed(lak::span<byte_t> data)
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+
+	lak::_alloc_block block;
+	{
+		lak::_alloc_block_shard &shard{state.shard_of(data.data())};
+		std::lock_guard lock{shard.mutex};
+		auto it{shard.blocks.find(data.data())};
+		// allocated before stats were enabled
+		if (it == shard.blocks.end()) return;
+		block = it->second;
+		shard.blocks.erase(it);
+	}
+
+	forget_block(state, block);
+}
+
+void lak::_alloc_stats_reserved(lak::span<void> pages)
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+	std::lock_guard lock{state.page_mutex};
+	state.reservations.insert_or_assign(
+	  uintptr_t(pages.data()),
+	  lak::_alloc_reservation{.size = pages.size(), .committed = 0U});
+	state.reserved_bytes += pages.size();
+	state.peak_reserved_bytes =
+	  std::max(state.peak_reserved_bytes, state.reserved_bytes);
+}
+
+void lak::_alloc_stats_committed(lak::span<void> pages)
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+	std::lock_guard lock{state.page_mutex};
+	auto it{state.find_reservation(pages.data())};
+	if (it == state.reservations.end()) return;
+	const size_t committed{
+	  std::min(pages.size(), it->second.size - it->second.committed)};
+	it->second.committed += committed;
+	state.committed_bytes += committed;
+	state.peak_committed_bytes =
+	  std::max(state.peak_committed_bytes, state.committed_bytes);
+}
+
+void lak::_alloc_stats_decommitted(lak::span<void> pages)
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+	std::lock_guard lock{state.page_mutex};
+	auto it{state.find_reservation(pages.data())};
+	if (it == state.reservations.end()) return;
+	const size_t decommitted{std::min(pages.size(), it->second.committed)};
+	it->second.committed -= decommitted;
+	state.committed_bytes -= decommitted;
+}
+
+void lak::_alloc_stats_released(lak::span<void> pages)
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+	std::lock_guard lock{state.page_mutex};
+	auto it{state.reservations.find(uintptr_t(pages.data()))};
+	if (it == state.reservations.end()) return;
+	state.reserved_bytes -= it->second.size;
+	state.committed_bytes -= it->second.committed;
+	state.reservations.erase(it);
+}
+
+void lak::enable_alloc_stats(bool enabled)
+{
+	// make sure the state exists before any hook can run
+	(void)alloc_stats_state();
+	lak::_alloc_stats_on.store(enabled, std::memory_order_relaxed);
+}
+
+lak::alloc_stats lak::get_alloc_stats()
+{
+	lak::_alloc_stats_state &state{alloc_stats_state()};
+
+	lak::alloc_stats result{};
+	result.allocations = state.allocations.load(std::memory_order_relaxed);
+	result.frees       = state.frees.load(std::memory_order_relaxed);
+	result.live_bytes  = state.live_bytes.load(std::memory_order_relaxed);
+	result.peak_live_bytes =
+	  state.peak_live_bytes.load(std::memory_order_relaxed);
+	result.total_bytes = state.total_bytes.load(std::memory_order_relaxed);
+	result.slack_bytes = state.slack_bytes.load(std::memory_order_relaxed);
+
+	{
+		std::lock_guard lock{state.page_mutex};
+		result.reserved_bytes       = state.reserved_bytes;
+		result.peak_reserved_bytes  = state.peak_reserved_bytes;
+		result.committed_bytes      = state.committed_bytes;
+		result.peak_committed_bytes = state.peak_committed_bytes;
+	}
+
+	for (size_t i = 0; i < lak::alloc_size_classes; ++i)
+	{
+		const lak::_alloc_size_class_slot &slot{state.size_classes[i]};
+		result.size_classes[i] = {
+		  .allocations = slot.allocations.load(std::memory_order_relaxed),
+		  .live_count  = slot.live_count.load(std::memory_order_relaxed),
+		  .live_bytes  = slot.live_bytes.load(std::memory_order_relaxed),
+		};
+	}
+
+	// no locks are held here, growing sites may record allocations
+	for (const lak::_alloc_site_slot &slot : state.sites)
+	{
+		if (!slot.ready.load(std::memory_order_acquire)) continue;
+		result.sites.push_back(lak::alloc_site_stats{
+		  .site        = slot.site,
+		  .allocations = slot.allocations.load(std::memory_order_relaxed),
+		  .frees       = slot.frees.load(std::memory_order_relaxed),
+		  .live_bytes  = slot.live_bytes.load(std::memory_order_relaxed),
+		  .total_bytes = slot.total_bytes.load(std::memory_order_relaxed),
+		});
+	}
+	lak::heapsort(
+	  result.sites.begin(),
+	  result.sites.end(),
+	  [](const lak::alloc_site_stats &a, const lak::alloc_site_stats &b)
+	  {
+		  return a.live_bytes != b.live_bytes ? a.live_bytes > b.live_bytes
+		                                      : a.total_bytes > b.total_bytes;
+	  });
+
+	return result;
+}
+
+static void write_json_string(std::ostream &strm, const char *str)
+{
+	if (!str)
+	{
+		strm << "null";
+		return;
+	}
+	strm << '"';
+	for (; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+			strm << '\\' << *str;
+		else if (uint8_t(*str) < 0x20U)
+			strm << ' ';
+		else
+			strm << *str;
+	}
+	strm << '"';
+}
+
+void lak::alloc_stats::to_json(std::ostream &strm) const
+{
+	strm << "{\"allocations\":" << allocations << ",\"frees\":" << frees
+	     << ",\"live_bytes\":" << live_bytes
+	     << ",\"peak_live_bytes\":" << peak_live_bytes
+	     << ",\"total_bytes\":" << total_bytes
+	     << ",\"slack_bytes\":" << slack_bytes << ",\"pages\":{"
+	     << "\"reserved_bytes\":" << reserved_bytes
+	     << ",\"peak_reserved_bytes\":" << peak_reserved_bytes
+	     << ",\"committed_bytes\":" << committed_bytes
+	     << ",\"peak_committed_bytes\":" << peak_committed_bytes << "}";
+
+	strm << ",\"size_classes\":[";
+	bool first{true};
+	for (size_t i = 0; i < lak::alloc_size_classes; ++i)
+	{
+		const lak::alloc_size_class_stats &size_class{size_classes[i]};
+		if (size_class.allocations == 0U) continue;
+		if (!first) strm << ",";
+		first = false;
+		strm << "{\"max_size\":";
+		if (i + 1U < lak::alloc_size_classes)
+			strm << ((size_t(1U) << i) - 1U);
+		else
+			strm << "null";
+		strm << ",\"allocations\":" << size_class.allocations
+		     << ",\"live_count\":" << size_class.live_count
+		     << ",\"live_bytes\":" << size_class.live_bytes << "}";
+	}
+	strm << "]";
+
+	strm << ",\"sites\":[";
+	first = true;
+	for (const lak::alloc_site_stats &site : sites)
+	{
+		if (!first) strm << ",";
+		first = false;
+		strm << "{\"file\":";
+		write_json_string(strm, site.site.file_name());
+		strm << ",\"line\":" << site.site.line() << ",\"function\":";
+		write_json_string(strm, site.site.function_name());
+		strm << ",\"allocations\":" << site.allocations
+		     << ",\"frees\":" << site.frees
+		     << ",\"live_bytes\":" << site.live_bytes
+		     << ",\"total_bytes\":" << site.total_bytes << "}";
+	}
+	strm << "]}";
+}
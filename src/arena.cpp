@@ -0,0 +1,132 @@
+#include "lak/arena.hpp"
+
+#include "lak/debug.hpp"
+#include "lak/math.hpp"
+#include "lak/memmanip.hpp"
+
+#include <algorithm>
+#include <bit>
+
+/* --- arena --- */
+
+lak::arena::arena(size_t block_size) : _block_size(block_size)
+{
+	ASSERT_GREATER(block_size, 0U);
+}
+
+size_t lak::arena::fit(const block &b, size_t size, size_t align)
+{
+	const uintptr_t base{uintptr_t(b.data())};
+	const size_t offset{
+	  size_t(lak::to_multiple<uintptr_t>(base + b.used, align) - base)};
+	if (offset > b.pages.size() || b.pages.size() - offset < size)
+		return SIZE_MAX;
+	return offset;
+}
+
+lak::alloc::result<lak::span<byte_t>> lak::arena::allocate(size_t size,
+                                                           size_t align)
+{
+	if (align == 0U) align = 1U;
+	ASSERT(std::has_single_bit(align));
+
+	size_t offset{SIZE_MAX};
+	for (; _current < _blocks.size(); ++_current)
+		if ((offset = fit(_blocks[_current], size, align)) != SIZE_MAX) break;
+
+	if (offset == SIZE_MAX)
+	{
+		// blocks after _current are always empty, start a new block at the end
+		// of the chain
+		if (size > SIZE_MAX - align) return lak::err_t<lak::bad_alloc>{};
+		RES_TRY_ASSIGN(
+		  lak::unique_pages pages =,
+		  lak::unique_pages::try_make(std::max(_block_size, size + align))
+		    .map_err([](auto &&) { return lak::bad_alloc{}; }));
+		_blocks.push_back(block{.pages = lak::move(pages)});
+		_current = _blocks.size() - 1U;
+		offset   = fit(_blocks[_current], size, align);
+		ASSERT_NOT_EQUAL(offset, SIZE_MAX);
+	}
+
+	block &b{_blocks[_current]};
+
+	if (const size_t end{offset + size}; end > b.committed)
+	{
+		const size_t new_committed{std::min(
+		  lak::round_to_page_multiple(std::max(end, b.committed + commit_size)),
+		  b.pages.size())};
+		if (lak::page_commit(lak::span<void>(b.data() + b.committed,
+		                                     new_committed - b.committed))
+		      .is_err())
+			return lak::err_t<lak::bad_alloc>{};
+		b.committed = new_committed;
+	}
+
+	b.used = offset + size;
+	return lak::ok_t{lak::span<byte_t>(b.data() + offset, size)};
+}
+
+void lak::arena::deallocate(lak::span<byte_t> data)
+{
+	if (_current >= _blocks.size()) return;
+	block &b{_blocks[_current]};
+	if (data.data() >= b.data() &&
+	    data.data() + data.size() == b.data() + b.used)
+		b.used = size_t(data.data() - b.data());
+}
+
+lak::arena::marker lak::arena::mark() const
+{
+	if (_current >= _blocks.size()) return {_current, 0U};
+	return {_current, _blocks[_current].used};
+}
+
+void lak::arena::rewind(marker m)
+{
+	ASSERT_GREATER_OR_EQUAL(_current, m.block);
+	for (size_t i = m.block + 1U; i <= _current && i < _blocks.size(); ++i)
+		_blocks[i].used = 0U;
+	if (m.block < _blocks.size())
+	{
+		ASSERT_GREATER_OR_EQUAL(_blocks[m.block].used, m.used);
+		_blocks[m.block].used = m.used;
+	}
+	_current = m.block;
+}
+
+void lak::arena::release()
+{
+	_blocks.force_clear();
+	_current = 0U;
+}
+
+size_t lak::arena::used() const
+{
+	size_t result{0U};
+	for (size_t i = 0U; i <= _current && i < _blocks.size(); ++i)
+		result += _blocks[i].used;
+	return result;
+}
+
+size_t lak::arena::reserved() const
+{
+	size_t result{0U};
+	for (const auto &b : _blocks) result += b.pages.size();
+	return result;
+}
+
+/* --- arena_allocator --- */
+
+lak::alloc::result<lak::span<byte_t>> lak::arena_allocator::allocate(
+  size_t size, size_t align) const
+{
+	ASSERT(_arena);
+	return _arena->allocate(size, align);
+}
+
+void lak::arena_allocator::deallocate(lak::span<byte_t> data) const
+{
+	ASSERT(_arena);
+	_arena->deallocate(data);
+}
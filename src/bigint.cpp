@@ -192,8 +192,8 @@ void lak::bigint::mul(lak::span<const value_type> value)
 		return;
 	}
 
-	_data.reserve(_data.size() + value.size());
-
+	// value may alias _data (x *= x), so _data must not be touched until
+	// result is swapped in
 	auto mspan{min_span()};
 
 	lak::bigint result;
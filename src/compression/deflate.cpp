@@ -37,88 +37,25 @@ const char *lak::deflate_iterator::error_name(error_t error)
 	}
 }
 
-template<typename T>
-bool lak::deflate_iterator::get_huff(lak::span<int16_t> table, T *out)
-{
-	uint8_t bits_used = 0;
-	uint32_t index    = 0;
-
-	for (bool looping = true; looping;)
-	{
-		if_let_ok (uintmax_t v, _compressed.peek_bits(bits_used + 1))
-		{
-			index += (v >> bits_used) & 1;
-			++bits_used;
-			if (table[index] >= 0)
-				looping = false;
-			else
-				index = ~(table[index]);
-			continue;
-		}
-		return true;
-	}
-
-	*out = table[index];
-
-	_compressed.read_bits(bits_used).UNWRAP();
-
-	return false;
-}
-
 lak::deflate_iterator::error_t lak::deflate_iterator::gen_huffman_table(
   lak::span<const uint8_t> lengths,
   bool allow_no_symbols,
-  lak::span<int16_t> table)
+  lak::huffman_kind kind,
+  uint8_t root_bits,
+  lak::huffman_table &table)
 {
-	uint16_t length_count[16] = {0};
-	uint16_t total_count      = 0;
-	uint16_t first_code[16];
-
-	for (uint32_t i = 0; i < lengths.size(); ++i)
-		if (lengths[i] > 0) ++length_count[lengths[i]];
-
-	for (uint32_t i = 1; i < 16; ++i) total_count += length_count[i];
-
-	if (total_count == 0)
+	switch (table.build(lengths, allow_no_symbols, kind, root_bits))
 	{
-		return allow_no_symbols ? error_t::ok : error_t::no_symbols;
-	}
-	else if (total_count == 1)
-	{
-		for (uint32_t i = 0; i < lengths.size(); ++i)
-			if (lengths[i] != 0) table[0] = table[1] = uint16_t(i);
-		return error_t::ok;
-	}
-
-	first_code[0] = 0;
-
-	for (uint32_t i = 1; i < 16; ++i)
-	{
-		first_code[i] = (first_code[i - 1] + length_count[i - 1]) << 1;
-		if (first_code[i] + length_count[i] > uint16_t(1 << i))
+		case lak::huffman_error::ok:
+			return error_t::ok;
+		case lak::huffman_error::no_symbols:
+			return error_t::no_symbols;
+		case lak::huffman_error::too_many_symbols:
 			return error_t::too_many_symbols;
+		case lak::huffman_error::incomplete_tree:
+			return error_t::incomplete_tree;
 	}
-
-	if (first_code[15] + length_count[15] != uint16_t(1 << 15))
-		return error_t::incomplete_tree;
-
-	for (uint32_t index = 0, i = 1; i < 16; ++i)
-	{
-		uint32_t code_limit = 1U << i;
-		uint32_t next_code  = first_code[i] + length_count[i];
-		uint32_t next_index = index + (code_limit - first_code[i]);
-
-		for (uint32_t j = 0; j < lengths.size(); ++j)
-			if (lengths[j] == i) table[index++] = uint16_t(j);
-
-		for (uint32_t j = next_code; j < code_limit; ++j)
-		{
-			table[index++] = uint16_t(~next_index);
-			next_index += 2;
-		}
-	}
-
-	return error_t::ok;
+	return error_t::huffman_table_gen_failed;
 }
 
 lak::deflate_iterator::deflate_iterator(
@@ -0,0 +1,644 @@
+#include "lak/compression/deflate_encoder.hpp"
+
+#include "lak/compression/huffman.hpp"
+#include "lak/crc.hpp"
+#include "lak/debug.hpp"
+#include "lak/utility.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+	struct match_params
+	{
+		// the most hash chain entries to search
+		size_t max_chain;
+		// stop searching once a match is at least this long
+		size_t nice_length;
+		// don't look for a better match at the next byte if we already have
+		// one at least this long
+		size_t max_lazy;
+		// search a quarter as many entries if we already have a match at least
+		// this long
+		size_t good_length;
+	};
+
+	constexpr match_params fast_params{
+	  .max_chain = 8U, .nice_length = 32U, .max_lazy = 0U, .good_length = 0U};
+	constexpr match_params lazy_params{.max_chain   = 128U,
+	                                   .nice_length = 128U,
+	                                   .max_lazy    = 32U,
+	                                   .good_length = 8U};
+
+	constexpr uint8_t codelen_order[19] = {
+	  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+	constexpr uint8_t codelen_extra[3] = {2U, 3U, 7U};
+
+	uint32_t length_symbol(size_t length)
+	{
+		if (length == lak::deflate_encoder::max_match) return 285U;
+		const uint32_t x{uint32_t(length - 3U)};
+		if (x < 8U) return 257U + x;
+		// 4 symbols per extra bit
+		const uint32_t n{uint32_t(std::bit_width(x) - 1U)};
+		return 257U + (4U * (n - 1U)) + ((x >> (n - 2U)) & 3U);
+	}
+
+	uint32_t distance_symbol(size_t distance)
+	{
+		const uint32_t x{uint32_t(distance - 1U)};
+		if (x < 4U) return x;
+		// 2 symbols per extra bit
+		const uint32_t n{uint32_t(std::bit_width(x) - 1U)};
+		return (2U * n) + ((x >> (n - 1U)) & 1U);
+	}
+
+	uint32_t adler32(uint32_t adler, lak::span<const byte_t> data)
+	{
+		uint32_t a = adler & 0xFFFFU, b = adler >> 16U;
+		while (!data.empty())
+		{
+			// the most bytes that can be summed before b could overflow
+			const size_t run{std::min<size_t>(data.size(), 5552U)};
+			for (byte_t c : data.first(run))
+			{
+				a += uint8_t(c);
+				b += a;
+			}
+			a %= 65521U;
+			b %= 65521U;
+			data = data.subspan(run);
+		}
+		return (b << 16U) | a;
+	}
+
+	uint32_t crc32(uint32_t crc, lak::span<const byte_t> data)
+	{
+		uint32_t icrc = ~crc;
+		for (byte_t c : data)
+			icrc = lak::crc32_table[(icrc & 0xFF) ^ uint8_t(c)] ^
+			       ((icrc >> 8) & 0xFF'FFFFUL);
+		return ~icrc & 0xFFFF'FFFFUL;
+	}
+
+	// multiplicative hash of the 3 bytes at data
+	uint32_t hash3(const byte_t *data, size_t bits)
+	{
+		const uint32_t x{uint32_t(data[0]) | (uint32_t(data[1]) << 8U) |
+		                 (uint32_t(data[2]) << 16U)};
+		return (x * 2654435761U) >> (32U - bits);
+	}
+
+	size_t match_length(const byte_t *a, const byte_t *b, size_t max_length)
+	{
+		size_t length = 0U;
+		for (uint64_t x, y; length + 8U <= max_length; length += 8U)
+		{
+			std::memcpy(&x, a + length, 8U);
+			std::memcpy(&y, b + length, 8U);
+			if (x != y) break;
+		}
+		while (length < max_length && a[length] == b[length]) ++length;
+		return length;
+	}
+
+	struct fixed_codes
+	{
+		uint8_t literal_lengths[288];
+		uint16_t literal_codes[288];
+		uint8_t distance_lengths[30];
+		uint16_t distance_codes[30];
+	};
+
+	const fixed_codes &get_fixed_codes()
+	{
+		static const fixed_codes codes = []
+		{
+			fixed_codes result;
+			std::fill_n(result.literal_lengths, 144U, uint8_t(8U));
+			std::fill_n(result.literal_lengths + 144U, 112U, uint8_t(9U));
+			std::fill_n(result.literal_lengths + 256U, 24U, uint8_t(7U));
+			std::fill_n(result.literal_lengths + 280U, 8U, uint8_t(8U));
+			std::fill_n(result.distance_lengths, 30U, uint8_t(5U));
+			lak::huffman_codes(result.literal_lengths, result.literal_codes);
+			lak::huffman_codes(result.distance_lengths, result.distance_codes);
+			return result;
+		}();
+		return codes;
+	}
+}
+
+/* --- deflate_encoder --- */
+
+lak::deflate_encoder::deflate_encoder(header_t header, level_t level)
+: _header(header), _level(level)
+{
+	_head.resize(size_t(1U) << _hash_bits, -1);
+	_prev.resize(window_size, -1);
+	_window.reserve(_window_limit);
+	write_header();
+}
+
+void lak::deflate_encoder::put_bits(uint32_t bits, uint8_t count)
+{
+	_bit_accum |= uint64_t(bits) << _num_bits;
+	_num_bits += count;
+	if (_num_bits >= 32U)
+	{
+		for (size_t i = 0U; i < 4U; ++i)
+			_compressed.push_back(byte_t(_bit_accum >> (i * 8U)));
+		_bit_accum >>= 32U;
+		_num_bits -= 32U;
+	}
+}
+
+void lak::deflate_encoder::align_bits()
+{
+	for (; _num_bits > 0U; _num_bits -= std::min<uint8_t>(_num_bits, 8U))
+	{
+		_compressed.push_back(byte_t(_bit_accum));
+		_bit_accum >>= 8U;
+	}
+	_bit_accum = 0U;
+}
+
+void lak::deflate_encoder::write_header()
+{
+	switch (_header)
+	{
+		case header_t::zlib:
+		{
+			_checksum = 1U;
+			// 32KiB window, the level is only informative
+			_compressed.push_back(byte_t(0x78U));
+			switch (_level)
+			{
+				case level_t::stored:
+					_compressed.push_back(byte_t(0x01U));
+					break;
+				case level_t::fast:
+					_compressed.push_back(byte_t(0x5EU));
+					break;
+				case level_t::lazy:
+					_compressed.push_back(byte_t(0x9CU));
+					break;
+			}
+		}
+		break;
+
+		case header_t::gzip:
+		{
+			_checksum = 0U;
+			// no file name or modification time, and an unknown OS
+			const uint8_t extra_flags{_level == level_t::fast ? uint8_t(4U)
+			                                                  : uint8_t(0U)};
+			const uint8_t header[10] = {
+			  0x1FU, 0x8BU, 0x08U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, extra_flags,
+			  0xFFU};
+			for (uint8_t b : header) _compressed.push_back(byte_t(b));
+		}
+		break;
+
+		case header_t::none:
+			break;
+	}
+}
+
+void lak::deflate_encoder::write_trailer()
+{
+	align_bits();
+	switch (_header)
+	{
+		case header_t::zlib:
+			for (size_t i = 4U; i-- > 0U;)
+				_compressed.push_back(byte_t(_checksum >> (i * 8U)));
+			break;
+
+		case header_t::gzip:
+			for (size_t i = 0U; i < 4U; ++i)
+				_compressed.push_back(byte_t(_checksum >> (i * 8U)));
+			for (size_t i = 0U; i < 4U; ++i)
+				_compressed.push_back(byte_t(_input_size >> (i * 8U)));
+			break;
+
+		case header_t::none:
+			break;
+	}
+}
+
+void lak::deflate_encoder::insert_hash(size_t pos)
+{
+	for (; _hashed < pos; ++_hashed)
+	{
+		if (_hashed + min_match > _window.size()) continue;
+		const uint32_t hash{hash3(_window.data() + _hashed, _hash_bits)};
+		_prev[_hashed & (window_size - 1U)] = _head[hash];
+		_head[hash]                         = int32_t(_hashed);
+	}
+}
+
+size_t lak::deflate_encoder::longest_match(size_t pos,
+                                           size_t prev_length,
+                                           size_t *distance) const
+{
+	ASSERT_EQUAL(_hashed, pos);
+
+	const size_t max_length{std::min(max_match, _window.size() - pos)};
+	if (max_length < min_match || prev_length >= max_length) return 0U;
+
+	const match_params &params{_level == level_t::fast ? fast_params
+	                                                   : lazy_params};
+	size_t chain{params.max_chain};
+	if (params.good_length > 0U && prev_length >= params.good_length)
+		chain >>= 2U;
+
+	const byte_t *data{_window.data()};
+	const size_t limit{pos > window_size ? pos - window_size : 0U};
+	const size_t initial_best{std::max(prev_length, min_match - 1U)};
+	size_t best{initial_best};
+
+	for (int32_t candidate = _head[hash3(data + pos, _hash_bits)];
+	     candidate >= 0 && size_t(candidate) >= limit && chain-- > 0U;)
+	{
+		const size_t c{size_t(candidate)};
+		// best < max_length, so these are in bounds
+		if (data[c + best] == data[pos + best] && data[c] == data[pos])
+		{
+			if (const size_t length{match_length(data + c, data + pos, max_length)};
+			    length > best)
+			{
+				best      = length;
+				*distance = pos - c;
+				if (length >= params.nice_length || length == max_length) break;
+			}
+		}
+
+		const int32_t next{_prev[c & (window_size - 1U)]};
+		if (next >= candidate) break;
+		candidate = next;
+	}
+
+	return best > initial_best ? best : 0U;
+}
+
+void lak::deflate_encoder::slide_window()
+{
+	// keep the shift a multiple of the window size so _prev doesn't move
+	if (_pos < window_size + _block_size) return;
+	const size_t shift{(_pos - window_size) & ~(window_size - 1U)};
+
+	std::copy(_window.begin() + shift, _window.end(), _window.begin());
+	_window.resize(_window.size() - shift);
+	_pos -= shift;
+	_hashed -= shift;
+
+	auto rebase = [shift](int32_t &pos)
+	{ pos = pos >= 0 && size_t(pos) >= shift ? int32_t(pos - shift) : -1; };
+	for (int32_t &pos : _head) rebase(pos);
+	for (int32_t &pos : _prev) rebase(pos);
+}
+
+void lak::deflate_encoder::match_greedy(size_t block_end)
+{
+	while (_pos < block_end)
+	{
+		size_t distance = 0U;
+		if (const size_t length{longest_match(_pos, 0U, &distance)};
+		    length >= min_match)
+		{
+			_tokens.push_back({uint16_t(length), uint16_t(distance)});
+			_pos += length;
+		}
+		else
+		{
+			_tokens.push_back({0U, uint16_t(_window[_pos])});
+			++_pos;
+		}
+		insert_hash(_pos);
+	}
+}
+
+void lak::deflate_encoder::match_lazy(size_t block_end)
+{
+	// the byte before _pos is waiting to see if the match starting at it is
+	// longer than the one starting at _pos
+	bool pending         = false;
+	size_t prev_length   = 0U;
+	size_t prev_distance = 0U;
+
+	auto emit_prev = [&]
+	{
+		if (prev_length >= min_match)
+		{
+			_tokens.push_back({uint16_t(prev_length), uint16_t(prev_distance)});
+			_pos += prev_length - 1U;
+			insert_hash(_pos);
+		}
+		else
+			_tokens.push_back({0U, uint16_t(_window[_pos - 1U])});
+		pending = false;
+	};
+
+	while (_pos < block_end)
+	{
+		size_t length = 0U, distance = 0U;
+		if (!pending || prev_length < lazy_params.max_lazy)
+			length = longest_match(_pos, pending ? prev_length : 0U, &distance);
+		insert_hash(_pos + 1U);
+
+		if (pending && prev_length >= min_match && length == 0U)
+		{
+			emit_prev();
+			continue;
+		}
+
+		// either there's no match at the previous byte or this one is longer
+		if (pending) _tokens.push_back({0U, uint16_t(_window[_pos - 1U])});
+		pending       = true;
+		prev_length   = length;
+		prev_distance = distance;
+		++_pos;
+	}
+
+	if (pending) emit_prev();
+}
+
+void lak::deflate_encoder::write_stored(lak::span<const byte_t> data,
+                                        bool final)
+{
+	do
+	{
+		const size_t size{std::min<size_t>(data.size(), 0xFFFFU)};
+		put_bits(final && size == data.size() ? 1U : 0U, 1U);
+		put_bits(0U, 2U);
+		align_bits();
+		const uint16_t len{uint16_t(size)}, nlen{uint16_t(~size)};
+		_compressed.push_back(byte_t(len));
+		_compressed.push_back(byte_t(len >> 8U));
+		_compressed.push_back(byte_t(nlen));
+		_compressed.push_back(byte_t(nlen >> 8U));
+		const size_t offset{_compressed.size()};
+		_compressed.resize(offset + size);
+		std::copy_n(data.begin(), size, _compressed.begin() + offset);
+		data = data.subspan(size);
+	} while (!data.empty());
+}
+
+void lak::deflate_encoder::write_block(size_t block_end, bool final)
+{
+	const size_t start{_pos};
+	_tokens.clear();
+	if (_level == level_t::fast)
+		match_greedy(block_end);
+	else
+		match_lazy(block_end);
+	const lak::span<const byte_t> raw{
+	  lak::span<const byte_t>(_window).subspan(start, _pos - start)};
+
+	uint32_t literal_freq[286]  = {};
+	uint32_t distance_freq[30] = {};
+	for (const token &t : _tokens)
+	{
+		if (t.length == 0U)
+		{
+			++literal_freq[t.value];
+		}
+		else
+		{
+			++literal_freq[length_symbol(t.length)];
+			++distance_freq[distance_symbol(t.value)];
+		}
+	}
+	literal_freq[256] = 1U;
+
+	uint8_t literal_lengths[286];
+	uint8_t distance_lengths[30];
+	lak::huffman_lengths(literal_freq, 15U, literal_lengths);
+	lak::huffman_lengths(distance_freq, 15U, distance_lengths);
+
+	size_t literal_count = 286U, distance_count = 30U;
+	while (literal_count > 257U && literal_lengths[literal_count - 1U] == 0U)
+		--literal_count;
+	while (distance_count > 1U && distance_lengths[distance_count - 1U] == 0U)
+		--distance_count;
+
+	// run length encode the code lengths
+	uint8_t lengths[286 + 30];
+	std::copy_n(literal_lengths, literal_count, lengths);
+	std::copy_n(distance_lengths, distance_count, lengths + literal_count);
+	const size_t lengths_count{literal_count + distance_count};
+
+	struct codelen_run
+	{
+		uint8_t symbol;
+		uint8_t extra;
+	};
+	lak::array<codelen_run> runs;
+	for (size_t i = 0U; i < lengths_count;)
+	{
+		const uint8_t length{lengths[i]};
+		size_t run = 1U;
+		while (i + run < lengths_count && lengths[i + run] == length) ++run;
+		i += run;
+
+		if (length == 0U)
+		{
+			while (run >= 11U)
+			{
+				const size_t count{std::min<size_t>(run, 138U)};
+				runs.push_back({18U, uint8_t(count - 11U)});
+				run -= count;
+			}
+			if (run >= 3U)
+			{
+				runs.push_back({17U, uint8_t(run - 3U)});
+				run = 0U;
+			}
+		}
+		else
+		{
+			runs.push_back({length, 0U});
+			--run;
+			while (run >= 3U)
+			{
+				const size_t count{std::min<size_t>(run, 6U)};
+				runs.push_back({16U, uint8_t(count - 3U)});
+				run -= count;
+			}
+		}
+
+		for (; run > 0U; --run) runs.push_back({length, 0U});
+	}
+
+	uint32_t codelen_freq[19] = {};
+	for (const codelen_run &run : runs) ++codelen_freq[run.symbol];
+	uint8_t codelen_lengths[19];
+	lak::huffman_lengths(codelen_freq, 7U, codelen_lengths);
+	size_t codelen_count = 19U;
+	while (codelen_count > 4U &&
+	       codelen_lengths[codelen_order[codelen_count - 1U]] == 0U)
+		--codelen_count;
+
+	// pick whichever block type is smallest
+	const fixed_codes &fixed{get_fixed_codes()};
+	size_t dynamic_bits = 3U + 5U + 5U + 4U + (3U * codelen_count);
+	size_t fixed_bits   = 3U;
+	for (const codelen_run &run : runs)
+		dynamic_bits += codelen_lengths[run.symbol] +
+		                (run.symbol >= 16U ? codelen_extra[run.symbol - 16U] : 0U);
+	for (size_t i = 0U; i < 286U; ++i)
+	{
+		const size_t extra{
+		  i > 256U ? size_t(lak::deflate_length_extra[i - 257U]) : 0U};
+		dynamic_bits += literal_freq[i] * (literal_lengths[i] + extra);
+		fixed_bits += literal_freq[i] * (fixed.literal_lengths[i] + extra);
+	}
+	for (size_t i = 0U; i < 30U; ++i)
+	{
+		const size_t extra{lak::deflate_distance_extra[i]};
+		dynamic_bits += distance_freq[i] * (distance_lengths[i] + extra);
+		fixed_bits += distance_freq[i] * (fixed.distance_lengths[i] + extra);
+	}
+	const size_t stored_blocks{std::max<size_t>((raw.size() + 0xFFFEU) / 0xFFFFU,
+	                                            1U)};
+	const size_t stored_bits{(raw.size() + (5U * stored_blocks)) * 8U};
+
+	if (stored_bits < std::min(fixed_bits, dynamic_bits))
+	{
+		write_stored(raw, final);
+		return;
+	}
+
+	auto write_tokens = [&](const uint8_t *literal_lengths,
+	                        const uint16_t *literal_codes,
+	                        const uint8_t *distance_lengths,
+	                        const uint16_t *distance_codes)
+	{
+		for (const token &t : _tokens)
+		{
+			if (t.length == 0U)
+			{
+				put_bits(literal_codes[t.value], literal_lengths[t.value]);
+				continue;
+			}
+
+			const uint32_t length{length_symbol(t.length)};
+			put_bits(literal_codes[length], literal_lengths[length]);
+			put_bits(t.length - lak::deflate_length_base[length - 257U],
+			         lak::deflate_length_extra[length - 257U]);
+
+			const uint32_t distance{distance_symbol(t.value)};
+			put_bits(distance_codes[distance], distance_lengths[distance]);
+			put_bits(t.value - lak::deflate_distance_base[distance],
+			         lak::deflate_distance_extra[distance]);
+		}
+		put_bits(literal_codes[256], literal_lengths[256]);
+	};
+
+	put_bits(final ? 1U : 0U, 1U);
+
+	if (fixed_bits <= dynamic_bits)
+	{
+		put_bits(1U, 2U);
+		write_tokens(fixed.literal_lengths,
+		             fixed.literal_codes,
+		             fixed.distance_lengths,
+		             fixed.distance_codes);
+		return;
+	}
+
+	put_bits(2U, 2U);
+	put_bits(uint32_t(literal_count - 257U), 5U);
+	put_bits(uint32_t(distance_count - 1U), 5U);
+	put_bits(uint32_t(codelen_count - 4U), 4U);
+	for (size_t i = 0U; i < codelen_count; ++i)
+		put_bits(codelen_lengths[codelen_order[i]], 3U);
+
+	uint16_t codelen_codes[19];
+	lak::huffman_codes(codelen_lengths, codelen_codes);
+	for (const codelen_run &run : runs)
+	{
+		put_bits(codelen_codes[run.symbol], codelen_lengths[run.symbol]);
+		if (run.symbol >= 16U)
+			put_bits(run.extra, codelen_extra[run.symbol - 16U]);
+	}
+
+	uint16_t literal_codes[286];
+	uint16_t distance_codes[30];
+	lak::huffman_codes(literal_lengths, literal_codes);
+	lak::huffman_codes(distance_lengths, distance_codes);
+	write_tokens(
+	  literal_lengths, literal_codes, distance_lengths, distance_codes);
+}
+
+void lak::deflate_encoder::write(lak::span<const byte_t> data)
+{
+	ASSERTF(!_finished, "writing to a finished deflate_encoder");
+
+	if (_header == header_t::zlib)
+		_checksum = adler32(_checksum, data);
+	else if (_header == header_t::gzip)
+		_checksum = crc32(_checksum, data);
+	_input_size += uint32_t(data.size());
+
+	while (!data.empty())
+	{
+		slide_window();
+		const size_t count{
+		  std::min(data.size(), _window_limit - _window.size())};
+		ASSERT_GREATER(count, 0U);
+		const size_t offset{_window.size()};
+		_window.resize(offset + count);
+		std::copy_n(data.begin(), count, _window.begin() + offset);
+		data = data.subspan(count);
+
+		if (_level == level_t::stored)
+		{
+			for (; _window.size() - _pos >= 0xFFFFU; _pos += 0xFFFFU)
+			{
+				write_stored(
+				  lak::span<const byte_t>(_window).subspan(_pos, 0xFFFFU), false);
+				slide_window();
+			}
+			continue;
+		}
+
+		// leave enough lookahead that matches are never cut short
+		while (_window.size() - _pos >= _block_size + (2U * max_match))
+		{
+			write_block(_pos + _block_size, false);
+			slide_window();
+		}
+	}
+}
+
+void lak::deflate_encoder::finish()
+{
+	ASSERTF(!_finished, "finishing a finished deflate_encoder");
+
+	if (_level == level_t::stored)
+		write_stored(lak::span<const byte_t>(_window).subspan(_pos), true);
+	else
+		write_block(_window.size(), true);
+	_pos = _window.size();
+
+	write_trailer();
+	_finished = true;
+}
+
+lak::array<byte_t> lak::deflate_encoder::take_compressed()
+{
+	return lak::exchange(_compressed, lak::array<byte_t>{});
+}
+
+lak::array<byte_t> lak::encode_deflate(lak::span<const byte_t> data,
+                                       lak::deflate_iterator::header_t header,
+                                       lak::deflate_encoder::level_t level)
+{
+	lak::deflate_encoder encoder{header, level};
+	encoder.write(data);
+	encoder.finish();
+	return encoder.take_compressed();
+}
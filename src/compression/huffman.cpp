@@ -0,0 +1,277 @@
+#include "lak/compression/huffman.hpp"
+
+#include "lak/debug.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr lak::huffman_entry invalid_entry{
+	  .value = 0U, .length = 1U, .op = lak::huffman_table::op_invalid};
+
+	lak::huffman_entry symbol_entry(lak::huffman_kind kind,
+	                                uint32_t symbol,
+	                                uint8_t length)
+	{
+		using table = lak::huffman_table;
+		switch (kind)
+		{
+			case lak::huffman_kind::symbols:
+				return {uint16_t(symbol), length, 0U};
+
+			case lak::huffman_kind::literal_length:
+				if (symbol < 256U)
+					return {uint16_t(symbol), length, table::op_literal};
+				if (symbol == 256U) return {0U, length, table::op_end};
+				if (symbol - 257U < 29U)
+					return {lak::deflate_length_base[symbol - 257U],
+					        length,
+					        lak::deflate_length_extra[symbol - 257U]};
+				break;
+
+			case lak::huffman_kind::distance:
+				if (symbol < 30U)
+					return {lak::deflate_distance_base[symbol],
+					        length,
+					        lak::deflate_distance_extra[symbol]};
+				break;
+		}
+		return {0U, length, table::op_invalid};
+	}
+
+	// deflate packs Huffman codes starting from their most significant bit
+	uint32_t reverse_bits(uint32_t code, uint8_t length)
+	{
+		uint32_t result = 0U;
+		for (uint8_t i = 0U; i < length; ++i, code >>= 1U)
+			result = (result << 1U) | (code & 1U);
+		return result;
+	}
+}
+
+lak::huffman_error lak::huffman_table::build(lak::span<const uint8_t> lengths,
+                                             bool allow_no_symbols,
+                                             lak::huffman_kind kind,
+                                             uint8_t root)
+{
+	static constexpr uint8_t max_root_bits = 11U;
+	ASSERT_LESS_OR_EQUAL(root, max_root_bits);
+
+	root_bits = root;
+	entries.clear();
+	entries.resize(size_t(1U) << root, invalid_entry);
+
+	uint16_t length_count[max_bits + 1U] = {};
+	for (uint8_t length : lengths)
+	{
+		ASSERT_LESS_OR_EQUAL(length, max_bits);
+		++length_count[length];
+	}
+	length_count[0] = 0U;
+
+	uint32_t total_count = 0U;
+	for (uint8_t i = 1U; i <= max_bits; ++i) total_count += length_count[i];
+
+	if (total_count == 0U)
+	{
+		return allow_no_symbols ? lak::huffman_error::ok
+		                        : lak::huffman_error::no_symbols;
+	}
+	else if (total_count == 1U)
+	{
+		// a lone code is a single bit, both values of which decode to it
+		for (uint32_t i = 0U; i < lengths.size(); ++i)
+			if (lengths[i] != 0U)
+				for (auto &entry : entries) entry = symbol_entry(kind, i, 1U);
+		return lak::huffman_error::ok;
+	}
+
+	uint32_t first_code[max_bits + 1U] = {};
+	for (uint8_t i = 1U; i <= max_bits; ++i)
+	{
+		first_code[i] = (first_code[i - 1U] + length_count[i - 1U]) << 1U;
+		if (first_code[i] + length_count[i] > (1U << i))
+			return lak::huffman_error::too_many_symbols;
+	}
+	if (first_code[max_bits] + length_count[max_bits] != (1U << max_bits))
+		return lak::huffman_error::incomplete_tree;
+
+	const uint32_t root_mask = (1U << root) - 1U;
+
+	// size the second level tables by the longest code under each root entry
+	uint8_t longest[1U << max_root_bits] = {};
+	uint32_t next_code[max_bits + 1U];
+	std::copy_n(first_code, max_bits + 1U, next_code);
+	for (uint8_t length : lengths)
+	{
+		if (length <= root) continue;
+		const uint32_t code{reverse_bits(next_code[length]++, length)};
+		longest[code & root_mask] =
+		  std::max(longest[code & root_mask], uint8_t(length - root));
+	}
+
+	size_t table_size = entries.size();
+	for (uint32_t i = 0U; i <= root_mask; ++i)
+	{
+		if (longest[i] == 0U) continue;
+		entries[i] = {
+		  uint16_t(table_size), root, uint8_t(op_link | longest[i])};
+		table_size += size_t(1U) << longest[i];
+	}
+	entries.resize(table_size, invalid_entry);
+
+	std::copy_n(first_code, max_bits + 1U, next_code);
+	for (uint32_t symbol = 0U; symbol < lengths.size(); ++symbol)
+	{
+		const uint8_t length{lengths[symbol]};
+		if (length == 0U) continue;
+		const uint32_t code{reverse_bits(next_code[length]++, length)};
+		const lak::huffman_entry entry{symbol_entry(kind, symbol, length)};
+
+		if (length <= root)
+		{
+			for (uint32_t i = code; i <= root_mask; i += 1U << length)
+				entries[i] = entry;
+		}
+		else
+		{
+			const lak::huffman_entry link{entries[code & root_mask]};
+			const uint32_t sub_size{1U << (link.op & 0xFU)};
+			for (uint32_t i = code >> root; i < sub_size; i += 1U << (length - root))
+				entries[link.value + i] = entry;
+		}
+	}
+
+	return lak::huffman_error::ok;
+}
+
+const lak::huffman_table &lak::huffman_table::fixed_literal_length()
+{
+	static const lak::huffman_table table = []
+	{
+		uint8_t lengths[288];
+		for (size_t i = 0U; i < 144U; ++i) lengths[i] = 8U;
+		for (size_t i = 144U; i < 256U; ++i) lengths[i] = 9U;
+		for (size_t i = 256U; i < 280U; ++i) lengths[i] = 7U;
+		for (size_t i = 280U; i < 288U; ++i) lengths[i] = 8U;
+		lak::huffman_table result;
+		[[maybe_unused]] const auto err{result.build(
+		  lengths, false, lak::huffman_kind::literal_length, 9U)};
+		ASSERT(err == lak::huffman_error::ok);
+		return result;
+	}();
+	return table;
+}
+
+const lak::huffman_table &lak::huffman_table::fixed_distance()
+{
+	static const lak::huffman_table table = []
+	{
+		uint8_t lengths[32];
+		for (auto &length : lengths) length = 5U;
+		lak::huffman_table result;
+		[[maybe_unused]] const auto err{
+		  result.build(lengths, false, lak::huffman_kind::distance, 5U)};
+		ASSERT(err == lak::huffman_error::ok);
+		return result;
+	}();
+	return table;
+}
+
+void lak::huffman_lengths(lak::span<const uint32_t> frequencies,
+                          uint8_t max_bits,
+                          lak::span<uint8_t> lengths)
+{
+	ASSERT_EQUAL(frequencies.size(), lengths.size());
+	ASSERT_GREATER_OR_EQUAL(size_t(1U) << max_bits, frequencies.size());
+	ASSERT_LESS_OR_EQUAL(max_bits, lak::huffman_table::max_bits);
+
+	std::fill(lengths.begin(), lengths.end(), uint8_t(0U));
+
+	// leaves sorted by frequency, padded out to two symbols
+	lak::array<uint32_t> symbols;
+	for (uint32_t i = 0U; i < frequencies.size(); ++i)
+		if (frequencies[i] > 0U) symbols.push_back(i);
+	for (uint32_t i = 0U; symbols.size() < 2U && i < frequencies.size(); ++i)
+		if (frequencies[i] == 0U) symbols.push_back(i);
+	if (symbols.size() < 2U) return;
+	std::stable_sort(symbols.begin(),
+	                 symbols.end(),
+	                 [&](uint32_t a, uint32_t b)
+	                 { return frequencies[a] < frequencies[b]; });
+
+	// the leaves are already sorted and the internal nodes are made in order
+	// of weight, so the two lightest nodes are always at the front of one of
+	// the two queues
+	const size_t leaf_count{symbols.size()};
+	lak::array<uint32_t> weight(leaf_count * 2U - 1U);
+	lak::array<uint32_t> parent(leaf_count * 2U - 1U);
+	for (size_t i = 0U; i < leaf_count; ++i)
+		weight[i] = frequencies[symbols[i]];
+	size_t next_leaf = 0U, next_node = leaf_count;
+	auto lightest    = [&](size_t made) -> size_t
+	{
+		if (next_leaf < leaf_count &&
+		    (next_node == made || weight[next_leaf] <= weight[next_node]))
+			return next_leaf++;
+		return next_node++;
+	};
+	for (size_t node = leaf_count; node < weight.size(); ++node)
+	{
+		const size_t a{lightest(node)}, b{lightest(node)};
+		weight[node] = weight[a] + weight[b];
+		parent[a] = parent[b] = uint32_t(node);
+	}
+
+	// children always come before their parent
+	lak::array<uint32_t> depth(weight.size());
+	depth.back() = 0U;
+	for (size_t i = weight.size() - 1U; i-- > 0U;)
+		depth[i] = depth[parent[i]] + 1U;
+
+	uint32_t length_count[lak::huffman_table::max_bits + 1U] = {};
+	for (size_t i = 0U; i < leaf_count; ++i)
+		++length_count[std::min<uint32_t>(depth[i], max_bits)];
+
+	// clamping the depths overfills the code space, so lengthen shorter codes
+	// until it fits again
+	uint32_t total = 0U;
+	for (uint8_t i = 1U; i <= max_bits; ++i)
+		total += length_count[i] << (max_bits - i);
+	for (; total > (1U << max_bits); --total)
+	{
+		--length_count[max_bits];
+		for (uint8_t i = max_bits - 1U; i > 0U; --i)
+		{
+			if (length_count[i] == 0U) continue;
+			--length_count[i];
+			length_count[i + 1U] += 2U;
+			break;
+		}
+	}
+
+	// the least frequent symbols get the longest codes
+	size_t index = 0U;
+	for (uint8_t length = max_bits; length > 0U; --length)
+		for (uint32_t i = 0U; i < length_count[length]; ++i)
+			lengths[symbols[index++]] = length;
+}
+
+void lak::huffman_codes(lak::span<const uint8_t> lengths,
+                        lak::span<uint16_t> codes)
+{
+	ASSERT_EQUAL(lengths.size(), codes.size());
+
+	uint16_t length_count[lak::huffman_table::max_bits + 1U] = {};
+	for (uint8_t length : lengths) ++length_count[length];
+	length_count[0] = 0U;
+
+	uint32_t next_code[lak::huffman_table::max_bits + 1U] = {};
+	for (uint8_t i = 1U; i <= lak::huffman_table::max_bits; ++i)
+		next_code[i] = (next_code[i - 1U] + length_count[i - 1U]) << 1U;
+
+	for (size_t i = 0U; i < lengths.size(); ++i)
+		codes[i] = lengths[i] == 0U
+		             ? uint16_t(0U)
+		             : uint16_t(reverse_bits(next_code[lengths[i]]++, lengths[i]));
+}
@@ -1,6 +1,11 @@
 #include "lak/compression/lz4.hpp"
 
-#include "lak/binary_writer.hpp"
+#include "lak/compiler.hpp"
+#include "lak/debug.hpp"
+#include "lak/xxhash.hpp"
+
+#include <algorithm>
+#include <cstring>
 
 const char *lak::lz4_error_name(lak::lz4_decode_error err)
 {
@@ -10,100 +15,701 @@ const char *lak::lz4_error_name(lak::lz4_decode_error err)
 			return "too many literals";
 		case lak::lz4_decode_error::out_of_data:
 			return "out of data";
+		case lak::lz4_decode_error::output_full:
+			return "output full";
 		case lak::lz4_decode_error::zero_offset:
 			return "zero offset";
 		case lak::lz4_decode_error::offset_too_large:
 			return "offset too large";
 		case lak::lz4_decode_error::match_too_long:
 			return "match too long";
+		case lak::lz4_decode_error::invalid_magic:
+			return "invalid magic";
+		case lak::lz4_decode_error::unsupported_frame:
+			return "unsupported frame";
+		case lak::lz4_decode_error::header_checksum_mismatch:
+			return "header checksum mismatch";
+		case lak::lz4_decode_error::block_too_large:
+			return "block too large";
+		case lak::lz4_decode_error::block_checksum_mismatch:
+			return "block checksum mismatch";
+		case lak::lz4_decode_error::content_size_mismatch:
+			return "content size mismatch";
+		case lak::lz4_decode_error::content_checksum_mismatch:
+			return "content checksum mismatch";
 		default:
 			return "invalid error code";
 	}
 }
 
-lak::result<lak::array<byte_t>, lak::lz4_decode_error> lak::decode_lz4_block(
-  lak::binary_reader &strm, size_t output_size, bool allow_partial_read)
+namespace
 {
-	lak::array<byte_t> output(output_size);
-	lak::binary_span_writer writer{lak::span<byte_t>(lak::span(output))};
+	constexpr size_t min_match = 4U;
+	// the last match must start at least this far from the end of a block
+	constexpr size_t match_start_limit = 12U;
+	// and every block ends with at least this many literals
+	constexpr size_t last_literals = 5U;
+	constexpr size_t max_offset    = 0xFFFFU;
 
-	auto out_of_data = [](auto &&)
-	{ return lak::lz4_decode_error::out_of_data; };
+	constexpr uint32_t frame_magic           = 0x184D2204U;
+	constexpr uint32_t skippable_frame_magic = 0x184D2A50U;
+	constexpr uint32_t uncompressed_block    = 0x8000'0000U;
 
-	for (;;)
+	uint32_t read_u32(const byte_t *data)
 	{
-		RES_TRY_ASSIGN(const uint8_t token =, strm.read_u8().map_err(out_of_data));
-		size_t match_length = (token >> 0) & 0xF;
-		size_t length       = (token >> 4) & 0xF;
+		uint32_t result;
+		std::memcpy(&result, data, sizeof(result));
+		return result;
+	}
+
+	uint32_t hash4(const byte_t *data, size_t bits)
+	{
+		return (read_u32(data) * 2654435761U) >> (32U - bits);
+	}
 
-		if (length == 15)
+	size_t match_length(const byte_t *a, const byte_t *b, size_t max_length)
+	{
+		size_t length = 0U;
+		for (uint64_t x, y; length + 8U <= max_length; length += 8U)
 		{
-			// read more bytes
+			std::memcpy(&x, a + length, 8U);
+			std::memcpy(&y, b + length, 8U);
+			if (x != y) break;
+		}
+		while (length < max_length && a[length] == b[length]) ++length;
+		return length;
+	}
 
-			for (;;)
+	void append(lak::array<byte_t> &output, lak::span<const byte_t> data)
+	{
+		const size_t offset{output.size()};
+		output.resize(offset + data.size());
+		std::copy_n(data.begin(), data.size(), output.begin() + offset);
+	}
+
+	void write_u32(lak::array<byte_t> &output, uint32_t value)
+	{
+		for (size_t i = 0U; i < 4U; ++i)
+			output.push_back(byte_t(value >> (i * 8U)));
+	}
+
+	void write_length(lak::array<byte_t> &output, size_t length)
+	{
+		for (; length >= 255U; length -= 255U) output.push_back(byte_t(255U));
+		output.push_back(byte_t(length));
+	}
+
+	void write_sequence(lak::array<byte_t> &output,
+	                    lak::span<const byte_t> literals,
+	                    size_t offset,
+	                    size_t length)
+	{
+		const size_t match_code{length - min_match};
+		output.push_back(
+		  byte_t((std::min<size_t>(literals.size(), 15U) << 4U) |
+		         std::min<size_t>(match_code, 15U)));
+		if (literals.size() >= 15U) write_length(output, literals.size() - 15U);
+		append(output, literals);
+		output.push_back(byte_t(offset));
+		output.push_back(byte_t(offset >> 8U));
+		if (match_code >= 15U) write_length(output, match_code - 15U);
+	}
+
+	void write_last_literals(lak::array<byte_t> &output,
+	                         lak::span<const byte_t> literals)
+	{
+		output.push_back(byte_t(std::min<size_t>(literals.size(), 15U) << 4U));
+		if (literals.size() >= 15U) write_length(output, literals.size() - 15U);
+		append(output, literals);
+	}
+
+	// compresses buffer after the first prefix bytes, which matches may refer
+	// back into
+	void encode_fast(lak::span<const byte_t> buffer,
+	                 size_t prefix,
+	                 lak::array<byte_t> &output,
+	                 uint32_t acceleration)
+	{
+		static constexpr size_t hash_bits = 12U;
+
+		const byte_t *base{buffer.data()};
+		const size_t end{buffer.size()};
+		size_t anchor = prefix;
+
+		if (end - prefix > match_start_limit)
+		{
+			lak::array<uint32_t> table;
+			table.resize(size_t(1U) << hash_bits, 0U);
+			for (size_t pos = prefix > max_offset ? prefix - max_offset : 0U;
+			     pos < prefix && pos + min_match <= end;
+			     ++pos)
+				table[hash4(base + pos, hash_bits)] = uint32_t(pos);
+
+			const size_t limit{end - match_start_limit};
+			const size_t match_end{end - last_literals};
+			const size_t first_step{size_t(std::max(acceleration, 1U)) << 6U};
+			size_t step = first_step;
+
+			for (size_t pos = prefix; pos < limit;)
 			{
-				RES_TRY_ASSIGN(uint8_t another =, strm.read_u8().map_err(out_of_data));
-				if (length + another < length)
-					return lak::err_t{lak::lz4_decode_error::too_many_literals};
-				length += another;
-				if (another != 255) break;
+				const uint32_t hash{hash4(base + pos, hash_bits)};
+				size_t match{table[hash]};
+				table[hash] = uint32_t(pos);
+				if (match >= pos || pos - match > max_offset ||
+				    read_u32(base + match) != read_u32(base + pos))
+				{
+					// skip ahead faster the longer we go without a match
+					pos += step++ >> 6U;
+					continue;
+				}
+
+				// extend the match backwards into the pending literals
+				while (pos > anchor && match > 0U &&
+				       base[pos - 1U] == base[match - 1U])
+				{
+					--pos;
+					--match;
+				}
+
+				const size_t length{
+				  min_match + match_length(base + match + min_match,
+				                           base + pos + min_match,
+				                           match_end - pos - min_match)};
+				write_sequence(output,
+				               buffer.subspan(anchor, pos - anchor),
+				               pos - match,
+				               length);
+				pos += length;
+				anchor = pos;
+				step   = first_step;
+
+				if (pos < limit)
+					table[hash4(base + pos - 2U, hash_bits)] = uint32_t(pos - 2U);
 			}
 		}
 
-		// there are <length> literals
+		write_last_literals(output, buffer.subspan(anchor));
+	}
+
+	void encode_high_compression(lak::span<const byte_t> buffer,
+	                             size_t prefix,
+	                             lak::array<byte_t> &output)
+	{
+		static constexpr size_t hash_bits    = 15U;
+		static constexpr size_t max_attempts = 256U;
+		static constexpr uint32_t no_pos     = UINT32_MAX;
+
+		const byte_t *base{buffer.data()};
+		const size_t end{buffer.size()};
+		size_t anchor = prefix;
 
-		if (writer.remaining().size() < length)
+		if (end - prefix > match_start_limit)
 		{
-			if (allow_partial_read)
-				length = writer.remaining().size();
-			else
-				return lak::err_t{lak::lz4_decode_error::output_full};
+			// head of each hash chain and the distance back to the next entry of
+			// the chain of each position in the window, 0 terminated
+			lak::array<uint32_t> head;
+			head.resize(size_t(1U) << hash_bits, no_pos);
+			lak::array<uint16_t> chain;
+			chain.resize(max_offset + 1U, 0U);
+
+			const size_t match_end{end - last_literals};
+			size_t hashed = prefix > max_offset ? prefix - max_offset : 0U;
+
+			auto find_match = [&](size_t pos, size_t *match) -> size_t
+			{
+				for (; hashed < pos; ++hashed)
+				{
+					const uint32_t hash{hash4(base + hashed, hash_bits)};
+					const size_t distance{
+					  head[hash] == no_pos ? 0U : hashed - head[hash]};
+					chain[hashed & max_offset] =
+					  uint16_t(distance > max_offset ? 0U : distance);
+					head[hash] = uint32_t(hashed);
+				}
+
+				const size_t max_length{match_end - pos};
+				size_t best = min_match - 1U;
+				uint32_t candidate{head[hash4(base + pos, hash_bits)]};
+				for (size_t attempts = max_attempts;
+				     candidate != no_pos && pos - candidate <= max_offset &&
+				     attempts > 0U;
+				     --attempts)
+				{
+					if (base[candidate + best] == base[pos + best] &&
+					    read_u32(base + candidate) == read_u32(base + pos))
+					{
+						const size_t length{
+						  min_match + match_length(base + candidate + min_match,
+						                           base + pos + min_match,
+						                           max_length - min_match)};
+						if (length > best)
+						{
+							best   = length;
+							*match = candidate;
+							if (length == max_length) break;
+						}
+					}
+
+					const uint16_t distance{chain[candidate & max_offset]};
+					if (distance == 0U) break;
+					candidate -= distance;
+				}
+				return best >= min_match ? best : 0U;
+			};
+
+			const size_t limit{end - match_start_limit};
+			for (size_t pos = prefix; pos < limit;)
+			{
+				size_t match = 0U;
+				size_t length{find_match(pos, &match)};
+				if (length == 0U)
+				{
+					++pos;
+					continue;
+				}
+
+				// take the match at the next byte instead if it's longer
+				for (size_t next_match = 0U; pos + 1U < limit;)
+				{
+					const size_t next_length{find_match(pos + 1U, &next_match)};
+					if (next_length <= length) break;
+					++pos;
+					length = next_length;
+					match  = next_match;
+				}
+
+				write_sequence(output,
+				               buffer.subspan(anchor, pos - anchor),
+				               pos - match,
+				               length);
+				pos += length;
+				anchor = pos;
+			}
 		}
-		if (strm.remaining().size() < length)
-			return lak::err_t{lak::lz4_decode_error::out_of_data};
-		writer.write(strm.remaining().first(length)).unwrap();
-		RES_TRY(strm.skip(length).map_err(out_of_data));
 
-		if (strm.empty()) break; // reached the end of the last block
+		write_last_literals(output, buffer.subspan(anchor));
+	}
+
+	void encode_block(lak::span<const byte_t> buffer,
+	                  size_t prefix,
+	                  lak::array<byte_t> &output,
+	                  lak::lz4_mode mode,
+	                  uint32_t acceleration)
+	{
+		output.reserve(output.size() +
+		               lak::lz4_compress_bound(buffer.size() - prefix));
+		if (mode == lak::lz4_mode::high_compression)
+			encode_high_compression(buffer, prefix, output);
+		else
+			encode_fast(buffer, prefix, output, acceleration);
+	}
 
-		RES_TRY_ASSIGN(const auto offset =, strm.read_u16().map_err(out_of_data));
-		if (offset == 0) return lak::err_t{lak::lz4_decode_error::zero_offset};
+	// the decoder copies in chunks of up to this many bytes, so it may write
+	// this far past the end of a sequence or read this far past the end of
+	// its literals. sequences closer than this to the end of either buffer
+	// are copied exactly.
+	constexpr size_t copy_slack = 16U;
 
-		if (match_length == 15)
+	force_inline void wild_copy(byte_t *dst, const byte_t *src, size_t size)
+	{
+		for (byte_t *const end{dst + size}; dst < end; dst += 16U, src += 16U)
+			std::memcpy(dst, src, 16U);
+	}
+
+	// matches may overlap the bytes they write
+	force_inline void copy_match(byte_t *dst, size_t offset, size_t size)
+	{
+		byte_t *const end{dst + size};
+		if (offset >= 16U)
+		{
+			wild_copy(dst, dst - offset, size);
+		}
+		else if (offset >= 8U)
+		{
+			for (; dst < end; dst += 8U) std::memcpy(dst, dst - offset, 8U);
+		}
+		else
+		{
+			// replicate the pattern until it's at least 8 bytes long, then copy
+			// from a whole number of patterns back
+			const byte_t *src{dst - offset};
+			for (size_t i = 0U; i < 8U; ++i) dst[i] = src[i];
+			const size_t period{offset * ((8U + offset - 1U) / offset)};
+			for (dst += 8U; dst < end; dst += 8U)
+				std::memcpy(dst, dst - period, 8U);
+		}
+	}
+
+	// decodes a block into output after the first prefix bytes, which matches
+	// may refer back into, and then back into dictionary before that. returns
+	// the number of bytes decoded.
+	lak::result<size_t, lak::lz4_decode_error> decode_block(
+	  lak::binary_reader &strm,
+	  lak::span<byte_t> output,
+	  size_t prefix,
+	  lak::span<const byte_t> dictionary,
+	  bool allow_partial_read)
+	{
+		const byte_t *const in_begin{strm.remaining().data()};
+		const byte_t *const in_end{in_begin + strm.remaining().size()};
+		const byte_t *in = in_begin;
+
+		byte_t *const out_begin{output.data()};
+		byte_t *const out_end{out_begin + output.size()};
+		byte_t *out = out_begin + prefix;
+
+		auto read_length = [&](size_t &length) -> bool
 		{
 			for (;;)
 			{
-				RES_TRY_ASSIGN(uint8_t another =, strm.read_u8().map_err(out_of_data));
-				if (match_length + another < match_length)
-					return lak::err_t{lak::lz4_decode_error::match_too_long};
-				match_length += another;
-				if (another != 255) break;
+				if (in == in_end) return false;
+				const uint8_t another{uint8_t(*in++)};
+				if (length + another < length) return false;
+				length += another;
+				if (another != 255U) return true;
+			}
+		};
+
+		for (;;)
+		{
+			if (in == in_end)
+				return lak::err_t{lak::lz4_decode_error::out_of_data};
+			const uint8_t token{uint8_t(*in++)};
+			size_t match_length = (token >> 0) & 0xF;
+			size_t length       = (token >> 4) & 0xF;
+
+			if (length == 15 && !read_length(length))
+				return lak::err_t{in == in_end
+				                    ? lak::lz4_decode_error::out_of_data
+				                    : lak::lz4_decode_error::too_many_literals};
+
+			// there are <length> literals
+
+			if (size_t(out_end - out) < length)
+			{
+				if (!allow_partial_read)
+					return lak::err_t{lak::lz4_decode_error::output_full};
+				length = size_t(out_end - out);
+			}
+			if (size_t(in_end - in) < length)
+				return lak::err_t{lak::lz4_decode_error::out_of_data};
+			if (size_t(in_end - in) >= length + copy_slack &&
+			    size_t(out_end - out) >= length + copy_slack)
+				wild_copy(out, in, length);
+			else if (length > 0U)
+				std::memcpy(out, in, length);
+			out += length;
+			in += length;
+
+			if (in == in_end) break; // reached the end of the last block
+
+			if (allow_partial_read && out == out_end) break;
+
+			if (in_end - in < 2)
+				return lak::err_t{lak::lz4_decode_error::out_of_data};
+			const size_t offset{size_t(in[0]) | (size_t(in[1]) << 8U)};
+			in += 2;
+			if (offset == 0) return lak::err_t{lak::lz4_decode_error::zero_offset};
+
+			if (match_length == 15 && !read_length(match_length))
+				return lak::err_t{in == in_end
+				                    ? lak::lz4_decode_error::out_of_data
+				                    : lak::lz4_decode_error::match_too_long};
+
+			// match_length is always offset by 4 (the minimum match length)
+			if (match_length + 4 < match_length)
+				return lak::err_t{lak::lz4_decode_error::match_too_long};
+			match_length += 4;
+
+			const size_t history{size_t(out - out_begin)};
+			if (history < offset && offset - history > dictionary.size())
+				return lak::err_t{lak::lz4_decode_error::offset_too_large};
+			if (size_t(out_end - out) < match_length)
+			{
+				if (!allow_partial_read)
+					return lak::err_t{lak::lz4_decode_error::output_full};
+				match_length = size_t(out_end - out);
 			}
+			if (history < offset)
+			{
+				// the match starts in the dictionary, the rest of it (if any)
+				// continues from the start of output
+				const size_t from_dictionary{
+				  std::min(match_length, offset - history)};
+				std::memcpy(out,
+				            dictionary.data() + dictionary.size() -
+				              (offset - history),
+				            from_dictionary);
+				out += from_dictionary;
+				match_length -= from_dictionary;
+			}
+			// copy_match always copies at least 8 bytes, which would read from
+			// before output if the whole match was in the dictionary
+			if (match_length > 0U &&
+			    size_t(out_end - out) >= match_length + copy_slack)
+			{
+				copy_match(out, offset, match_length);
+				out += match_length;
+			}
+			else
+			{
+				// this may be an aliasing copy!
+				for (byte_t *end{out + match_length}; out < end; ++out)
+					*out = *(out - offset);
+			}
+
+			if (allow_partial_read && out == out_end) break;
 		}
 
-		// match_length is always offset by 4 (the minimum match length)
-		if (match_length + 4 < match_length)
-			return lak::err_t{lak::lz4_decode_error::match_too_long};
-		match_length += 4;
+		RES_TRY(strm.skip(size_t(in - in_begin)).map_err(
+		  [](auto &&) { return lak::lz4_decode_error::out_of_data; }));
+
+		return lak::ok_t{size_t(out - out_begin) - prefix};
+	}
+}
+
+void lak::encode_lz4_block(lak::span<const byte_t> data,
+                           lak::array<byte_t> *output,
+                           lak::lz4_mode mode,
+                           uint32_t acceleration,
+                           lak::span<const byte_t> dictionary)
+{
+	if (dictionary.empty())
+	{
+		encode_block(data, 0U, *output, mode, acceleration);
+		return;
+	}
+
+	// the matches need the dictionary and data in one buffer
+	dictionary = dictionary.last(std::min(dictionary.size(), max_offset));
+	lak::array<byte_t> buffer;
+	buffer.reserve(dictionary.size() + data.size());
+	append(buffer, dictionary);
+	append(buffer, data);
+	encode_block(buffer, dictionary.size(), *output, mode, acceleration);
+}
+
+lak::array<byte_t> lak::encode_lz4_block(lak::span<const byte_t> data,
+                                         lak::lz4_mode mode,
+                                         uint32_t acceleration)
+{
+	lak::array<byte_t> result;
+	lak::encode_lz4_block(data, &result, mode, acceleration);
+	return result;
+}
+
+lak::result<lak::array<byte_t>, lak::lz4_decode_error> lak::decode_lz4_block(
+  lak::binary_reader &strm, size_t output_size, bool allow_partial_read)
+{
+	lak::array<byte_t> output(output_size);
+
+	RES_TRY_ASSIGN(const size_t decoded =,
+	               lak::decode_lz4_block(
+	                 strm, lak::span(output), {}, allow_partial_read));
+
+	if (decoded != output.size()) WARNING("Expected More Output Data");
+
+	return lak::move_ok(output);
+}
+
+lak::result<size_t, lak::lz4_decode_error> lak::decode_lz4_block(
+  lak::binary_reader &strm,
+  lak::span<byte_t> output,
+  lak::span<const byte_t> dictionary,
+  bool allow_partial_read)
+{
+	return decode_block(strm,
+	                    output,
+	                    0U,
+	                    dictionary.last(std::min(dictionary.size(), max_offset)),
+	                    allow_partial_read);
+}
+
+lak::result<size_t, lak::lz4_decode_error> lak::decode_lz4_block(
+  lak::binary_reader &strm,
+  lak::array<byte_t> *output,
+  size_t max_output_size,
+  bool linked,
+  bool allow_partial_read)
+{
+	const size_t start{output->size()};
+	const size_t prefix{linked ? std::min(start, max_offset) : 0U};
 
-		// this may be an aliasing copy!
-		if (writer.position() < offset)
-			return lak::err_t{lak::lz4_decode_error::offset_too_large};
-		if (writer.remaining().size() < match_length)
+	// resizing a byte array leaves the new bytes uninitialised
+	output->resize(start + max_output_size);
+	auto result{decode_block(
+	  strm,
+	  lak::span(*output).subspan(start - prefix, prefix + max_output_size),
+	  prefix,
+	  {},
+	  allow_partial_read)};
+	output->resize(start + result.unwrap_or(0U));
+	return result;
+}
+
+lak::array<byte_t> lak::encode_lz4_frame(
+  lak::span<const byte_t> data, const lak::lz4_frame_options &options)
+{
+	lak::array<byte_t> result;
+	write_u32(result, frame_magic);
+
+	const size_t descriptor_start{result.size()};
+	result.push_back(byte_t(0x40U | (options.linked_blocks ? 0x00U : 0x20U) |
+	                        (options.block_checksums ? 0x10U : 0x00U) |
+	                        (options.content_size ? 0x08U : 0x00U) |
+	                        (options.content_checksum ? 0x04U : 0x00U)));
+	result.push_back(byte_t(uint8_t(options.block_size) << 4U));
+	if (options.content_size)
+	{
+		write_u32(result, uint32_t(uint64_t(data.size())));
+		write_u32(result, uint32_t(uint64_t(data.size()) >> 32U));
+	}
+	result.push_back(byte_t(
+	  lak::xxhash32(lak::span<const byte_t>(result).subspan(descriptor_start)) >>
+	  8U));
+
+	const size_t block_size{size_t(1U)
+	                        << (8U + (2U * uint8_t(options.block_size)))};
+	for (size_t start = 0U; start < data.size(); start += block_size)
+	{
+		const size_t size{std::min(block_size, data.size() - start)};
+		const size_t prefix{options.linked_blocks ? std::min(start, max_offset)
+		                                          : 0U};
+
+		const size_t size_pos{result.size()};
+		write_u32(result, 0U);
+		encode_block(data.subspan(start - prefix, prefix + size),
+		             prefix,
+		             result,
+		             options.mode,
+		             options.acceleration);
+
+		// store blocks that didn't compress
+		uint32_t block_header{uint32_t(result.size() - size_pos - 4U)};
+		if (block_header >= size)
 		{
-			if (allow_partial_read)
-				match_length = writer.remaining().size();
-			else
-				return lak::err_t{lak::lz4_decode_error::output_full};
+			result.resize(size_pos + 4U);
+			append(result, data.subspan(start, size));
+			block_header = uint32_t(size) | uncompressed_block;
 		}
-		for (const auto &v : lak::span<const byte_t>(
-		       writer.remaining().begin() - offset, match_length))
-			writer.write_u8(uint8_t(v)).unwrap();
+		for (size_t i = 0U; i < 4U; ++i)
+			result[size_pos + i] = byte_t(block_header >> (i * 8U));
+
+		if (options.block_checksums)
+			write_u32(result,
+			          lak::xxhash32(
+			            lak::span<const byte_t>(result).subspan(size_pos + 4U)));
+	}
+
+	// end mark
+	write_u32(result, 0U);
+
+	if (options.content_checksum) write_u32(result, lak::xxhash32(data));
+
+	return result;
+}
 
-		if (allow_partial_read && writer.empty()) break;
+lak::result<lak::array<byte_t>, lak::lz4_decode_error> lak::decode_lz4_frame(
+  lak::binary_reader &strm)
+{
+	auto out_of_data = [](auto &&)
+	{ return lak::lz4_decode_error::out_of_data; };
+
+	uint32_t magic;
+	for (;;)
+	{
+		RES_TRY_ASSIGN(magic =, strm.read_u32().map_err(out_of_data));
+		if ((magic & 0xFFFF'FFF0U) != skippable_frame_magic) break;
+		RES_TRY_ASSIGN(const uint32_t size =,
+		               strm.read_u32().map_err(out_of_data));
+		RES_TRY(strm.skip(size).map_err(out_of_data));
 	}
+	if (magic != frame_magic)
+		return lak::err_t{lak::lz4_decode_error::invalid_magic};
 
-	if (!writer.empty()) WARNING("Expected More Output Data");
+	const lak::span<const byte_t> descriptor{strm.remaining()};
+	RES_TRY_ASSIGN(const uint8_t flags =, strm.read_u8().map_err(out_of_data));
+	RES_TRY_ASSIGN(const uint8_t block_descriptor =,
+	               strm.read_u8().map_err(out_of_data));
+
+	const bool independent_blocks{(flags & 0x20U) != 0U};
+	const bool block_checksums{(flags & 0x10U) != 0U};
+	const bool has_content_size{(flags & 0x08U) != 0U};
+	const bool content_checksum{(flags & 0x04U) != 0U};
+	const uint8_t block_size_id{uint8_t((block_descriptor >> 4U) & 0x7U)};
+
+	// version 1, no dictionary ID and no reserved bits
+	if ((flags & 0xC3U) != 0x40U || (block_descriptor & 0x8FU) != 0U ||
+	    block_size_id < uint8_t(lak::lz4_block_size::max_64KiB))
+		return lak::err_t{lak::lz4_decode_error::unsupported_frame};
+
+	uint64_t content_size = 0U;
+	if (has_content_size)
+	{
+		RES_TRY_ASSIGN(content_size =, strm.read_u64().map_err(out_of_data));
+	}
+
+	const size_t descriptor_size{size_t(strm.remaining().data() -
+	                                    descriptor.data())};
+	RES_TRY_ASSIGN(const uint8_t header_checksum =,
+	               strm.read_u8().map_err(out_of_data));
+	if (uint8_t(lak::xxhash32(descriptor.first(descriptor_size)) >> 8U) !=
+	    header_checksum)
+		return lak::err_t{lak::lz4_decode_error::header_checksum_mismatch};
+
+	const size_t block_size{size_t(1U) << (8U + (2U * block_size_id))};
+
+	lak::array<byte_t> output;
+	if (has_content_size)
+	{
+		// content_size is untrusted, don't reserve more than the rest of the
+		// frame could decode to. every byte of an lz4 block decodes to at most
+		// 255 bytes (a match length byte).
+		const uint64_t max_size{uint64_t(strm.remaining().size()) * 255U};
+		output.reserve(
+		  size_t(std::min({content_size, max_size, uint64_t(SIZE_MAX)})));
+	}
+
+	for (;;)
+	{
+		RES_TRY_ASSIGN(const uint32_t block_header =,
+		               strm.read_u32().map_err(out_of_data));
+		if (block_header == 0U) break; // end mark
+
+		const size_t size{block_header & ~uncompressed_block};
+		if (size > block_size)
+			return lak::err_t{lak::lz4_decode_error::block_too_large};
+		RES_TRY_ASSIGN(const lak::span<const byte_t> block =,
+		               strm.read_bytes(size).map_err(out_of_data));
+
+		if (block_checksums)
+		{
+			RES_TRY_ASSIGN(const uint32_t checksum =,
+			               strm.read_u32().map_err(out_of_data));
+			if (lak::xxhash32(block) != checksum)
+				return lak::err_t{lak::lz4_decode_error::block_checksum_mismatch};
+		}
+
+		if ((block_header & uncompressed_block) != 0U)
+		{
+			append(output, block);
+			continue;
+		}
+
+		RES_TRY(lak::decode_lz4_block(
+		  lak::binary_reader(block), &output, block_size, !independent_blocks));
+	}
+
+	if (has_content_size && output.size() != content_size)
+		return lak::err_t{lak::lz4_decode_error::content_size_mismatch};
+
+	if (content_checksum)
+	{
+		RES_TRY_ASSIGN(const uint32_t checksum =,
+		               strm.read_u32().map_err(out_of_data));
+		if (lak::xxhash32(output) != checksum)
+			return lak::err_t{lak::lz4_decode_error::content_checksum_mismatch};
+	}
 
 	return lak::move_ok(output);
 }
@@ -13,14 +13,24 @@
 #	include <unistd.h>
 #endif
 
+#if defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
 #include "lak/functional.hpp"
 
 #include "lak/debug.hpp"
+#include "lak/defer.hpp"
 #include "lak/file.hpp"
+#include "lak/memmanip.hpp"
 
 #include "lak/strconv.hpp"
 #include "lak/string_view.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -140,6 +150,194 @@ lak::errno_result<lak::array<byte_t>> lak::read_file(const lak::fs::path &path)
 	return lak::move_ok(result);
 }
 
+/* --- mapped_file --- */
+
+lak::error_code_result<lak::mapped_file> lak::mapped_file::open(
+  const fs::path &path, const lak::mapped_file_options &options)
+{
+	const bool writable{options.access ==
+	                    lak::mapped_file_access::read_write};
+	const bool read_only{options.access == lak::mapped_file_access::read_only};
+
+	lak::mapped_file result;
+	result._access = options.access;
+
+#if defined(LAK_OS_WINDOWS)
+	auto last_error{[]() -> std::error_code
+	                { return {int(::GetLastError()), std::system_category()}; }};
+
+	HANDLE file{::CreateFileW(path.c_str(),
+	                          writable ? GENERIC_READ | GENERIC_WRITE
+	                                   : GENERIC_READ,
+	                          FILE_SHARE_READ | FILE_SHARE_WRITE,
+	                          nullptr,
+	                          OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL,
+	                          nullptr)};
+	if (file == INVALID_HANDLE_VALUE) return lak::err_t{last_error()};
+	DEFER(::CloseHandle(file););
+
+	LARGE_INTEGER file_size;
+	if (!::GetFileSizeEx(file, &file_size)) return lak::err_t{last_error()};
+	if (file_size.QuadPart == 0) return lak::move_ok(result);
+
+	HANDLE mapping{::CreateFileMappingW(file,
+	                                    nullptr,
+	                                    writable    ? PAGE_READWRITE
+	                                    : read_only ? PAGE_READONLY
+	                                                : PAGE_WRITECOPY,
+	                                    0,
+	                                    0,
+	                                    nullptr)};
+	if (!mapping) return lak::err_t{last_error()};
+	// the view keeps the mapping alive
+	DEFER(::CloseHandle(mapping););
+
+	void *ptr{::MapViewOfFile(mapping,
+	                          writable    ? FILE_MAP_WRITE
+	                          : read_only ? FILE_MAP_READ
+	                                      : FILE_MAP_COPY,
+	                          0,
+	                          0,
+	                          0)};
+	if (!ptr) return lak::err_t{last_error()};
+
+	result._data =
+	  lak::span<byte_t>(static_cast<byte_t *>(ptr), size_t(file_size.QuadPart));
+
+	if (options.prefault)
+	{
+		WIN32_MEMORY_RANGE_ENTRY range{ptr, result._data.size()};
+		::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+	}
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	auto last_error{[]() -> std::error_code
+	                { return {errno, std::generic_category()}; }};
+
+	int file{::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC)};
+	if (file == -1) return lak::err_t{last_error()};
+	// the mapping keeps the file alive
+	DEFER(::close(file););
+
+	struct stat file_stat;
+	if (::fstat(file, &file_stat) == -1) return lak::err_t{last_error()};
+	if (file_stat.st_size == 0) return lak::move_ok(result);
+
+	int flags{writable ? MAP_SHARED : MAP_PRIVATE};
+#	ifdef MAP_POPULATE
+	if (options.prefault) flags |= MAP_POPULATE;
+#	endif
+
+	void *ptr{::mmap(nullptr,
+	                 size_t(file_stat.st_size),
+	                 read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+	                 flags,
+	                 file,
+	                 0)};
+	if (ptr == MAP_FAILED) return lak::err_t{last_error()};
+
+	result._data =
+	  lak::span<byte_t>(static_cast<byte_t *>(ptr), size_t(file_stat.st_size));
+
+#	ifndef MAP_POPULATE
+	if (options.prefault)
+		::madvise(ptr, result._data.size(), MADV_WILLNEED);
+#	endif
+#else
+	ASSERT_NYI();
+	return lak::err_t{std::make_error_code(std::errc::not_supported)};
+#endif
+
+	result.advise(options.advice);
+
+	return lak::move_ok(result);
+}
+
+lak::mapped_file::mapped_file(mapped_file &&other)
+: _data(lak::exchange(other._data, {})), _access(other._access)
+{
+}
+
+lak::mapped_file &lak::mapped_file::operator=(mapped_file &&other)
+{
+	lak::swap(_data, other._data);
+	lak::swap(_access, other._access);
+	return *this;
+}
+
+void lak::mapped_file::clear()
+{
+	if (_data.empty()) return;
+#if defined(LAK_OS_WINDOWS)
+	::UnmapViewOfFile(_data.data());
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	::munmap(_data.data(), _data.size());
+#endif
+	_data = {};
+}
+
+lak::span<byte_t> lak::mapped_file::mutable_data()
+{
+	ASSERT(_access != lak::mapped_file_access::read_only);
+	return _data;
+}
+
+// page aligned range covering [offset, offset + count) of data
+static lak::span<byte_t> page_range(lak::span<byte_t> data,
+                                    size_t offset,
+                                    size_t count)
+{
+	ASSERT_LESS_OR_EQUAL(offset, data.size());
+	count = std::min(count, data.size() - offset);
+	const size_t slack{offset % lak::page_size()};
+	return lak::span<byte_t>(data.data() + offset - slack, count + slack);
+}
+
+void lak::mapped_file::advise(lak::mapped_file_advice advice,
+                              size_t offset,
+                              size_t count)
+{
+	if (_data.empty()) return;
+#if defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	const lak::span<byte_t> range{page_range(_data, offset, count)};
+	switch (advice)
+	{
+		case lak::mapped_file_advice::normal:
+			::madvise(range.data(), range.size(), MADV_NORMAL);
+			break;
+		case lak::mapped_file_advice::sequential:
+			::madvise(range.data(), range.size(), MADV_SEQUENTIAL);
+			break;
+		case lak::mapped_file_advice::random:
+			::madvise(range.data(), range.size(), MADV_RANDOM);
+			break;
+	}
+#else
+	// windows has no access pattern hints for mapped views
+	(void)advice;
+	(void)offset;
+	(void)count;
+#endif
+}
+
+lak::error_code_result<> lak::mapped_file::flush(size_t offset, size_t count)
+{
+	if (_data.empty() || _access != lak::mapped_file_access::read_write)
+		return lak::ok_t{};
+
+	const lak::span<byte_t> range{page_range(_data, offset, count)};
+#if defined(LAK_OS_WINDOWS)
+	// only starts the write, windows needs the file handle to wait on it
+	if (!::FlushViewOfFile(range.data(), range.size()))
+		return lak::err_t{
+		  std::error_code{int(::GetLastError()), std::system_category()}};
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	if (::msync(range.data(), range.size(), MS_SYNC) == -1)
+		return lak::err_t{std::error_code{errno, std::generic_category()}};
+#endif
+	return lak::ok_t{};
+}
+
 bool lak::save_file(const lak::fs::path &path, lak::span<const byte_t> data)
 {
 	std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
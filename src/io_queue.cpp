@@ -0,0 +1,1007 @@
+#ifdef LAK_NO_FILESYSTEM
+#	error This file should not be compiled with filesystems disabled
+#endif
+
+#include "lak/os.hpp"
+
+#if defined(LAK_OS_WINDOWS)
+#	include "lak/windows.hpp"
+#endif
+
+#if defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#if defined(LAK_OS_LINUX) && __has_include(<linux/io_uring.h>)
+#	include <linux/io_uring.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <sys/uio.h>
+#	if defined(__NR_io_uring_setup)
+#		define LAK_HAS_IO_URING
+#	endif
+#endif
+
+#include "lak/io_queue.hpp"
+
+#include "lak/debug.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/* --- io_file --- */
+
+lak::error_code_result<lak::io_file> lak::io_file::open(
+  const fs::path &path, lak::io_file::mode mode)
+{
+#if defined(LAK_OS_WINDOWS)
+	DWORD access      = GENERIC_READ;
+	DWORD disposition = OPEN_EXISTING;
+	switch (mode)
+	{
+		case mode::read:
+			break;
+		case mode::write:
+			access      = GENERIC_WRITE;
+			disposition = CREATE_ALWAYS;
+			break;
+		case mode::read_write:
+			access      = GENERIC_READ | GENERIC_WRITE;
+			disposition = OPEN_ALWAYS;
+			break;
+	}
+
+	HANDLE file{::CreateFileW(path.c_str(),
+	                          access,
+	                          FILE_SHARE_READ | FILE_SHARE_WRITE,
+	                          nullptr,
+	                          disposition,
+	                          FILE_ATTRIBUTE_NORMAL,
+	                          nullptr)};
+	if (file == INVALID_HANDLE_VALUE)
+		return lak::err_t{
+		  std::error_code(int(::GetLastError()), std::system_category())};
+
+	return lak::ok_t{lak::io_file(intptr_t(file))};
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	int flags = O_RDONLY;
+	switch (mode)
+	{
+		case mode::read:
+			break;
+		case mode::write:
+			flags = O_WRONLY | O_CREAT | O_TRUNC;
+			break;
+		case mode::read_write:
+			flags = O_RDWR | O_CREAT;
+			break;
+	}
+
+	int file{::open(path.c_str(), flags | O_CLOEXEC, 0666)};
+	if (file == -1)
+		return lak::err_t{std::error_code(errno, std::generic_category())};
+
+	return lak::ok_t{lak::io_file(intptr_t(file))};
+#else
+	ASSERT_NYI();
+	return lak::err_t{std::make_error_code(std::errc::not_supported)};
+#endif
+}
+
+void lak::io_file::close()
+{
+	if (!is_open()) return;
+#if defined(LAK_OS_WINDOWS)
+	::CloseHandle(HANDLE(_handle));
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	::close(int(_handle));
+#endif
+	_handle = -1;
+}
+
+lak::error_code_result<uint64_t> lak::io_file::size() const
+{
+	ASSERT(is_open());
+#if defined(LAK_OS_WINDOWS)
+	LARGE_INTEGER file_size;
+	if (!::GetFileSizeEx(HANDLE(_handle), &file_size))
+		return lak::err_t{
+		  std::error_code(int(::GetLastError()), std::system_category())};
+	return lak::ok_t{uint64_t(file_size.QuadPart)};
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+	struct stat file_stat;
+	if (::fstat(int(_handle), &file_stat) == -1)
+		return lak::err_t{std::error_code(errno, std::generic_category())};
+	return lak::ok_t{uint64_t(file_stat.st_size)};
+#else
+	return lak::err_t{std::make_error_code(std::errc::not_supported)};
+#endif
+}
+
+/* --- blocking io --- */
+
+// runs op to completion on this thread
+static lak::io_result perform(lak::io_operation *op)
+{
+	if (op->kind == lak::io_kind::open)
+	{
+		ASSERT(op->path);
+		RES_TRY_ASSIGN(lak::io_file file =, lak::io_file::open(*op->path));
+		RES_TRY_ASSIGN(const uint64_t size =, file.size());
+		op->file = file.release();
+		return lak::ok_t{size_t(size)};
+	}
+
+	if (op->kind == lak::io_kind::readahead)
+	{
+#if defined(POSIX_FADV_WILLNEED)
+		if (int error{::posix_fadvise(int(op->file),
+		                              off_t(op->offset),
+		                              off_t(op->buffer.size()),
+		                              POSIX_FADV_WILLNEED)};
+		    error != 0)
+			return lak::err_t{std::error_code(error, std::generic_category())};
+#endif
+		return lak::ok_t{op->buffer.size()};
+	}
+
+	const bool reading{op->kind == lak::io_kind::read};
+
+	while (op->_transferred < op->buffer.size())
+	{
+		byte_t *data{op->buffer.data() + op->_transferred};
+		const size_t count{op->buffer.size() - op->_transferred};
+		const uint64_t offset{op->offset + op->_transferred};
+
+#if defined(LAK_OS_WINDOWS)
+		OVERLAPPED overlapped{};
+		overlapped.Offset     = DWORD(offset);
+		overlapped.OffsetHigh = DWORD(offset >> 32U);
+		const DWORD to_transfer{DWORD(std::min<size_t>(count, 0x80000000U))};
+		DWORD transferred{0U};
+		if (!(reading ? ::ReadFile(HANDLE(op->file),
+		                           data,
+		                           to_transfer,
+		                           &transferred,
+		                           &overlapped)
+		              : ::WriteFile(HANDLE(op->file),
+		                            data,
+		                            to_transfer,
+		                            &transferred,
+		                            &overlapped)))
+		{
+			const DWORD error{::GetLastError()};
+			if (error == ERROR_HANDLE_EOF) break;
+			return lak::err_t{std::error_code(int(error), std::system_category())};
+		}
+#elif defined(LAK_OS_LINUX) || defined(LAK_OS_APPLE)
+		const ssize_t transferred{
+		  reading ? ::pread(int(op->file), data, count, off_t(offset))
+		          : ::pwrite(int(op->file), data, count, off_t(offset))};
+		if (transferred == -1)
+		{
+			if (errno == EINTR) continue;
+			return lak::err_t{std::error_code(errno, std::generic_category())};
+		}
+#else
+		ASSERT_NYI();
+		size_t transferred{0U};
+		(void)data;
+		(void)count;
+		(void)offset;
+		(void)reading;
+#endif
+
+		if (transferred == 0) break;
+		op->_transferred += size_t(transferred);
+	}
+
+	return lak::ok_t{op->_transferred};
+}
+
+/* --- io_uring --- */
+
+#ifdef LAK_HAS_IO_URING
+static int io_uring_setup(unsigned entries, io_uring_params *params)
+{
+	return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring,
+                          unsigned to_submit,
+                          unsigned min_complete,
+                          unsigned flags)
+{
+	return int(::syscall(
+	  __NR_io_uring_enter, ring, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int io_uring_register(int ring,
+                             unsigned opcode,
+                             const void *arg,
+                             unsigned count)
+{
+	return int(::syscall(__NR_io_uring_register, ring, opcode, arg, count));
+}
+
+// the kernel caps a single read or write at this many bytes
+static constexpr size_t io_uring_max_transfer = 0x7FFFF000U;
+
+struct io_uring_state
+{
+	int fd = -1;
+
+	lak::span<byte_t> sq_ring;
+	lak::span<byte_t> cq_ring;
+	lak::span<byte_t> sqe_ring;
+
+	// written by the kernel
+	unsigned *sq_head = nullptr;
+	// written by us, under sq_mutex
+	unsigned *sq_tail  = nullptr;
+	unsigned *sq_array = nullptr;
+	unsigned sq_mask   = 0U;
+	unsigned sq_size   = 0U;
+	io_uring_sqe *sqes = nullptr;
+
+	// written by the reaper thread
+	unsigned *cq_head = nullptr;
+	// written by the kernel
+	unsigned *cq_tail  = nullptr;
+	unsigned cq_mask   = 0U;
+	io_uring_cqe *cqes = nullptr;
+
+	std::mutex sq_mutex;
+	// entries written to the submission ring but not yet handed to the kernel
+	unsigned unsubmitted    = 0U;
+	// operations submitted from completion callbacks (or partial transfers),
+	// only touched by the reaper thread. they're submitted between
+	// completions so the reaper never blocks on a full ring it has to drain
+	lak::array<lak::io_operation *> deferred;
+	// the reaper's last flush was refused with EBUSY
+	bool flush_pending = false;
+	bool buffers_registered = false;
+
+	std::thread reaper;
+
+	~io_uring_state();
+};
+
+io_uring_state::~io_uring_state()
+{
+	for (lak::span<byte_t> ring : {sq_ring, cq_ring, sqe_ring})
+		if (!ring.empty()) ::munmap(ring.data(), ring.size());
+	if (fd != -1) ::close(fd);
+}
+#endif
+
+/* --- io_queue_impl --- */
+
+struct lak::io_queue_impl
+{
+	lak::io_backend backend = lak::io_backend::thread_pool;
+	size_t depth;
+
+	std::mutex mutex;
+	std::condition_variable not_full;
+	std::condition_variable idle;
+	size_t in_flight = 0U;
+
+	lak::optional<lak::tasks> pool;
+
+#ifdef LAK_HAS_IO_URING
+	lak::unique_ptr<io_uring_state> ring;
+
+	bool ring_init(unsigned entries);
+
+	// write op (or the stop request if op is null) to the submission ring,
+	// requires sq_mutex
+	void ring_push(lak::io_operation *op);
+
+	// hand the unsubmitted entries to the kernel, requires sq_mutex. if the
+	// kernel is waiting for the completion ring to be drained (EBUSY) the
+	// reaper gets false back instead of retrying, it's the only thread that
+	// can drain it
+	bool ring_flush(bool reaping = false);
+
+	// submit as many deferred operations as the ring will take, returns
+	// false if any are still waiting to be handed to the kernel
+	bool ring_submit_deferred();
+
+	void ring_reap();
+#endif
+
+	io_queue_impl(const lak::io_queue_options &options);
+
+	~io_queue_impl();
+
+	// reserve slots for up to count operations, blocks until at least one is
+	// available. returns the number reserved.
+	size_t admit(size_t count);
+
+	void dispatch(lak::span<lak::io_operation *const> operations);
+
+	// call the completion callback of op and release its slot
+	void complete(lak::io_operation *op, lak::io_result result);
+
+	void wait_idle();
+};
+
+template struct lak::unique_ptr<lak::io_queue_impl>;
+
+// the queue whose completion callback the current thread is running
+static thread_local lak::io_queue_impl *completing = nullptr;
+
+lak::io_queue_impl::io_queue_impl(const lak::io_queue_options &options)
+: depth(options.queue_depth)
+{
+	ASSERT_GREATER(depth, 0U);
+
+#ifdef LAK_HAS_IO_URING
+	if (options.backend != lak::io_backend::thread_pool &&
+	    ring_init(unsigned(std::min<size_t>(depth, 4096U))))
+	{
+		backend = lak::io_backend::io_uring;
+		return;
+	}
+#endif
+
+	ASSERTF(options.backend != lak::io_backend::io_uring,
+	        "io_uring is not supported");
+
+	ASSERT_GREATER(options.threads, 0U);
+	backend = lak::io_backend::thread_pool;
+	pool    = lak::tasks(options.threads);
+}
+
+lak::io_queue_impl::~io_queue_impl()
+{
+	wait_idle();
+
+#ifdef LAK_HAS_IO_URING
+	if (ring)
+	{
+		{
+			std::lock_guard lock(ring->sq_mutex);
+			ring_push(nullptr);
+			ring_flush();
+		}
+		ring->reaper.join();
+	}
+#endif
+}
+
+size_t lak::io_queue_impl::admit(size_t count)
+{
+	std::unique_lock lock(mutex);
+	if (completing != this)
+	{
+		not_full.wait(lock, [&] { return in_flight < depth; });
+		count = std::min(count, depth - in_flight);
+	}
+	in_flight += count;
+	return count;
+}
+
+void lak::io_queue_impl::dispatch(
+  lak::span<lak::io_operation *const> operations)
+{
+	for (lak::io_operation *op : operations) op->_transferred = 0U;
+
+#ifdef LAK_HAS_IO_URING
+	if (ring)
+	{
+		if (completing == this)
+		{
+			// on the reaper thread, it submits these between completions
+			for (lak::io_operation *op : operations) ring->deferred.push_back(op);
+			return;
+		}
+		std::lock_guard lock(ring->sq_mutex);
+		for (lak::io_operation *op : operations) ring_push(op);
+		ring_flush();
+		return;
+	}
+#endif
+
+	for (lak::io_operation *op : operations)
+		pool->push([this, op] { complete(op, perform(op)); });
+}
+
+void lak::io_queue_impl::complete(lak::io_operation *op,
+                                  lak::io_result result)
+{
+	lak::io_queue_impl *previous{lak::exchange(completing, this)};
+	op->_complete(op, lak::move(result));
+	completing = previous;
+
+	std::lock_guard lock(mutex);
+	--in_flight;
+	not_full.notify_one();
+	if (in_flight == 0U) idle.notify_all();
+}
+
+void lak::io_queue_impl::wait_idle()
+{
+	ASSERTF(completing != this,
+	        "wait_idle would deadlock in a completion callback");
+	std::unique_lock lock(mutex);
+	idle.wait(lock, [&] { return in_flight == 0U; });
+}
+
+#ifdef LAK_HAS_IO_URING
+bool lak::io_queue_impl::ring_init(unsigned entries)
+{
+	io_uring_params params{};
+	// completions are queued in the kernel rather than dropped if the
+	// completion ring overflows, callbacks may exceed the queue depth
+	params.flags      = IORING_SETUP_CQSIZE;
+	params.cq_entries = entries * 4U;
+
+	const int fd{io_uring_setup(entries, &params)};
+	if (fd < 0) return false;
+
+	auto state{lak::unique_ptr<io_uring_state>::make()};
+	state->fd = fd;
+
+	if (!(params.features & IORING_FEAT_NODROP)) return false;
+
+	alignas(io_uring_probe) byte_t
+	  probe_data[sizeof(io_uring_probe) + 256U * sizeof(io_uring_probe_op)]{};
+	io_uring_probe *probe{reinterpret_cast<io_uring_probe *>(probe_data)};
+	if (io_uring_register(fd, IORING_REGISTER_PROBE, probe, 256U) < 0)
+		return false;
+	for (unsigned opcode : {IORING_OP_NOP,
+	                        IORING_OP_READ,
+	                        IORING_OP_WRITE,
+	                        IORING_OP_READ_FIXED,
+	                        IORING_OP_WRITE_FIXED,
+	                        IORING_OP_FADVISE,
+	                        IORING_OP_OPENAT})
+		if (opcode > probe->last_op ||
+		    !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+			return false;
+
+	auto map{[&](size_t size, off_t offset) -> lak::span<byte_t>
+	         {
+		         void *ptr{::mmap(nullptr,
+		                          size,
+		                          PROT_READ | PROT_WRITE,
+		                          MAP_SHARED | MAP_POPULATE,
+		                          fd,
+		                          offset)};
+		         if (ptr == MAP_FAILED) return {};
+		         return lak::span<byte_t>(static_cast<byte_t *>(ptr), size);
+	         }};
+
+	state->sq_ring = map(params.sq_off.array + params.sq_entries * 4U,
+	                     IORING_OFF_SQ_RING);
+	state->cq_ring =
+	  map(params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe),
+	      IORING_OFF_CQ_RING);
+	state->sqe_ring =
+	  map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES);
+	if (state->sq_ring.empty() || state->cq_ring.empty() ||
+	    state->sqe_ring.empty())
+		return false;
+
+	byte_t *sq{state->sq_ring.data()};
+	state->sq_head  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+	state->sq_tail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	state->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+	state->sq_mask =
+	  *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	state->sq_size = params.sq_entries;
+	state->sqes = reinterpret_cast<io_uring_sqe *>(state->sqe_ring.data());
+
+	byte_t *cq{state->cq_ring.data()};
+	state->cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	state->cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	state->cq_mask =
+	  *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	state->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+	ring          = lak::move(state);
+	ring->reaper  = std::thread([this] { ring_reap(); });
+	return true;
+}
+
+void lak::io_queue_impl::ring_push(lak::io_operation *op)
+{
+	const unsigned tail{*ring->sq_tail};
+	while (tail - std::atomic_ref(*ring->sq_head).load(
+	                std::memory_order_acquire) == ring->sq_size)
+		ring_flush();
+
+	const unsigned index{tail & ring->sq_mask};
+	io_uring_sqe &sqe{ring->sqes[index]};
+	sqe = {};
+
+	if (!op)
+	{
+		sqe.opcode = IORING_OP_NOP;
+	}
+	else if (op->kind == lak::io_kind::readahead)
+	{
+		sqe.opcode         = IORING_OP_FADVISE;
+		sqe.fd             = int(op->file);
+		sqe.off            = op->offset;
+		sqe.len = unsigned(std::min<size_t>(op->buffer.size(), UINT32_MAX));
+		sqe.fadvise_advice = POSIX_FADV_WILLNEED;
+		sqe.user_data      = uint64_t(uintptr_t(op));
+	}
+	else if (op->kind == lak::io_kind::open)
+	{
+		ASSERT(op->path);
+		sqe.opcode     = IORING_OP_OPENAT;
+		sqe.fd         = AT_FDCWD;
+		sqe.addr       = uint64_t(uintptr_t(op->path->c_str()));
+		sqe.open_flags = O_RDONLY | O_CLOEXEC;
+		sqe.user_data  = uint64_t(uintptr_t(op));
+	}
+	else
+	{
+		const bool fixed{op->buffer_index >= 0};
+		if (op->kind == lak::io_kind::read)
+			sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+		else
+			sqe.opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+		if (fixed) sqe.buf_index = uint16_t(op->buffer_index);
+		sqe.fd   = int(op->file);
+		sqe.off  = op->offset + op->_transferred;
+		sqe.addr = uint64_t(uintptr_t(op->buffer.data() + op->_transferred));
+		sqe.len  = unsigned(
+		  std::min(op->buffer.size() - op->_transferred, io_uring_max_transfer));
+		sqe.user_data = uint64_t(uintptr_t(op));
+	}
+
+	ring->sq_array[index] = index;
+	std::atomic_ref(*ring->sq_tail).store(tail + 1U, std::memory_order_release);
+	++ring->unsubmitted;
+}
+
+bool lak::io_queue_impl::ring_flush(bool reaping)
+{
+	while (ring->unsubmitted > 0U)
+	{
+		const int submitted{io_uring_enter(ring->fd, ring->unsubmitted, 0U, 0U)};
+		if (submitted >= 0)
+			ring->unsubmitted -= unsigned(submitted);
+		else if (errno == EBUSY && reaping)
+			return false;
+		else if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+			std::this_thread::yield();
+		else
+			FATAL("io_uring_enter failed with error ", errno);
+	}
+	return true;
+}
+
+bool lak::io_queue_impl::ring_submit_deferred()
+{
+	if (ring->deferred.empty() && !ring->flush_pending) return true;
+
+	// another thread may be holding the lock while it waits for us to drain
+	// the completion ring
+	std::unique_lock lock(ring->sq_mutex, std::try_to_lock);
+	if (!lock) return false;
+
+	size_t pushed{0U};
+	for (; pushed < ring->deferred.size(); ++pushed)
+	{
+		const bool full{
+		  *ring->sq_tail -
+		    std::atomic_ref(*ring->sq_head).load(std::memory_order_acquire) ==
+		  ring->sq_size};
+		if (full && !ring_flush(true)) break;
+		ring_push(ring->deferred[pushed]);
+	}
+	ring->deferred.erase(ring->deferred.begin(),
+	                     ring->deferred.begin() + pushed);
+
+	ring->flush_pending = !ring_flush(true);
+	return !ring->flush_pending && ring->deferred.empty();
+}
+
+void lak::io_queue_impl::ring_reap()
+{
+	for (;;)
+	{
+		const unsigned head{*ring->cq_head};
+		if (head ==
+		    std::atomic_ref(*ring->cq_tail).load(std::memory_order_acquire))
+		{
+			// only block if nothing is waiting on us to be submitted, otherwise
+			// just move any overflowed completions into the ring
+			const unsigned min_complete{ring_submit_deferred() ? 1U : 0U};
+			if (io_uring_enter(
+			      ring->fd, 0U, min_complete, IORING_ENTER_GETEVENTS) < 0 &&
+			    errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				FATAL("io_uring_enter failed with error ", errno);
+			continue;
+		}
+
+		const io_uring_cqe cqe{ring->cqes[head & ring->cq_mask]};
+		std::atomic_ref(*ring->cq_head).store(head + 1U,
+		                                      std::memory_order_release);
+
+		// the stop request
+		if (cqe.user_data == 0U) break;
+
+		lak::io_operation *op{
+		  reinterpret_cast<lak::io_operation *>(uintptr_t(cqe.user_data))};
+
+		if (cqe.res < 0)
+		{
+			complete(op,
+			         lak::err_t{std::error_code(-cqe.res, std::generic_category())});
+		}
+		else if (op->kind == lak::io_kind::readahead)
+		{
+			complete(op, lak::ok_t{op->buffer.size()});
+		}
+		else if (op->kind == lak::io_kind::open)
+		{
+			// the open already brought the inode into memory, so sizing the
+			// file here doesn't wait on the disk
+			lak::io_file file{lak::io_file::adopt(intptr_t(cqe.res))};
+			auto size{file.size()};
+			if (size.is_ok()) op->file = file.release();
+			complete(op,
+			         lak::move(size).map([](uint64_t s) { return size_t(s); }));
+		}
+		else
+		{
+			op->_transferred += size_t(cqe.res);
+			if (cqe.res == 0 || op->_transferred == op->buffer.size())
+			{
+				complete(op, lak::ok_t{op->_transferred});
+			}
+			else
+			{
+				// partial transfer, queue the rest
+				ring->deferred.push_back(op);
+			}
+		}
+
+		ring_submit_deferred();
+	}
+}
+#endif
+
+/* --- io_queue --- */
+
+lak::io_queue::io_queue(const lak::io_queue_options &options)
+: _impl(lak::unique_ptr<lak::io_queue_impl>::make(options))
+{
+}
+
+lak::io_queue::io_queue(io_queue &&other) : _impl(lak::move(other._impl)) {}
+
+lak::io_queue &lak::io_queue::operator=(io_queue &&other)
+{
+	_impl = lak::move(other._impl);
+	return *this;
+}
+
+lak::io_queue::~io_queue() {}
+
+lak::io_backend lak::io_queue::backend() const
+{
+	ASSERT(_impl);
+	return _impl->backend;
+}
+
+size_t lak::io_queue::queue_depth() const
+{
+	ASSERT(_impl);
+	return _impl->depth;
+}
+
+void lak::io_queue::submit(lak::span<lak::io_operation *const> operations)
+{
+	ASSERT(_impl);
+	while (!operations.empty())
+	{
+		const size_t count{_impl->admit(operations.size())};
+		_impl->dispatch(operations.first(count));
+		operations = operations.subspan(count);
+	}
+}
+
+void lak::io_queue::submit(lak::io_operation &operation)
+{
+	lak::io_operation *op{&operation};
+	submit(lak::span<lak::io_operation *const>(&op, 1U));
+}
+
+lak::io_awaitable lak::io_queue::async_read(const lak::io_file &file,
+                                            uint64_t offset,
+                                            lak::span<byte_t> buffer)
+{
+	lak::io_awaitable result;
+	result.kind      = lak::io_kind::read;
+	result.file      = file.native_handle();
+	result.offset    = offset;
+	result.buffer    = buffer;
+	result._complete = &lak::io_awaitable::complete;
+	result._queue    = this;
+	return result;
+}
+
+lak::io_awaitable lak::io_queue::async_write(const lak::io_file &file,
+                                             uint64_t offset,
+                                             lak::span<const byte_t> buffer)
+{
+	lak::io_awaitable result;
+	result.kind   = lak::io_kind::write;
+	result.file   = file.native_handle();
+	result.offset = offset;
+	// writes only read from the buffer
+	result.buffer =
+	  lak::span<byte_t>(const_cast<byte_t *>(buffer.data()), buffer.size());
+	result._complete = &lak::io_awaitable::complete;
+	result._queue    = this;
+	return result;
+}
+
+void lak::io_queue::readahead(const lak::io_file &file,
+                              uint64_t offset,
+                              size_t size)
+{
+	auto *op{lak::io_callback<void (*)(lak::io_result)>::make(
+	  [](lak::io_result) {})};
+	op->kind   = lak::io_kind::readahead;
+	op->file   = file.native_handle();
+	op->offset = offset;
+	op->buffer = lak::span<byte_t>(static_cast<byte_t *>(nullptr), size);
+	submit(*op);
+}
+
+lak::error_code_result<> lak::io_queue::register_buffers(
+  lak::span<const lak::span<byte_t>> buffers)
+{
+	ASSERT(_impl);
+#ifdef LAK_HAS_IO_URING
+	if (_impl->ring)
+	{
+		unregister_buffers();
+		if (buffers.empty()) return lak::ok_t{};
+
+		lak::array<iovec> iovecs;
+		iovecs.reserve(buffers.size());
+		for (const lak::span<byte_t> &buffer : buffers)
+			iovecs.push_back(iovec{buffer.data(), buffer.size()});
+
+		if (io_uring_register(_impl->ring->fd,
+		                      IORING_REGISTER_BUFFERS,
+		                      iovecs.data(),
+		                      unsigned(iovecs.size())) < 0)
+			return lak::err_t{std::error_code(errno, std::generic_category())};
+
+		_impl->ring->buffers_registered = true;
+	}
+#else
+	(void)buffers;
+#endif
+	return lak::ok_t{};
+}
+
+void lak::io_queue::unregister_buffers()
+{
+	ASSERT(_impl);
+#ifdef LAK_HAS_IO_URING
+	if (_impl->ring && _impl->ring->buffers_registered)
+	{
+		io_uring_register(
+		  _impl->ring->fd, IORING_UNREGISTER_BUFFERS, nullptr, 0U);
+		_impl->ring->buffers_registered = false;
+	}
+#endif
+}
+
+void lak::io_queue::wait_idle()
+{
+	ASSERT(_impl);
+	_impl->wait_idle();
+}
+
+/* --- io_awaitable --- */
+
+void lak::io_awaitable::await_suspend(std::coroutine_handle<> handle)
+{
+	_handle = handle;
+	// this may be resumed before submit returns
+	_queue->submit(*this);
+}
+
+void lak::io_awaitable::complete(lak::io_operation *op,
+                                 lak::io_result result)
+{
+	lak::io_awaitable *awaitable{static_cast<lak::io_awaitable *>(op)};
+	awaitable->_result = lak::move(result);
+	awaitable->_handle.resume();
+}
+
+/* --- load_files --- */
+
+namespace
+{
+	struct load_state
+	{
+		lak::io_queue *queue;
+		lak::_load_files_callback callback;
+		void *context;
+		bool readahead;
+
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t pending = 0U;
+	};
+
+	// opens path, then reads the whole file, with a readahead hint alongside
+	// the read if load_state::readahead is set
+	struct load_operation : public lak::io_operation
+	{
+		load_state *state;
+		size_t index;
+		lak::fs::path file_path;
+		lak::io_file handle;
+		lak::array<byte_t> data;
+
+		struct hint : public lak::io_operation
+		{
+			load_operation *load;
+		} ahead;
+		// the read and the readahead hint, whichever completes last releases
+		// the file
+		std::atomic_uint8_t parts = 1U;
+
+		static void opened(lak::io_operation *op, lak::io_result result);
+		static void read(lak::io_operation *op, lak::io_result result);
+		static void hinted(lak::io_operation *op, lak::io_result result);
+
+		void finish(lak::error_code_result<lak::array<byte_t>> result);
+		void release();
+	};
+
+	void load_operation::opened(lak::io_operation *op, lak::io_result result)
+	{
+		load_operation *load{static_cast<load_operation *>(op)};
+
+		if (result.is_err())
+		{
+			load->finish(lak::err_t{result.unsafe_unwrap_err()});
+			load->release();
+			return;
+		}
+
+		load->handle = lak::io_file::adopt(load->file);
+		const size_t size{result.unsafe_unwrap()};
+
+		if (size == 0U)
+		{
+			load->finish(lak::ok_t{lak::array<byte_t>{}});
+			load->release();
+			return;
+		}
+
+		load->data.resize(size);
+		load->kind      = lak::io_kind::read;
+		load->offset    = 0U;
+		load->buffer    = lak::span<byte_t>(load->data);
+		load->_complete = &load_operation::read;
+
+		if (!load->state->readahead)
+		{
+			load->state->queue->submit(*load);
+			return;
+		}
+
+		load->parts       = 2U;
+		load->ahead.kind  = lak::io_kind::readahead;
+		load->ahead.file  = load->file;
+		load->ahead.load  = load;
+		load->ahead.buffer =
+		  lak::span<byte_t>(static_cast<byte_t *>(nullptr), size);
+		load->ahead._complete = &load_operation::hinted;
+
+		lak::io_operation *ops[]{&load->ahead, load};
+		load->state->queue->submit(lak::span<lak::io_operation *const>(ops));
+	}
+
+	void load_operation::read(lak::io_operation *op, lak::io_result result)
+	{
+		load_operation *load{static_cast<load_operation *>(op)};
+
+		load->finish(lak::move(result).map(
+		  [&](size_t size)
+		  {
+			  // the file shrunk since it was opened
+			  load->data.resize(size);
+			  return lak::move(load->data);
+		  }));
+
+		if (--load->parts == 0U) load->release();
+	}
+
+	void load_operation::hinted(lak::io_operation *op, lak::io_result)
+	{
+		// the hint failing doesn't affect the read
+		load_operation *load{static_cast<hint *>(op)->load};
+		if (--load->parts == 0U) load->release();
+	}
+
+	void load_operation::finish(
+	  lak::error_code_result<lak::array<byte_t>> result)
+	{
+		state->callback(state->context, index, file_path, lak::move(result));
+	}
+
+	void load_operation::release()
+	{
+		load_state &state{*this->state};
+
+		delete this;
+
+		std::lock_guard lock(state.mutex);
+		if (--state.pending == 0U) state.done.notify_all();
+	}
+}
+
+void lak::_load_files(lak::io_queue &queue,
+                      lak::_load_files_next next,
+                      lak::_load_files_callback callback,
+                      void *context,
+                      bool readahead)
+{
+	// operations are handed to the queue in batches to amortise the cost of
+	// entering the kernel
+	static constexpr size_t batch_size = 64U;
+
+	load_state state;
+	state.queue     = &queue;
+	state.callback  = callback;
+	state.context   = context;
+	state.readahead = readahead;
+
+	lak::array<lak::io_operation *> batch;
+	batch.reserve(batch_size);
+
+	auto flush{[&]
+	           {
+		           queue.submit(lak::span<lak::io_operation *const>(batch));
+		           batch.clear();
+	           }};
+
+	fs::path path;
+	for (size_t index = 0U; next(context, path); ++index)
+	{
+		// the read is queued by load_operation::opened once the file has been
+		// opened and sized
+		load_operation *op{new load_operation{}};
+		op->state     = &state;
+		op->index     = index;
+		op->file_path = path;
+		op->kind      = lak::io_kind::open;
+		op->path      = &op->file_path;
+		op->_complete = &load_operation::opened;
+
+		{
+			std::lock_guard lock(state.mutex);
+			++state.pending;
+		}
+
+		batch.push_back(op);
+		if (batch.size() == batch_size) flush();
+	}
+
+	if (!batch.empty()) flush();
+
+	std::unique_lock lock(state.mutex);
+	state.done.wait(lock, [&] { return state.pending == 0U; });
+}
@@ -1,38 +1,135 @@
 #include "lak/memmanip.hpp"
+#include "lak/alloc_stats.hpp"
 #include "lak/compiler.hpp"
+#include "lak/math.hpp"
 #include "lak/os.hpp"
 #include "lak/span.hpp"
 
 #include "wrapper.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cstdio>
+
 size_t lak::page_size()
 {
 	const static long page_size = sysconf(_SC_PAGESIZE);
 	return page_size;
 }
 
+size_t lak::huge_page_size()
+{
+#if defined(LAK_OS_LINUX) && defined(MADV_HUGEPAGE)
+	const static size_t huge_page_size = []() -> size_t
+	{
+		// transparent huge pages are PMD sized
+		size_t result = 0U;
+		if (FILE *file = std::fopen(
+		      "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r"))
+		{
+			if (std::fscanf(file, "%zu", &result) != 1) result = 0U;
+			std::fclose(file);
+		}
+		return result;
+	}();
+	return huge_page_size;
+#else
+	return 0U;
+#endif
+}
+
 lak::page_result_t<lak::span<void>> lak::page_reserve(size_t size,
                                                       size_t *page_size_out)
+{
+	return lak::page_reserve(size, lak::page_options{}, page_size_out);
+}
+
+lak::page_result_t<lak::span<void>> lak::page_reserve(
+  size_t size, const lak::page_options &options, size_t *page_size_out)
 {
 	ASSERT_GREATER(size, 0U);
 
-	size = lak::round_to_page_multiple(size, page_size_out);
+	size_t page_size = 0U;
+	size             = lak::round_to_page_multiple(size, &page_size);
 
-	auto ptr_to_span = [size](void *ptr) { return lak::span<void>(ptr, size); };
-#ifdef LAK_OS_APPLE
-	return lak::posix::mmap(
-	         nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0)
+	int flags        = MAP_PRIVATE | MAP_ANON;
+	size_t alignment = page_size;
+
+	if (options.explicit_page_size != 0U)
+	{
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+		ASSERT(std::has_single_bit(options.explicit_page_size));
+		page_size = options.explicit_page_size;
+		size      = lak::to_multiple(size, page_size);
+		alignment = page_size;
+		flags |= MAP_HUGETLB | (std::countr_zero(page_size) << MAP_HUGE_SHIFT);
 #else
-	return lak::posix::open("/dev/zero", O_RDWR)
-	  .and_then(
-	    [size](int fd)
-	    {
-		    return lak::posix::mmap(
-		      nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_FILE, fd, 0);
-	    })
+		return lak::err_t{lak::page_error{}};
 #endif
-	  .map_err([](auto &&) -> lak::page_error { return {}; })
-	  .map(ptr_to_span);
+	}
+	else if (options.transparent_huge_pages)
+	{
+		alignment = std::max(lak::huge_page_size(), page_size);
+	}
+
+	// over reserve so that an aligned span can be cut out of the mapping,
+	// hugetlb mappings are always aligned
+	const size_t mapped_size = options.explicit_page_size == 0U
+	                             ? size + (alignment - page_size)
+	                             : size;
+
+	auto mapped =
+	  lak::posix::mmap(nullptr, mapped_size, PROT_NONE, flags, -1, 0);
+	if (mapped.is_err()) return lak::err_t{lak::page_error{}};
+
+	byte_t *base  = static_cast<byte_t *>(mapped.unsafe_unwrap());
+	byte_t *begin = lak::align_ptr(base, alignment);
+	byte_t *end   = begin + size;
+	if (begin != base) (void)lak::posix::munmap(base, begin - base);
+	if (end != base + mapped_size)
+		(void)lak::posix::munmap(end, (base + mapped_size) - end);
+
+#ifdef MADV_HUGEPAGE
+	// only a hint, the kernel may have transparent huge pages disabled
+	if (options.transparent_huge_pages && options.explicit_page_size == 0U)
+		(void)lak::posix::madvise(begin, size, MADV_HUGEPAGE);
+#endif
+
+#ifdef LAK_OS_LINUX
+	if (options.numa_node >= 0)
+	{
+		// MPOL_BIND from <linux/mempolicy.h>
+		static constexpr int mpol_bind     = 2;
+		static constexpr size_t node_count = 1024U;
+		static constexpr size_t word_bits  = CHAR_BIT * sizeof(unsigned long);
+
+		unsigned long node_mask[node_count / word_bits] = {};
+		const size_t node                               = options.numa_node;
+		if (node >= node_count)
+		{
+			(void)lak::posix::munmap(begin, size);
+			return lak::err_t{lak::page_error{}};
+		}
+		node_mask[node / word_bits] |= 1UL << (node % word_bits);
+
+		// the kernel ignores the last bit of max_node
+		if (lak::posix::mbind(
+		      begin, size, mpol_bind, node_mask, node_count + 1U, 0U)
+		      .is_err())
+		{
+			(void)lak::posix::munmap(begin, size);
+			return lak::err_t{lak::page_error{}};
+		}
+	}
+#endif
+
+	if (page_size_out) *page_size_out = page_size;
+
+	lak::span<void> pages(static_cast<void *>(begin), size);
+	if (lak::alloc_stats_enabled()) lak::_alloc_stats_reserved(pages);
+	return lak::ok_t{pages};
 }
 
 lak::page_result_t<> lak::page_decommit(lak::span<void> pages)
@@ -49,7 +146,12 @@ lak::page_result_t<> lak::page_decommit(lak::span<void> pages)
 #endif
 	    })
 	  .map_err([](auto &&) -> lak::page_error { return {}; })
-	  .map([](auto &&) -> lak::monostate { return {}; });
+	  .map([](auto &&) -> lak::monostate { return {}; })
+	  .if_ok(
+	    [&](auto &&)
+	    {
+		    if (lak::alloc_stats_enabled()) lak::_alloc_stats_decommitted(pages);
+	    });
 }
 
 lak::page_result_t<> lak::page_commit(lak::span<void> pages)
@@ -57,10 +159,84 @@ lak::page_result_t<> lak::page_commit(lak::span<void> pages)
 	return lak::posix::mprotect(
 	         pages.data(), pages.size(), PROT_READ | PROT_WRITE)
 	  .map_err([](auto &&) -> lak::page_error { return {}; })
-	  .map([](auto &&) -> lak::monostate { return {}; });
+	  .map([](auto &&) -> lak::monostate { return {}; })
+	  .if_ok(
+	    [&](auto &&)
+	    {
+		    if (lak::alloc_stats_enabled()) lak::_alloc_stats_committed(pages);
+	    });
 }
 
 lak::page_result_t<> lak::page_free(lak::span<void> pages)
+{
+	return lak::posix::munmap(pages.data(), pages.size())
+	  .map_err([](auto &&) -> lak::page_error { return {}; })
+	  .map([](auto &&) -> lak::monostate { return {}; })
+	  .if_ok(
+	    [&](auto &&)
+	    {
+		    if (lak::alloc_stats_enabled()) lak::_alloc_stats_released(pages);
+	    });
+}
+
+size_t lak::shared_memory_granularity()
+{
+	return lak::page_size();
+}
+
+lak::page_result_t<lak::shared_memory_handle> lak::shared_memory_create(
+  size_t size)
+{
+#ifdef LAK_OS_LINUX
+	auto fd = lak::posix::memfd_create("lak::shared_memory", MFD_CLOEXEC);
+#else
+	// unlinked straight away, the name only has to be unique for a moment
+	static std::atomic_uint32_t counter = 0U;
+	char name[64];
+	std::snprintf(name,
+	              sizeof(name),
+	              "/lak.%ld.%u",
+	              long(::getpid()),
+	              unsigned(counter.fetch_add(1U, std::memory_order_relaxed)));
+	auto fd = lak::posix::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd.is_ok()) ::shm_unlink(name);
+#endif
+	if (fd.is_err()) return lak::err_t{lak::page_error{}};
+
+	const int handle = fd.unsafe_unwrap();
+	if (lak::posix::ftruncate(handle, off_t(size)).is_err())
+	{
+		(void)lak::posix::close(handle);
+		return lak::err_t{lak::page_error{}};
+	}
+
+	return lak::ok_t{lak::shared_memory_handle(handle)};
+}
+
+void lak::shared_memory_close(lak::shared_memory_handle handle)
+{
+	(void)lak::posix::close(int(handle));
+}
+
+lak::page_result_t<lak::span<void>> lak::shared_memory_map(
+  lak::shared_memory_handle handle,
+  size_t offset,
+  size_t size,
+  bool copy_on_write)
+{
+	ASSERT_EQUAL(offset % lak::shared_memory_granularity(), 0U);
+
+	return lak::posix::mmap(nullptr,
+	                        size,
+	                        PROT_READ | PROT_WRITE,
+	                        copy_on_write ? MAP_PRIVATE : MAP_SHARED,
+	                        int(handle),
+	                        off_t(offset))
+	  .map_err([](auto &&) -> lak::page_error { return {}; })
+	  .map([size](void *ptr) { return lak::span<void>(ptr, size); });
+}
+
+lak::page_result_t<> lak::shared_memory_unmap(lak::span<void> pages)
 {
 	return lak::posix::munmap(pages.data(), pages.size())
 	  .map_err([](auto &&) -> lak::page_error { return {}; })
@@ -11,6 +11,9 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#ifdef LAK_OS_LINUX
+#	include <sys/syscall.h>
+#endif
 
 namespace lak
 {
@@ -29,6 +32,22 @@ namespace lak
 				return lak::err_t{lak::errno_error::last_error()};
 		}
 
+		lak::posix::result<int> close(int file_descriptor)
+		{
+			if (int result = ::close(file_descriptor); result != -1)
+				return lak::ok_t{result};
+			else
+				return lak::err_t{lak::errno_error::last_error()};
+		}
+
+		lak::posix::result<int> ftruncate(int file_descriptor, off_t length)
+		{
+			if (int result = ::ftruncate(file_descriptor, length); result != -1)
+				return lak::ok_t{result};
+			else
+				return lak::err_t{lak::errno_error::last_error()};
+		}
+
 		lak::posix::result<void *> mmap(void *address,
 		                                size_t length,
 		                                int protect,
@@ -67,6 +86,42 @@ namespace lak
 			else
 				return lak::err_t{lak::errno_error::last_error()};
 		}
+
+#ifdef LAK_OS_LINUX
+		lak::posix::result<int> memfd_create(const char *name, unsigned flags)
+		{
+			if (int result = ::memfd_create(name, flags); result != -1)
+				return lak::ok_t{result};
+			else
+				return lak::err_t{lak::errno_error::last_error()};
+		}
+#else
+		lak::posix::result<int> shm_open(const char *name, int oflag, mode_t mode)
+		{
+			if (int result = ::shm_open(name, oflag, mode); result != -1)
+				return lak::ok_t{result};
+			else
+				return lak::err_t{lak::errno_error::last_error()};
+		}
+#endif
+
+#ifdef LAK_OS_LINUX
+		// called through syscall to avoid depending on libnuma
+		lak::posix::result<long> mbind(void *address,
+		                               size_t length,
+		                               int mode,
+		                               const unsigned long *node_mask,
+		                               unsigned long max_node,
+		                               unsigned flags)
+		{
+			if (long result = ::syscall(
+			      SYS_mbind, address, length, mode, node_mask, max_node, flags);
+			    result != -1)
+				return lak::ok_t{result};
+			else
+				return lak::err_t{lak::errno_error::last_error()};
+		}
+#endif
 	}
 }
 
@@ -1,58 +1,331 @@
 #include "lak/tasks.hpp"
 
-#include "lak/span_manip.hpp"
+#include "lak/array.hpp"
+#include "lak/debug.hpp"
 
-std::mutex &lak::tasks::await_not_full()
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+struct lak::tasks_impl
+{
+	struct alignas(64) worker
+	{
+		std::mutex mutex;
+		// the owning worker pushes and pops from the back, thieves take from the
+		// front.
+		std::deque<lak::task_job *> jobs;
+		std::thread thread;
+	};
+
+	lak::array<lak::unique_ptr<worker>> workers;
+	size_t max_pending;
+
+	// jobs that have been pushed but have not finished running
+	std::atomic_size_t active = 0U;
+	// jobs that are sitting in a deque waiting to be taken
+	std::atomic_size_t queued      = 0U;
+	std::atomic_size_t next_worker = 0U;
+
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	std::atomic_size_t sleeping = 0U;
+	bool stopping               = false;
+
+	// producers waiting for a free slot, or for the pool to drain
+	std::mutex admit_mutex;
+	std::condition_variable not_full;
+	std::condition_variable drained;
+	std::atomic_size_t admit_waiting = 0U;
+
+	tasks_impl(size_t threads, size_t max_pending);
+
+	~tasks_impl();
+
+	bool try_admit();
+
+	bool spin_admit();
+
+	void admit();
+
+	bool admit_until(std::chrono::steady_clock::time_point deadline);
+
+	void submit(lak::task_job *job);
+
+	void finish();
+
+	void run(lak::task_job *job);
+
+	lak::task_job *take(size_t index);
+
+	void work(size_t index);
+};
+
+template struct lak::unique_ptr<lak::tasks_impl>;
+
+// the pool and worker index of the current thread, if it is a worker
+static thread_local lak::tasks_impl *current_pool = nullptr;
+static thread_local size_t current_worker         = 0U;
+
+lak::tasks_impl::tasks_impl(size_t threads, size_t max_pending)
+: max_pending(max_pending)
+{
+	ASSERT_GREATER(threads, 0U);
+	ASSERT_GREATER(max_pending, 0U);
+	workers.resize(threads);
+	for (auto &w : workers) w = lak::unique_ptr<worker>::make();
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i]->thread = std::thread([this, i] { work(i); });
+}
+
+lak::tasks_impl::~tasks_impl()
+{
+	if (active > 0)
+	{
+		std::unique_lock lock{admit_mutex};
+		++admit_waiting;
+		drained.wait(lock, [this] { return active == 0; });
+		--admit_waiting;
+	}
+	{
+		std::lock_guard lock{sleep_mutex};
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto &w : workers)
+		if (w->thread.joinable()) w->thread.join();
+}
+
+bool lak::tasks_impl::try_admit()
+{
+	if (current_pool == this)
+	{
+		++active;
+		return true;
+	}
+
+	for (size_t a = active.load(); a < max_pending;)
+		if (active.compare_exchange_weak(a, a + 1)) return true;
+
+	return false;
+}
+
+bool lak::tasks_impl::spin_admit()
+{
+	for (size_t i = 0; i < lak::tasks::admit_spin_count; ++i)
+		if (try_admit()) return true;
+	return false;
+}
+
+void lak::tasks_impl::admit()
+{
+	if (spin_admit()) return;
+
+	std::unique_lock lock{admit_mutex};
+	++admit_waiting;
+	not_full.wait(lock, [this] { return try_admit(); });
+	--admit_waiting;
+}
+
+bool lak::tasks_impl::admit_until(
+  std::chrono::steady_clock::time_point deadline)
+{
+	if (spin_admit()) return true;
+
+	std::unique_lock lock{admit_mutex};
+	++admit_waiting;
+	const bool admitted{
+	  not_full.wait_until(lock, deadline, [this] { return try_admit(); })};
+	--admit_waiting;
+	return admitted;
+}
+
+void lak::tasks_impl::finish()
+{
+	const size_t remaining{--active};
+	if (admit_waiting > 0)
+	{
+		std::lock_guard lock{admit_mutex};
+		not_full.notify_one();
+		if (remaining == 0) drained.notify_all();
+	}
+}
+
+void lak::tasks_impl::submit(lak::task_job *job)
 {
+	const size_t index{current_pool == this
+	                     ? current_worker
+	                     : next_worker.fetch_add(1U) % workers.size()};
+
+	{
+		worker &w{*workers[index]};
+		std::lock_guard lock{w.mutex};
+		w.jobs.push_back(job);
+	}
+	++queued;
+
+	if (sleeping > 0)
+	{
+		std::lock_guard lock{sleep_mutex};
+		wake.notify_one();
+	}
+}
+
+lak::task_job *lak::tasks_impl::take(size_t index)
+{
+	if (queued == 0) return nullptr;
+
+	{
+		worker &w{*workers[index]};
+		std::lock_guard lock{w.mutex};
+		if (!w.jobs.empty())
+		{
+			lak::task_job *job{w.jobs.back()};
+			w.jobs.pop_back();
+			--queued;
+			return job;
+		}
+	}
+
+	for (size_t i = 1; i < workers.size(); ++i)
+	{
+		worker &w{*workers[(index + i) % workers.size()]};
+		// don't queue up behind a busy deque, try the next victim instead
+		std::unique_lock lock{w.mutex, std::try_to_lock};
+		if (lock.owns_lock() && !w.jobs.empty())
+		{
+			lak::task_job *job{w.jobs.front()};
+			w.jobs.pop_front();
+			--queued;
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+void lak::tasks_impl::run(lak::task_job *job)
+{
+	job->_invoke(job);
+	finish();
+}
+
+void lak::tasks_impl::work(size_t index)
+{
+	current_pool   = this;
+	current_worker = index;
+
 	for (;;)
 	{
-		while (_active >= _threads.size()) std::this_thread::yield();
-		_mutex.lock();
-		if (_active < _threads.size()) return _mutex;
-		_mutex.unlock();
+		if (lak::task_job *job{take(index)}; job)
+		{
+			run(job);
+			continue;
+		}
+
+		std::unique_lock lock{sleep_mutex};
+		++sleeping;
+		wake.wait(lock, [this] { return stopping || queued > 0; });
+		--sleeping;
+		if (stopping && queued == 0) break;
+	}
+
+	current_pool = nullptr;
+}
+
+void lak::task_state_base::release()
+{
+	if (_ref_count.fetch_sub(1U, std::memory_order_acq_rel) == 1U)
+		_destroy(this);
+}
+
+void lak::task_state_base::complete()
+{
+	_ready.store(true, std::memory_order_release);
+	_ready.notify_all();
+	if (lak::task_job *job{_continuation.exchange(this)}; job)
+		lak::tasks::submit_continuation(_pool, job);
+}
+
+void lak::task_state_base::wait()
+{
+	if (current_pool && current_pool == _pool)
+	{
+		// help out instead of blocking a worker that the task may be waiting
+		// behind
+		while (!ready())
+		{
+			if (lak::task_job *job{current_pool->take(current_worker)}; job)
+				current_pool->run(job);
+			else
+				break;
+		}
 	}
+
+	while (!ready()) _ready.wait(false, std::memory_order_acquire);
 }
 
-void lak::tasks::deactivate(size_t index)
+void lak::task_state_base::set_continuation(lak::task_job *job)
 {
-	const size_t active = _active;
-	ASSERT_GREATER(active, index);
-	lak::rotate_left(lak::span(_threads).subspan(index, active - index));
-	--_active;
+	lak::task_job *expected{nullptr};
+	if (!_continuation.compare_exchange_strong(expected, job))
+	{
+		// already completed
+		ASSERT_EQUAL(expected, static_cast<lak::task_job *>(this));
+		lak::tasks::submit_continuation(_pool, job);
+	}
 }
 
-void lak::tasks::deactivate(std::thread::id id)
+void lak::tasks::submit_continuation(lak::tasks_impl *impl,
+                                     lak::task_job *job)
 {
-	size_t index = 0;
-	for (const auto &t : lak::span(_threads).first(_active))
-		if (t.get_id() == id)
-			return deactivate(index);
-		else
-			++index;
+	ASSERT(impl);
+	++impl->active;
+	impl->submit(job);
 }
 
-lak::tasks::tasks(tasks &&other)
+void lak::tasks::admit()
 {
-	std::scoped_lock lock{_mutex, other._mutex};
-	lak::swap(_threads, other._threads);
-	_active       = size_t(other._active);
-	other._active = 0U;
+	ASSERT(_impl);
+	_impl->admit();
 }
 
+bool lak::tasks::try_admit()
+{
+	ASSERT(_impl);
+	return _impl->try_admit();
+}
+
+bool lak::tasks::admit_until(std::chrono::steady_clock::time_point deadline)
+{
+	ASSERT(_impl);
+	return _impl->admit_until(deadline);
+}
+
+void lak::tasks::submit(lak::task_job *job) { _impl->submit(job); }
+
+lak::tasks::tasks(size_t threads)
+: tasks(threads, threads * default_queue_depth)
+{
+}
+
+lak::tasks::tasks(size_t threads, size_t max_pending)
+{
+	if (threads > 0U)
+		_impl = lak::unique_ptr<lak::tasks_impl>::make(threads, max_pending);
+}
+
+lak::tasks::tasks(tasks &&other) : _impl(lak::move(other._impl)) {}
+
 lak::tasks &lak::tasks::operator=(tasks &&other)
 {
-	std::scoped_lock lock{_mutex, other._mutex};
-	lak::swap(_threads, other._threads);
-	size_t active = _active;
-	_active       = size_t(other._active);
-	other._active = active;
+	_impl = lak::move(other._impl);
 	return *this;
 }
 
-lak::tasks::~tasks()
+lak::tasks::~tasks() {}
+
+size_t lak::tasks::size() const
 {
-	while (_active > 0) std::this_thread::yield();
-	std::lock_guard lock{_mutex};
-	for (std::thread &t : _threads)
-		if (t.joinable()) t.join();
+	return _impl ? _impl->workers.size() : 0U;
 }
@@ -1,13 +1,55 @@
 #include "lak/alloc.hpp"
+#include "lak/alloc_stats.hpp"
 
+#include "lak/array.hpp"
+#include "lak/json.hpp"
+#include "lak/memmanip.hpp"
 #include "lak/result.hpp"
+#include "lak/string_view.hpp"
 #include "lak/test.hpp"
 
+#include <sstream>
+#include <thread>
+
 BEGIN_TEST(local_alloc)
 {
-	// auto span{lak::local_alloc(10).UNWRAP()};
+	auto span{lak::local_alloc(10).UNWRAP()};
+
+	ASSERT_NOT_EQUAL(span.data(), nullptr);
+	ASSERT_EQUAL(span.size(), 10U);
+
+	lak::local_free(span);
+
+	// a freed block is reused by the next allocation of its size class
+	auto again{lak::local_alloc(12).UNWRAP()};
+	ASSERT_EQUAL(again.data(), span.data());
+	lak::local_free(again);
+
+	lak::array<lak::span<byte_t>> spans;
+	for (size_t i = 0; i < 10000U; ++i)
+	{
+		auto s{lak::local_alloc(1U + (i % 300U)).UNWRAP()};
+		for (byte_t &b : s) b = byte_t(i);
+		spans.push_back(s);
+	}
+	for (size_t i = 0; i < spans.size(); ++i)
+		for (byte_t b : spans[i]) ASSERT_EQUAL(uint8_t(b), uint8_t(i));
+
+	// blocks allocated on this thread can be freed from another
+	std::thread([&] { for (auto &s : spans) lak::local_free(s); }).join();
+	spans.clear();
 
-	// lak::local_free(span);
+	for (size_t align : {32U, 256U, 4096U})
+	{
+		auto aligned{lak::local_alloc(24U, align).UNWRAP()};
+		ASSERT_EQUAL(uintptr_t(aligned.data()) % align, 0U);
+		lak::local_free(aligned);
+	}
+
+	// too big for the arena, falls back to global_alloc
+	auto large{lak::local_alloc(1024U * 1024U).UNWRAP()};
+	ASSERT_EQUAL(large.size(), 1024U * 1024U);
+	lak::local_free(large);
 
 	return 0;
 }
@@ -31,3 +73,69 @@ BEGIN_TEST(global_alloc)
 	return 0;
 }
 END_TEST()
+
+BEGIN_TEST(alloc_stats)
+{
+	lak::enable_alloc_stats();
+
+	const auto before{lak::get_alloc_stats()};
+
+	const auto site{lak::source_location::current()};
+	auto span{lak::global_alloc(3000U, 0U, site).UNWRAP()};
+
+	const auto during{lak::get_alloc_stats()};
+	ASSERT_GREATER_OR_EQUAL(during.allocations, before.allocations + 1U);
+	ASSERT_GREATER_OR_EQUAL(during.peak_live_bytes, 3000U);
+	// 3000 is in the [2048, 4096) size class
+	ASSERT_GREATER_OR_EQUAL(during.size_classes[12].live_count,
+	                        before.size_classes[12].live_count + 1U);
+
+	auto find_site{[&](const lak::alloc_stats &stats, uint_least32_t line)
+	               {
+		               for (const auto &s : stats.sites)
+			               if (s.site.line() == line &&
+			                   s.site.file_name() == site.file_name())
+				               return s;
+		               return lak::alloc_site_stats{};
+	               }};
+
+	const auto site_during{find_site(during, site.line())};
+	ASSERT_EQUAL(site_during.allocations, 1U);
+	ASSERT_EQUAL(site_during.live_bytes, 3000U);
+
+	lak::global_free(span);
+
+	const auto site_after{find_site(lak::get_alloc_stats(), site.line())};
+	ASSERT_EQUAL(site_after.frees, 1U);
+	ASSERT_EQUAL(site_after.live_bytes, 0U);
+
+	{
+		// arrays count their allocations against their user, not array.inl
+		const uint_least32_t line{lak::source_location::current().line() + 1U};
+		lak::array<uint32_t> array(100U);
+		const auto array_site{find_site(lak::get_alloc_stats(), line)};
+		ASSERT_EQUAL(array_site.allocations, 1U);
+		ASSERT_EQUAL(array_site.live_bytes, 400U);
+	}
+
+	// reserved and committed pages are tracked separately
+	auto pages{lak::page_reserve(1024U * 1024U).UNWRAP()};
+	ASSERT(lak::page_commit(lak::span<void>(pages.data(), 64U * 1024U))
+	         .is_ok());
+	const auto paged{lak::get_alloc_stats()};
+	ASSERT_GREATER_OR_EQUAL(paged.reserved_bytes, pages.size());
+	ASSERT_GREATER_OR_EQUAL(paged.committed_bytes, 64U * 1024U);
+	ASSERT(lak::page_free(pages).is_ok());
+	const auto freed{lak::get_alloc_stats()};
+	ASSERT_EQUAL(freed.reserved_bytes + pages.size(), paged.reserved_bytes);
+	ASSERT_EQUAL(freed.committed_bytes + 64U * 1024U, paged.committed_bytes);
+
+	std::stringstream json;
+	freed.to_json(json);
+	ASSERT(lak::JSON::parse(lak::as_u8string(json.str())).is_ok());
+
+	lak::enable_alloc_stats(false);
+
+	return 0;
+}
+END_TEST()
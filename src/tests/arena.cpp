@@ -0,0 +1,63 @@
+#include "lak/arena.hpp"
+
+#include "lak/test.hpp"
+
+BEGIN_TEST(arena)
+{
+	lak::arena arena(64U * 1024U);
+
+	auto a{arena.allocate(10U).UNWRAP()};
+	ASSERT_EQUAL(a.size(), 10U);
+	auto b{arena.allocate(100U, 64U).UNWRAP()};
+	ASSERT_EQUAL(uintptr_t(b.data()) % 64U, 0U);
+	ASSERT_GREATER(b.data(), a.data());
+
+	// only the last allocation is given back
+	arena.deallocate(a);
+	const size_t used{arena.used()};
+	arena.deallocate(b);
+	ASSERT_LESS(arena.used(), used);
+
+	const auto marker{arena.mark()};
+	auto c{arena.allocate(1000U).UNWRAP()};
+	for (byte_t &v : c) v = byte_t(0xAB);
+	// bigger than a block, chains a new one
+	auto big{arena.allocate(256U * 1024U).UNWRAP()};
+	for (byte_t &v : big) v = byte_t(0xCD);
+	ASSERT_GREATER_OR_EQUAL(arena.reserved(), 320U * 1024U);
+
+	arena.rewind(marker);
+	ASSERT_EQUAL(arena.allocate(1000U).UNWRAP().data(), c.data());
+
+	// running out of address space is an error, not fatal
+	const size_t reserved{arena.reserved()};
+	ASSERT(arena.allocate(SIZE_MAX / 2U).is_err());
+	ASSERT(arena.allocate(SIZE_MAX).is_err());
+	ASSERT_EQUAL(arena.reserved(), reserved);
+
+	{
+		const lak::arena_allocator alloc(arena);
+		lak::arena_array<int> array(alloc);
+		for (int i = 0; i < 10000; ++i) array.push_back(i);
+		for (int i = 0; i < 10000; ++i) ASSERT_EQUAL(array[i], i);
+		auto copy{array};
+		ASSERT_EQUAL(copy.get_allocator()._arena, &arena);
+		ASSERT(copy == array);
+	}
+
+	{
+		lak::arena_string<char> str(arena);
+		for (int i = 0; i < 100; ++i) str += "hello arena ";
+		ASSERT_EQUAL(str.size(), 1200U);
+	}
+
+	arena.reset();
+	ASSERT_EQUAL(arena.used(), 0U);
+	ASSERT_EQUAL(arena.allocate(10U).UNWRAP().data(), a.data());
+
+	arena.release();
+	ASSERT_EQUAL(arena.reserved(), 0U);
+
+	return 0;
+}
+END_TEST()
@@ -1,6 +1,8 @@
 #include "lak/array.hpp"
 
 #include "lak/concepts.hpp"
+#include "lak/memory.hpp"
+#include "lak/span_manip.hpp"
 #include "lak/test.hpp"
 #include "lak/utility.hpp"
 
@@ -11,6 +13,8 @@ static_assert(lak::concepts::contiguous_range_of<lak::array<lak::incomplete>,
 static_assert(
   lak::concepts::contiguous_range_of<lak::uninit_array<lak::incomplete>,
                                      lak::incomplete>);
+static_assert(
+  lak::concepts::contiguous_range_of<lak::small_array<int, 4U>, int>);
 
 template<typename T>
 lak::array<T> one_page_array(const T &default_value = {})
@@ -169,3 +173,216 @@ BEGIN_TEST(array_insert)
 	return 0;
 }
 END_TEST()
+
+BEGIN_TEST(array_growth)
+{
+	{
+		lak::array<int> array;
+		array.set_growth(lak::array_growth::exact());
+		for (int i = 0; i < 10; ++i)
+		{
+			array.push_back(i);
+			ASSERT_EQUAL(array.capacity(), array.size());
+		}
+		// copies keep the policy
+		lak::array<int> copy(array);
+		ASSERT_EQUAL(copy.growth().mode, lak::array_growth::mode::exact);
+	}
+
+	{
+		lak::array<int> array;
+		array.set_growth(lak::array_growth::geometric(3U, 2U));
+		array.reserve(10U);
+		ASSERT_EQUAL(array.capacity(), 10U);
+		array.resize(11U);
+		ASSERT_EQUAL(array.capacity(), 15U);
+	}
+
+	{
+		lak::array<int> array;
+		array.set_growth(lak::array_growth::page());
+		array.push_back(0);
+		ASSERT_EQUAL(array.capacity(), lak::page_size() / sizeof(int));
+	}
+
+	// reserving a large range up front only commits what's used, and the
+	// elements never move
+	{
+		static constexpr size_t reserved = size_t(1U) << 26U;
+		lak::array<int> array;
+		array.reserve(reserved);
+		ASSERT_EQUAL(array.capacity(), reserved);
+		ASSERT_LESS(array.committed(), reserved);
+
+		array.push_back(0);
+		const int *data{array.data()};
+		for (int i = 1; i < 0x100000; ++i) array.push_back(i);
+		ASSERT_EQUAL(uintptr_t(array.data()), uintptr_t(data));
+		ASSERT_GREATER_OR_EQUAL(array.committed(), array.size());
+		ASSERT_LESS(array.committed(), reserved);
+		ASSERT_EQUAL(array[0xFFFFF], 0xFFFFF);
+	}
+
+	return 0;
+}
+END_TEST()
+
+BEGIN_TEST(small_array)
+{
+	lak::small_array<int, 4U> array;
+	ASSERT(array.is_small());
+	ASSERT_EQUAL(array.capacity(), 4U);
+
+	const auto *inline_data{array.data()};
+	for (int i = 0; i < 4; ++i) array.push_back(i);
+	ASSERT(array.is_small());
+	ASSERT_EQUAL(uintptr_t(array.data()), uintptr_t(inline_data));
+
+	// spills once it outgrows the inline storage
+	array.push_back(4);
+	ASSERT(!array.is_small());
+	ASSERT_GREATER_OR_EQUAL(array.capacity(), 8U);
+	for (int i = 0; i < 5; ++i) ASSERT_EQUAL(array[i], i);
+
+	array.insert(array.begin() + 1, {10, 11});
+	ASSERT_EQUAL(array.size(), 7U);
+	ASSERT_EQUAL(array[1], 10);
+	ASSERT_EQUAL(array[2], 11);
+	ASSERT_EQUAL(array[3], 1);
+	array.erase(array.begin() + 1, array.begin() + 3);
+	for (int i = 0; i < 5; ++i) ASSERT_EQUAL(array[i], i);
+
+	ASSERT_EQUAL(array.popped_front(), 0);
+	ASSERT_EQUAL(array.popped_back(), 4);
+	ASSERT(array == (lak::small_array<int, 4U>{1, 2, 3}));
+
+	array.force_clear();
+	ASSERT(array.is_small());
+	ASSERT(array.empty());
+
+	// inline elements are moved, spilled storage is handed over
+	lak::small_array<lak::array<int>, 2U> arrays;
+	arrays.emplace_back(lak::array<int>{1, 2, 3});
+	arrays.emplace_front(lak::array<int>{0});
+	{
+		auto moved{lak::move(arrays)};
+		ASSERT(arrays.empty());
+		ASSERT_EQUAL(moved.size(), 2U);
+		ASSERT_EQUAL(moved[0].size(), 1U);
+		ASSERT_EQUAL(moved[1].size(), 3U);
+
+		moved.push_back(lak::array<int>{4});
+		ASSERT(!moved.is_small());
+		const auto *spilled{moved.data()};
+		arrays = lak::move(moved);
+		ASSERT_EQUAL(uintptr_t(arrays.data()), uintptr_t(spilled));
+		ASSERT(moved.is_small());
+	}
+
+	auto copy{arrays};
+	ASSERT_EQUAL(copy.size(), arrays.size());
+	ASSERT_NOT_EQUAL(copy.data(), arrays.data());
+	ASSERT_EQUAL(copy[1][2], 3);
+	copy.resize(1U);
+	ASSERT_EQUAL(copy.size(), 1U);
+	ASSERT_EQUAL(copy[0][0], 0);
+
+	arrays.reserve(100U);
+	ASSERT_GREATER_OR_EQUAL(arrays.capacity(), 100U);
+	ASSERT_EQUAL(arrays.size(), 3U);
+	ASSERT_EQUAL(arrays[2][0], 4);
+
+	return 0;
+}
+END_TEST()
+
+namespace
+{
+	// counts every move and copy, but opts in to being relocated by memcpy
+	struct relocatable
+	{
+		static inline size_t moves = 0U;
+		int value;
+
+		relocatable(int v) : value(v) {}
+		relocatable(const relocatable &other) : value(other.value) { ++moves; }
+		relocatable(relocatable &&other) : value(other.value) { ++moves; }
+		relocatable &operator=(const relocatable &other)
+		{
+			value = other.value;
+			++moves;
+			return *this;
+		}
+		relocatable &operator=(relocatable &&other)
+		{
+			value = other.value;
+			++moves;
+			return *this;
+		}
+		~relocatable() {}
+	};
+}
+
+template<>
+struct lak::is_trivially_relocatable<relocatable> : lak::true_type
+{
+};
+
+static_assert(lak::is_trivially_relocatable_v<int>);
+static_assert(lak::is_trivially_relocatable_v<lak::array<int>>);
+static_assert(lak::is_trivially_relocatable_v<lak::array<int, 4U>>);
+static_assert(lak::is_trivially_relocatable_v<lak::small_array<int, 4U>>);
+static_assert(lak::is_trivially_relocatable_v<lak::unique_ptr<int>>);
+static_assert(!lak::is_trivially_relocatable_v<std::string>);
+
+BEGIN_TEST(array_relocate)
+{
+	{
+		lak::array<relocatable> array;
+		for (int i = 0; i < 1000; ++i) array.emplace_back(i);
+		array.erase(array.begin() + 10, array.begin() + 20);
+		array.pop_front();
+		array.insert(array.begin() + 5, relocatable(-1));
+		ASSERT_EQUAL(relocatable::moves, 1U);
+		ASSERT_EQUAL(array.size(), 990U);
+		ASSERT_EQUAL(array[4].value, 5);
+		ASSERT_EQUAL(array[5].value, -1);
+		ASSERT_EQUAL(array[6].value, 6);
+		ASSERT_EQUAL(array[10].value, 20);
+		ASSERT_EQUAL(array.back().value, 999);
+	}
+
+	{
+		relocatable::moves = 0U;
+		lak::small_array<relocatable, 4U> array;
+		for (int i = 0; i < 100; ++i) array.emplace_back(i);
+		array.erase(array.begin());
+		ASSERT_EQUAL(relocatable::moves, 0U);
+		ASSERT_EQUAL(array.front().value, 1);
+		ASSERT_EQUAL(array.back().value, 99);
+	}
+
+	// arrays of arrays are relocated without touching the inner arrays
+	{
+		lak::array<lak::array<int>> array;
+		for (int i = 0; i < 100; ++i) array.emplace_back().push_back(i);
+		const int *inner{array[50].data()};
+		array.erase(array.begin());
+		ASSERT_EQUAL(uintptr_t(array[49].data()), uintptr_t(inner));
+	}
+
+	// rotates larger than the stack buffer fall back to swapping
+	for (size_t distance : {size_t(3U), size_t(2000U), size_t(4000U)})
+	{
+		lak::array<size_t> array;
+		for (size_t i = 0; i < 5000U; ++i) array.push_back(i);
+		lak::rotate_left(lak::span<size_t>(array), distance);
+		for (size_t i = 0; i < array.size(); ++i)
+			ASSERT_EQUAL(array[i], (i + distance) % array.size());
+		lak::rotate_right(lak::span<size_t>(array), distance);
+		for (size_t i = 0; i < array.size(); ++i) ASSERT_EQUAL(array[i], i);
+	}
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,80 @@
+#include "lak/concurrent_railcar.hpp"
+
+#include "lak/array.hpp"
+#include "lak/test.hpp"
+
+#include <thread>
+
+BEGIN_TEST(concurrent_railcar)
+{
+	{
+		lak::concurrent_railcar<size_t> railcar;
+		ASSERT(railcar.empty());
+		ASSERT(railcar.snapshot().empty());
+		for (size_t i = 0; i < 10000U; ++i) ASSERT_EQUAL(railcar.push_back(i), i);
+		ASSERT_EQUAL(railcar.size(), 10000U);
+		for (size_t i = 0; i < 10000U; ++i) ASSERT_EQUAL(railcar[i], i);
+		ASSERT_EQUAL(railcar.try_get(10000U), nullptr);
+
+		const size_t *first{&railcar[0]};
+		railcar.clear();
+		ASSERT(railcar.empty());
+		// bins are kept by clear
+		railcar.push_back(1U);
+		ASSERT_EQUAL(&railcar[0], first);
+	}
+
+	{
+		static constexpr size_t thread_count = 4U;
+		static constexpr size_t per_thread   = 50000U;
+
+		lak::concurrent_railcar<lak::array<size_t>> railcar;
+		std::atomic_bool done = false;
+
+		// snapshots taken while the producers are running only ever see fully
+		// constructed elements
+		std::thread reader(
+		  [&]
+		  {
+			  size_t last_size = 0U;
+			  while (!done)
+			  {
+				  auto snapshot{railcar.snapshot()};
+				  ASSERT_GREATER_OR_EQUAL(snapshot.size(), last_size);
+				  last_size = snapshot.size();
+				  for (size_t i = 0; i < snapshot.size(); i += 97U)
+					  ASSERT_EQUAL(snapshot[i].size(), 1U);
+			  }
+		  });
+
+		lak::array<std::thread> producers;
+		for (size_t t = 0; t < thread_count; ++t)
+			producers.push_back(std::thread(
+			  [&, t]
+			  {
+				  for (size_t i = 0; i < per_thread; ++i)
+				  {
+					  lak::array<size_t> value;
+					  value.push_back(t * per_thread + i);
+					  const size_t index{railcar.push_back(lak::move(value))};
+					  ASSERT_EQUAL(railcar[index][0], t * per_thread + i);
+				  }
+			  }));
+		for (auto &producer : producers) producer.join();
+		done = true;
+		reader.join();
+
+		auto snapshot{railcar.snapshot()};
+		ASSERT_EQUAL(snapshot.size(), thread_count * per_thread);
+		lak::array<bool> seen;
+		seen.resize(thread_count * per_thread);
+		for (const auto &value : snapshot)
+		{
+			ASSERT(!seen[value[0]]);
+			seen[value[0]] = true;
+		}
+	}
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,75 @@
+#include "lak/coroutine.hpp"
+
+#include "lak/array.hpp"
+#include "lak/test.hpp"
+
+namespace
+{
+	lak::task<int> answer() { co_return 42; }
+
+	lak::task<int> add(lak::task<int> a, lak::task<int> b)
+	{
+		int result = 0;
+		result += (co_await a).UNWRAP();
+		result += (co_await b).UNWRAP();
+		co_return result;
+	}
+
+	lak::task<std::thread::id> hop(lak::tasks &pool)
+	{
+		co_await lak::schedule_on(pool);
+		co_return std::this_thread::get_id();
+	}
+
+	lak::task<int> throws()
+	{
+		throw std::runtime_error("expected failure");
+		co_return 0;
+	}
+
+	lak::task<lak::result<int, int>> checked(lak::result<int, int> value)
+	{
+		int v = co_await value;
+		co_return lak::ok_t{v + 1};
+	}
+
+	lak::task<size_t> fan_out(lak::tasks &pool, size_t count)
+	{
+		lak::array<lak::task<size_t>> children;
+		for (size_t i = 0; i < count; ++i)
+			children.push_back(lak::spawn(pool,
+			                              [](size_t i) -> lak::task<size_t>
+			                              { co_return i; }(i)));
+		size_t sum = 0U;
+		for (auto &child : children) sum += (co_await child).UNWRAP();
+		co_return sum;
+	}
+}
+
+BEGIN_TEST(coroutine)
+{
+	ASSERT_EQUAL(lak::sync_wait(answer()).UNWRAP(), 42);
+	ASSERT_EQUAL(lak::sync_wait(add(answer(), answer())).UNWRAP(), 84);
+
+	ASSERT_EQUAL(lak::sync_wait(throws()).UNWRAP_ERR(),
+	             lak::await_error::failed);
+
+	ASSERT_EQUAL(lak::sync_wait(checked(lak::ok_t{1})).UNWRAP().UNWRAP(), 2);
+	ASSERT_EQUAL(lak::sync_wait(checked(lak::err_t{7})).UNWRAP().UNWRAP_ERR(),
+	             7);
+
+	lak::tasks pool(2U);
+
+	ASSERT_NOT_EQUAL(lak::sync_wait(hop(pool)).UNWRAP(),
+	                 std::this_thread::get_id());
+
+	ASSERT_EQUAL(lak::sync_wait(fan_out(pool, 1000U)).UNWRAP(), 499500U);
+
+	{
+		// destroying a running task detaches it
+		auto detached{lak::spawn(pool, hop(pool))};
+	}
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,362 @@
+#include "lak/compression/deflate.hpp"
+#include "lak/compression/deflate_encoder.hpp"
+#include "lak/tinflate.hpp"
+
+#include "lak/memmanip.hpp"
+#include "lak/test.hpp"
+
+namespace
+{
+	// zlib streams of test_data(), one with fixed Huffman codes and one with
+	// dynamic Huffman codes and an empty stored block in the middle
+	constexpr uint8_t fixed_stream[] = {
+	  0x78, 0x01, 0x33, 0x30, 0x34, 0x32, 0x36, 0x31, 0x35, 0x33, 0xB7, 0xB0,
+	  0x54, 0x30, 0x40, 0x30, 0x4B, 0x12, 0x93, 0x72, 0x52, 0x15, 0x0A, 0x4B,
+	  0x33, 0x93, 0xB3, 0x15, 0x52, 0x52, 0xD3, 0x72, 0x12, 0x4B, 0x52, 0x15,
+	  0xD2, 0xF2, 0x2B, 0x14, 0x72, 0x12, 0xB3, 0x15, 0xB8, 0x14, 0x32, 0x4A,
+	  0xD3, 0xD2, 0x72, 0x13, 0xF3, 0x14, 0x92, 0x8A, 0xF2, 0xCB, 0xF3, 0x80,
+	  0x7C, 0x90, 0x4C, 0x49, 0x46, 0x2A, 0x58, 0x16, 0xA2, 0x07, 0xA2, 0x9F,
+	  0x0B, 0x4A, 0x83, 0xE4, 0x21, 0x6A, 0x21, 0x24, 0x92, 0x45, 0x98, 0x56,
+	  0x80, 0x0C, 0x82, 0xF1, 0x21, 0xB2, 0xA8, 0xD6, 0x81, 0xE4, 0xA1, 0x96,
+	  0x00, 0x59, 0x30, 0x39, 0x74, 0x13, 0x20, 0x16, 0xC3, 0x44, 0x31, 0xAC,
+	  0xC5, 0x70, 0x01, 0xBA, 0x43, 0x91, 0x45, 0x61, 0x76, 0x20, 0xCC, 0x05,
+	  0x79, 0x14, 0xC1, 0x83, 0xC9, 0x23, 0x19, 0x0A, 0x13, 0x02, 0x19, 0x08,
+	  0xC2, 0x10, 0xE3, 0xB8, 0xD0, 0x9C, 0x05, 0x0B, 0x33, 0x2E, 0x64, 0xAD,
+	  0x20, 0xE5, 0x5C, 0x28, 0xC1, 0x05, 0x52, 0x82, 0xA4, 0x00, 0x11, 0x0C,
+	  0xA8, 0x01, 0x83, 0x1A, 0x94, 0x98, 0xCE, 0x83, 0xF0, 0x10, 0x46, 0x72,
+	  0xC1, 0xD5, 0xA2, 0x06, 0x13, 0x8C, 0x87, 0x88, 0x4D, 0x2E, 0xE4, 0x40,
+	  0x07, 0x9B, 0x02, 0xE2, 0xA3, 0xB8, 0x1A, 0xA6, 0x09, 0x3D, 0x3E, 0x40,
+	  0x0A, 0x41, 0x3E, 0x82, 0x89, 0x43, 0x0C, 0x81, 0x7A, 0x01, 0xC9, 0x41,
+	  0xC8, 0xB1, 0x8E, 0x91, 0x0E, 0x51, 0x03, 0x1E, 0x49, 0x1A, 0xC4, 0x85,
+	  0x78, 0x05, 0x62, 0x0A, 0x6A, 0x80, 0x80, 0xD3, 0x02, 0x5C, 0x1B, 0xCC,
+	  0x74, 0x2E, 0x94, 0xE0, 0x42, 0x4D, 0x61, 0x30, 0xF3, 0x50, 0x5D, 0x8B,
+	  0xB0, 0x05, 0x11, 0x0C, 0x98, 0x24, 0xB2, 0x0F, 0xD0, 0xED, 0x87, 0xC4,
+	  0x29, 0x82, 0xCF, 0x85, 0x25, 0x1C, 0xE0, 0x21, 0x86, 0x55, 0x07, 0x46,
+	  0xFC, 0xA3, 0x5A, 0x85, 0x23, 0x77, 0x61, 0xA6, 0x1A, 0xB8, 0xE1, 0xC8,
+	  0x19, 0x06, 0x4B, 0x02, 0x46, 0x75, 0x0D, 0x72, 0x0E, 0xC0, 0x91, 0x75,
+	  0xB8, 0xD0, 0x5C, 0x04, 0x91, 0xC3, 0x51, 0xA4, 0x40, 0x92, 0x0F, 0xAA,
+	  0xBF, 0xB1, 0x69, 0x47, 0x76, 0x34, 0x22, 0x16, 0xB8, 0xC0, 0x34, 0xC8,
+	  0xE1, 0x18, 0x6E, 0x41, 0xF6, 0x0D, 0x72, 0x84, 0xC0, 0xC4, 0x50, 0xB2,
+	  0x32, 0x3C, 0x32, 0x11, 0xD9, 0x1E, 0xC3, 0x40, 0xE4, 0x80, 0x45, 0x4F,
+	  0xDB, 0x18, 0x9E, 0xC3, 0x1E, 0x68, 0xA8, 0xF1, 0x85, 0x16, 0x84, 0xD0,
+	  0x90, 0x40, 0x72, 0x2A, 0x17, 0x46, 0xAA, 0xC2, 0x4C, 0x91, 0x5C, 0x18,
+	  0x29, 0x16, 0x23, 0xB8, 0x11, 0xC6, 0xA1, 0x87, 0x01, 0x48, 0x39, 0x66,
+	  0x4E, 0x47, 0x4E, 0x0F, 0x5C, 0x48, 0x6A, 0x30, 0x92, 0x1F, 0xF6, 0x58,
+	  0xE3, 0x42, 0xCA, 0xC7, 0x5C, 0x28, 0xC5, 0x1F, 0x96, 0x52, 0x11, 0x91,
+	  0xAD, 0xB8, 0xE0, 0x1E, 0xC2, 0x12, 0xA8, 0xA8, 0x05, 0x17, 0xBA, 0xCF,
+	  0x91, 0x0B, 0x40, 0xE4, 0x8A, 0x06, 0x3D, 0x96, 0x90, 0x53, 0x1C, 0x2C,
+	  0xFD, 0x20, 0xEB, 0x45, 0x14, 0xC2, 0xA8, 0x65, 0x01, 0x66, 0x0A, 0xC4,
+	  0x52, 0x4C, 0xC3, 0xAA, 0x1B, 0x58, 0xDD, 0x88, 0x70, 0x10, 0x17, 0xDC,
+	  0x51, 0xA8, 0x89, 0x87, 0x0B, 0x6E, 0x18, 0xA2, 0x90, 0x40, 0x0F, 0x4C,
+	  0x70, 0xF5, 0x82, 0xE2, 0x69, 0x58, 0x82, 0x87, 0xA5, 0x5B, 0xD4, 0x14,
+	  0xC6, 0x85, 0x91, 0xBB, 0xD1, 0xCB, 0x6A, 0xF4, 0xF4, 0x8F, 0xEA, 0x55,
+	  0xD4, 0xBA, 0x1B, 0x47, 0x4E, 0x40, 0x2B, 0x76, 0x71, 0x65, 0x53, 0x74,
+	  0xBF, 0x20, 0x69, 0xE3, 0x42, 0xF1, 0x2C, 0xAC, 0x0E, 0x45, 0x78, 0x16,
+	  0x7B, 0xC1, 0x85, 0x5E, 0xE6, 0x62, 0x29, 0xAC, 0xB8, 0x70, 0x4B, 0xA1,
+	  0x65, 0x37, 0x6C, 0x65, 0x03, 0x24, 0x69, 0xA0, 0xE7, 0x12, 0xBC, 0x4E,
+	  0xC2, 0x48, 0x6C, 0xB0, 0x78, 0xC2, 0xAC, 0x16, 0xB0, 0x6A, 0xC3, 0xE2,
+	  0x22, 0xCC, 0x62, 0x35, 0x03, 0x35, 0x63, 0xA2, 0x56, 0xEF, 0xD8, 0xCA,
+	  0xA0, 0x8C, 0x54, 0x94, 0xB6, 0x06, 0x22, 0x97, 0x21, 0xD2, 0x2A, 0x17,
+	  0x92, 0x4F, 0x61, 0x6D, 0x13, 0xE4, 0x94, 0x88, 0xD9, 0x1C, 0x43, 0xF5,
+	  0x13, 0x66, 0xC5, 0x8D, 0xA5, 0x46, 0xE6, 0xC2, 0xE6, 0x3F, 0x2E, 0xB8,
+	  0x3D, 0x58, 0x0A, 0x29, 0x9C, 0xED, 0x34, 0x98, 0x1B, 0x91, 0x2B, 0x79,
+	  0x6C, 0xAD, 0x1D, 0xD4, 0x6C, 0x8A, 0x1E, 0x97, 0x08, 0xFF, 0xA1, 0xE6,
+	  0x45, 0xD4, 0x66, 0x1C, 0x17, 0x52, 0xE1, 0x42, 0xA0, 0x00, 0xC3, 0x9E,
+	  0x9D, 0x90, 0xCB, 0x40, 0xE4, 0xC6, 0x13, 0x72, 0x66, 0x44, 0x4D, 0x74,
+	  0xC8, 0xF1, 0x8B, 0xDA, 0xAE, 0x45, 0x6D, 0xA0, 0xA1, 0xEA, 0xE5, 0x82,
+	  0x3B, 0x1C, 0xB5, 0x85, 0x81, 0x16, 0x0D, 0xC8, 0xA5, 0x2C, 0x72, 0xC8,
+	  0xA1, 0xD4, 0x91, 0x18, 0x29, 0x19, 0xA3, 0xB4, 0x42, 0x2B, 0x2A, 0x31,
+	  0x53, 0x75, 0x46, 0x2A, 0x96, 0xA0, 0x05, 0x89, 0xA2, 0x8A, 0x60, 0x68,
+	  0x44, 0x8E, 0x05, 0x84, 0xD7, 0x90, 0x4B, 0x39, 0x44, 0xED, 0x8C, 0xF0,
+	  0x0B, 0x46, 0x3E, 0xC1, 0xD4, 0x0E, 0x4B, 0x30, 0x30, 0x36, 0x72, 0xE2,
+	  0x40, 0x78, 0x18, 0x33, 0xB9, 0x23, 0x27, 0x71, 0x5C, 0xC5, 0x32, 0xAC,
+	  0xCB, 0x83, 0x70, 0x1A, 0xCE, 0xAA, 0x11, 0x91, 0x18, 0x70, 0x74, 0x0C,
+	  0x10, 0x61, 0x84, 0xAD, 0x7C, 0xC3, 0x2D, 0x83, 0xB7, 0xD5, 0x03, 0xF3,
+	  0x38, 0x46, 0x8B, 0x07, 0xBD, 0x3C, 0xC3, 0x1A, 0xA4, 0xA8, 0x51, 0x86,
+	  0x1C, 0x99, 0x28, 0xBD, 0x18, 0xA4, 0x3C, 0x83, 0xEC, 0x40, 0xE4, 0x40,
+	  0xC3, 0xDE, 0xD2, 0xC4, 0xD5, 0x3E, 0x43, 0x4D, 0xC8, 0x08, 0x1E, 0xD6,
+	  0x5A, 0x04, 0xA7, 0x7B, 0x91, 0x6B, 0x60, 0x0C, 0x9F, 0xA2, 0x77, 0x5A,
+	  0x11, 0xA1, 0x8F, 0xDC, 0x7A, 0x40, 0x0B, 0x0F, 0xB4, 0xA2, 0x08, 0xB3,
+	  0xB7, 0x80, 0x9C, 0xAA, 0xD0, 0xD3, 0x0B, 0x66, 0xB6, 0xC1, 0x59, 0x00,
+	  0xA2, 0x37, 0x5A, 0x10, 0x65, 0x11, 0x00, 0xA6, 0xAC, 0x1E, 0x8C};
+
+	constexpr uint8_t dynamic_stream[] = {
+	  0x78, 0xDA, 0x74, 0x54, 0x5B, 0x92, 0xC2, 0x40, 0x08, 0xFC, 0xE7, 0x14,
+	  0x73, 0x04, 0x1F, 0xEB, 0xEB, 0x38, 0x71, 0x37, 0x29, 0x2D, 0xA3, 0x96,
+	  0x56, 0x2C, 0x3D, 0xFE, 0x4A, 0x08, 0x43, 0x33, 0x4C, 0x3E, 0x4C, 0xC2,
+	  0x00, 0x4D, 0xD3, 0x30, 0x2E, 0x96, 0xAB, 0xF5, 0xCF, 0x66, 0xBB, 0xDB,
+	  0x1F, 0xD2, 0xC2, 0x3E, 0x87, 0xE6, 0xD8, 0xB7, 0xE9, 0xF1, 0x3A, 0xFF,
+	  0x5E, 0xD2, 0x5F, 0xDB, 0xF5, 0xCD, 0xD0, 0xA6, 0xEE, 0xFE, 0x49, 0x7D,
+	  0x73, 0x49, 0x94, 0x4E, 0xAF, 0xAE, 0xBB, 0x36, 0xB7, 0x74, 0x7C, 0xDE,
+	  0xDF, 0xB7, 0xAF, 0xCD, 0x9E, 0xE1, 0xD4, 0x8E, 0x5E, 0xC9, 0x91, 0x7C,
+	  0x9A, 0xDE, 0xEC, 0x97, 0x58, 0x79, 0x42, 0xA1, 0x58, 0x82, 0x81, 0xD4,
+	  0x16, 0xAF, 0x2F, 0xC7, 0xFE, 0xA9, 0xC8, 0xF7, 0x4B, 0x7D, 0x25, 0x82,
+	  0x14, 0xD6, 0xD3, 0x50, 0x36, 0x30, 0x28, 0x89, 0xE2, 0xA9, 0xD6, 0x30,
+	  0x5C, 0x6E, 0xD4, 0x2C, 0xF5, 0x03, 0xA8, 0x1E, 0x31, 0x20, 0xFF, 0x04,
+	  0x8E, 0x0A, 0x5A, 0xAA, 0x19, 0x61, 0x2A, 0x87, 0x93, 0x93, 0x8B, 0x43,
+	  0x20, 0xC0, 0x64, 0xF0, 0xC2, 0x78, 0x29, 0x23, 0x3D, 0xB1, 0x0C, 0x92,
+	  0x72, 0xAC, 0x97, 0x49, 0x2D, 0x9B, 0x26, 0xA1, 0xE8, 0x23, 0x0A, 0xDB,
+	  0x8E, 0xB5, 0x26, 0x95, 0xF3, 0xE0, 0x40, 0xEE, 0x48, 0xCF, 0x05, 0x64,
+	  0x6A, 0x01, 0x08, 0xE1, 0xD4, 0xC3, 0x1E, 0x7A, 0xE1, 0xC1, 0xCD, 0xA6,
+	  0xB4, 0x22, 0x28, 0x5E, 0x90, 0x71, 0x17, 0x72, 0x9A, 0xA2, 0x93, 0x93,
+	  0xCB, 0x6F, 0x98, 0xE2, 0x79, 0xB6, 0x56, 0xC5, 0x64, 0x88, 0x4F, 0xEC,
+	  0xA0, 0xAC, 0x2F, 0x33, 0x35, 0x9B, 0x2A, 0x3A, 0x64, 0xC5, 0xAA, 0x19,
+	  0x61, 0xFE, 0xBE, 0xD4, 0xCC, 0xED, 0x8A, 0x5B, 0x93, 0xC1, 0xF1, 0xC2,
+	  0x54, 0x16, 0xD8, 0xB3, 0xC1, 0x1B, 0x30, 0x73, 0x75, 0xA8, 0x60, 0x24,
+	  0xBE, 0x99, 0xBF, 0x14, 0x59, 0x1F, 0xDF, 0x77, 0x2D, 0x1D, 0x49, 0xDB,
+	  0x14, 0x68, 0x7C, 0x33, 0xF1, 0xC0, 0x05, 0xBB, 0xC1, 0x81, 0xE8, 0x99,
+	  0xBB, 0xCA, 0x79, 0x98, 0x76, 0xED, 0x03, 0x20, 0x0A, 0x5B, 0xEE, 0x76,
+	  0x68, 0xAE, 0x2E, 0x9A, 0x9F, 0x57, 0x21, 0xE1, 0xA4, 0x04, 0x50, 0xA5,
+	  0xB0, 0x55, 0x71, 0x23, 0x29, 0x6C, 0x6C, 0x90, 0x9B, 0xE1, 0xFE, 0x01,
+	  0x00, 0x00, 0xFF, 0xFF, 0x7D, 0x56, 0x5B, 0x72, 0xC3, 0x30, 0x08, 0xFC,
+	  0xE7, 0x14, 0x3E, 0x42, 0xDF, 0x8F, 0xE3, 0x38, 0xAD, 0x3D, 0xEA, 0xC4,
+	  0x4D, 0xA6, 0x9D, 0x64, 0xDA, 0xE3, 0x27, 0x18, 0x23, 0x16, 0x90, 0xF2,
+	  0x11, 0x47, 0x46, 0x02, 0xED, 0xA2, 0x05, 0x79, 0x3C, 0x4D, 0x03, 0x0D,
+	  0x9F, 0xD3, 0xBC, 0x8C, 0xD7, 0x51, 0x39, 0xCF, 0xF3, 0xF7, 0x78, 0x18,
+	  0x96, 0x71, 0x3F, 0xEC, 0x7E, 0x8F, 0x7F, 0x87, 0x3A, 0xC3, 0x16, 0x1D,
+	  0xCF, 0xC7, 0xFF, 0xAB, 0x8F, 0xAD, 0x39, 0x8D, 0xBB, 0x65, 0x1A, 0xEE,
+	  0xEE, 0x1F, 0x1E, 0x9F, 0x9E, 0x5F, 0x5E, 0xDF, 0xDE, 0x37, 0x83, 0x2E,
+	  0xD7, 0x7F, 0xD2, 0xE5, 0x85, 0xC7, 0xBA, 0x15, 0x07, 0x03, 0x57, 0x35,
+	  0xFF, 0x9C, 0xBF, 0x3E, 0xF6, 0xEB, 0x1E, 0xB4, 0x8D, 0x0D, 0x65, 0x63,
+	  0xB9, 0xEC, 0xA8, 0x0B, 0xAB, 0xB5, 0x18, 0x25, 0xDA, 0xD6, 0xF0, 0x7E,
+	  0x6A, 0xD3, 0x80, 0xE2, 0x27, 0xB8, 0x64, 0x4B, 0x72, 0xBE, 0x3C, 0x46,
+	  0x28, 0x1E, 0x24, 0x26, 0x81, 0x10, 0x9C, 0xE4, 0x89, 0x9F, 0x1C, 0x80,
+	  0xFF, 0x39, 0x88, 0x01, 0xA2, 0x0A, 0x4A, 0x42, 0x44, 0xA8, 0x9A, 0x30,
+	  0xF6, 0x8C, 0xC9, 0xE4, 0x48, 0x9E, 0x34, 0x5B, 0x74, 0xAF, 0xF5, 0xB7,
+	  0xCE, 0x5A, 0x4C, 0x84, 0xC9, 0xEB, 0x36, 0xD2, 0xEB, 0x3B, 0x92, 0xF5,
+	  0xE4, 0x62, 0x0A, 0x90, 0x32, 0x50, 0x15, 0x33, 0x18, 0x4C, 0x1D, 0x39,
+	  0x49, 0x91, 0x0B, 0xB8, 0x91, 0x23, 0xBB, 0x92, 0x2C, 0x48, 0x16, 0x96,
+	  0xA2, 0xDE, 0x8A, 0xA6, 0xC1, 0x83, 0x76, 0x81, 0xBB, 0x53, 0xEC, 0xDD,
+	  0x92, 0x54, 0x31, 0x84, 0x22, 0x8D, 0x58, 0x25, 0x37, 0x21, 0x25, 0xB1,
+	  0xE9, 0x39, 0x21, 0xD0, 0x94, 0x36, 0x73, 0x6B, 0x20, 0x4A, 0xF9, 0xD6,
+	  0xDC, 0x78, 0x1D, 0xDF, 0x48, 0xAF, 0xEA, 0xD0, 0x63, 0x51, 0xE5, 0xD0,
+	  0xF6, 0x24, 0x57, 0xE9, 0x62, 0x33, 0x25, 0xFA, 0x4D, 0x64, 0x16, 0xD9,
+	  0xE0, 0x49, 0xCB, 0x98, 0xE3, 0x07, 0x69, 0x50, 0x8B, 0x1F, 0xD5, 0x7D,
+	  0x60, 0x32, 0xB2, 0x49, 0x0B, 0x14, 0xA3, 0x84, 0x95, 0x69, 0x54, 0x9E,
+	  0x77, 0xD4, 0xCA, 0x8A, 0x67, 0x69, 0xFC, 0x7C, 0x2D, 0xAA, 0x04, 0xD5,
+	  0x8F, 0x52, 0x9D, 0x74, 0x0E, 0xAB, 0x5D, 0x4E, 0xD8, 0x03, 0xAD, 0x9C,
+	  0xC8, 0x15, 0xA3, 0x17, 0x1D, 0x9E, 0xAF, 0xE9, 0xDC, 0x3A, 0x52, 0x9D,
+	  0x73, 0xBE, 0x54, 0x81, 0xAF, 0x2D, 0xA1, 0xA5, 0x2A, 0xDB, 0x3E, 0x67,
+	  0x0E, 0x75, 0x9B, 0x95, 0x9C, 0xBA, 0x55, 0x68, 0x95, 0x59, 0xD5, 0x1B,
+	  0x0E, 0xEF, 0xC8, 0x56, 0x6F, 0x49, 0x8E, 0x78, 0x0A, 0x46, 0x0D, 0xBB,
+	  0x9C, 0xB8, 0x98, 0x2E, 0x83, 0xD6, 0xCC, 0xE8, 0xDD, 0x55, 0x30, 0x3A,
+	  0x46, 0x71, 0x18, 0xE1, 0x2C, 0x77, 0x94, 0x78, 0xAF, 0x2D, 0xCB, 0x2C,
+	  0x01, 0xB4, 0xEE, 0xD5, 0x68, 0x62, 0x68, 0x90, 0x56, 0x9A, 0x28, 0x66,
+	  0xDF, 0xC4, 0xFA, 0x33, 0x29, 0x05, 0x78, 0x7E, 0x4A, 0x3C, 0x4A, 0x34,
+	  0xF5, 0xB3, 0x66, 0x4A, 0xFD, 0x91, 0xE1, 0x61, 0x62, 0x67, 0xC1, 0x9A,
+	  0x41, 0x80, 0x98, 0x34, 0x4B, 0x74, 0xEC, 0x37, 0xAD, 0x1E, 0xEC, 0x85,
+	  0x6C, 0x6F, 0xCD, 0x5B, 0xA4, 0x8B, 0x17, 0x6F, 0xE0, 0xC4, 0xD4, 0xE7,
+	  0x95, 0x20, 0xFB, 0xF8, 0xF5, 0x10, 0xF2, 0x11, 0x5A, 0x91, 0x8F, 0x64,
+	  0x37, 0x57, 0xFB, 0xEA, 0xCB, 0x65, 0xD3, 0x6D, 0x80, 0xF1, 0xA3, 0xC5,
+	  0x7A, 0xD1, 0x05, 0xA6, 0xAC, 0x1E, 0x8C};
+
+	lak::array<byte_t> test_data()
+	{
+		const char *words[] = {"lak",
+		                       "deflate",
+		                       "huffman",
+		                       "table",
+		                       "the",
+		                       "quick",
+		                       "brown",
+		                       "fox",
+		                       "0123456789",
+		                       "\n"};
+		lak::array<byte_t> result;
+		for (uint32_t x = 1U; result.size() < 4000U;)
+		{
+			x = (x * 1103515245U + 12345U) & 0x7FFF'FFFFU;
+			for (const char *c = words[(x >> 16U) % 10U]; *c; ++c)
+				result.push_back(byte_t(*c));
+			result.push_back(byte_t(' '));
+		}
+		result.resize(4000U);
+		return result;
+	}
+
+	lak::array<byte_t> inflate_iterator(
+	  lak::span<const byte_t> compressed,
+	  lak::deflate_iterator::header_t header =
+	    lak::deflate_iterator::header_t::zlib)
+	{
+		lak::array<byte_t, 0x8000> buff;
+		lak::deflate_iterator iter{compressed, buff, header, false};
+		lak::array<byte_t> out;
+		iter
+		  .read(
+		    [&](lak::span<byte_t> v)
+		    {
+			    out.resize(out.size() + v.size());
+			    lak::memcpy(lak::span(out).last(v.size()), v);
+			    return true;
+		    })
+		  .UNWRAP();
+		ASSERT_EQUAL(iter.input_consumed(),
+		             compressed.size() -
+		               (header == lak::deflate_iterator::header_t::zlib   ? 4U
+		                : header == lak::deflate_iterator::header_t::gzip ? 8U
+		                                                                  : 0U));
+		return out;
+	}
+
+	lak::array<byte_t> inflate_tinf(lak::span<const byte_t> compressed)
+	{
+		lak::array<byte_t> out;
+		out.resize(0x2000);
+		byte_t *head = out.data();
+		ASSERT_EQUAL(tinf::tinflate(compressed, lak::span(out), &head),
+		             tinf::error_t::OK);
+		out.resize(size_t(head - out.data()));
+		return out;
+	}
+}
+
+BEGIN_TEST(deflate)
+{
+	const lak::array<byte_t> expected{test_data()};
+
+	for (lak::span<const byte_t> compressed :
+	     {lak::span<const byte_t>(lak::as_bytes(&fixed_stream)),
+	      lak::span<const byte_t>(lak::as_bytes(&dynamic_stream))})
+	{
+		ASSERT_ARRAY_EQUAL(inflate_iterator(compressed), expected);
+		ASSERT_ARRAY_EQUAL(inflate_tinf(compressed), expected);
+
+		// feed the iterator one byte at a time so codes get split between
+		// buffers
+		lak::array<byte_t, 0x8000> buff;
+		lak::deflate_iterator iter{compressed.subspan(2U, 1U),
+		                           buff,
+		                           lak::deflate_iterator::header_t::none};
+		lak::array<byte_t> out;
+		size_t offset = 3U;
+		for (bool done = false; !done;)
+		{
+			if_let_err (auto err,
+			            iter.read(
+			              [&](lak::span<byte_t> v)
+			              {
+				              out.resize(out.size() + v.size());
+				              lak::memcpy(lak::span(out).last(v.size()), v);
+				              return true;
+			              }))
+			{
+				ASSERT_EQUAL(err, lak::deflate_iterator::error_t::out_of_data);
+				ASSERT_LESS(offset, compressed.size());
+				iter.replace_compressed(compressed.subspan(offset++, 1U));
+			}
+			else
+				done = true;
+		}
+		ASSERT_ARRAY_EQUAL(out, expected);
+	}
+
+	// the table for a single code decodes both values of its bit
+	{
+		const uint8_t lengths[] = {0U, 0U, 1U, 0U};
+		lak::huffman_table table;
+		ASSERT(table.build(lengths, false, lak::huffman_kind::symbols, 7U) ==
+		       lak::huffman_error::ok);
+		ASSERT_EQUAL(table.lookup(0U).value, 2U);
+		ASSERT_EQUAL(table.lookup(1U).value, 2U);
+		ASSERT_EQUAL(table.lookup(1U).length, 1U);
+	}
+
+	// codes longer than the root table go through a second level table
+	{
+		lak::array<uint8_t> lengths;
+		lengths.resize(16U);
+		for (uint8_t i = 0U; i < 15U; ++i) lengths[i] = uint8_t(i + 1U);
+		lengths[15] = 15U;
+		lak::huffman_table table;
+		ASSERT(table.build(lengths, false, lak::huffman_kind::symbols, 4U) ==
+		       lak::huffman_error::ok);
+		// symbol n has the code of n ones followed by a zero
+		for (uint32_t n = 0U; n < 15U; ++n)
+		{
+			const lak::huffman_entry entry{table.lookup((1U << n) - 1U)};
+			ASSERT_EQUAL(entry.value, n);
+			ASSERT_EQUAL(entry.length, uint8_t(n + 1U));
+		}
+		ASSERT_EQUAL(table.lookup(0x7FFFU).value, 15U);
+		lengths[15] = 0U;
+		ASSERT(table.build(lengths, false, lak::huffman_kind::symbols, 4U) ==
+		       lak::huffman_error::incomplete_tree);
+	}
+
+	return 0;
+}
+END_TEST()
+
+BEGIN_TEST(deflate_encoder)
+{
+	using header_t = lak::deflate_encoder::header_t;
+	using level_t  = lak::deflate_encoder::level_t;
+
+	// long enough to slide the window, with runs of compressible and
+	// incompressible data
+	lak::array<byte_t> large;
+	for (uint32_t x = 1U; large.size() < 300000U;)
+	{
+		x = (x * 1103515245U + 12345U) & 0x7FFF'FFFFU;
+		if ((large.size() / 50000U) % 2U == 0U)
+			large.push_back(byte_t(x >> 16U));
+		else
+			large.push_back(byte_t('a' + (x >> 16U) % 4U));
+	}
+
+	const lak::array<byte_t> inputs[] = {{}, test_data(), large};
+
+	for (const auto &input : inputs)
+	{
+		for (level_t level : {level_t::stored, level_t::fast, level_t::lazy})
+		{
+			for (header_t header : {header_t::none, header_t::zlib, header_t::gzip})
+			{
+				const lak::array<byte_t> compressed{
+				  lak::encode_deflate(input, header, level)};
+				ASSERT_ARRAY_EQUAL(inflate_iterator(compressed, header), input);
+			}
+
+			// zlib checks the header
+			const lak::array<byte_t> compressed{
+			  lak::encode_deflate(input, header_t::zlib, level)};
+			ASSERT_EQUAL((uint32_t(compressed[0]) << 8U | uint32_t(compressed[1])) %
+			               31U,
+			             0U);
+
+			if (input.size() < 0x2000U)
+				ASSERT_ARRAY_EQUAL(inflate_tinf(compressed), input);
+
+			// streaming in uneven pieces gives the same output
+			lak::deflate_encoder encoder{header_t::zlib, level};
+			lak::array<byte_t> streamed;
+			for (lak::span<const byte_t> remaining{input}; !remaining.empty();)
+			{
+				const size_t size{std::min<size_t>(remaining.size(), 7777U)};
+				encoder.write(remaining.first(size));
+				remaining = remaining.subspan(size);
+				for (byte_t b : encoder.take_compressed()) streamed.push_back(b);
+			}
+			encoder.finish();
+			ASSERT(encoder.is_finished());
+			for (byte_t b : encoder.take_compressed()) streamed.push_back(b);
+			ASSERT_ARRAY_EQUAL(inflate_iterator(streamed), input);
+		}
+	}
+
+	// compression actually happens
+	const lak::array<byte_t> data{test_data()};
+	const size_t stored_size{
+	  lak::encode_deflate(data, header_t::none, level_t::stored).size()};
+	const size_t fast_size{
+	  lak::encode_deflate(data, header_t::none, level_t::fast).size()};
+	const size_t lazy_size{
+	  lak::encode_deflate(data, header_t::none, level_t::lazy).size()};
+	ASSERT_GREATER(stored_size, data.size());
+	ASSERT_LESS(fast_size, data.size() / 2U);
+	ASSERT_LESS_OR_EQUAL(lazy_size, fast_size);
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,68 @@
+#include "lak/file.hpp"
+
+#include "lak/binary_reader.hpp"
+#include "lak/test.hpp"
+
+BEGIN_TEST(mapped_file)
+{
+	const lak::fs::path path{lak::fs::temp_directory_path() /
+	                         "lak_test_mapped_file.bin"};
+
+	lak::array<byte_t> contents;
+	contents.resize(3U * lak::page_size() + 123U);
+	for (size_t i = 0; i < contents.size(); ++i)
+		contents[i] = byte_t(uint8_t(i * 7U));
+	ASSERT(lak::save_file(path, contents));
+
+	{
+		auto file{lak::mapped_file::open(
+		            path,
+		            lak::mapped_file_options{
+		              .advice   = lak::mapped_file_advice::sequential,
+		              .prefault = true,
+		            })
+		            .UNWRAP()};
+		ASSERT_EQUAL(file.size(), contents.size());
+		ASSERT(lak::span<const byte_t>(contents) == file.data());
+
+		// views can be read without copying them
+		lak::binary_reader reader{file.data()};
+		ASSERT_EQUAL(reader.read<uint8_t>().UNWRAP(), 0U);
+		ASSERT_EQUAL(reader.read<uint8_t>().UNWRAP(), 7U);
+
+		file.advise(lak::mapped_file_advice::random, lak::page_size() + 1U, 10U);
+	}
+
+	// copy on write mappings don't change the file
+	{
+		auto file{lak::mapped_file::open(
+		            path,
+		            lak::mapped_file_options{
+		              .access = lak::mapped_file_access::copy_on_write})
+		            .UNWRAP()};
+		file.mutable_data()[0] = byte_t(0xFFU);
+		ASSERT_EQUAL(uint8_t(file.data()[0]), 0xFFU);
+	}
+	auto unchanged{lak::read_file(path).UNWRAP()};
+	ASSERT_EQUAL(uint8_t(unchanged[0]), 0U);
+
+	// read_write mappings do
+	{
+		auto file{lak::mapped_file::open(
+		            path,
+		            lak::mapped_file_options{
+		              .access = lak::mapped_file_access::read_write})
+		            .UNWRAP()};
+		file.mutable_data()[lak::page_size() + 5U] = byte_t(0xABU);
+		file.flush(lak::page_size(), 10U).UNWRAP();
+	}
+	auto changed{lak::read_file(path).UNWRAP()};
+	ASSERT_EQUAL(uint8_t(changed[lak::page_size() + 5U]), 0xABU);
+
+	lak::remove_path(path).UNWRAP();
+
+	ASSERT(lak::mapped_file::open(path).is_err());
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,269 @@
+#include "lak/io_queue.hpp"
+
+#include "lak/coroutine.hpp"
+#include "lak/test.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+	lak::array<byte_t> pattern(size_t size, size_t seed)
+	{
+		lak::array<byte_t> result;
+		result.resize(size);
+		for (size_t i = 0; i < size; ++i)
+			result[i] = byte_t(uint8_t(i * 31U + seed));
+		return result;
+	}
+
+	lak::task<size_t> copy_file(lak::io_queue &queue,
+	                            const lak::io_file &from,
+	                            const lak::io_file &to,
+	                            size_t size)
+	{
+		lak::array<byte_t> buffer;
+		buffer.resize(size);
+		size_t read = (co_await queue.async_read(from, 0U, buffer)).UNWRAP();
+		co_return (co_await queue.async_write(
+		             to, 0U, lak::span<const byte_t>(buffer).first(read)))
+		  .UNWRAP();
+	}
+}
+
+BEGIN_TEST(io_queue)
+{
+	const lak::fs::path directory{lak::fs::temp_directory_path() /
+	                              "lak_test_io_queue"};
+	lak::fs::remove_all(directory);
+	lak::fs::create_directories(directory);
+
+	static constexpr size_t file_count = 100U;
+	lak::array<lak::fs::path> paths;
+	for (size_t i = 0; i < file_count; ++i)
+	{
+		paths.push_back(directory / ("file" + std::to_string(i)));
+		ASSERT(lak::save_file(paths.back(), pattern(i * 97U, i)));
+	}
+
+	for (lak::io_backend backend :
+	     {lak::io_backend::thread_pool, lak::io_backend::automatic})
+	{
+		lak::io_queue queue{lak::io_queue_options{
+		  .backend     = backend,
+		  .queue_depth = 16U,
+		}};
+		if (backend == lak::io_backend::thread_pool)
+			ASSERT_EQUAL(queue.backend(), lak::io_backend::thread_pool);
+		ASSERT_EQUAL(queue.queue_depth(), 16U);
+
+		// callbacks, reads past the end of the file come up short
+		{
+			auto file{lak::io_file::open(paths[50]).UNWRAP()};
+			ASSERT_EQUAL(file.size().UNWRAP(), 50U * 97U);
+
+			lak::array<byte_t> buffer;
+			buffer.resize(100U);
+			std::atomic_size_t read = 0U;
+			queue.read(file,
+			           50U * 97U - 40U,
+			           buffer,
+			           [&](lak::io_result result) { read = result.UNWRAP(); });
+			queue.readahead(file, 0U, 50U * 97U);
+			queue.wait_idle();
+			ASSERT_EQUAL(read.load(), 40U);
+			const auto expected{pattern(50U * 97U, 50U)};
+			ASSERT(lak::span<const byte_t>(buffer).first(40U) ==
+			       lak::span<const byte_t>(expected).subspan(50U * 97U - 40U));
+		}
+
+		// batched submits of more operations than the queue depth
+		{
+			lak::array<lak::io_file> files;
+			lak::array<lak::array<byte_t>> buffers;
+			for (size_t i = 0; i < file_count; ++i)
+			{
+				files.push_back(lak::io_file::open(paths[i]).UNWRAP());
+				buffers.emplace_back().resize(i * 97U);
+			}
+
+			std::atomic_size_t completed = 0U;
+			auto on_complete{[&](lak::io_result result)
+			                 {
+				                 result.UNWRAP();
+				                 ++completed;
+			                 }};
+			using callback = lak::io_callback<decltype(on_complete)>;
+
+			lak::array<lak::io_operation *> operations;
+			for (size_t i = 0; i < file_count; ++i)
+			{
+				callback *op{callback::make(on_complete)};
+				op->file   = files[i].native_handle();
+				op->buffer = buffers[i];
+				operations.push_back(op);
+			}
+			queue.submit(lak::span<lak::io_operation *const>(operations));
+			queue.wait_idle();
+
+			ASSERT_EQUAL(completed.load(), file_count);
+			for (size_t i = 0; i < file_count; ++i)
+				ASSERT(buffers[i] == pattern(i * 97U, i));
+		}
+
+		// callbacks that submit more operations than the queue depth
+		{
+			auto file{lak::io_file::open(paths[30]).UNWRAP()};
+
+			struct chained_operation : public lak::io_operation
+			{
+				lak::io_queue *queue;
+				lak::span<chained_operation> chain;
+				std::atomic_size_t *next;
+				std::atomic_size_t *completed;
+				byte_t data[16];
+			};
+
+			std::atomic_size_t next = 1U;
+			std::atomic_size_t completed = 0U;
+			lak::array<chained_operation> chain;
+			chain.resize(1000U);
+			for (auto &op : chain)
+			{
+				op.file      = file.native_handle();
+				op.buffer    = op.data;
+				op.queue     = &queue;
+				op.chain     = chain;
+				op.next      = &next;
+				op.completed = &completed;
+				op._complete = [](lak::io_operation *o, lak::io_result result)
+				{
+					auto *op{static_cast<chained_operation *>(o)};
+					ASSERT_EQUAL(result.UNWRAP(), 16U);
+					++*op->completed;
+					for (size_t i = 0; i < 2U; ++i)
+						if (const size_t index{op->next->fetch_add(1U)};
+						    index < op->chain.size())
+							op->queue->submit(op->chain[index]);
+				};
+			}
+			queue.submit(chain[0]);
+			queue.wait_idle();
+			ASSERT_EQUAL(completed.load(), chain.size());
+			const auto expected{pattern(30U * 97U, 30U)};
+			for (const auto &op : chain)
+				ASSERT(lak::span<const byte_t>(op.data) ==
+				       lak::span<const byte_t>(expected).first(16U));
+		}
+
+		// opening through the queue
+		{
+			struct open_operation : public lak::io_operation
+			{
+				lak::optional<lak::io_result> result;
+			} op;
+			op.kind      = lak::io_kind::open;
+			op.path      = &paths[20];
+			op._complete = [](lak::io_operation *o, lak::io_result result)
+			{ static_cast<open_operation *>(o)->result = lak::move(result); };
+			queue.submit(op);
+			queue.wait_idle();
+			ASSERT_EQUAL(op.result->UNWRAP(), 20U * 97U);
+			auto file{lak::io_file::adopt(op.file)};
+			ASSERT(file.is_open());
+			ASSERT_EQUAL(file.size().UNWRAP(), 20U * 97U);
+		}
+
+		// registered buffers
+		{
+			auto file{lak::io_file::open(paths[10]).UNWRAP()};
+			lak::array<byte_t> buffer;
+			buffer.resize(10U * 97U);
+			const lak::span<byte_t> buffers[]{buffer};
+			const bool registered{queue.register_buffers(buffers).is_ok()};
+
+			auto on_complete{[](lak::io_result result)
+			                 { ASSERT_EQUAL(result.UNWRAP(), 10U * 97U); }};
+			auto *op{lak::io_callback<decltype(on_complete)>::make(on_complete)};
+			op->file         = file.native_handle();
+			op->buffer       = buffer;
+			op->buffer_index = registered ? 0 : -1;
+			queue.submit(*op);
+			queue.wait_idle();
+			ASSERT(buffer == pattern(10U * 97U, 10U));
+			if (registered) queue.unregister_buffers();
+		}
+
+		// awaitables
+		{
+			const lak::fs::path copy{directory / "copy"};
+			{
+				auto from{lak::io_file::open(paths[99]).UNWRAP()};
+				auto to{
+				  lak::io_file::open(copy, lak::io_file::mode::write).UNWRAP()};
+				ASSERT_EQUAL(
+				  lak::sync_wait(copy_file(queue, from, to, 99U * 97U))
+				    .UNWRAP(),
+				  99U * 97U);
+			}
+			ASSERT(lak::read_file(copy).UNWRAP() == pattern(99U * 97U, 99U));
+			lak::fs::remove(copy);
+		}
+
+		// load_files
+		{
+			lak::array<lak::fs::path> load_paths{paths};
+			load_paths.push_back(directory / "missing");
+
+			std::mutex mutex;
+			lak::array<size_t> loaded;
+			size_t failed = 0U;
+			lak::load_files(
+			  queue,
+			  load_paths,
+			  [&](size_t index,
+			      lak::error_code_result<lak::array<byte_t>> result)
+			  {
+				  std::lock_guard lock(mutex);
+				  if (index == file_count)
+				  {
+					  ASSERT(result.is_err());
+					  ++failed;
+					  return;
+				  }
+				  ASSERT(result.UNWRAP() == pattern(index * 97U, index));
+				  loaded.push_back(index);
+			  });
+			ASSERT_EQUAL(loaded.size(), file_count);
+			ASSERT_EQUAL(failed, 1U);
+		}
+
+		// load_directory
+		{
+			std::atomic_size_t loaded = 0U;
+			lak::load_directory(
+			  queue,
+			  directory,
+			  [&](const lak::fs::path &path,
+			      lak::error_code_result<lak::array<byte_t>> result)
+			  {
+				  const size_t index{
+				    std::stoul(path.filename().string().substr(4U))};
+				  ASSERT(result.UNWRAP() == pattern(index * 97U, index));
+				  ++loaded;
+			  })
+			  .UNWRAP();
+			ASSERT_EQUAL(loaded.load(), file_count);
+
+			ASSERT(lak::load_directory(queue,
+			                           directory / "missing",
+			                           [](const lak::fs::path &, auto) {})
+			         .is_err());
+		}
+	}
+
+	lak::fs::remove_all(directory);
+
+	return 0;
+}
+END_TEST()
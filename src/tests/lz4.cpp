@@ -0,0 +1,258 @@
+#include "lak/compression/lz4.hpp"
+#include "lak/xxhash.hpp"
+
+#include "lak/test.hpp"
+
+namespace
+{
+	// "lak lz4 frame, lak lz4 frame, lak lz4 frame!\n" compressed by the lz4
+	// command line tool with block checksums, content size and content
+	// checksum
+	constexpr uint8_t reference_frame[] = {
+	  0x04, 0x22, 0x4D, 0x18, 0x7C, 0x40, 0x2D, 0x00, 0x00, 0x00, 0x00, 0x00,
+	  0x00, 0x00, 0x63, 0x1A, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x6C, 0x61, 0x6B,
+	  0x20, 0x6C, 0x7A, 0x34, 0x20, 0x66, 0x72, 0x61, 0x6D, 0x65, 0x2C, 0x20,
+	  0x0F, 0x00, 0x06, 0x50, 0x61, 0x6D, 0x65, 0x21, 0x0A, 0x49, 0x5F, 0xB8,
+	  0x6E, 0x00, 0x00, 0x00, 0x00, 0xEA, 0x46, 0xBB, 0xB2};
+
+	lak::array<byte_t> to_bytes(const char *str)
+	{
+		lak::array<byte_t> result;
+		for (; *str; ++str) result.push_back(byte_t(*str));
+		return result;
+	}
+
+	// long enough to span several blocks, with runs of compressible and
+	// incompressible data
+	lak::array<byte_t> test_data(size_t size)
+	{
+		lak::array<byte_t> result;
+		for (uint32_t x = 1U; result.size() < size;)
+		{
+			x = (x * 1103515245U + 12345U) & 0x7FFF'FFFFU;
+			if ((result.size() / 50000U) % 2U == 0U)
+				result.push_back(byte_t(x >> 16U));
+			else
+				result.push_back(byte_t('a' + (x >> 16U) % 4U));
+		}
+		return result;
+	}
+}
+
+BEGIN_TEST(xxhash)
+{
+	ASSERT_EQUAL(lak::xxhash32({}), 0x02CC'5D05U);
+	ASSERT_EQUAL(lak::xxhash32(to_bytes("abc")), 0x32D1'53FFU);
+	ASSERT_EQUAL(lak::xxhash32(to_bytes("abc"), 1U),
+	             lak::xxhash32(to_bytes("abc"), 1U));
+	ASSERT_NOT_EQUAL(lak::xxhash32(to_bytes("abc"), 1U),
+	                 lak::xxhash32(to_bytes("abc")));
+
+	return 0;
+}
+END_TEST()
+
+BEGIN_TEST(lz4_block)
+{
+	const lak::array<byte_t> inputs[] = {
+	  {},
+	  to_bytes("short"),
+	  to_bytes("exactly thirteen bytes of literals then a match, then a match"),
+	  test_data(200000U)};
+
+	for (const auto &input : inputs)
+	{
+		for (lak::lz4_mode mode :
+		     {lak::lz4_mode::fast, lak::lz4_mode::high_compression})
+		{
+			for (uint32_t acceleration : {1U, 8U})
+			{
+				const lak::array<byte_t> compressed{
+				  lak::encode_lz4_block(input, mode, acceleration)};
+				ASSERT_LESS_OR_EQUAL(compressed.size(),
+				                     lak::lz4_compress_bound(input.size()));
+				ASSERT_ARRAY_EQUAL(
+				  lak::decode_lz4_block(lak::binary_reader(compressed), input.size())
+				    .UNWRAP(),
+				  input);
+			}
+		}
+	}
+
+	// short and overlapping match offsets, ending at every distance from the
+	// end of the output
+	for (size_t period = 1U; period <= 20U; ++period)
+	{
+		for (size_t size = 20U; size < 80U; size += 7U)
+		{
+			lak::array<byte_t> input;
+			for (size_t i = 0U; i < size; ++i)
+				input.push_back(byte_t('a' + (i % period)));
+			ASSERT_ARRAY_EQUAL(
+			  lak::decode_lz4_block(lak::binary_reader(lak::encode_lz4_block(input)),
+			                        input.size())
+			    .UNWRAP(),
+			  input);
+		}
+	}
+
+	// matches across the dictionary
+	const lak::array<byte_t> dictionary{to_bytes("the quick brown fox")};
+	const lak::array<byte_t> data{to_bytes("jumps over the quick brown fox")};
+	lak::array<byte_t> compressed;
+	lak::encode_lz4_block(
+	  data, &compressed, lak::lz4_mode::fast, 1U, dictionary);
+	ASSERT_LESS(compressed.size(), data.size());
+
+	// decoding into a caller's buffer
+	lak::array<byte_t> decoded(data.size());
+	ASSERT_EQUAL(lak::decode_lz4_block(lak::binary_reader(compressed),
+	                                   lak::span(decoded),
+	                                   dictionary)
+	               .UNWRAP(),
+	             data.size());
+	ASSERT_ARRAY_EQUAL(decoded, data);
+	ASSERT(lak::decode_lz4_block(lak::binary_reader(compressed),
+	                             lak::span(decoded))
+	         .UNWRAP_ERR() == lak::lz4_decode_error::offset_too_large);
+	ASSERT(lak::decode_lz4_block(lak::binary_reader(compressed),
+	                             lak::span(decoded).first(data.size() - 1U),
+	                             dictionary)
+	         .UNWRAP_ERR() == lak::lz4_decode_error::output_full);
+
+	// a match that starts in the dictionary and continues into the output
+	const lak::array<byte_t> pattern{to_bytes("abcdefgh")};
+	const lak::array<byte_t> repeated{to_bytes("efghabcdefghabcdefghabcd0123")};
+	compressed.clear();
+	lak::encode_lz4_block(
+	  repeated, &compressed, lak::lz4_mode::fast, 1U, pattern);
+	decoded.resize(repeated.size());
+	ASSERT_EQUAL(lak::decode_lz4_block(
+	               lak::binary_reader(compressed), lak::span(decoded), pattern)
+	               .UNWRAP(),
+	             repeated.size());
+	ASSERT_ARRAY_EQUAL(decoded, repeated);
+
+	// a short offset match that lies entirely in the dictionary
+	const lak::array<byte_t> short_dictionary{to_bytes("abcdefg")};
+	const uint8_t short_match[] = {
+	  0x00, 0x07, 0x00, 0x50, 'v', 'w', 'x', 'y', 'z'};
+	const lak::array<byte_t> short_expected{to_bytes("abcdvwxyz")};
+	decoded.clear();
+	decoded.resize(64U);
+	ASSERT_EQUAL(
+	  lak::decode_lz4_block(lak::binary_reader(lak::as_bytes(&short_match)),
+	                        lak::span(decoded),
+	                        short_dictionary)
+	    .UNWRAP(),
+	  9U);
+	ASSERT_ARRAY_EQUAL(lak::span(decoded).first(9U),
+	                   lak::span(short_expected));
+
+	// appending linked blocks
+	lak::array<byte_t> appended{dictionary};
+	compressed.clear();
+	lak::encode_lz4_block(
+	  data, &compressed, lak::lz4_mode::fast, 1U, dictionary);
+	ASSERT_EQUAL(lak::decode_lz4_block(
+	               lak::binary_reader(compressed), &appended, 1000U, true)
+	               .UNWRAP(),
+	             data.size());
+	ASSERT_EQUAL(appended.size(), dictionary.size() + data.size());
+	ASSERT_ARRAY_EQUAL(lak::span(appended).subspan(dictionary.size()),
+	                   lak::span(data));
+
+	// compression actually happens
+	const lak::array<byte_t> large{test_data(200000U)};
+	const size_t fast_size{lak::encode_lz4_block(large).size()};
+	const size_t high_size{
+	  lak::encode_lz4_block(large, lak::lz4_mode::high_compression).size()};
+	ASSERT_LESS(fast_size, large.size() * 9U / 10U);
+	ASSERT_LESS_OR_EQUAL(high_size, fast_size);
+
+	return 0;
+}
+END_TEST()
+
+BEGIN_TEST(lz4_frame)
+{
+	ASSERT_ARRAY_EQUAL(
+	  lak::decode_lz4_frame(lak::binary_reader(lak::as_bytes(&reference_frame)))
+	    .UNWRAP(),
+	  to_bytes("lak lz4 frame, lak lz4 frame, lak lz4 frame!\n"));
+
+	const lak::array<byte_t> inputs[] = {
+	  {}, to_bytes("short"), test_data(300000U)};
+
+	for (const auto &input : inputs)
+	{
+		for (uint8_t flags = 0U; flags < 16U; ++flags)
+		{
+			const bool high_compression{(flags & 1U) != 0U};
+			lak::lz4_frame_options options;
+			options.mode = high_compression ? lak::lz4_mode::high_compression
+			                                : lak::lz4_mode::fast;
+			options.linked_blocks    = (flags & 2U) != 0U;
+			options.block_checksums  = (flags & 4U) != 0U;
+			options.content_size     = (flags & 8U) != 0U;
+			options.content_checksum = !high_compression;
+			options.block_size       = options.linked_blocks
+			                             ? lak::lz4_block_size::max_1MiB
+			                             : lak::lz4_block_size::max_64KiB;
+
+			const lak::array<byte_t> compressed{
+			  lak::encode_lz4_frame(input, options)};
+			ASSERT_ARRAY_EQUAL(
+			  lak::decode_lz4_frame(lak::binary_reader(compressed)).UNWRAP(),
+			  input);
+		}
+	}
+
+	// skippable frames are ignored
+	const lak::array<byte_t> data{test_data(1000U)};
+	lak::array<byte_t> framed;
+	for (uint8_t b : {0x50, 0x2A, 0x4D, 0x18, 0x03, 0x00, 0x00, 0x00, 1, 2, 3})
+		framed.push_back(byte_t(b));
+	for (byte_t b : lak::encode_lz4_frame(data)) framed.push_back(b);
+	ASSERT_ARRAY_EQUAL(
+	  lak::decode_lz4_frame(lak::binary_reader(framed)).UNWRAP(), data);
+
+	// corruption is detected
+	lak::lz4_frame_options options;
+	options.block_checksums = true;
+	const lak::array<byte_t> compressed{lak::encode_lz4_frame(data, options)};
+	auto corrupt = [&](size_t index) -> lak::lz4_decode_error
+	{
+		lak::array<byte_t> copy{compressed};
+		copy[index] = byte_t(uint8_t(copy[index]) ^ 0x01U);
+		return lak::decode_lz4_frame(lak::binary_reader(copy)).UNWRAP_ERR();
+	};
+	ASSERT(corrupt(0U) == lak::lz4_decode_error::invalid_magic);
+	ASSERT(corrupt(5U) == lak::lz4_decode_error::unsupported_frame);
+	ASSERT(corrupt(6U) == lak::lz4_decode_error::header_checksum_mismatch);
+	ASSERT(corrupt(12U) == lak::lz4_decode_error::block_checksum_mismatch);
+	ASSERT(corrupt(compressed.size() - 1U) ==
+	       lak::lz4_decode_error::content_checksum_mismatch);
+
+	// the declared content size isn't trusted
+	lak::lz4_frame_options sized;
+	sized.content_size = true;
+	lak::array<byte_t> huge{lak::encode_lz4_frame({}, sized)};
+	huge[12U] = byte_t(0x10U); // 2^52 bytes
+	huge[14U] = byte_t(uint8_t(
+	  lak::xxhash32(lak::span<const byte_t>(huge).subspan(4U, 10U)) >> 8U));
+	ASSERT(lak::decode_lz4_frame(lak::binary_reader(huge)).UNWRAP_ERR() ==
+	       lak::lz4_decode_error::content_size_mismatch);
+
+	// even when there's plenty of frame left to decode
+	sized.block_size = lak::lz4_block_size::max_4MiB;
+	huge             = lak::encode_lz4_frame(test_data(1U << 20U), sized);
+	for (size_t i = 6U; i < 14U; ++i) huge[i] = byte_t(0xFFU);
+	huge[14U] = byte_t(uint8_t(
+	  lak::xxhash32(lak::span<const byte_t>(huge).subspan(4U, 10U)) >> 8U));
+	ASSERT(lak::decode_lz4_frame(lak::binary_reader(huge)).UNWRAP_ERR() ==
+	       lak::lz4_decode_error::content_size_mismatch);
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,66 @@
+#include "lak/memmanip.hpp"
+
+#include "lak/array.hpp"
+#include "lak/os.hpp"
+#include "lak/test.hpp"
+
+BEGIN_TEST(page_reserve)
+{
+	size_t page_size{0U};
+	auto pages{lak::page_reserve(10000U, &page_size).UNWRAP()};
+	ASSERT_EQUAL(page_size, lak::page_size());
+	ASSERT_EQUAL(pages.size() % page_size, 0U);
+	ASSERT_GREATER_OR_EQUAL(pages.size(), 10000U);
+	ASSERT(lak::page_commit(pages).is_ok());
+	lak::span<byte_t> bytes(pages);
+	for (byte_t &b : bytes) b = byte_t(0xAA);
+	ASSERT(lak::page_free(pages).is_ok());
+
+	return 0;
+}
+END_TEST()
+
+BEGIN_TEST(page_reserve_huge)
+{
+	const size_t huge_size{lak::huge_page_size()};
+	const size_t size{huge_size ? huge_size * 2U : 1024U * 1024U};
+
+	auto pages{
+	  lak::page_reserve(size, lak::page_options{.transparent_huge_pages = true})
+	    .UNWRAP()};
+	if (huge_size) ASSERT_EQUAL(uintptr_t(pages.data()) % huge_size, 0U);
+	ASSERT(lak::page_commit(pages).is_ok());
+	lak::span<byte_t> bytes(pages);
+	for (byte_t &b : bytes) b = byte_t(1);
+	ASSERT(lak::page_free(pages).is_ok());
+
+#ifdef LAK_OS_LINUX
+	// node 0 always exists
+	auto bound{
+	  lak::page_reserve(size, lak::page_options{.numa_node = 0}).UNWRAP()};
+	ASSERT(lak::page_commit(bound).is_ok());
+	ASSERT(lak::page_free(bound).is_ok());
+#endif
+
+	// the explicit huge page pool is usually empty, but the reservation must
+	// be a whole number of huge pages if it succeeds
+	size_t explicit_size{0U};
+	if (auto explicit_pages{lak::page_reserve(
+	      1U, lak::page_options{.explicit_page_size = 2U * 1024U * 1024U},
+	      &explicit_size)};
+	    explicit_pages.is_ok())
+	{
+		ASSERT_EQUAL(explicit_size, 2U * 1024U * 1024U);
+		ASSERT_EQUAL(explicit_pages.unsafe_unwrap().size(), explicit_size);
+		ASSERT(lak::page_free(explicit_pages.unsafe_unwrap()).is_ok());
+	}
+
+	// large arrays are reserved on huge pages
+	lak::array<uint32_t> array;
+	array.resize(size / sizeof(uint32_t) + 1U);
+	for (size_t i = 0; i < array.size(); ++i) array[i] = uint32_t(i);
+	for (size_t i = 0; i < array.size(); ++i) ASSERT_EQUAL(array[i], i);
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,87 @@
+#include "lak/mpmc_buffer.hpp"
+
+#include "lak/array.hpp"
+#include "lak/test.hpp"
+
+#include <memory>
+#include <thread>
+
+BEGIN_TEST(mpmc_buffer)
+{
+	{
+		lak::mpmc_buffer<int, 4> buffer;
+		ASSERT(buffer.empty());
+		ASSERT(buffer.try_push(1));
+		ASSERT(buffer.try_push(2));
+		ASSERT_EQUAL(buffer.size(), 2U);
+		auto front{buffer.try_pop()};
+		ASSERT(front.has_value());
+		ASSERT_EQUAL(*front, 1);
+
+		int values[] = {3, 4, 5, 6};
+		ASSERT_EQUAL(buffer.try_push_batch(lak::span<int>(values)), 3U);
+		ASSERT(!buffer.try_push(7));
+
+		int out[8] = {};
+		ASSERT_EQUAL(buffer.try_pop_batch(lak::span<int>(out)), 4U);
+		ASSERT_EQUAL(out[0], 2);
+		ASSERT_EQUAL(out[3], 5);
+		ASSERT(!buffer.try_pop().has_value());
+	}
+
+	{
+		auto counter{std::make_shared<int>(0)};
+		{
+			lak::mpmc_buffer<std::shared_ptr<int>, 2> buffer;
+			ASSERT(buffer.try_push(counter));
+			ASSERT_EQUAL(counter.use_count(), 2);
+		}
+		ASSERT_EQUAL(counter.use_count(), 1);
+	}
+
+	{
+		// every value pushed by every producer is popped exactly once
+		constexpr size_t threads = 4U;
+		constexpr size_t count   = 20000U;
+		lak::mpmc_buffer<size_t, 128> buffer;
+		std::atomic_size_t popped = 0U;
+		std::atomic_size_t sum    = 0U;
+
+		lak::array<std::thread> workers;
+		for (size_t t = 0U; t < threads; ++t)
+		{
+			workers.push_back(std::thread(
+			  [&, t]
+			  {
+				  for (size_t i = 0U; i < count; i += 2U)
+				  {
+					  size_t batch[] = {t * count + i, t * count + i + 1U};
+					  size_t pushed  = 0U;
+					  while (pushed < 2U)
+						  pushed += buffer.try_push_batch(
+						    lak::span<size_t>(batch + pushed, 2U - pushed));
+				  }
+			  }));
+			workers.push_back(std::thread(
+			  [&]
+			  {
+				  size_t out[8];
+				  while (popped.load() < threads * count)
+				  {
+					  size_t n = buffer.try_pop_batch(lak::span<size_t>(out));
+					  for (size_t i = 0U; i < n; ++i) sum += out[i];
+					  popped += n;
+				  }
+			  }));
+		}
+		for (auto &worker : workers) worker.join();
+
+		const size_t total = threads * count;
+		ASSERT_EQUAL(popped.load(), total);
+		ASSERT_EQUAL(sum.load(), total * (total - 1U) / 2U);
+		ASSERT(buffer.empty());
+	}
+
+	return 0;
+}
+END_TEST()
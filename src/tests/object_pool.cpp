@@ -0,0 +1,83 @@
+#include "lak/object_pool.hpp"
+
+#include "lak/array.hpp"
+#include "lak/bank_ptr.hpp"
+#include "lak/test.hpp"
+
+#include <thread>
+
+namespace
+{
+	struct pooled
+	{
+		static inline std::atomic_int live = 0;
+		size_t value;
+		pooled(size_t v) : value(v) { ++live; }
+		~pooled() { --live; }
+	};
+}
+
+BEGIN_TEST(object_pool)
+{
+	using pool = lak::object_pool<pooled>;
+
+	pooled *a{pool::create(1U)};
+	ASSERT_EQUAL(a->value, 1U);
+	pool::destroy(a);
+	// the most recently freed slot is reused first
+	pooled *b{pool::create(2U)};
+	ASSERT_EQUAL((void *)a, (void *)b);
+	pool::destroy(b);
+
+	{
+		// enough to cycle magazines through the depot and allocate more slabs
+		lak::array<pooled *> values;
+		for (size_t i = 0; i < pool::slab_size * 3U; ++i)
+			values.push_back(pool::create(i));
+		for (size_t i = 0; i < values.size(); ++i)
+			ASSERT_EQUAL(values[i]->value, i);
+		ASSERT_EQUAL(size_t(pooled::live.load()), values.size());
+
+		// slots can be freed from another thread
+		std::thread([&] { for (auto *v : values) pool::destroy(v); }).join();
+		ASSERT_EQUAL(pooled::live.load(), 0);
+	}
+
+	{
+		lak::array<std::thread> threads;
+		for (size_t t = 0; t < 4U; ++t)
+			threads.push_back(std::thread(
+			  [t]
+			  {
+				  lak::array<pooled *> values;
+				  for (size_t round = 0; round < 10U; ++round)
+				  {
+					  for (size_t i = 0; i < 1000U; ++i)
+						  values.push_back(pool::create(t * 1000U + i));
+					  for (size_t i = 0; i < 1000U; ++i)
+						  ASSERT_EQUAL(values[i]->value, t * 1000U + i);
+					  for (auto *v : values) pool::destroy(v);
+					  values.clear();
+				  }
+			  }));
+		for (auto &thread : threads) thread.join();
+		ASSERT_EQUAL(pooled::live.load(), 0);
+	}
+
+	{
+		// the bank pointers allocate from the pool
+		auto unique{lak::unique_bank_ptr<pooled>::create(5U)};
+		ASSERT_EQUAL(unique->value, 5U);
+		ASSERT_EQUAL(pooled::live.load(), 1);
+		lak::shared_bank_ptr<pooled> shared{lak::move(unique)};
+		ASSERT(!unique);
+		auto copy{shared};
+		shared.reset();
+		ASSERT_EQUAL(copy->value, 5U);
+		copy.reset();
+		ASSERT_EQUAL(pooled::live.load(), 0);
+	}
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,81 @@
+#include "lak/parallel_algorithm.hpp"
+
+#include "lak/array.hpp"
+#include "lak/test.hpp"
+
+#include <string>
+
+BEGIN_TEST(parallel_algorithm)
+{
+	lak::tasks pool(4U);
+
+	lak::array<uint32_t> values;
+	values.resize(100000U);
+	uint32_t seed = 0x12345678U;
+	for (auto &v : values)
+	{
+		seed = seed * 1664525U + 1013904223U;
+		v    = seed >> 16U;
+	}
+
+	lak::array<uint64_t> doubled;
+	doubled.resize(values.size());
+	ASSERT_EQUAL(lak::parallel_transform(pool,
+	                                     values.begin(),
+	                                     values.end(),
+	                                     doubled.begin(),
+	                                     [](uint32_t v) { return uint64_t(v) * 2U; }),
+	             doubled.end());
+
+	uint64_t expected_sum = 0U;
+	for (size_t i = 0; i < values.size(); ++i)
+	{
+		ASSERT_EQUAL(doubled[i], uint64_t(values[i]) * 2U);
+		expected_sum += values[i];
+	}
+
+	ASSERT_EQUAL(lak::parallel_accumulate(
+	               pool, values.begin(), values.end(), uint64_t(0U)),
+	             expected_sum);
+
+	// folds that only take (T, value_type) need a separate combine
+	lak::array<std::string> strings;
+	size_t expected_length = 0U;
+	for (size_t i = 0; i < 20000U; ++i)
+	{
+		strings.push_back(std::string(i % 7U, 'x'));
+		expected_length += i % 7U;
+	}
+	ASSERT_EQUAL(
+	  lak::parallel_accumulate(
+	    pool,
+	    strings.begin(),
+	    strings.end(),
+	    size_t(3U),
+	    [](size_t acc, const std::string &s) { return acc + s.size(); },
+	    std::plus<>{}),
+	  expected_length + 3U);
+
+	ASSERT_EQUAL(lak::parallel_count(pool, values.begin(), values.end(), 7U),
+	             lak::count(values.begin(), values.end(), 7U));
+
+	lak::parallel_for(pool, doubled.begin(), doubled.end(), [](auto &v) { ++v; });
+	for (size_t i = 0; i < values.size(); ++i)
+		ASSERT_EQUAL(doubled[i], uint64_t(values[i]) * 2U + 1U);
+
+	lak::array<uint32_t> sorted{values};
+	lak::parallel_sort(pool, sorted.begin(), sorted.end());
+	for (size_t i = 1; i < sorted.size(); ++i)
+		ASSERT_LESS_OR_EQUAL(sorted[i - 1], sorted[i]);
+	ASSERT_EQUAL(lak::parallel_accumulate(
+	               pool, sorted.begin(), sorted.end(), uint64_t(0U)),
+	             expected_sum);
+
+	lak::parallel_sort(
+	  pool, sorted.begin(), sorted.end(), [](auto a, auto b) { return a > b; });
+	for (size_t i = 1; i < sorted.size(); ++i)
+		ASSERT_GREATER_OR_EQUAL(sorted[i - 1], sorted[i]);
+
+	return 0;
+}
+END_TEST()
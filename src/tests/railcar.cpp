@@ -0,0 +1,76 @@
+#include "lak/railcar.hpp"
+
+#include "lak/test.hpp"
+
+BEGIN_TEST(railcar)
+{
+	{
+		lak::railcar<int> railcar(100U);
+		ASSERT_EQUAL(railcar.bin_size(), 128U);
+		for (int i = 0; i < 1000; ++i) railcar.push_back(i);
+		ASSERT_EQUAL(railcar.size(), 1000U);
+		for (int i = 0; i < 1000; ++i) ASSERT_EQUAL(railcar[i], i);
+
+		// elements never move as the railcar grows
+		const int *first{&railcar[0]};
+		for (int i = 1000; i < 5000; ++i) railcar.push_back(i);
+		ASSERT_EQUAL(&railcar[0], first);
+
+		railcar.erase(&railcar[10]);
+		ASSERT_EQUAL(railcar.size(), 4999U);
+		ASSERT_EQUAL(railcar[10], 11);
+		ASSERT_EQUAL(railcar[127], 128);
+		ASSERT_EQUAL(railcar[128], 129);
+		ASSERT_EQUAL(railcar.back(), 4999);
+
+		int expected = 0;
+		for (int value : railcar)
+		{
+			if (expected == 10) ++expected;
+			ASSERT_EQUAL(value, expected++);
+		}
+
+		// copies keep the bin size
+		lak::railcar<int> copy{railcar};
+		ASSERT_EQUAL(copy.bin_size(), 128U);
+		ASSERT_EQUAL(copy.size(), railcar.size());
+		ASSERT_EQUAL(copy[4000], railcar[4000]);
+
+		// cleared bins are reused
+		railcar.clear();
+		ASSERT(railcar.empty());
+		railcar.push_back(-1);
+		ASSERT_EQUAL(railcar[0], -1);
+		ASSERT_EQUAL(railcar.size(), 1U);
+
+		railcar.resize(300U);
+		ASSERT_EQUAL(railcar.size(), 300U);
+		railcar.resize(10U);
+		ASSERT_EQUAL(railcar.size(), 10U);
+		ASSERT_EQUAL(railcar[0], -1);
+		railcar.shrink_to_fit();
+	}
+
+	{
+		struct large
+		{
+			char data[10000];
+		};
+		lak::railcar<large> railcar;
+		railcar.emplace_back();
+		// large elements still get several per bin
+		ASSERT_EQUAL(railcar.bin_size(), 8U);
+	}
+
+	{
+		lak::railcar<char> railcar;
+		railcar.reserve(100000U);
+		const size_t bin_size{railcar.bin_size()};
+		ASSERT_EQUAL(bin_size & (bin_size - 1U), 0U);
+		for (size_t i = 0; i < 100000U; ++i) railcar.push_back(char(i));
+		for (size_t i = 0; i < 100000U; ++i) ASSERT_EQUAL(railcar[i], char(i));
+	}
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,117 @@
+#include "lak/slot_map.hpp"
+
+#include "lak/bank_ptr.hpp"
+#include "lak/test.hpp"
+
+static_assert(sizeof(lak::slot_handle) == sizeof(uint32_t));
+
+BEGIN_TEST(slot_map)
+{
+	lak::slot_map<int> map;
+	ASSERT(!map.contains(lak::slot_handle{}));
+
+	lak::array<lak::slot_handle> handles;
+	for (int i = 0; i < 100; ++i) handles.push_back(map.insert(i));
+	ASSERT_EQUAL(map.size(), 100U);
+	for (int i = 0; i < 100; ++i) ASSERT_EQUAL(*map.get(handles[i]), i);
+
+	// erasing keeps the values dense and the other handles valid
+	for (int i = 0; i < 100; i += 2) ASSERT(map.erase(handles[i]));
+	ASSERT_EQUAL(map.size(), 50U);
+	ASSERT(!map.erase(handles[0]));
+	int sum = 0;
+	for (int value : map) sum += value;
+	ASSERT_EQUAL(sum, 50 * 50);
+	for (int i = 0; i < 100; ++i)
+	{
+		ASSERT_EQUAL(map.contains(handles[i]), i % 2 == 1);
+		if (i % 2 == 1) ASSERT_EQUAL(*map.get(handles[i]), i);
+	}
+	for (size_t i = 0; i < map.size(); ++i)
+		ASSERT_EQUAL(map.get(map.handle_at(i)), map.data() + i);
+
+	// reused slots don't resolve stale handles
+	const lak::slot_handle reused{map.insert(-1)};
+	ASSERT_EQUAL(reused.index(), handles[98].index());
+	ASSERT_EQUAL(map.get(handles[98]), nullptr);
+	ASSERT_EQUAL(*map.get(reused), -1);
+
+	// generations wrap around, slots are reused forever
+	{
+		lak::slot_map<int> small;
+		const lak::slot_handle first{small.insert(0)};
+		lak::slot_handle handle{first};
+		for (uint32_t i = 0; i < lak::slot_handle::max_generation; ++i)
+		{
+			ASSERT(small.erase(handle));
+			handle = small.insert(0);
+			ASSERT_EQUAL(handle.index(), 0U);
+			ASSERT(!small.contains(first));
+		}
+		ASSERT(small.erase(handle));
+		handle = small.insert(0);
+		ASSERT_EQUAL(handle.index(), 0U);
+		ASSERT_EQUAL(handle.generation(), 0U);
+		ASSERT(!handle.is_null());
+	}
+
+	map.clear();
+	ASSERT(map.empty());
+	ASSERT(!map.contains(reused));
+	ASSERT(!map.contains(handles[1]));
+
+	return 0;
+}
+END_TEST()
+
+namespace
+{
+	struct entity
+	{
+		int value;
+	};
+}
+
+BEGIN_TEST(bank)
+{
+	lak::array<lak::unique_bank_ptr<entity>> entities;
+	for (int i = 0; i < 1000; ++i)
+		entities.push_back(lak::unique_bank_ptr<entity>::create(entity{i}));
+	ASSERT_EQUAL(lak::bank<entity>::size(), 1000U);
+
+	const lak::slot_handle destroyed{entities[10].handle()};
+	entities[10].reset();
+	ASSERT_EQUAL(lak::bank<entity>::get(destroyed), nullptr);
+	ASSERT_EQUAL(lak::bank<entity>::get(entities[11].handle()),
+	             entities[11].get());
+
+	entity *raw{entities[20].release()};
+	ASSERT_EQUAL(lak::bank<entity>::handle_of(raw).is_null(), false);
+	auto adopted{lak::unique_bank_ptr<entity>::from_raw_bank_ptr(raw)};
+	ASSERT_EQUAL(adopted->value, 20);
+
+	ASSERT_EQUAL(
+	  lak::bank<entity>::find_if([](const entity &e) { return e.value == 500; }),
+	  entities[500].get());
+
+	int count = 0;
+	lak::bank<entity>::for_each([&](entity &) { ++count; });
+	ASSERT_EQUAL(count, 999);
+
+	{
+		auto shared{lak::shared_bank_ptr<entity>::create(entity{-1})};
+		auto copy{shared};
+		const lak::slot_handle handle{shared.handle()};
+		shared.reset();
+		ASSERT_EQUAL(lak::bank<entity>::get(handle), copy.get());
+		copy.reset();
+		ASSERT_EQUAL(lak::bank<entity>::get(handle), nullptr);
+	}
+
+	adopted.reset();
+	entities.clear();
+	ASSERT_EQUAL(lak::bank<entity>::size(), 0U);
+
+	return 0;
+}
+END_TEST()
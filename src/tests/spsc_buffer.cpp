@@ -0,0 +1,73 @@
+#include "lak/spsc_buffer.hpp"
+
+#include "lak/test.hpp"
+
+#include <memory>
+#include <thread>
+
+BEGIN_TEST(spsc_buffer)
+{
+	{
+		lak::spsc_buffer<int, 4> buffer;
+		ASSERT(buffer.empty());
+		ASSERT(buffer.try_push(1));
+		ASSERT(buffer.try_push(2));
+		ASSERT_EQUAL(buffer.size(), 2U);
+		auto front{buffer.try_pop()};
+		ASSERT(front.has_value());
+		ASSERT_EQUAL(*front, 1);
+
+		int values[] = {3, 4, 5, 6};
+		ASSERT_EQUAL(buffer.try_push_batch(lak::span<int>(values)), 3U);
+		ASSERT(!buffer.try_push(7));
+
+		int out[8] = {};
+		ASSERT_EQUAL(buffer.try_pop_batch(lak::span<int>(out)), 4U);
+		ASSERT_EQUAL(out[0], 2);
+		ASSERT_EQUAL(out[3], 5);
+		ASSERT(!buffer.try_pop().has_value());
+	}
+
+	{
+		// values left in the buffer are destroyed with it
+		auto counter{std::make_shared<int>(0)};
+		{
+			lak::spsc_buffer<std::shared_ptr<int>, 2> buffer;
+			ASSERT(buffer.try_push(counter));
+			ASSERT_EQUAL(counter.use_count(), 2);
+		}
+		ASSERT_EQUAL(counter.use_count(), 1);
+	}
+
+	{
+		constexpr size_t count = 100000U;
+		lak::spsc_buffer<size_t, 64> buffer;
+
+		std::thread producer(
+		  [&]
+		  {
+			  size_t batch[16];
+			  for (size_t i = 0U; i < count;)
+			  {
+				  size_t n = std::min<size_t>(16U, count - i);
+				  for (size_t j = 0U; j < n; ++j) batch[j] = i + j;
+				  size_t pushed = 0U;
+				  while (pushed < n)
+					  pushed += buffer.try_push_batch(
+					    lak::span<size_t>(batch + pushed, n - pushed));
+				  i += n;
+			  }
+		  });
+
+		size_t expected = 0U;
+		while (expected < count)
+			if (auto value{buffer.try_pop()}; value.has_value())
+				ASSERT_EQUAL(*value, expected++);
+
+		producer.join();
+		ASSERT(buffer.empty());
+	}
+
+	return 0;
+}
+END_TEST()
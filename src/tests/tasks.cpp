@@ -0,0 +1,107 @@
+#include "lak/tasks.hpp"
+
+#include "lak/array.hpp"
+#include "lak/test.hpp"
+
+#include <atomic>
+
+BEGIN_TEST(tasks)
+{
+	std::atomic_size_t counter = 0U;
+
+	{
+		lak::tasks pool(4U, 16U);
+		ASSERT_EQUAL(pool.size(), 4U);
+		for (size_t i = 0; i < 1000U; ++i) pool.push([&] { ++counter; });
+	}
+
+	ASSERT_EQUAL(counter.load(), 1000U);
+
+	counter = 0U;
+
+	{
+		lak::tasks pool(2U, 2U);
+		for (size_t i = 0; i < 10U; ++i)
+			pool.push(
+			  [&]
+			  {
+				  // pushing from a worker must not block on a full pool
+				  for (size_t j = 0; j < 10U; ++j) pool.push([&] { ++counter; });
+			  });
+	}
+
+	ASSERT_EQUAL(counter.load(), 100U);
+
+	{
+		std::atomic_bool release = false;
+		lak::tasks pool(1U, 1U);
+		pool.push(
+		  [&]
+		  {
+			  while (!release) std::this_thread::yield();
+			  ++counter;
+		  });
+		ASSERT(!pool.try_push([&] { ++counter; }).has_value());
+		ASSERT(!pool
+		          .push_for([&] { ++counter; }, std::chrono::milliseconds(10))
+		          .has_value());
+		release = true;
+		ASSERT(pool.push_for([&] { ++counter; }, std::chrono::seconds(10))
+		         .has_value());
+		pool.push([&] { ++counter; });
+	}
+
+	ASSERT_EQUAL(counter.load(), 103U);
+
+	lak::tasks moved{lak::tasks::hardware_max()};
+	lak::tasks pool{lak::move(moved)};
+	ASSERT_EQUAL(moved.size(), 0U);
+	ASSERT_GREATER(pool.size(), 0U);
+
+	return 0;
+}
+END_TEST()
+
+BEGIN_TEST(task_handle)
+{
+	lak::tasks pool(4U);
+
+	lak::task_handle<int> handle{pool.push([] { return 42; })};
+	ASSERT(handle.valid());
+	ASSERT_EQUAL(handle.wait().UNWRAP(), 42);
+	ASSERT(handle.ready());
+	ASSERT_EQUAL(handle.try_get().UNWRAP(), 42);
+
+	lak::task_handle<lak::monostate> void_handle{pool.push([] {})};
+	ASSERT(void_handle.wait().is_ok());
+
+	lak::task_handle<int> failed{pool.push(
+	  []() -> int { throw std::runtime_error("expected failure"); })};
+	ASSERT_EQUAL(failed.wait().UNWRAP_ERR(), lak::task_error::failed);
+
+	auto chained{pool.push([] { return 20; })
+	               .then([](int &v) { return v + 1; })
+	               .then([](int &v) { return v * 2; })};
+	ASSERT_EQUAL(chained.wait().UNWRAP(), 42);
+
+	bool ran = false;
+	auto skipped{lak::move(failed).then([&](int &) { ran = true; })};
+	ASSERT_EQUAL(skipped.wait().UNWRAP_ERR(), lak::task_error::failed);
+	ASSERT(!ran);
+
+	// fan out then fan in from inside the pool
+	auto sum{pool.push(
+	  [&pool]
+	  {
+		  lak::array<lak::task_handle<size_t>> parts;
+		  for (size_t i = 0; i < 100U; ++i)
+			  parts.push_back(pool.push([i] { return i; }));
+		  size_t result = 0U;
+		  for (auto &part : parts) result += part.wait().UNWRAP();
+		  return result;
+	  })};
+	ASSERT_EQUAL(sum.wait().UNWRAP(), 4950U);
+
+	return 0;
+}
+END_TEST()
@@ -0,0 +1,57 @@
+#include "lak/unique_pages.hpp"
+
+#include "lak/test.hpp"
+
+BEGIN_TEST(shared_pages)
+{
+	size_t size{0U};
+	lak::shared_pages pages{lak::shared_pages::make(10000U, &size)};
+	ASSERT_GREATER_OR_EQUAL(size, 10000U);
+	ASSERT_EQUAL(pages.size(), size);
+	ASSERT_EQUAL(pages.use_count(), 1U);
+	ASSERT(!pages.is_fork());
+
+	lak::span<uint8_t> bytes(pages.span());
+	for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = uint8_t(i);
+
+	// copies and slices share the pages
+	{
+		lak::shared_pages copy{pages};
+		lak::shared_pages slice{pages.subspan(100U, 200U)};
+		ASSERT_EQUAL(pages.use_count(), 3U);
+		ASSERT_EQUAL(slice.size(), 200U);
+		ASSERT_EQUAL(static_cast<uint8_t *>(slice.data()), bytes.data() + 100U);
+		static_cast<uint8_t *>(copy.data())[0] = 42U;
+		ASSERT_EQUAL(bytes[0], 42U);
+	}
+	ASSERT_EQUAL(pages.use_count(), 1U);
+
+	// forks are copy on write
+	lak::shared_pages slice{pages.last(5000U)};
+	lak::shared_pages forked{slice.fork()};
+	ASSERT(forked.is_fork());
+	ASSERT_EQUAL(forked.size(), 5000U);
+	ASSERT_NOT_EQUAL(forked.data(), slice.data());
+	lak::span<uint8_t> fork_bytes(forked.span());
+	const size_t offset{size - 5000U};
+	for (size_t i = 0; i < fork_bytes.size(); ++i)
+		ASSERT_EQUAL(fork_bytes[i], uint8_t(offset + i));
+	fork_bytes[0] = 7U;
+	ASSERT_EQUAL(bytes[offset], uint8_t(offset));
+
+	// forks of forks are copies
+	lak::shared_pages fork_fork{forked.fork()};
+	ASSERT(fork_fork.is_fork());
+	ASSERT_EQUAL(fork_fork.use_count(), 1U);
+	ASSERT_EQUAL(fork_fork.size(), 5000U);
+	ASSERT_EQUAL(static_cast<uint8_t *>(fork_fork.data())[0], 7U);
+	static_cast<uint8_t *>(fork_fork.data())[0] = 9U;
+	ASSERT_EQUAL(fork_bytes[0], 7U);
+
+	// the pages outlive the original
+	pages = {};
+	ASSERT_EQUAL(static_cast<uint8_t *>(slice.data())[1], uint8_t(offset + 1U));
+
+	return 0;
+}
+END_TEST()
@@ -267,6 +267,9 @@ namespace tinf
 	[[fallthrough]];                                                            \
 	case state_t::STATE:
 
+		lak::huffman_entry entry;
+		uint32_t extra;
+
 		switch (state.state)
 		{
 			case state_t::HEADER:
@@ -301,7 +304,7 @@ namespace tinf
 
 				if (state.block_type == 0)
 				{
-					state.num_bits = 0; // go to byte boundary
+					state.flush_bits(state.num_bits % 8); // go to byte boundary
 
 					SET_STATE(UNCOMPRESSED_LEN)
 
@@ -379,9 +382,12 @@ namespace tinf
 							state.codelen_len[codelen_order[state.counter]] = 0;
 					}
 
-					if (gen_huffman_table(
-					      19, state.codelen_len, false, state.codelen_table) !=
-					    error_t::OK)
+					if (gen_huffman_table(19,
+					                      state.codelen_len,
+					                      false,
+					                      lak::huffman_kind::symbols,
+					                      7U,
+					                      &state.codelen_table) != error_t::OK)
 					{
 						state.crc = ~icrc & 0xFFFF'FFFFUL;
 						return error_t::HUFFMAN_TABLE_GEN_FAILED;
@@ -397,8 +403,9 @@ namespace tinf
 					{
 						if (state.repeat_count == 0)
 						{
-							if (state.get_huff(state.codelen_table, &state.symbol))
+							if (state.get_huff(state.codelen_table, &entry))
 								return out_of_data();
+							state.symbol = entry.value;
 
 							if (state.symbol < 16)
 							{
@@ -449,67 +456,41 @@ namespace tinf
 					if (gen_huffman_table(state.literal_count,
 					                      state.literal_len,
 					                      false,
-					                      state.literal_table) != error_t::OK ||
+					                      lak::huffman_kind::literal_length,
+					                      10U,
+					                      &state.literal_table) != error_t::OK ||
 					    gen_huffman_table(state.distance_count,
 					                      state.distance_len,
 					                      true,
-					                      state.distance_table) != error_t::OK)
+					                      lak::huffman_kind::distance,
+					                      8U,
+					                      &state.distance_table) != error_t::OK)
 					{
 						state.crc = ~icrc & 0xFFFF'FFFFUL;
 						return error_t::HUFFMAN_TABLE_GEN_FAILED;
 					}
+
+					state.fixed_tables = false;
 				}
 				else
 				{
-					int32_t next_free = 2;
-					int32_t i;
-
-					for (i = 0; i < 0x7E; ++i)
-					{
-						state.literal_table[i] = int16_t(~next_free);
-						next_free += 2;
-					}
-
-					for (; i < 0x96; ++i)
-						state.literal_table[i] = (int16_t)i + (256 - 0x7E);
-
-					for (; i < 0xFE; ++i)
-					{
-						state.literal_table[i] = int16_t(~next_free);
-						next_free += 2;
-					}
-
-					for (; i < 0x18E; ++i)
-						state.literal_table[i] = (int16_t)i + (0 - 0xFE);
-
-					for (; i < 0x196; ++i)
-						state.literal_table[i] = (int16_t)i + (280 - 0x18E);
-
-					for (; i < 0x1CE; ++i)
-					{
-						state.literal_table[i] = int16_t(~next_free);
-						next_free += 2;
-					}
-
-					for (; i < 0x23E; ++i)
-						state.literal_table[i] = (int16_t)i + (144 - 0x1CE);
-
-					for (i = 0; i < 0x1E; ++i)
-						state.distance_table[i] = int16_t(~(i * 2 + 2));
-
-					for (i = 0x1E; i < 0x3E; ++i)
-						state.distance_table[i] = int16_t(i - 0x1E);
+					state.fixed_tables = true;
 				}
 
 				for (;;)
 				{
 					SET_STATE(READ_SYMBOL)
 
-					if (state.get_huff(state.literal_table, &state.symbol))
+					if (state.get_huff(state.fixed_tables
+					                     ? lak::huffman_table::fixed_literal_length()
+					                     : state.literal_table,
+					                   &entry))
 						return out_of_data();
 
-					if (state.symbol < 256)
+					if (entry.op == lak::huffman_table::op_literal)
 					{
+						state.symbol = entry.value;
+
 						SET_STATE(PUSH_SYMBOL)
 
 						if (!push((byte_t)state.symbol)) return error_t::OUTPUT_FULL;
@@ -517,56 +498,45 @@ namespace tinf
 						continue;
 					}
 
-					if (state.symbol == 256) break;
-
-					if (state.symbol <= 264)
-					{
-						state.repeat_length = (state.symbol - 257) + 3;
-					}
-					else if (state.symbol <= 284)
-					{
-						SET_STATE(READ_LENGTH)
+					if (entry.op == lak::huffman_table::op_end) break;
 
-						const uint32_t lengthBits = (state.symbol - 261) / 4;
-						if (state.get_bits(lengthBits, &state.repeat_length))
-							return out_of_data();
-						state.repeat_length +=
-						  3 + ((4 + ((state.symbol - 265) & 3)) << lengthBits);
-					}
-					else if (state.symbol == 285)
-					{
-						state.repeat_length = 258;
-					}
-					else
+					if (entry.op > lak::huffman_table::max_bits)
 					{
 						state.crc = ~icrc & 0xFFFF'FFFFUL;
 						return error_t::INVALID_SYMBOL;
 					}
 
+					// the table has the base length and the number of extra bits
+					state.repeat_length = entry.value;
+					state.symbol        = entry.op;
+
+					SET_STATE(READ_LENGTH)
+
+					if (state.get_bits(state.symbol, &extra)) return out_of_data();
+					state.repeat_length += extra;
+
 					SET_STATE(READ_DISTANCE)
 
-					if (state.get_huff(state.distance_table, &state.symbol))
+					if (state.get_huff(state.fixed_tables
+					                     ? lak::huffman_table::fixed_distance()
+					                     : state.distance_table,
+					                   &entry))
 						return out_of_data();
 
-					if (state.symbol <= 3)
-					{
-						state.distance = state.symbol + 1;
-					}
-					else if (state.symbol <= 29)
-					{
-						SET_STATE(READ_DISTANCE_EXTRA)
-
-						const uint32_t distance_bits = (state.symbol - 2) / 2;
-						if (state.get_bits(distance_bits, &state.distance))
-							return out_of_data();
-						state.distance += 1 + ((2 + (state.symbol & 1)) << distance_bits);
-					}
-					else
+					if (entry.op > lak::huffman_table::max_bits)
 					{
 						state.crc = ~icrc & 0xFFFF'FFFFUL;
 						return error_t::INVALID_SYMBOL;
 					}
 
+					state.distance = entry.value;
+					state.symbol   = entry.op;
+
+					SET_STATE(READ_DISTANCE_EXTRA)
+
+					if (state.get_bits(state.symbol, &extra)) return out_of_data();
+					state.distance += extra;
+
 					if (state.distance > static_cast<uintptr_t>(*head - output.begin()))
 					{
 						state.crc = ~icrc & 0xFFFF'FFFFUL;
@@ -600,54 +570,24 @@ namespace tinf
 	error_t gen_huffman_table(uint32_t symbols,
 	                          const uint8_t *lengths,
 	                          bool allow_no_symbols,
-	                          int16_t *table)
+	                          lak::huffman_kind kind,
+	                          uint8_t root_bits,
+	                          lak::huffman_table *table)
 	{
-		uint16_t length_count[16] = {0};
-		uint16_t total_count      = 0;
-		uint16_t first_code[16];
-
-		for (uint32_t i = 0; i < symbols; ++i)
-			if (lengths[i] > 0) ++length_count[lengths[i]];
-
-		for (uint32_t i = 1; i < 16; ++i) total_count += length_count[i];
-
-		if (total_count == 0)
+		switch (table->build(lak::span(lengths, symbols),
+		                     allow_no_symbols,
+		                     kind,
+		                     root_bits))
 		{
-			return allow_no_symbols ? error_t::OK : error_t::NO_SYMBOLS;
-		}
-		else if (total_count == 1)
-		{
-			for (uint32_t i = 0; i < symbols; ++i)
-				if (lengths[i] != 0) table[0] = table[1] = (uint16_t)i;
-			return error_t::OK;
-		}
-
-		first_code[0] = 0;
-		for (uint32_t i = 1; i < 16; ++i)
-		{
-			first_code[i] = (first_code[i - 1] + length_count[i - 1]) << 1;
-			if (first_code[i] + length_count[i] > (uint16_t)1 << i)
+			case lak::huffman_error::ok:
+				return error_t::OK;
+			case lak::huffman_error::no_symbols:
+				return error_t::NO_SYMBOLS;
+			case lak::huffman_error::too_many_symbols:
 				return error_t::TOO_MANY_SYMBOLS;
+			case lak::huffman_error::incomplete_tree:
+				return error_t::INCOMPLETE_TREE;
 		}
-		if (first_code[15] + length_count[15] != (uint16_t)1 << 15)
-			return error_t::INCOMPLETE_TREE;
-
-		for (uint32_t index = 0, i = 1; i < 16; ++i)
-		{
-			uint32_t code_limit = 1U << i;
-			uint32_t next_code  = first_code[i] + length_count[i];
-			uint32_t next_index = index + (code_limit - first_code[i]);
-
-			for (uint32_t j = 0; j < symbols; ++j)
-				if (lengths[j] == i) table[index++] = (uint16_t)j;
-
-			for (uint32_t j = next_code; j < code_limit; ++j)
-			{
-				table[index++] = int16_t(~next_index);
-				next_index += 2;
-			}
-		}
-
-		return error_t::OK;
+		return error_t::HUFFMAN_TABLE_GEN_FAILED;
 	}
 }
@@ -2,8 +2,12 @@
 
 #include "lak/result.hpp"
 
+#include "lak/debug.hpp"
+#include "lak/math.hpp"
 #include "lak/memmanip.hpp"
 
+#include <atomic>
+
 void lak::unique_pages::clear()
 {
 	if (!empty()) lak::page_free(*this).expect("free failed");
@@ -12,6 +16,135 @@ void lak::unique_pages::clear()
 
 lak::unique_pages lak::unique_pages::make(size_t min_size, size_t *actual_size)
 {
-	return lak::unique_pages(
-	  lak::page_reserve(min_size, actual_size).expect("reserve failed"));
+	return lak::unique_pages::try_make(min_size, actual_size)
+	  .expect("reserve failed");
+}
+
+lak::page_result_t<lak::unique_pages> lak::unique_pages::try_make(
+  size_t min_size, size_t *actual_size)
+{
+	return lak::page_reserve(min_size, actual_size)
+	  .map([](lak::span<void> pages) { return lak::unique_pages(pages); });
+}
+
+/* --- shared_pages --- */
+
+namespace lak
+{
+	struct _shared_pages_block
+	{
+		std::atomic_size_t count;
+		// -1 for forks, their pages are private to this block
+		lak::shared_memory_handle handle;
+		lak::span<void> mapping;
+	};
+}
+
+void lak::shared_pages::retain() const
+{
+	if (_block) _block->count.fetch_add(1U, std::memory_order_relaxed);
+}
+
+void lak::shared_pages::clear()
+{
+	static_cast<lak::span<void> &>(*this) = {};
+
+	if (!_block) return;
+
+	lak::_shared_pages_block *block{lak::exchange(_block, nullptr)};
+	if (block->count.fetch_sub(1U, std::memory_order_acq_rel) != 1U) return;
+
+	lak::shared_memory_unmap(block->mapping).expect("unmap failed");
+	if (block->handle != -1) lak::shared_memory_close(block->handle);
+	delete block;
+}
+
+lak::shared_pages lak::shared_pages::make(size_t min_size, size_t *actual_size)
+{
+	ASSERT_GREATER(min_size, 0U);
+
+	const size_t size{
+	  lak::to_multiple(min_size, lak::shared_memory_granularity())};
+
+	const lak::shared_memory_handle handle{
+	  lak::shared_memory_create(size).expect("create failed")};
+
+	auto mapping{lak::shared_memory_map(handle, 0U, size, false)};
+	if (mapping.is_err()) lak::shared_memory_close(handle);
+
+	lak::span<void> pages{lak::move(mapping).expect("map failed")};
+
+	if (actual_size) *actual_size = size;
+
+	return lak::shared_pages(
+	  new lak::_shared_pages_block{
+	    .count = 1U, .handle = handle, .mapping = pages},
+	  pages);
+}
+
+size_t lak::shared_pages::use_count() const
+{
+	return _block ? _block->count.load(std::memory_order_relaxed) : 0U;
+}
+
+bool lak::shared_pages::is_fork() const
+{
+	return _block && _block->handle == -1;
+}
+
+lak::shared_pages lak::shared_pages::subspan(size_t offset, size_t count) const
+{
+	ASSERT_LESS_OR_EQUAL(offset, size());
+	if (count == lak::dynamic_extent) count = size() - offset;
+	ASSERT_LESS_OR_EQUAL(count, size() - offset);
+
+	retain();
+	return lak::shared_pages(
+	  _block,
+	  lak::span<void>(static_cast<byte_t *>(data()) + offset, count));
+}
+
+lak::shared_pages lak::shared_pages::first(size_t count) const
+{
+	return subspan(0U, count);
+}
+
+lak::shared_pages lak::shared_pages::last(size_t count) const
+{
+	ASSERT_LESS_OR_EQUAL(count, size());
+	return subspan(size() - count, count);
+}
+
+lak::shared_pages lak::shared_pages::fork() const
+{
+	if (!_block) return {};
+
+	if (is_fork())
+	{
+		// nothing else can see the copy, forking it keeps the result private
+		// once the copy goes away
+		lak::shared_pages copy{lak::shared_pages::make(size())};
+		lak::memcpy(lak::span<byte_t>(copy.span()),
+		            lak::span<const byte_t>(span()));
+		return copy.first(size()).fork();
+	}
+
+	// map the granularity aligned range that covers this slice
+	const size_t granularity{lak::shared_memory_granularity()};
+	const size_t offset{size_t(static_cast<byte_t *>(data()) -
+	                           static_cast<byte_t *>(_block->mapping.data()))};
+	const size_t map_offset{offset - (offset % granularity)};
+	const size_t map_size{
+	  lak::to_multiple(offset + size(), granularity) - map_offset};
+
+	lak::span<void> mapping{
+	  lak::shared_memory_map(_block->handle, map_offset, map_size, true)
+	    .expect("map failed")};
+
+	return lak::shared_pages(
+	  new lak::_shared_pages_block{
+	    .count = 1U, .handle = -1, .mapping = mapping},
+	  lak::span<void>(static_cast<byte_t *>(mapping.data()) +
+	                    (offset - map_offset),
+	                  size()));
 }
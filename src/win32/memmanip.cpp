@@ -1,5 +1,7 @@
 #include "lak/memmanip.hpp"
+#include "lak/alloc_stats.hpp"
 #include "lak/compiler.hpp"
+#include "lak/math.hpp"
 #include "lak/os.hpp"
 #include "lak/span.hpp"
 
@@ -17,18 +19,62 @@ size_t lak::page_size()
 	return page_size;
 }
 
+size_t lak::huge_page_size()
+{
+	// large pages can't be reserved without being committed, so there's no
+	// transparent equivalent
+	return 0U;
+}
+
 lak::page_result_t<lak::span<void>> lak::page_reserve(size_t size,
                                                       size_t *page_size_out)
+{
+	return lak::page_reserve(size, lak::page_options{}, page_size_out);
+}
+
+lak::page_result_t<lak::span<void>> lak::page_reserve(
+  size_t size, const lak::page_options &options, size_t *page_size_out)
 {
 	ASSERT_GREATER(size, 0U);
 
-	size = lak::round_to_page_multiple(size, page_size_out);
+	size_t page_size = 0U;
+	size             = lak::round_to_page_multiple(size, &page_size);
+
+	DWORD allocation_type = MEM_RESERVE;
+
+	if (options.explicit_page_size != 0U)
+	{
+		// large pages are committed up front and need SeLockMemoryPrivilege
+		if (options.explicit_page_size != ::GetLargePageMinimum())
+			return lak::err_t{lak::page_error{}};
+		page_size = options.explicit_page_size;
+		size      = lak::to_multiple(size, page_size);
+		allocation_type |= MEM_COMMIT | MEM_LARGE_PAGES;
+	}
 
 	auto ptr_to_span = [size](void *ptr) { return lak::span<void>(ptr, size); };
 
-	return lak::winapi::virtual_alloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE)
+	return (options.numa_node >= 0
+	          ? lak::winapi::virtual_alloc_numa(nullptr,
+	                                            size,
+	                                            allocation_type,
+	                                            PAGE_READWRITE,
+	                                            DWORD(options.numa_node))
+	          : lak::winapi::virtual_alloc(
+	              nullptr, size, allocation_type, PAGE_READWRITE))
 	  .map(ptr_to_span)
-	  .map_err([](auto &&) -> lak::page_error { return {}; });
+	  .map_err([](auto &&) -> lak::page_error { return {}; })
+	  .if_ok(
+	    [&](lak::span<void> pages)
+	    {
+		    if (page_size_out) *page_size_out = page_size;
+		    if (lak::alloc_stats_enabled())
+		    {
+			    lak::_alloc_stats_reserved(pages);
+			    if (allocation_type & MEM_COMMIT)
+				    lak::_alloc_stats_committed(pages);
+		    }
+	    });
 }
 
 lak::page_result_t<> lak::page_commit(lak::span<void> pages)
@@ -36,19 +82,34 @@ lak::page_result_t<> lak::page_commit(lak::span<void> pages)
 	return lak::winapi::virtual_alloc(
 	         pages.data(), pages.size(), MEM_COMMIT, PAGE_READWRITE)
 	  .map([](auto &&) -> lak::monostate { return {}; })
-	  .map_err([](auto &&) -> lak::page_error { return {}; });
+	  .map_err([](auto &&) -> lak::page_error { return {}; })
+	  .if_ok(
+	    [&](auto &&)
+	    {
+		    if (lak::alloc_stats_enabled()) lak::_alloc_stats_committed(pages);
+	    });
 }
 
 lak::page_result_t<> lak::page_decommit(lak::span<void> pages)
 {
 	return lak::winapi::virtual_free(pages.data(), pages.size(), MEM_DECOMMIT)
-	  .map_err([](auto &&) -> lak::page_error { return {}; });
+	  .map_err([](auto &&) -> lak::page_error { return {}; })
+	  .if_ok(
+	    [&](auto &&)
+	    {
+		    if (lak::alloc_stats_enabled()) lak::_alloc_stats_decommitted(pages);
+	    });
 }
 
 lak::page_result_t<> lak::page_free(lak::span<void> pages)
 {
 	return lak::winapi::virtual_free(pages.data(), 0, MEM_RELEASE)
-	  .map_err([](auto &&) -> lak::page_error { return {}; });
+	  .map_err([](auto &&) -> lak::page_error { return {}; })
+	  .if_ok(
+	    [&](auto &&)
+	    {
+		    if (lak::alloc_stats_enabled()) lak::_alloc_stats_released(pages);
+	    });
 }
 
 #if 0
@@ -82,4 +143,65 @@ lak::page_result_t<bool> lak::pages_are_reserved(lak::span<void> pages)
       lak::span<void>(lak::span<uint8_t>(pages).subspan(info.RegionSize));
   }
 }
-#endif
\ No newline at end of file
+#endif
+size_t lak::shared_memory_granularity()
+{
+	const static DWORD granularity = []()
+	{
+		SYSTEM_INFO system_info;
+		::GetSystemInfo(&system_info);
+		return system_info.dwAllocationGranularity;
+	}();
+
+	return granularity;
+}
+
+lak::page_result_t<lak::shared_memory_handle> lak::shared_memory_create(
+  size_t size)
+{
+	const uint64_t size64 = size;
+	if (HANDLE handle = ::CreateFileMappingW(INVALID_HANDLE_VALUE,
+	                                         nullptr,
+	                                         PAGE_READWRITE,
+	                                         DWORD(size64 >> 32U),
+	                                         DWORD(size64),
+	                                         nullptr);
+	    handle != nullptr)
+		return lak::ok_t{lak::shared_memory_handle(handle)};
+	else
+		return lak::err_t{lak::page_error{}};
+}
+
+void lak::shared_memory_close(lak::shared_memory_handle handle)
+{
+	::CloseHandle(HANDLE(handle));
+}
+
+lak::page_result_t<lak::span<void>> lak::shared_memory_map(
+  lak::shared_memory_handle handle,
+  size_t offset,
+  size_t size,
+  bool copy_on_write)
+{
+	ASSERT_EQUAL(offset % lak::shared_memory_granularity(), 0U);
+
+	const uint64_t offset64 = offset;
+	if (void *ptr = ::MapViewOfFile(HANDLE(handle),
+	                                copy_on_write ? FILE_MAP_COPY
+	                                              : FILE_MAP_ALL_ACCESS,
+	                                DWORD(offset64 >> 32U),
+	                                DWORD(offset64),
+	                                size);
+	    ptr != nullptr)
+		return lak::ok_t{lak::span<void>(ptr, size)};
+	else
+		return lak::err_t{lak::page_error{}};
+}
+
+lak::page_result_t<> lak::shared_memory_unmap(lak::span<void> pages)
+{
+	if (::UnmapViewOfFile(pages.data()))
+		return lak::ok_t{};
+	else
+		return lak::err_t{lak::page_error{}};
+}
@@ -74,6 +74,22 @@ lak::error_code_result<LPVOID> lak::winapi::virtual_alloc(
 	  ::VirtualAlloc, address, size, allocation_type, protect);
 }
 
+lak::error_code_result<LPVOID> lak::winapi::virtual_alloc_numa(
+  LPVOID address,
+  SIZE_T size,
+  DWORD allocation_type,
+  DWORD protect,
+  DWORD node)
+{
+	return lak::winapi::invoke_null_err(::VirtualAllocExNuma,
+	                                    ::GetCurrentProcess(),
+	                                    address,
+	                                    size,
+	                                    allocation_type,
+	                                    protect,
+	                                    node);
+}
+
 lak::error_code_result<> lak::winapi::virtual_free(LPVOID address,
                                                    SIZE_T size,
                                                    DWORD free_type)
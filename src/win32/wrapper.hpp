@@ -71,6 +71,12 @@ namespace lak
 		                                             DWORD allocation_type,
 		                                             DWORD protect);
 
+		lak::error_code_result<LPVOID> virtual_alloc_numa(LPVOID address,
+		                                                  SIZE_T size,
+		                                                  DWORD allocation_type,
+		                                                  DWORD protect,
+		                                                  DWORD node);
+
 		lak::error_code_result<> virtual_free(LPVOID address,
 		                                      SIZE_T size,
 		                                      DWORD free_type);
@@ -0,0 +1,65 @@
+#include "lak/xxhash.hpp"
+
+#include <bit>
+
+namespace
+{
+	constexpr uint32_t prime1 = 2654435761U;
+	constexpr uint32_t prime2 = 2246822519U;
+	constexpr uint32_t prime3 = 3266489917U;
+	constexpr uint32_t prime4 = 668265263U;
+	constexpr uint32_t prime5 = 374761393U;
+
+	uint32_t read_u32(const byte_t *data)
+	{
+		return uint32_t(data[0]) | (uint32_t(data[1]) << 8U) |
+		       (uint32_t(data[2]) << 16U) | (uint32_t(data[3]) << 24U);
+	}
+
+	uint32_t round_lane(uint32_t acc, uint32_t lane)
+	{
+		return std::rotl(acc + (lane * prime2), 13) * prime1;
+	}
+}
+
+uint32_t lak::xxhash32(lak::span<const byte_t> data, uint32_t seed)
+{
+	const byte_t *p{data.data()};
+	const byte_t *const end{p + data.size()};
+
+	uint32_t hash;
+	if (data.size() >= 16U)
+	{
+		uint32_t v1 = seed + prime1 + prime2;
+		uint32_t v2 = seed + prime2;
+		uint32_t v3 = seed;
+		uint32_t v4 = seed - prime1;
+		for (; end - p >= 16; p += 16)
+		{
+			v1 = round_lane(v1, read_u32(p));
+			v2 = round_lane(v2, read_u32(p + 4));
+			v3 = round_lane(v3, read_u32(p + 8));
+			v4 = round_lane(v4, read_u32(p + 12));
+		}
+		hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) +
+		       std::rotl(v4, 18);
+	}
+	else
+	{
+		hash = seed + prime5;
+	}
+
+	hash += uint32_t(data.size());
+
+	for (; end - p >= 4; p += 4)
+		hash = std::rotl(hash + (read_u32(p) * prime3), 17) * prime4;
+	for (; p < end; ++p)
+		hash = std::rotl(hash + (uint32_t(*p) * prime5), 11) * prime1;
+
+	hash ^= hash >> 15U;
+	hash *= prime2;
+	hash ^= hash >> 13U;
+	hash *= prime3;
+	hash ^= hash >> 16U;
+	return hash;
+}